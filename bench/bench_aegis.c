@@ -0,0 +1,1197 @@
+// Vector / string micro-benchmarks with JSON output.
+//
+// Every case reports the best wall time over --reps runs as ns/op and
+// throughput, the allocator traffic of one run (through a counting
+// ag_allocator) and, with --perf on Linux, instructions and cache misses of
+// the best run read from perf_event_open.
+//
+// Syntax => bench_aegis [--reps N] [--quick] [--perf] [--filter substr]
+//           bench_aegis --quick > before.json
+
+#define _GNU_SOURCE
+#include "aegis/aegis_vector.h"
+#include "aegis/aegis_string.h"
+#include "aegis/aegis_hashmap.h"
+#include "aegis/aegis_sort.h"
+#include "aegis/aegis_threadpool.h"
+#include "aegis/aegis_ringbuf.h"
+#include "aegis/aegis_deque.h"
+#include "aegis/aegis_bitvec.h"
+#include "aegis/aegis_strbuilder.h"
+#include "aegis/aegis_split.h"
+#include "aegis/aegis_intern.h"
+#include "aegis/aegis_utf8.h"
+#include "aegis/aegis_io.h"
+
+#include <time.h>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define BENCH_HAS_PERF 1
+#else
+#define BENCH_HAS_PERF 0
+#endif
+
+// ---------------------------------------------------------------------------
+// Counting allocator
+// ---------------------------------------------------------------------------
+
+typedef struct {
+     uint64_t allocs;
+     uint64_t reallocs;
+     uint64_t frees;
+     uint64_t bytes;     // Sum of every alloc / realloc request
+} bench_alloc_stats;
+
+static bench_alloc_stats alloc_stats;
+
+static void*
+__count_alloc(void *ctx, size_t size)
+{
+     (void)ctx;
+     alloc_stats.allocs++;
+     alloc_stats.bytes += size;
+     return malloc(size);
+}
+
+static void*
+__count_realloc(void *ctx, void *ptr, size_t old_size, size_t new_size)
+{
+     (void)ctx; (void)old_size;
+     alloc_stats.reallocs++;
+     alloc_stats.bytes += new_size;
+     return realloc(ptr, new_size);
+}
+
+static void
+__count_free(void *ctx, void *ptr, size_t size)
+{
+     (void)ctx; (void)size;
+     alloc_stats.frees++;
+     free(ptr);
+}
+
+static ag_allocator counting_alloc = {
+     .alloc   = __count_alloc,
+     .realloc = __count_realloc,
+     .free    = __count_free,
+     .ctx     = NULL,
+};
+
+// ---------------------------------------------------------------------------
+// Hardware counters
+// ---------------------------------------------------------------------------
+
+typedef struct {
+     int leader;         // Group leader fd (instructions), -1 if unavailable
+     int misses;
+} bench_perf;
+
+typedef struct {
+     uint64_t instructions;
+     uint64_t cache_misses;
+} bench_perf_sample;
+
+#if BENCH_HAS_PERF
+static int
+__perf_open(uint64_t config, int group)
+{
+     struct perf_event_attr attr;
+     memset(&attr, 0, sizeof(attr));
+     attr.size = sizeof(attr);
+     attr.type = PERF_TYPE_HARDWARE;
+     attr.config = config;
+     attr.disabled = (group == -1);
+     attr.exclude_kernel = 1;
+     attr.exclude_hv = 1;
+     attr.read_format = PERF_FORMAT_GROUP;
+     return (int)syscall(SYS_perf_event_open, &attr, 0, -1, group, 0);
+}
+#endif
+
+static bool
+bench_perf_open(bench_perf *perf)
+{
+     perf->leader = perf->misses = -1;
+#if BENCH_HAS_PERF
+     perf->leader = __perf_open(PERF_COUNT_HW_INSTRUCTIONS, -1);
+     if(perf->leader < 0) return false;
+     perf->misses = __perf_open(PERF_COUNT_HW_CACHE_MISSES, perf->leader);
+     if(perf->misses < 0) {
+          close(perf->leader);
+          perf->leader = -1;
+          return false;
+     }
+     return true;
+#else
+     return false;
+#endif
+}
+
+static void
+bench_perf_close(bench_perf *perf)
+{
+#if BENCH_HAS_PERF
+     if(perf->misses >= 0) close(perf->misses);
+     if(perf->leader >= 0) close(perf->leader);
+#endif
+     perf->leader = perf->misses = -1;
+}
+
+static inline void
+bench_perf_start(bench_perf *perf)
+{
+#if BENCH_HAS_PERF
+     if(perf->leader < 0) return;
+     ioctl(perf->leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+     ioctl(perf->leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#else
+     (void)perf;
+#endif
+}
+
+static inline bench_perf_sample
+bench_perf_stop(bench_perf *perf)
+{
+     bench_perf_sample sample = {0, 0};
+#if BENCH_HAS_PERF
+     if(perf->leader < 0) return sample;
+     ioctl(perf->leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+     uint64_t group[3]; // nr, instructions, cache misses
+     if(read(perf->leader, group, sizeof(group)) == (ssize_t)sizeof(group)) {
+          sample.instructions = group[1];
+          sample.cache_misses = group[2];
+     }
+#else
+     (void)perf;
+#endif
+     return sample;
+}
+
+// ---------------------------------------------------------------------------
+// Runner
+// ---------------------------------------------------------------------------
+
+typedef struct {
+     const char *name;
+     const char *param_name;  // What `param` means for this case
+     size_t param;
+     size_t n;
+
+     // Filled by the case body
+     size_t ops;
+     size_t bytes_per_op;
+     uint64_t elapsed_ns;
+     bench_perf_sample counters;
+
+     bench_perf *perf;
+     uint64_t t0;
+} bench_case;
+
+typedef void (*bench_fn)(bench_case *c);
+
+#define bench_countof(arr) (sizeof(arr) / sizeof((arr)[0]))
+
+static struct {
+     unsigned reps;
+     bool quick;
+     bool perf;
+     const char *filter;
+     bool first_result;
+} config = { 5, false, false, NULL, true };
+
+// Defeats dead-code elimination of benchmark results
+static volatile uint64_t bench_sink;
+
+static inline uint64_t
+bench_now_ns(void)
+{
+     struct timespec ts;
+     clock_gettime(CLOCK_MONOTONIC, &ts);
+     return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static inline void
+bench_start(bench_case *c)
+{
+     bench_perf_start(c->perf);
+     c->t0 = bench_now_ns();
+}
+
+static inline void
+bench_stop(bench_case *c)
+{
+     c->elapsed_ns = bench_now_ns() - c->t0;
+     c->counters = bench_perf_stop(c->perf);
+}
+
+static void
+bench_json_result(const bench_case *best, const bench_alloc_stats *allocs)
+{
+     double ns_per_op = (double)best->elapsed_ns / (double)agmax(best->ops, (size_t)1);
+     double ops_per_sec = ns_per_op > 0 ? 1e9 / ns_per_op : 0;
+
+     printf("%s\n    {\"name\": \"%s\", \"%s\": %zu, \"n\": %zu, \"ops\": %zu, "
+            "\"ns_per_op\": %.3f, \"ops_per_sec\": %.1f, \"bytes_per_sec\": %.1f, "
+            "\"allocs\": %llu, \"reallocs\": %llu, \"frees\": %llu, \"alloc_bytes\": %llu, ",
+            config.first_result ? "" : ",",
+            best->name, best->param_name, best->param, best->n, best->ops,
+            ns_per_op, ops_per_sec, ops_per_sec * (double)best->bytes_per_op,
+            (unsigned long long)allocs->allocs, (unsigned long long)allocs->reallocs,
+            (unsigned long long)allocs->frees, (unsigned long long)allocs->bytes);
+     if(best->perf->leader >= 0)
+          printf("\"instructions\": %llu, \"cache_misses\": %llu}",
+                 (unsigned long long)best->counters.instructions,
+                 (unsigned long long)best->counters.cache_misses);
+     else
+          printf("\"instructions\": null, \"cache_misses\": null}");
+     config.first_result = false;
+}
+
+static void
+bench_run(bench_fn fn, const char *name, const char *param_name, size_t param, size_t n, bench_perf *perf)
+{
+     if(config.filter != NULL && strstr(name, config.filter) == NULL) return;
+
+     bench_case best = {0};
+     bench_alloc_stats allocs = {0};
+     for(unsigned rep = 0; rep < config.reps; rep++) {
+          bench_case c = { .name = name, .param_name = param_name, .param = param,
+                           .n = n, .perf = perf };
+          memset(&alloc_stats, 0, sizeof(alloc_stats));
+          fn(&c);
+          // Allocation counts are deterministic, the first run's are as good as any
+          if(rep == 0) allocs = alloc_stats;
+          if(rep == 0 || c.elapsed_ns < best.elapsed_ns) best = c;
+     }
+     bench_json_result(&best, &allocs);
+}
+
+// ---------------------------------------------------------------------------
+// Vector cases (param = element size)
+// ---------------------------------------------------------------------------
+
+#define BENCH_MAX_ELEM 64
+
+static void
+bench_vec_push_back(bench_case *c)
+{
+     byte elem[BENCH_MAX_ELEM] = {1};
+     vector *vec = __vec_init_with_alloc(0, c->param, false, &counting_alloc);
+
+     bench_start(c);
+     for(size_t i = 0; i < c->n; i++) {
+          elem[0] = (byte)i;
+          __vec_push_back(vec, elem);
+     }
+     bench_stop(c);
+
+     bench_sink += vec->size;
+     c->ops = c->n;
+     c->bytes_per_op = c->param;
+     __vec_clean(vec);
+}
+
+static void
+bench_vec_push_back_reserved(bench_case *c)
+{
+     byte elem[BENCH_MAX_ELEM] = {1};
+     vector *vec = __vec_init_with_alloc(0, c->param, false, &counting_alloc);
+     __vec_reserve(vec, c->n);
+
+     bench_start(c);
+     for(size_t i = 0; i < c->n; i++) {
+          elem[0] = (byte)i;
+          __vec_push_back(vec, elem);
+     }
+     bench_stop(c);
+
+     bench_sink += vec->size;
+     c->ops = c->n;
+     c->bytes_per_op = c->param;
+     __vec_clean(vec);
+}
+
+// Growth / realloc: appends in 64-element chunks from an empty vector
+static void
+bench_vec_push_back_n(bench_case *c)
+{
+     const size_t chunk = 64;
+     byte *src = (byte*)calloc(chunk, c->param);
+     vector *vec = __vec_init_with_alloc(0, c->param, false, &counting_alloc);
+
+     bench_start(c);
+     for(size_t i = 0; i < c->n; i += chunk)
+          __vec_push_back_n(vec, src, agmin(chunk, c->n - i));
+     bench_stop(c);
+
+     bench_sink += vec->size;
+     c->ops = c->n;
+     c->bytes_per_op = c->param;
+     __vec_clean(vec);
+     free(src);
+}
+
+typedef enum { BENCH_FRONT, BENCH_MIDDLE, BENCH_BACK } bench_pos;
+
+static inline size_t
+bench_position(bench_pos where, size_t size)
+{
+     switch(where) {
+     case BENCH_FRONT:  return 0;
+     case BENCH_MIDDLE: return size / 2;
+     default:           return size;
+     }
+}
+
+static void
+__bench_vec_insert(bench_case *c, bench_pos where)
+{
+     byte elem[BENCH_MAX_ELEM] = {1};
+     vector *vec = __vec_init_with_alloc(0, c->param, false, &counting_alloc);
+     // __vec_insert needs a valid position, seed one element
+     __vec_push_back(vec, elem);
+
+     bench_start(c);
+     for(size_t i = 1; i < c->n; i++) {
+          size_t pos = bench_position(where, vec->size);
+          if(pos == vec->size) __vec_push_back(vec, elem);
+          else __vec_insert(vec, pos, elem);
+     }
+     bench_stop(c);
+
+     bench_sink += vec->size;
+     c->ops = c->n - 1;
+     c->bytes_per_op = c->param;
+     __vec_clean(vec);
+}
+
+static void bench_vec_insert_front(bench_case *c)  { __bench_vec_insert(c, BENCH_FRONT); }
+static void bench_vec_insert_middle(bench_case *c) { __bench_vec_insert(c, BENCH_MIDDLE); }
+static void bench_vec_insert_back(bench_case *c)   { __bench_vec_insert(c, BENCH_BACK); }
+
+static void
+__bench_vec_erase(bench_case *c, bench_pos where)
+{
+     vector *vec = __vec_init_with_alloc(c->n, c->param, true, &counting_alloc);
+
+     bench_start(c);
+     while(vec->size > 0) {
+          size_t pos = bench_position(where, vec->size);
+          __vec_erase(vec, pos == vec->size ? pos - 1 : pos);
+     }
+     bench_stop(c);
+
+     bench_sink += vec->capacity;
+     c->ops = c->n;
+     c->bytes_per_op = c->param;
+     __vec_clean(vec);
+}
+
+static void bench_vec_erase_front(bench_case *c)  { __bench_vec_erase(c, BENCH_FRONT); }
+static void bench_vec_erase_middle(bench_case *c) { __bench_vec_erase(c, BENCH_MIDDLE); }
+static void bench_vec_erase_back(bench_case *c)   { __bench_vec_erase(c, BENCH_BACK); }
+
+static void
+bench_vec_fill(bench_case *c)
+{
+     byte elem[BENCH_MAX_ELEM];
+     memset(elem, 0x5a, sizeof(elem));
+     vector *vec = __vec_init_with_alloc(c->n, c->param, false, &counting_alloc);
+     // Fill a few times so small N still gives a readable time
+     size_t rounds = agmax((size_t)1, (size_t)(1u << 24) / (c->n * c->param));
+
+     bench_start(c);
+     for(size_t r = 0; r < rounds; r++) {
+          elem[0] = (byte)r;
+          __vec_fill(vec, 0, vec->size, elem);
+     }
+     bench_stop(c);
+
+     bench_sink += ((byte*)vec->data)[0];
+     c->ops = rounds * c->n;
+     c->bytes_per_op = c->param;
+     __vec_clean(vec);
+}
+
+// ---------------------------------------------------------------------------
+// String cases
+// ---------------------------------------------------------------------------
+
+static char*
+bench_random_text(size_t len, uint64_t seed)
+{
+     char *text = (char*)malloc(len + 1);
+     for(size_t i = 0; i < len; i++) {
+          seed ^= seed << 13;
+          seed ^= seed >> 7;
+          seed ^= seed << 17;
+          text[i] = (char)('a' + seed % 26);
+     }
+     text[len] = '\0';
+     return text;
+}
+
+// param = chunk length
+static void
+bench_string_append(bench_case *c)
+{
+     char *chunk = bench_random_text(c->param, 1);
+     ag_string str = new_string_with_alloc("", &counting_alloc);
+
+     bench_start(c);
+     for(size_t i = 0; i < c->n; i++)
+          string_append_n(str, chunk, c->param);
+     bench_stop(c);
+
+     bench_sink += str->size;
+     c->ops = c->n;
+     c->bytes_per_op = c->param;
+     __vec_clean(str);
+     free(chunk);
+}
+
+// Same appends through a builder, including the final string
+static void
+bench_strbuilder_append(bench_case *c)
+{
+     char *chunk = bench_random_text(c->param, 1);
+     ag_strbuilder *sb = strbuilder_init_with_alloc(&counting_alloc);
+
+     bench_start(c);
+     for(size_t i = 0; i < c->n; i++)
+          strbuilder_append_n(sb, chunk, c->param);
+     ag_string str = strbuilder_to_string(sb);
+     bench_stop(c);
+
+     bench_sink += str->size;
+     c->ops = c->n;
+     c->bytes_per_op = c->param;
+     __vec_clean(str);
+     strbuilder_clean(sb);
+     free(chunk);
+}
+
+// param = substring length, taken at pseudo-random offsets of a 1 MiB string
+static void
+bench_sub_string(bench_case *c)
+{
+     const size_t text_len = 1 << 20;
+     char *text = bench_random_text(text_len, 2);
+     ag_string str = new_string_n_with_alloc(text, text_len, &counting_alloc);
+
+     bench_start(c);
+     size_t pos = 0;
+     for(size_t i = 0; i < c->n; i++) {
+          pos = (pos + 7919 * 64) % (text_len - c->param);
+          ag_string sub = sub_string(str, pos, c->param);
+          bench_sink += sub->size;
+          __vec_clean(sub);
+     }
+     bench_stop(c);
+
+     c->ops = c->n;
+     c->bytes_per_op = c->param;
+     __vec_clean(str);
+     free(text);
+}
+
+// param = needle length, n = haystack length, the only match is at the end
+static void
+bench_find_substr(bench_case *c)
+{
+     char *text = bench_random_text(c->n, 3);
+     // Uppercase cannot occur in the random text, so the tail is the only hit
+     for(size_t i = c->n - c->param; i < c->n; i++) text[i] = 'A';
+     ag_string hay = new_string_n_with_alloc(text, c->n, &counting_alloc);
+     ag_string needle = new_string_n_with_alloc(text + c->n - c->param, c->param, &counting_alloc);
+     size_t rounds = agmax((size_t)1, (size_t)(1u << 26) / c->n);
+
+     bench_start(c);
+     for(size_t r = 0; r < rounds; r++)
+          bench_sink += (uint64_t)(find_substr(hay, needle) - sget(hay));
+     bench_stop(c);
+
+     c->ops = rounds;
+     c->bytes_per_op = c->n;
+     __vec_clean(needle);
+     __vec_clean(hay);
+     free(text);
+}
+
+// Text of n bytes with a delimiter from " ,;" (or a newline) every param bytes
+static char*
+bench_delimited_text(size_t n, size_t token_len, bool lines)
+{
+     char *text = bench_random_text(n, 5);
+     for(size_t i = token_len; i < n; i += token_len + 1)
+          text[i] = lines ? '\n' : " ,;"[i % 3];
+     return text;
+}
+
+// param = token length, tokens collected into a vector
+static void
+bench_split_any(bench_case *c)
+{
+     char *text = bench_delimited_text(c->n, c->param, false);
+     ag_string_view src = sv_from_buf(text, c->n);
+     vector *toks = vec_init_with_alloc(0, ag_token, false, &counting_alloc);
+     size_t rounds = agmax((size_t)1, (size_t)(1u << 26) / c->n);
+
+     bench_start(c);
+     for(size_t r = 0; r < rounds; r++) {
+          toks->size = 0;
+          bench_sink += sv_split_any(src, sv_from_cstr(" ,;"), 0, toks);
+     }
+     bench_stop(c);
+
+     c->ops = rounds;
+     c->bytes_per_op = c->n;
+     __vec_clean(toks);
+     free(text);
+}
+
+// param = line length, streaming iterator
+static void
+bench_split_lines(bench_case *c)
+{
+     char *text = bench_delimited_text(c->n, c->param, true);
+     ag_string_view src = sv_from_buf(text, c->n);
+     size_t rounds = agmax((size_t)1, (size_t)(1u << 26) / c->n);
+
+     bench_start(c);
+     for(size_t r = 0; r < rounds; r++) {
+          ag_split_iter it;
+          ag_string_view line;
+          split_iter_init_lines(&it, src);
+          while(split_next(&it, &line)) bench_sink += line.size;
+     }
+     bench_stop(c);
+
+     c->ops = rounds;
+     c->bytes_per_op = c->n;
+     free(text);
+}
+
+// param = distinct keys, n = interned tokens drawn from them
+static void
+__bench_intern(bench_case *c, bool bulk)
+{
+     ag_string text = new_string_with_alloc("", &counting_alloc);
+     uint64_t seed = 7;
+     for(size_t i = 0; i < c->n; i++) {
+          seed ^= seed << 13;
+          seed ^= seed >> 7;
+          seed ^= seed << 17;
+          char key[32];
+          int len = snprintf(key, sizeof(key), "key_%llu ", (unsigned long long)(seed % c->param));
+          string_append_n(text, key, (size_t)len);
+     }
+     ag_string_view src = sv_from_string(text);
+     vector *toks = vec_init_with_alloc(0, ag_token, false, &counting_alloc);
+     sv_split(src, sv_from_cstr(" "), AG_SPLIT_SKIP_EMPTY, toks);
+     uint32_t *ids = (uint32_t*)malloc(toks->size * sizeof(uint32_t));
+     ag_intern *pool = intern_init();
+
+     bench_start(c);
+     if(bulk) intern_tokens(pool, src, toks, ids);
+     else
+          for(size_t i = 0; i < toks->size; i++)
+               ids[i] = intern_sv(pool, sv_token(src, vec_at(toks, ag_token, i)));
+     bench_stop(c);
+
+     bench_sink += ids[toks->size - 1] + intern_size(pool);
+     c->ops = toks->size;
+     c->bytes_per_op = 0;
+     intern_clean(pool);
+     free(ids);
+     __vec_clean(toks);
+     __vec_clean(text);
+}
+
+static void bench_intern_sv(bench_case *c) { __bench_intern(c, false); }
+static void bench_intern_tokens(bench_case *c) { __bench_intern(c, true); }
+
+// pct percent of the characters are 2 or 3-byte sequences, the rest ASCII
+static char*
+bench_utf8_text(size_t n, size_t pct)
+{
+     char *text = bench_random_text(n, 6);
+     uint64_t seed = 7;
+     for(size_t i = 0; i + 3 <= n;) {
+          seed ^= seed << 13;
+          seed ^= seed >> 7;
+          seed ^= seed << 17;
+          if(seed % 100 >= pct) {
+               i++;
+          } else if(seed & 128) {
+               memcpy(text + i, "\xc3\xa9", 2);
+               i += 2;
+          } else {
+               memcpy(text + i, "\xe4\xb8\xad", 3);
+               i += 3;
+          }
+     }
+     return text;
+}
+
+// param = percent of non-ASCII characters
+static void
+__bench_utf8(bench_case *c, bool transcode)
+{
+     char *text = bench_utf8_text(c->n, c->param);
+     ag_string_view src = sv_from_buf(text, c->n);
+     uint16_t *units = (uint16_t*)malloc(c->n * sizeof(uint16_t));
+     size_t rounds = agmax((size_t)1, (size_t)(1u << 26) / c->n);
+
+     bench_start(c);
+     for(size_t r = 0; r < rounds; r++)
+          bench_sink += transcode ? utf8_to_utf16(src, units) : sv_utf8_valid(src);
+     bench_stop(c);
+
+     c->ops = rounds;
+     c->bytes_per_op = c->n;
+     free(units);
+     free(text);
+}
+
+static void bench_utf8_validate(bench_case *c) { __bench_utf8(c, false); }
+static void bench_utf8_to_utf16(bench_case *c) { __bench_utf8(c, true); }
+
+// Temporary file of n bytes in lines of param bytes (plus "\n")
+static char*
+bench_line_file(size_t n, size_t line_len)
+{
+     static char path[] = "/tmp/aegis_bench_linesXXXXXX";
+     strcpy(path + sizeof(path) - 7, "XXXXXX");
+     int fd = mkstemp(path);
+     if(fd < 0) return NULL;
+     char *text = bench_delimited_text(n, line_len, true);
+     bool ok = write(fd, text, n) == (ssize_t)n;
+     close(fd);
+     free(text);
+     return ok ? path : NULL;
+}
+
+// 0: reader over read(2), 1: reader over a mapping, 2: fgets + new_string per line
+static void
+__bench_lines(bench_case *c, int how)
+{
+     char *path = bench_line_file(c->n, c->param);
+     if(path == NULL) return;
+     size_t rounds = agmax((size_t)1, (size_t)(1u << 26) / c->n);
+     char line[4096];
+
+     bench_start(c);
+     for(size_t r = 0; r < rounds; r++) {
+          if(how < 2) {
+               ag_reader *in = reader_open(path, how == 1 ? AG_READER_MMAP : 0);
+               ag_string_view view;
+               while(reader_next_line(in, &view)) bench_sink += view.size;
+               reader_close(in);
+          } else {
+               FILE *in = fopen(path, "rb");
+               while(fgets(line, sizeof(line), in) != NULL) {
+                    ag_string str = new_string_with_alloc(line, &counting_alloc);
+                    bench_sink += str->size;
+                    vec_clean(str);
+               }
+               fclose(in);
+          }
+     }
+     bench_stop(c);
+
+     c->ops = rounds;
+     c->bytes_per_op = c->n;
+     unlink(path);
+}
+
+static void bench_reader_lines(bench_case *c)      { __bench_lines(c, 0); }
+static void bench_reader_lines_mmap(bench_case *c) { __bench_lines(c, 1); }
+static void bench_fgets_lines(bench_case *c)       { __bench_lines(c, 2); }
+
+// ---------------------------------------------------------------------------
+// Hash map cases (param = key size)
+// ---------------------------------------------------------------------------
+
+AG_HASHMAP_DEFINE(bench_map_u64, uint64_t, uint64_t)
+
+static inline uint64_t
+bench_key(size_t i)
+{
+     return (uint64_t)i * 0x9e3779b97f4a7c15ull;
+}
+
+static void
+bench_hashmap_insert(bench_case *c)
+{
+     bench_map_u64 *map = bench_map_u64_init_with_alloc(&counting_alloc);
+
+     bench_start(c);
+     for(size_t i = 0; i < c->n; i++)
+          bench_map_u64_put(map, bench_key(i), i);
+     bench_stop(c);
+
+     bench_sink += bench_map_u64_size(map);
+     c->ops = c->n;
+     c->bytes_per_op = c->param;
+     bench_map_u64_clean(map);
+}
+
+// Alternating hits and misses over a prebuilt map
+static void
+bench_hashmap_find(bench_case *c)
+{
+     bench_map_u64 *map = bench_map_u64_init_with_alloc(&counting_alloc);
+     for(size_t i = 0; i < c->n; i++)
+          bench_map_u64_put(map, bench_key(i), i);
+     size_t lookups = agmax(c->n, (size_t)1 << 20);
+
+     bench_start(c);
+     uint64_t found = 0;
+     for(size_t i = 0; i < lookups; i++) {
+          uint64_t *v = bench_map_u64_find(map, bench_key((i * 7) % (2 * c->n)));
+          if(v != NULL) found += *v;
+     }
+     bench_stop(c);
+
+     bench_sink += found;
+     c->ops = lookups;
+     c->bytes_per_op = c->param;
+     bench_map_u64_clean(map);
+}
+
+static void
+bench_hashmap_find_sv(bench_case *c)
+{
+     ag_hashmap *map = hashmap_init_string_with_alloc(sizeof(size_t), &counting_alloc);
+     // "key-000...<i>", param bytes each
+     size_t stride = c->param + 1;
+     char *keys = (char*)malloc(c->n * stride);
+     for(size_t i = 0; i < c->n; i++) {
+          snprintf(keys + i * stride, stride, "key-%0*zu", (int)c->param - 4, i);
+          hashmap_put_sv(map, sv_from_buf(keys + i * stride, c->param), &i);
+     }
+     size_t lookups = agmax(c->n, (size_t)1 << 20);
+
+     bench_start(c);
+     uint64_t found = 0;
+     for(size_t i = 0; i < lookups; i++) {
+          size_t k = (i * 7) % c->n;
+          size_t *v = hashmap_find_sv(map, sv_from_buf(keys + k * stride, c->param));
+          if(v != NULL) found += *v;
+     }
+     bench_stop(c);
+
+     bench_sink += found;
+     c->ops = lookups;
+     c->bytes_per_op = c->param;
+     hashmap_clean(map);
+     free(keys);
+}
+
+// ---------------------------------------------------------------------------
+// Sort cases (param = element size, uint32_t keys)
+// ---------------------------------------------------------------------------
+
+static uint32_t*
+bench_random_u32(size_t n)
+{
+     uint32_t *keys = (uint32_t*)malloc(n * sizeof(uint32_t));
+     uint64_t seed = 0x9e3779b97f4a7c15ull;
+     for(size_t i = 0; i < n; i++) {
+          seed ^= seed << 13;
+          seed ^= seed >> 7;
+          seed ^= seed << 17;
+          keys[i] = (uint32_t)seed;
+     }
+     return keys;
+}
+
+static int
+bench_cmp_u32(const void *a, const void *b)
+{
+     uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+     return (x > y) - (x < y);
+}
+
+static void
+__bench_sort(bench_case *c, int which)
+{
+     uint32_t *keys = bench_random_u32(c->n);
+
+     bench_start(c);
+     switch(which) {
+     case 0:  qsort(keys, c->n, sizeof(uint32_t), bench_cmp_u32); break;
+     case 1:  ag_sort_u32_sort(keys, c->n); break;
+     case 2:  ag_sort_u32_stable_sort(keys, c->n); break;
+     default: ag_radix_sort_u32(keys, c->n); break;
+     }
+     bench_stop(c);
+
+     bench_sink += keys[c->n / 2];
+     c->ops = c->n;
+     c->bytes_per_op = c->param;
+     free(keys);
+}
+
+// One pool for the whole run, sized to the machine
+static ag_threadpool *bench_pool;
+
+static void
+bench_parallel_sort(bench_case *c)
+{
+     uint32_t *keys = bench_random_u32(c->n);
+
+     bench_start(c);
+     ag_sort_u32_parallel_sort(keys, c->n, bench_pool);
+     bench_stop(c);
+
+     bench_sink += keys[c->n / 2];
+     c->ops = c->n;
+     c->bytes_per_op = c->param;
+     free(keys);
+}
+
+static void bench_qsort(bench_case *c)       { __bench_sort(c, 0); }
+static void bench_sort(bench_case *c)        { __bench_sort(c, 1); }
+static void bench_stable_sort(bench_case *c) { __bench_sort(c, 2); }
+static void bench_radix_sort(bench_case *c)  { __bench_sort(c, 3); }
+
+// ---------------------------------------------------------------------------
+// Ring buffer cases (param = element size). Uncontended cost: one thread
+// moves n records through a 1024-slot ring, one by one or 16 at a time.
+// ---------------------------------------------------------------------------
+
+#define BENCH_RING_CAP 1024
+#define BENCH_RING_BATCH 16
+
+static void
+__bench_ringbuf(bench_case *c, bool spsc, bool batch)
+{
+     ag_ringbuf *ring = spsc ? ringbuf_init_spsc_with_alloc(BENCH_RING_CAP, c->param, &counting_alloc)
+                             : ringbuf_init_with_alloc(BENCH_RING_CAP, c->param, &counting_alloc);
+     byte *buf = (byte*)calloc(BENCH_RING_BATCH, c->param);
+
+     bench_start(c);
+     for(size_t done = 0; done < c->n;) {
+          size_t k = agmin(c->n - done, (size_t)BENCH_RING_CAP);
+          if(batch) {
+               for(size_t i = 0; i < k; i += BENCH_RING_BATCH)
+                    ringbuf_push_n(ring, buf, agmin(k - i, (size_t)BENCH_RING_BATCH));
+               for(size_t i = 0; i < k; i += BENCH_RING_BATCH)
+                    ringbuf_pop_n(ring, buf, agmin(k - i, (size_t)BENCH_RING_BATCH));
+          }
+          else {
+               for(size_t i = 0; i < k; i++) ringbuf_try_push(ring, buf);
+               for(size_t i = 0; i < k; i++) ringbuf_try_pop(ring, buf);
+          }
+          done += k;
+     }
+     bench_stop(c);
+
+     bench_sink += buf[0];
+     c->ops = c->n;
+     c->bytes_per_op = c->param;
+     free(buf);
+     ringbuf_clean(ring);
+}
+
+static void bench_ringbuf_mpmc(bench_case *c)       { __bench_ringbuf(c, false, false); }
+static void bench_ringbuf_mpmc_batch(bench_case *c) { __bench_ringbuf(c, false, true); }
+static void bench_ringbuf_spsc(bench_case *c)       { __bench_ringbuf(c, true, false); }
+static void bench_ringbuf_spsc_batch(bench_case *c) { __bench_ringbuf(c, true, true); }
+
+// ---------------------------------------------------------------------------
+// Short-lived vectors of BENCH_SMALL_N elements (param = element size):
+// heap vector vs ag_small_vector with inline storage for all of them
+// ---------------------------------------------------------------------------
+
+#define BENCH_SMALL_N 16
+
+static void
+__bench_small(bench_case *c, bool inline_storage)
+{
+     byte elem[BENCH_MAX_ELEM] = {1};
+     ag_small_vector(byte, BENCH_SMALL_N * BENCH_MAX_ELEM) small;
+     size_t rounds = c->n / BENCH_SMALL_N;
+
+     bench_start(c);
+     for(size_t r = 0; r < rounds; r++) {
+          vector *vec = inline_storage
+               ? __vec_init_inline(&small.vec, small.storage, BENCH_SMALL_N, c->param, &counting_alloc)
+               : __vec_init_with_alloc(0, c->param, false, &counting_alloc);
+          for(size_t i = 0; i < BENCH_SMALL_N; i++) {
+               elem[0] = (byte)i;
+               __vec_push_back(vec, elem);
+          }
+          bench_sink += ((byte*)vec->data)[c->param];
+          __vec_clean(vec);
+     }
+     bench_stop(c);
+
+     c->ops = rounds * BENCH_SMALL_N;
+     c->bytes_per_op = c->param;
+}
+
+static void bench_vec_push_back_16(bench_case *c)   { __bench_small(c, false); }
+static void bench_small_vec_push_back(bench_case *c) { __bench_small(c, true); }
+
+// ---------------------------------------------------------------------------
+// Deque cases (param = element size)
+// ---------------------------------------------------------------------------
+
+static void
+__bench_deque_push(bench_case *c, bool front)
+{
+     byte elem[BENCH_MAX_ELEM] = {1};
+     ag_deque *dq = __deque_init(c->param, &counting_alloc);
+
+     bench_start(c);
+     for(size_t i = 0; i < c->n; i++) {
+          elem[0] = (byte)i;
+          if(front) __deque_push_front(dq, elem);
+          else __deque_push_back(dq, elem);
+     }
+     bench_stop(c);
+
+     bench_sink += dq->size;
+     c->ops = c->n;
+     c->bytes_per_op = c->param;
+     __deque_clean(dq);
+}
+
+static void bench_deque_push_back(bench_case *c)  { __bench_deque_push(c, false); }
+static void bench_deque_push_front(bench_case *c) { __bench_deque_push(c, true); }
+
+// ---------------------------------------------------------------------------
+// Bit vector cases (n = bits, about half set)
+// ---------------------------------------------------------------------------
+
+static ag_bitvec*
+bench_random_bits(size_t n)
+{
+     ag_bitvec *bv = bitvec_init_with_alloc(n, &counting_alloc);
+     uint64_t seed = 0x2545f4914f6cdd1dull;
+     for(size_t i = 0; i < (n + 63) / 64; i++) {
+          seed ^= seed << 13;
+          seed ^= seed >> 7;
+          seed ^= seed << 17;
+          bv->words[i] = seed;
+     }
+     bitvec_resize(bv, n); // clears the bits past n
+     return bv;
+}
+
+// Whole-vector passes, repeated to cover about 2^26 bits
+static void
+__bench_bitvec_bulk(bench_case *c, bool count)
+{
+     ag_bitvec *a = bench_random_bits(c->n);
+     ag_bitvec *b = bench_random_bits(c->n);
+     size_t passes = agmax(((size_t)1 << 26) / c->n, (size_t)1);
+
+     bench_start(c);
+     size_t total = 0;
+     for(size_t p = 0; p < passes; p++) {
+          if(count) total += bitvec_count(a);
+          else bitvec_and(a, b);
+     }
+     bench_stop(c);
+
+     bench_sink += total + a->words[0];
+     c->ops = passes * c->n;
+     c->bytes_per_op = 0;
+     bitvec_clean(a);
+     bitvec_clean(b);
+}
+
+// Random rank or select queries, param = 1 with the directory built. A scan
+// reads n/2 bits per query on average, so it gets fewer queries.
+static void
+__bench_bitvec_query(bench_case *c, bool select)
+{
+     ag_bitvec *bv = bench_random_bits(c->n);
+     if(c->param) bitvec_build_rank(bv);
+     size_t ones = bitvec_count(bv);
+     size_t queries = c->param ? (size_t)1 << 20 : agmax(((size_t)1 << 32) / c->n, (size_t)16);
+
+     bench_start(c);
+     size_t total = 0;
+     for(size_t i = 0; i < queries; i++) {
+          size_t q = (i * 0x9e3779b97f4a7c15ull) >> 20;
+          total += select ? bitvec_select(bv, q % ones) : bitvec_rank(bv, q % c->n);
+     }
+     bench_stop(c);
+
+     bench_sink += total;
+     c->ops = queries;
+     c->bytes_per_op = 0;
+     bitvec_clean(bv);
+}
+
+static void bench_bitvec_count(bench_case *c)  { __bench_bitvec_bulk(c, true); }
+static void bench_bitvec_and(bench_case *c)    { __bench_bitvec_bulk(c, false); }
+static void bench_bitvec_rank(bench_case *c)   { __bench_bitvec_query(c, false); }
+static void bench_bitvec_select(bench_case *c) { __bench_bitvec_query(c, true); }
+
+// ---------------------------------------------------------------------------
+// Main
+// ---------------------------------------------------------------------------
+
+static void
+bench_usage(const char *argv0)
+{
+     fprintf(stderr, "usage: %s [--reps N] [--quick] [--perf] [--filter substr]\n", argv0);
+     exit(EXIT_FAILURE);
+}
+
+int
+main(int argc, char **argv)
+{
+     for(int i = 1; i < argc; i++) {
+          if(strcmp(argv[i], "--reps") == 0 && i + 1 < argc) config.reps = (unsigned)atoi(argv[++i]);
+          else if(strcmp(argv[i], "--quick") == 0) config.quick = true;
+          else if(strcmp(argv[i], "--perf") == 0) config.perf = true;
+          else if(strcmp(argv[i], "--filter") == 0 && i + 1 < argc) config.filter = argv[++i];
+          else bench_usage(argv[0]);
+     }
+     if(config.reps == 0) config.reps = 1;
+
+     bench_perf perf = { -1, -1 };
+     bool perf_ok = config.perf && bench_perf_open(&perf);
+     if(config.perf && !perf_ok)
+          fprintf(stderr, "bench: perf_event_open unavailable, counters reported as null\n");
+
+     const size_t elem_sizes[] = { 4, 8, 32, 64 };
+     const size_t grow_ns[] = { 1000, 100000, 1000000 };
+     const size_t quick_grow_ns[] = { 1000, 10000 };
+     const size_t shift_ns[] = { 1000, 10000, 50000 };
+     const size_t quick_shift_ns[] = { 1000, 5000 };
+
+     const size_t *grow = config.quick ? quick_grow_ns : grow_ns;
+     size_t grow_count = config.quick ? bench_countof(quick_grow_ns) : bench_countof(grow_ns);
+     const size_t *shift = config.quick ? quick_shift_ns : shift_ns;
+     size_t shift_count = config.quick ? bench_countof(quick_shift_ns) : bench_countof(shift_ns);
+
+     printf("{\n  \"suite\": \"aegis\",\n  \"reps\": %u,\n  \"quick\": %s,\n  \"perf\": %s,\n  \"results\": [",
+            config.reps, config.quick ? "true" : "false", perf_ok ? "true" : "false");
+
+     static const struct { const char *name; bench_fn fn; bool shifts; } vec_cases[] = {
+          { "vec_push_back",          bench_vec_push_back,          false },
+          { "vec_push_back_reserved", bench_vec_push_back_reserved, false },
+          { "vec_push_back_n",        bench_vec_push_back_n,        false },
+          { "vec_fill",               bench_vec_fill,               false },
+          { "vec_insert_front",       bench_vec_insert_front,       true },
+          { "vec_insert_middle",      bench_vec_insert_middle,      true },
+          { "vec_insert_back",        bench_vec_insert_back,        true },
+          { "vec_erase_front",        bench_vec_erase_front,        true },
+          { "vec_erase_middle",       bench_vec_erase_middle,       true },
+          { "vec_erase_back",         bench_vec_erase_back,         true },
+     };
+     for(size_t k = 0; k < bench_countof(vec_cases); k++) {
+          // O(n^2) cases get smaller N
+          const size_t *ns = vec_cases[k].shifts ? shift : grow;
+          size_t ns_count = vec_cases[k].shifts ? shift_count : grow_count;
+          for(size_t e = 0; e < bench_countof(elem_sizes); e++)
+               for(size_t i = 0; i < ns_count; i++)
+                    bench_run(vec_cases[k].fn, vec_cases[k].name, "elem_size", elem_sizes[e], ns[i], &perf);
+     }
+
+     const size_t chunks[] = { 1, 16, 256 };
+     for(size_t e = 0; e < bench_countof(chunks); e++)
+          for(size_t i = 0; i < grow_count; i++)
+               bench_run(bench_string_append, "string_append", "chunk_len", chunks[e], grow[i], &perf);
+     for(size_t e = 0; e < bench_countof(chunks); e++)
+          for(size_t i = 0; i < grow_count; i++)
+               bench_run(bench_strbuilder_append, "strbuilder_append", "chunk_len", chunks[e], grow[i], &perf);
+
+     const size_t sub_lens[] = { 8, 64, 1024 };
+     for(size_t e = 0; e < bench_countof(sub_lens); e++)
+          bench_run(bench_sub_string, "sub_string", "sub_len", sub_lens[e], config.quick ? 10000 : 100000, &perf);
+
+     const size_t needle_lens[] = { 1, 8, 64 };
+     const size_t hay_lens[] = { 64, 4096, 1 << 20 };
+     for(size_t e = 0; e < bench_countof(needle_lens); e++)
+          for(size_t i = 0; i < bench_countof(hay_lens); i++)
+               bench_run(bench_find_substr, "find_substr", "needle_len", needle_lens[e], hay_lens[i], &perf);
+
+     const size_t token_lens[] = { 4, 32, 256 };
+     for(size_t e = 0; e < bench_countof(token_lens); e++) {
+          bench_run(bench_split_any, "split_any", "token_len", token_lens[e], 1 << 20, &perf);
+          bench_run(bench_split_lines, "split_lines", "token_len", token_lens[e], 1 << 20, &perf);
+     }
+
+     const size_t distinct[] = { 1000, 100000 };
+     for(size_t e = 0; e < bench_countof(distinct); e++) {
+          bench_run(bench_intern_sv, "intern_sv", "distinct", distinct[e], 1 << 20, &perf);
+          bench_run(bench_intern_tokens, "intern_tokens", "distinct", distinct[e], 1 << 20, &perf);
+     }
+
+     const size_t non_ascii[] = { 0, 10, 100 };
+     for(size_t e = 0; e < bench_countof(non_ascii); e++) {
+          bench_run(bench_utf8_validate, "utf8_validate", "non_ascii_pct", non_ascii[e], 1 << 20, &perf);
+          bench_run(bench_utf8_to_utf16, "utf8_to_utf16", "non_ascii_pct", non_ascii[e], 1 << 20, &perf);
+     }
+
+     const size_t line_lens[] = { 32, 256 };
+     for(size_t e = 0; e < bench_countof(line_lens); e++) {
+          bench_run(bench_fgets_lines, "fgets_lines", "line_len", line_lens[e], 1 << 24, &perf);
+          bench_run(bench_reader_lines, "reader_lines", "line_len", line_lens[e], 1 << 24, &perf);
+          bench_run(bench_reader_lines_mmap, "reader_lines_mmap", "line_len", line_lens[e], 1 << 24, &perf);
+     }
+
+     for(size_t i = 0; i < grow_count; i++) {
+          bench_run(bench_hashmap_insert, "hashmap_insert", "key_size", sizeof(uint64_t), grow[i], &perf);
+          bench_run(bench_hashmap_find, "hashmap_find", "key_size", sizeof(uint64_t), grow[i], &perf);
+          bench_run(bench_hashmap_find_sv, "hashmap_find_sv", "key_size", 16, grow[i], &perf);
+     }
+
+     for(size_t i = 0; i < grow_count; i++) {
+          bench_run(bench_qsort, "qsort", "elem_size", sizeof(uint32_t), grow[i], &perf);
+          bench_run(bench_sort, "vec_sort", "elem_size", sizeof(uint32_t), grow[i], &perf);
+          bench_run(bench_stable_sort, "vec_stable_sort", "elem_size", sizeof(uint32_t), grow[i], &perf);
+          bench_run(bench_radix_sort, "vec_radix_sort", "elem_size", sizeof(uint32_t), grow[i], &perf);
+     }
+
+     for(size_t e = 0; e < bench_countof(elem_sizes); e++) {
+          for(size_t i = 0; i < grow_count; i++) {
+               bench_run(bench_vec_push_back_16, "vec_push_back_16", "elem_size", elem_sizes[e], grow[i], &perf);
+               bench_run(bench_small_vec_push_back, "small_vec_push_back", "elem_size", elem_sizes[e], grow[i], &perf);
+               bench_run(bench_deque_push_back, "deque_push_back", "elem_size", elem_sizes[e], grow[i], &perf);
+               bench_run(bench_deque_push_front, "deque_push_front", "elem_size", elem_sizes[e], grow[i], &perf);
+          }
+     }
+
+     for(size_t e = 0; e < bench_countof(elem_sizes); e++) {
+          for(size_t i = 0; i < grow_count; i++) {
+               bench_run(bench_ringbuf_mpmc, "ringbuf_mpmc", "elem_size", elem_sizes[e], grow[i], &perf);
+               bench_run(bench_ringbuf_mpmc_batch, "ringbuf_mpmc_batch", "elem_size", elem_sizes[e], grow[i], &perf);
+               bench_run(bench_ringbuf_spsc, "ringbuf_spsc", "elem_size", elem_sizes[e], grow[i], &perf);
+               bench_run(bench_ringbuf_spsc_batch, "ringbuf_spsc_batch", "elem_size", elem_sizes[e], grow[i], &perf);
+          }
+     }
+
+     const size_t bit_ns[] = { (size_t)1 << 16, (size_t)1 << 20, (size_t)1 << 24 };
+     size_t bit_count = config.quick ? 2 : bench_countof(bit_ns);
+     for(size_t i = 0; i < bit_count; i++) {
+          bench_run(bench_bitvec_count, "bitvec_count", "indexed", 0, bit_ns[i], &perf);
+          bench_run(bench_bitvec_and, "bitvec_and", "indexed", 0, bit_ns[i], &perf);
+          for(size_t indexed = 0; indexed < 2; indexed++) {
+               bench_run(bench_bitvec_rank, "bitvec_rank", "indexed", indexed, bit_ns[i], &perf);
+               bench_run(bench_bitvec_select, "bitvec_select", "indexed", indexed, bit_ns[i], &perf);
+          }
+     }
+
+     bench_pool = ag_threadpool_init(0);
+     for(size_t i = 0; i < grow_count; i++)
+          bench_run(bench_parallel_sort, "vec_parallel_sort", "elem_size", sizeof(uint32_t), grow[i], &perf);
+     ag_threadpool_clean(bench_pool);
+
+     printf("\n  ]\n}\n");
+     bench_perf_close(&perf);
+     return (int)(bench_sink & 0);
+}
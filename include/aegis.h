@@ -2,7 +2,66 @@
 #ifndef AEGIS_H
 #define AEGIS_H
 
+/*
+ * Single translation unit mode: define AEGIS_IMPLEMENTATION in exactly
+ * one .c file and include this header there before any system header
+ * (the sources need _GNU_SOURCE). The whole library then compiles into
+ * that file, nothing needs linking but -lm -lpthread, and the compiler
+ * can inline every call without LTO. Other files include it plainly.
+ * Build with -I<aegis>/include. This needs the source tree: the .c files
+ * are included from ../src, and the aegis.h installed by CMake carries no
+ * sources, so there AEGIS_IMPLEMENTATION stops with an #error.
+ */
+#if defined(AEGIS_IMPLEMENTATION) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
+#include "aegis/aegis_allocator.h"
+#include "aegis/aegis_bitvec.h"
+#include "aegis/aegis_common.h"
+#include "aegis/aegis_deque.h"
+#include "aegis/aegis_hash.h"
+#include "aegis/aegis_hashmap.h"
+#include "aegis/aegis_intern.h"
+#include "aegis/aegis_io.h"
+#include "aegis/aegis_numformat.h"
+#include "aegis/aegis_numparse.h"
+#include "aegis/aegis_ringbuf.h"
+#include "aegis/aegis_search.h"
+#include "aegis/aegis_sort.h"
+#include "aegis/aegis_split.h"
+#include "aegis/aegis_stats.h"
+#include "aegis/aegis_strbuilder.h"
+#include "aegis/aegis_string.h"
+#include "aegis/aegis_string_view.h"
+#include "aegis/aegis_threadpool.h"
+#include "aegis/aegis_typed_vector.h"
+#include "aegis/aegis_utf8.h"
 #include "aegis/aegis_utils.h"
 #include "aegis/aegis_vector.h"
 
+#ifdef AEGIS_IMPLEMENTATION
+#include "../src/aegis_allocator.c"
+#include "../src/aegis_bitvec.c"
+#include "../src/aegis_deque.c"
+#include "../src/aegis_hash.c"
+#include "../src/aegis_hashmap.c"
+#include "../src/aegis_intern.c"
+#include "../src/aegis_io.c"
+#include "../src/aegis_numformat.c"
+#include "../src/aegis_numparse.c"
+#include "../src/aegis_ringbuf.c"
+#include "../src/aegis_search.c"
+#include "../src/aegis_sort.c"
+#include "../src/aegis_split.c"
+#include "../src/aegis_stats.c"
+#include "../src/aegis_strbuilder.c"
+#include "../src/aegis_string.c"
+#include "../src/aegis_string_view.c"
+#include "../src/aegis_threadpool.c"
+#include "../src/aegis_utf8.c"
+#include "../src/aegis_utils.c"
+#include "../src/aegis_vector.c"
+#endif /* AEGIS_IMPLEMENTATION */
+
 #endif /* AEGIS_H */
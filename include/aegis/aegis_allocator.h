@@ -0,0 +1,62 @@
+#ifndef AEGIS_ALLOCATOR_H
+#define AEGIS_ALLOCATOR_H
+
+#include "aegis_common.h"
+
+// Allocator interface used by every container.
+//
+// `size` / `old_size` are always the exact byte counts the container asked
+// for earlier, so backends never need to store per-block headers.
+typedef struct __AG_ALLOCATOR__{
+     void* (*alloc)  (void *ctx, size_t size);
+     void* (*realloc)(void *ctx, void *ptr, size_t old_size, size_t new_size);
+     void  (*free)   (void *ctx, void *ptr, size_t size);
+     void *ctx;          // Backend state, passed back to every call
+} ag_allocator;
+
+// malloc / realloc / free
+extern ag_allocator ag_default_allocator;
+
+#define ag_alloc(__alloc__, size) \
+          ((__alloc__)->alloc((__alloc__)->ctx, size))
+
+#define ag_realloc(__alloc__, ptr, old_size, new_size) \
+          ((__alloc__)->realloc((__alloc__)->ctx, ptr, old_size, new_size))
+
+#define ag_free(__alloc__, ptr, size) \
+          ((__alloc__)->free((__alloc__)->ctx, ptr, size))
+
+
+// Bump arena.
+// Allocation is a pointer bump, free is a no-op (except for the most recent
+// block) and ag_arena_reset() releases everything at once while keeping the
+// chunks for the next round.
+typedef struct __AG_ARENA_CHUNK__ ag_arena_chunk;
+
+typedef struct __AG_ARENA__{
+     ag_allocator allocator;  // Pass &arena->allocator to *_with_alloc
+     ag_arena_chunk *first;
+     ag_arena_chunk *current;
+     size_t chunk_size;       // Default capacity of a new chunk in bytes
+} ag_arena;
+
+ag_arena *ag_arena_init(size_t chunk_size);
+void ag_arena_reset(ag_arena *arena);
+void ag_arena_clean(ag_arena *arena);
+
+
+// Fixed-size block pool.
+// Requests up to block_size bytes are served from a free list carved out of
+// slabs; larger requests fall through to ag_default_allocator.
+typedef struct __AG_POOL__{
+     ag_allocator allocator;  // Pass &pool->allocator to *_with_alloc
+     size_t block_size;
+     size_t blocks_per_slab;
+     void *free_list;
+     void *slabs;
+} ag_pool;
+
+ag_pool *ag_pool_init(size_t block_size, size_t blocks_per_slab);
+void ag_pool_clean(ag_pool *pool);
+
+#endif //AEGIS_ALLOCATOR_H
@@ -0,0 +1,121 @@
+#ifndef AEGIS_BITVEC_H
+#define AEGIS_BITVEC_H
+
+#include "aegis_common.h"
+#include "aegis_allocator.h"
+
+// Packed bit vector.
+//
+// Bits live in 64-bit words, bit i in words[i / 64] at position i % 64.
+// Allocated bits past size are always zero, so whole-word loops
+// (count, bulk operations, searches) never need a tail mask. Bulk operations
+// and popcount use AVX2 when the CPU has it (picked at runtime), else the
+// POPCNT instruction, else plain C.
+//
+// Rank and select work on any bit vector by scanning. bitvec_build_rank adds
+// a directory (one 64-bit count per 512 bits plus a sampled select table,
+// about 12.5% extra space) that makes rank O(1) and select a short search.
+// The directory describes the bits at build time: rebuild it after changing
+// bits; resizing drops it.
+//
+// Syntax => ag_bitvec *bv = bitvec_init(1000000);
+//           bitvec_set(bv, 42);
+//           bitvec_and(bv, other);              // bv &= other
+//           for(size_t i = bitvec_find_first(bv); i != AG_NPOS; i = bitvec_find_next(bv, i + 1))
+
+#ifndef AG_NPOS
+#define AG_NPOS ((size_t)-1) // same sentinel as aegis_string_view.h
+#endif
+
+#define AG_BITVEC_WORD_BITS 64
+#define AG_BITVEC_RANK_BLOCK 512    // bits per rank directory entry
+#define AG_BITVEC_SELECT_SAMPLE 4096 // set bits per select sample
+
+typedef struct __AG_BITVEC__{
+     // private read-only
+     uint64_t *words;
+     size_t size;             // Number of bits
+     size_t capacity;         // Allocated words
+     ag_allocator *allocator;
+
+     // Rank/select directory, NULL until bitvec_build_rank
+     uint64_t *rank;          // Set bits before each AG_BITVEC_RANK_BLOCK, plus the total
+     size_t *select;          // Rank block holding set bit k * AG_BITVEC_SELECT_SAMPLE
+     size_t rank_blocks;
+     size_t select_samples;
+} ag_bitvec;
+
+#define __BITVEC_WORDS(nbits) (((nbits) + AG_BITVEC_WORD_BITS - 1) / AG_BITVEC_WORD_BITS)
+
+ag_bitvec *bitvec_init(size_t nbits);
+ag_bitvec *bitvec_init_with_alloc(size_t nbits, ag_allocator *alloc);
+void bitvec_clean(ag_bitvec *bv);
+
+// New bits are zero
+void bitvec_resize(ag_bitvec *bv, size_t nbits);
+void bitvec_push_back(ag_bitvec *bv, bool bit);
+
+void bitvec_set_all(ag_bitvec *bv);
+void bitvec_clear_all(ag_bitvec *bv);
+void bitvec_not(ag_bitvec *bv);
+
+// Whole-vector operations, dst and src must have the same size
+void bitvec_and(ag_bitvec *dst, const ag_bitvec *src);
+void bitvec_or(ag_bitvec *dst, const ag_bitvec *src);
+void bitvec_xor(ag_bitvec *dst, const ag_bitvec *src);
+void bitvec_andnot(ag_bitvec *dst, const ag_bitvec *src); // dst &= ~src
+
+size_t bitvec_count(const ag_bitvec *bv);
+
+// First set bit at index >= from, or AG_NPOS
+size_t bitvec_find_next(const ag_bitvec *bv, size_t from);
+
+// Set bits in [0, pos)
+size_t bitvec_rank(const ag_bitvec *bv, size_t pos);
+// Index of the set bit with rank k (0-based), or AG_NPOS
+size_t bitvec_select(const ag_bitvec *bv, size_t k);
+void bitvec_build_rank(ag_bitvec *bv);
+void bitvec_drop_rank(ag_bitvec *bv);
+
+#define bitvec_size(__bv__) ((__bv__)->size)
+#define bitvec_find_first(__bv__) bitvec_find_next(__bv__, 0)
+
+static inline bool
+bitvec_test(const ag_bitvec *bv, size_t i)
+{
+     assert(i < bv->size);
+     return (bv->words[i / AG_BITVEC_WORD_BITS] >> (i % AG_BITVEC_WORD_BITS)) & 1;
+}
+
+static inline void
+bitvec_set(ag_bitvec *bv, size_t i)
+{
+     assert(i < bv->size);
+     bv->words[i / AG_BITVEC_WORD_BITS] |= (uint64_t)1 << (i % AG_BITVEC_WORD_BITS);
+}
+
+static inline void
+bitvec_clear(ag_bitvec *bv, size_t i)
+{
+     assert(i < bv->size);
+     bv->words[i / AG_BITVEC_WORD_BITS] &= ~((uint64_t)1 << (i % AG_BITVEC_WORD_BITS));
+}
+
+static inline void
+bitvec_flip(ag_bitvec *bv, size_t i)
+{
+     assert(i < bv->size);
+     bv->words[i / AG_BITVEC_WORD_BITS] ^= (uint64_t)1 << (i % AG_BITVEC_WORD_BITS);
+}
+
+// Branch-free set-or-clear
+static inline void
+bitvec_assign(ag_bitvec *bv, size_t i, bool bit)
+{
+     assert(i < bv->size);
+     uint64_t mask = (uint64_t)1 << (i % AG_BITVEC_WORD_BITS);
+     uint64_t *w = &bv->words[i / AG_BITVEC_WORD_BITS];
+     *w = (*w & ~mask) | (-(uint64_t)bit & mask);
+}
+
+#endif //AEGIS_BITVEC_H
@@ -14,5 +14,9 @@
 // represent 1 byte (8-bits)
 typedef unsigned char byte;
 
+// Rarely taken slow paths (growth): kept out of line and out of the hot
+// code layout, so the inline fast paths around them stay small
+#define AG_COLD __attribute__((cold, noinline))
+
 
 #endif// AEGIS_COMMON_H
@@ -0,0 +1,124 @@
+#ifndef AEGIS_DEQUE_H
+#define AEGIS_DEQUE_H
+
+#include "aegis_vector.h"
+#include "aegis_utils.h"
+
+// Segmented double-ended queue.
+//
+// Elements live in fixed-size blocks reached through a block index (a ring
+// of block pointers). Growing at either end adds a block and at most moves
+// the index pointers, never an element, so element addresses stay valid
+// until that element is popped, and no push pays for copying the contents.
+// Blocks hold a power-of-two count of elements so indexing is a shift and a
+// mask. One emptied block is kept to avoid alloc/free churn at a boundary.
+//
+// Syntax => ag_deque *dq = deque_init(int);
+//           deque_push_back(dq, int, 1);
+//           deque_push_front(dq, int, 0);
+//           int *p = deque_at_ptr(dq, 1);    // stays valid while 1 is stored
+//
+//           size_t it = 0, n; void *run;
+//           while(deque_next_block(dq, &it, &run, &n)) ... // n contiguous elements
+
+// Target block size in bytes, at least AG_DEQUE_MIN_BLOCK_ELEMS elements
+#ifndef AG_DEQUE_BLOCK_BYTES
+#define AG_DEQUE_BLOCK_BYTES 4096
+#endif
+#define AG_DEQUE_MIN_BLOCK_ELEMS 16
+
+typedef struct __AG_DEQUE__{
+     // private read-only
+     byte **blocks;           // Block index, a ring of index_capacity pointers
+     size_t index_capacity;   // Power of two, 0 before the first block
+     size_t first_block;      // Ring slot of the front block
+     size_t nblocks;          // Blocks in use
+     size_t start;            // Position of the front element in the front block
+     size_t size;
+     size_t element_size;
+     size_t block_shift;      // log2(elements per block)
+     byte *spare;             // One empty block kept for reuse
+     ag_allocator *allocator;
+} ag_deque;
+
+// User API .
+
+#define deque_init(type) \
+          __deque_init(sizeof(type), &ag_default_allocator)
+
+#define deque_init_with_alloc(type, alloc) \
+          __deque_init(sizeof(type), alloc)
+
+#define deque_clean(__dq__) \
+          __deque_clean(__dq__)
+
+#define deque_clear(__dq__) \
+          __deque_clear(__dq__)
+
+#define deque_size(__dq__) ((__dq__)->size)
+#define deque_empty(__dq__) ((__dq__)->size == 0)
+#define deque_block_elems(__dq__) ((size_t)1 << (__dq__)->block_shift)
+
+// Push returns the address of the new element
+#define deque_push_back(__dq__, type, val) \
+          __deque_push_back(__dq__, vec_wrap_val(type, val))
+
+#define deque_push_front(__dq__, type, val) \
+          __deque_push_front(__dq__, vec_wrap_val(type, val))
+
+#define deque_push_back_n(__dq__, src, n) \
+          __deque_push_back_n(__dq__, src, n)
+
+#define deque_pop_back(__dq__) \
+          __deque_pop_back(__dq__)
+
+#define deque_pop_front(__dq__) \
+          __deque_pop_front(__dq__)
+
+#define deque_at_ptr(__dq__, index) \
+          __deque_at_ptr(__dq__, index)
+
+#define deque_at(__dq__, type, index) \
+          (*(type*)__deque_at_ptr(__dq__, index))
+
+#define deque_front(__dq__, type) deque_at(__dq__, type, 0)
+#define deque_back(__dq__, type) deque_at(__dq__, type, (__dq__)->size - 1)
+
+// Contiguous runs in order: *data gets the run starting at element *it,
+// *count its length, and *it moves past it. False once *it reaches size.
+#define deque_next_block(__dq__, it, data, count) \
+          __deque_next_block(__dq__, it, data, count)
+
+// Core Functions
+ag_deque *__deque_init(size_t element_size, ag_allocator *alloc);
+void __deque_clean(ag_deque *dq);
+void __deque_clear(ag_deque *dq);
+
+void *__deque_push_back(ag_deque *dq, const void *val);
+void *__deque_push_front(ag_deque *dq, const void *val);
+void __deque_push_back_n(ag_deque *dq, const void *src, size_t n);
+void __deque_pop_back(ag_deque *dq);
+void __deque_pop_front(ag_deque *dq);
+
+static inline void*
+__deque_at_ptr(const ag_deque *dq, size_t index)
+{
+     assert(index < dq->size);
+     size_t pos = dq->start + index;
+     byte *block = dq->blocks[(dq->first_block + (pos >> dq->block_shift)) & (dq->index_capacity - 1)];
+     return block + (pos & (((size_t)1 << dq->block_shift) - 1)) * dq->element_size;
+}
+
+static inline bool
+__deque_next_block(const ag_deque *dq, size_t *it, void **data, size_t *count)
+{
+     if(*it >= dq->size) return false;
+     size_t offset = (dq->start + *it) & (((size_t)1 << dq->block_shift) - 1);
+     size_t n = agmin(((size_t)1 << dq->block_shift) - offset, dq->size - *it);
+     *data = __deque_at_ptr(dq, *it);
+     *count = n;
+     *it += n;
+     return true;
+}
+
+#endif //AEGIS_DEQUE_H
@@ -0,0 +1,21 @@
+#ifndef AEGIS_HASH_H
+#define AEGIS_HASH_H
+
+#include "aegis_common.h"
+
+// Fast non-cryptographic hashing (wyhash-style 64x64->128 multiply mixing).
+// Not suitable where attackers control keys and can pick the seed.
+
+#define AG_HASH_SEED 0
+
+uint64_t ag_hash_bytes(const void *data, size_t len, uint64_t seed);
+
+// Finalizer for integer keys
+static inline uint64_t
+ag_hash_u64(uint64_t x)
+{
+     __uint128_t r = (__uint128_t)(x ^ 0x2d358dccaa6c78a5ull) * 0x8bb84b93962eacc9ull;
+     return (uint64_t)r ^ (uint64_t)(r >> 64);
+}
+
+#endif //AEGIS_HASH_H
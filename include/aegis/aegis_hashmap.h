@@ -0,0 +1,239 @@
+#ifndef AEGIS_HASHMAP_H
+#define AEGIS_HASHMAP_H
+
+#include "aegis_string_view.h"
+#include "aegis_hash.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Open-addressing hash map, Swiss-table style.
+//
+// Every slot has a control byte holding AG_HMAP_EMPTY or a 7-bit tag taken
+// from the top of the key's hash. A lookup compares 16 control bytes at once
+// (one SSE2 compare) and only touches slots whose tag matches. Probing is
+// linear over slots and erase shifts the following entries back, so there
+// are no tombstones: a lookup ends at the first empty slot it sees.
+//
+// Keys and values are stored inline, `key_size` and `value_size` bytes per
+// entry, like vector elements. Byte keys are hashed and compared bytewise
+// (zero any struct padding). Maps made with hashmap_init_string own copies of
+// ag_string keys and are queried with ag_string_view.
+//
+// Pointers returned by find / insert stay valid until the next insert, erase
+// or rehash.
+//
+// Syntax => ag_hashmap *m = hashmap_init(sizeof(int), sizeof(double));
+//           int k = 7; double v = 1.5;
+//           hashmap_put(m, &k, &v);
+//           double *found = hashmap_find(m, &k);
+//
+// AG_HASHMAP_DEFINE(name, K, V) generates a typed flavor whose lookups are
+// specialized for sizeof(K) at compile time.
+
+#define AG_HMAP_GROUP 16
+#define AG_HMAP_EMPTY ((int8_t)-128)
+
+// Map flags
+#define AG_HMAP_STRING_KEYS (1u << 0) // keys are owned ag_strings
+
+typedef struct __AG_HASHMAP__{
+     int8_t *ctrl;            // capacity + AG_HMAP_GROUP control bytes, the tail mirrors the head
+     uint32_t *hashes;        // Low hash bits per slot, for rehash and erase without rehashing keys
+     byte *slots;             // capacity * slot_size bytes of key / value pairs
+
+     // private read-only
+     size_t size;             // Number of entries
+     size_t capacity;         // Number of slots, 0 or a power of two >= AG_HMAP_GROUP
+     size_t key_size;
+     size_t value_size;
+     size_t value_offset;     // Offset of the value inside a slot
+     size_t slot_size;
+     ag_allocator *allocator; // Owner of the header, the table and string keys
+     unsigned int flags;      // AG_HMAP_* flags
+} ag_hashmap;
+
+ag_hashmap *hashmap_init(size_t key_size, size_t value_size);
+ag_hashmap *hashmap_init_with_alloc(size_t key_size, size_t value_size, ag_allocator *alloc);
+ag_hashmap *hashmap_init_string(size_t value_size);
+ag_hashmap *hashmap_init_string_with_alloc(size_t value_size, ag_allocator *alloc);
+void hashmap_clean(ag_hashmap *map);
+void hashmap_clear(ag_hashmap *map);
+
+// Room for n entries without a rehash
+void hashmap_reserve(ag_hashmap *map, size_t n);
+// Resizes the table to the smallest valid capacity >= `capacity` that also
+// fits the current entries (so it can shrink, hashmap_rehash(m, 0) is a
+// shrink-to-fit)
+void hashmap_rehash(ag_hashmap *map, size_t capacity);
+
+// Byte keys. find returns the value or NULL; insert returns the value slot
+// of key, adding a zeroed value if it was missing; put inserts or assigns.
+// The *_hashed variants take hashmap_hash(map, key) computed earlier.
+uint64_t hashmap_hash(const ag_hashmap *map, const void *key);
+void *hashmap_find(const ag_hashmap *map, const void *key);
+void *hashmap_find_hashed(const ag_hashmap *map, const void *key, uint64_t hash);
+void *hashmap_insert(ag_hashmap *map, const void *key, bool *inserted);
+void *hashmap_insert_hashed(ag_hashmap *map, const void *key, uint64_t hash, bool *inserted);
+void hashmap_put(ag_hashmap *map, const void *key, const void *value);
+bool hashmap_erase(ag_hashmap *map, const void *key);
+
+// ag_string keys, same contract. A new key is copied with the map's allocator.
+void *hashmap_find_sv(const ag_hashmap *map, ag_string_view key);
+void *hashmap_find_sv_hashed(const ag_hashmap *map, ag_string_view key, uint64_t hash);
+void *hashmap_insert_sv(ag_hashmap *map, ag_string_view key, bool *inserted);
+void *hashmap_insert_sv_hashed(ag_hashmap *map, ag_string_view key, uint64_t hash, bool *inserted);
+void hashmap_put_sv(ag_hashmap *map, ag_string_view key, const void *value);
+bool hashmap_erase_sv(ag_hashmap *map, ag_string_view key);
+
+static inline uint64_t
+hashmap_hash_sv(ag_string_view key)
+{
+     return sv_hash(key);
+}
+
+// Iteration in slot order, start with *it = 0:
+// for(size_t it = 0; hashmap_next(m, &it, &k, &v);) ...
+// For string maps *key points at the stored ag_string.
+bool hashmap_next(const ag_hashmap *map, size_t *it, void **key, void **value);
+
+#define hashmap_size(__map__) ((__map__)->size)
+
+// ---------------------------------------------------------------------------
+// Probe core, inline so the typed flavor folds key_size into it
+// ---------------------------------------------------------------------------
+
+// Bit i set where ctrl[i] == tag, for the 16 bytes at ctrl
+static inline uint32_t
+__hmap_match(const int8_t *ctrl, int8_t tag)
+{
+#if defined(__SSE2__)
+     __m128i group = _mm_loadu_si128((const __m128i*)ctrl);
+     return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(tag)));
+#else
+     uint32_t mask = 0;
+     for(int i = 0; i < AG_HMAP_GROUP; i++)
+          mask |= (uint32_t)(ctrl[i] == tag) << i;
+     return mask;
+#endif
+}
+
+static inline int8_t
+__hmap_tag(uint64_t hash)
+{
+     return (int8_t)(hash >> 57);
+}
+
+static inline uint64_t
+__hmap_hash_bytes(const void *key, size_t key_size)
+{
+     if(key_size == 8) {
+          uint64_t k;
+          memcpy(&k, key, 8);
+          return ag_hash_u64(k);
+     }
+     if(key_size == 4) {
+          uint32_t k;
+          memcpy(&k, key, 4);
+          return ag_hash_u64(k);
+     }
+     return ag_hash_bytes(key, key_size, AG_HASH_SEED);
+}
+
+// Slot index of a byte key, or AG_NPOS
+static inline size_t
+__hmap_probe_bytes(const ag_hashmap *map, const void *key, size_t key_size, uint64_t hash)
+{
+     if(map->size == 0) return AG_NPOS;
+
+     size_t mask = map->capacity - 1;
+     size_t pos = (size_t)hash & mask;
+     int8_t tag = __hmap_tag(hash);
+     for(;;) {
+          uint32_t match = __hmap_match(map->ctrl + pos, tag);
+          uint32_t empty = __hmap_match(map->ctrl + pos, AG_HMAP_EMPTY);
+          // Slots past the first empty one belong to other probe runs
+          if(empty) match &= (empty & (0u - empty)) - 1;
+          while(match) {
+               size_t i = (pos + (size_t)__builtin_ctz(match)) & mask;
+               if(memcmp(map->slots + i * map->slot_size, key, key_size) == 0) return i;
+               match &= match - 1;
+          }
+          if(empty) return AG_NPOS;
+          pos = (pos + AG_HMAP_GROUP) & mask;
+     }
+}
+
+// Slot index of the new (or existing) entry, *inserted tells which
+size_t __hmap_insert_bytes(ag_hashmap *map, const void *key, uint64_t hash, bool *inserted);
+
+// ---------------------------------------------------------------------------
+// Typed flavor
+// ---------------------------------------------------------------------------
+
+// Syntax => AG_HASHMAP_DEFINE(ag_map_u64_int, uint64_t, int)
+//           ag_map_u64_int *m = ag_map_u64_int_init();
+//           ag_map_u64_int_put(m, 42, 7);
+//           int *v = ag_map_u64_int_find(m, 42);
+#define AG_HASHMAP_DEFINE(name, K, V)                                            \
+typedef struct { ag_hashmap base; } name;                                        \
+                                                                                 \
+static inline name *                                                             \
+name##_init(void) { return (name*)hashmap_init(sizeof(K), sizeof(V)); }          \
+                                                                                 \
+static inline name *                                                             \
+name##_init_with_alloc(ag_allocator *alloc)                                      \
+{                                                                                \
+     return (name*)hashmap_init_with_alloc(sizeof(K), sizeof(V), alloc);         \
+}                                                                                \
+                                                                                 \
+static inline void                                                               \
+name##_clean(name *map) { hashmap_clean(&map->base); }                           \
+                                                                                 \
+static inline void                                                               \
+name##_clear(name *map) { hashmap_clear(&map->base); }                           \
+                                                                                 \
+static inline void                                                               \
+name##_reserve(name *map, size_t n) { hashmap_reserve(&map->base, n); }          \
+                                                                                 \
+static inline size_t                                                             \
+name##_size(const name *map) { return map->base.size; }                          \
+                                                                                 \
+static inline uint64_t                                                           \
+name##_hash(K key) { return __hmap_hash_bytes(&key, sizeof(K)); }                \
+                                                                                 \
+static inline V *                                                                \
+name##_find_hashed(const name *map, K key, uint64_t hash)                        \
+{                                                                                \
+     size_t i = __hmap_probe_bytes(&map->base, &key, sizeof(K), hash);           \
+     if(i == AG_NPOS) return NULL;                                               \
+     return (V*)(map->base.slots + i * map->base.slot_size + map->base.value_offset);\
+}                                                                                \
+                                                                                 \
+static inline V *                                                                \
+name##_find(const name *map, K key)                                              \
+{                                                                                \
+     return name##_find_hashed(map, key, name##_hash(key));                      \
+}                                                                                \
+                                                                                 \
+static inline bool                                                               \
+name##_contains(const name *map, K key) { return name##_find(map, key) != NULL; }\
+                                                                                 \
+static inline V *                                                                \
+name##_insert(name *map, K key, bool *inserted)                                  \
+{                                                                                \
+     size_t i = __hmap_insert_bytes(&map->base, &key, name##_hash(key), inserted);\
+     return (V*)(map->base.slots + i * map->base.slot_size + map->base.value_offset);\
+}                                                                                \
+                                                                                 \
+static inline void                                                               \
+name##_put(name *map, K key, V val)                                              \
+{                                                                                \
+     *name##_insert(map, key, NULL) = val;                                       \
+}                                                                                \
+                                                                                 \
+static inline bool                                                               \
+name##_erase(name *map, K key) { return hashmap_erase(&map->base, &key); }
+
+#endif //AEGIS_HASHMAP_H
@@ -0,0 +1,79 @@
+#ifndef AEGIS_INTERN_H
+#define AEGIS_INTERN_H
+
+#include "aegis_split.h"
+#include "aegis_hash.h"
+
+// String interning pool.
+//
+// Each distinct string is stored once, NUL-terminated, in an arena together
+// with its hash, and named by a 32-bit id; equal strings get equal ids, so
+// comparing interned strings is comparing integers. Entries never move or
+// die before intern_clean, so the entry pointers are stable too.
+//
+// The pool is split into AG_INTERN_SHARDS shards picked by hash bits, each
+// with its own table, arena and read-write lock: lookups of present strings
+// take a read lock, only first sightings take a write lock, and threads
+// interning different strings rarely meet on a lock. Going from an id back
+// to its string takes no lock at all.
+//
+// Syntax => ag_intern *pool = intern_init();
+//           uint32_t a = intern_sv(pool, sv_from_cstr("GET"));
+//           uint32_t b = intern_cstr(pool, method);
+//           if(a == b) ...
+//           printf("%s\n", intern_entry(pool, a)->data);
+//           intern_clean(pool);
+
+#define AG_INTERN_SHARD_BITS 4
+#define AG_INTERN_SHARDS (1u << AG_INTERN_SHARD_BITS)
+#define AG_INTERN_NONE UINT32_MAX // intern_find_sv miss
+
+typedef struct __AG_INTERN__ ag_intern;
+
+typedef struct __AG_INTERNED__{
+     uint64_t hash;           // sv_hash of the bytes
+     uint32_t size;
+     uint32_t id;
+     char data[];             // size bytes and a NUL
+} ag_interned;
+
+ag_intern *intern_init(void);
+void intern_clean(ag_intern *pool);
+
+// Id of s, adding it on first sight. Strings must be shorter than 4 GiB.
+uint32_t intern_sv(ag_intern *pool, ag_string_view s);
+// hash = sv_hash(s) computed earlier
+uint32_t intern_sv_hashed(ag_intern *pool, ag_string_view s, uint64_t hash);
+// Id of s if present, AG_INTERN_NONE otherwise; never adds
+uint32_t intern_find_sv(ag_intern *pool, ag_string_view s);
+
+// Interns every ag_token of tokens (a vector of ag_token into src, as
+// sv_split produces) and writes the ids to ids[0 .. tokens->size). Works in
+// batches that take each shard's lock once per batch.
+void intern_tokens(ag_intern *pool, ag_string_view src, const vector *tokens, uint32_t *ids);
+
+// Entry of an id returned by this pool, lock-free
+const ag_interned *intern_entry(const ag_intern *pool, uint32_t id);
+// Number of distinct strings
+size_t intern_size(const ag_intern *pool);
+
+static inline uint32_t
+intern_cstr(ag_intern *pool, const char *cstr)
+{
+     return intern_sv(pool, sv_from_cstr(cstr));
+}
+
+static inline ag_string_view
+intern_view(const ag_intern *pool, uint32_t id)
+{
+     const ag_interned *e = intern_entry(pool, id);
+     return (ag_string_view){ e->data, e->size };
+}
+
+static inline uint64_t
+intern_hash(const ag_intern *pool, uint32_t id)
+{
+     return intern_entry(pool, id)->hash;
+}
+
+#endif //AEGIS_INTERN_H
@@ -0,0 +1,81 @@
+#ifndef AEGIS_IO_H
+#define AEGIS_IO_H
+
+#include "aegis_string_view.h"
+
+// Buffered file input and output.
+//
+// ag_reader fills one reusable ag_string buffer with large read(2) calls (or
+// maps the whole file with AG_READER_MMAP) and hands out lines and records as
+// views into it: nothing is allocated per line. A record that straddles two
+// reads is moved to the front of the buffer and completed by the next read;
+// a record longer than the buffer grows it. Delimiters are found with memchr,
+// which glibc vectorizes.
+//
+// A view stays valid until the next call on the reader (for mapped files,
+// until reader_close). Lines follow sv_lines: "\n" ends a line, a "\r" before
+// it is dropped, and a final line ending does not start another line.
+//
+// ag_writer gathers output in its buffer and writes it out when full; pieces
+// larger than half the buffer go straight to write(2) after a flush.
+//
+// Syntax => ag_reader *in = reader_open("access.log", 0);
+//           ag_string_view line;
+//           while(reader_next_line(in, &line)) ...
+//           if(reader_error(in)) perror("access.log");
+//           reader_close(in);
+//
+//           ag_writer *out = writer_open("out.txt", 0);
+//           writer_write(out, line);
+//           writer_write_char(out, '\n');
+//           if(!writer_close(out)) ...      // flushes, false if any write failed
+
+#define AG_IO_BUFFER (256 << 10) // Default buffer size, bytes
+
+#define AG_READER_MMAP (1u << 0) // Map the file instead of reading it (falls back to reads)
+
+#define AG_WRITER_APPEND (1u << 0) // writer_open appends instead of truncating
+
+typedef struct __AG_READER__ ag_reader;
+typedef struct __AG_WRITER__ ag_writer;
+
+// NULL with errno set when the file cannot be opened
+ag_reader *reader_open(const char *path, unsigned flags);
+// Reads fd (left open by reader_close); buffer_size 0 picks AG_IO_BUFFER
+ag_reader *reader_from_fd(int fd, size_t buffer_size, unsigned flags);
+void reader_close(ag_reader *r);
+
+// Next line / record ending in delim into *out, false at the end of the input
+// or on a read error
+bool reader_next_line(ag_reader *r, ag_string_view *out);
+bool reader_next_record(ag_reader *r, char delim, ag_string_view *out);
+// errno of the failed read, 0 if none
+int reader_error(const ag_reader *r);
+
+// NULL with errno set when the file cannot be created
+ag_writer *writer_open(const char *path, unsigned flags);
+// Writes to fd (left open by writer_close); buffer_size 0 picks AG_IO_BUFFER
+ag_writer *writer_from_fd(int fd, size_t buffer_size);
+// Flushes and frees; false if any write failed
+bool writer_close(ag_writer *w);
+
+// False once a write has failed; later writes are dropped
+bool writer_write(ag_writer *w, ag_string_view s);
+bool writer_write_char(ag_writer *w, char c);
+bool writer_flush(ag_writer *w);
+// errno of the failed write, 0 if none
+int writer_error(const ag_writer *w);
+
+static inline bool
+writer_write_string(ag_writer *w, const ag_string str)
+{
+     return writer_write(w, sv_from_string(str));
+}
+
+static inline bool
+writer_write_cstr(ag_writer *w, const char *cstr)
+{
+     return writer_write(w, sv_from_cstr(cstr));
+}
+
+#endif //AEGIS_IO_H
@@ -0,0 +1,32 @@
+#ifndef AEGIS_NUMFORMAT_H
+#define AEGIS_NUMFORMAT_H
+
+#include "aegis_string.h"
+
+// Locale-independent number formatting straight into an ag_string's spare
+// capacity (at most one growth per call, no temporary buffers).
+//
+// Doubles use Grisu2: the output always parses back to the same double and
+// is the shortest such digit string in all but rare cases. Format:
+//   123.0   0.001   1.5e-07 -> "1.5e-7"   1e+21 -> "1e21"   nan   inf   -inf
+
+// Worst-case output lengths, for callers formatting into their own buffers
+#define AG_FORMAT_U64_MAX    20
+#define AG_FORMAT_I64_MAX    21
+#define AG_FORMAT_DOUBLE_MAX 25
+
+// Raw formatters, no terminator written, return the length
+size_t ag_format_u64(char *buf, uint64_t v);
+size_t ag_format_i64(char *buf, int64_t v);
+size_t ag_format_double(char *buf, double v);
+
+void string_append_int(ag_string str, long long v);
+void string_append_u64(ag_string str, uint64_t v);
+void string_append_double(ag_string str, double v);
+
+// printf-style append through vsnprintf (uses the C locale settings of the
+// process for %f & co.), grows the string at most once
+void string_appendf(ag_string str, const char *fmt, ...)
+     __attribute__((format(printf, 2, 3)));
+
+#endif //AEGIS_NUMFORMAT_H
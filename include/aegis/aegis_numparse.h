@@ -0,0 +1,41 @@
+#ifndef AEGIS_NUMPARSE_H
+#define AEGIS_NUMPARSE_H
+
+#include "aegis_string_view.h"
+
+// Locale-independent number parsing on views and ag_strings.
+//
+// Integers read 8 digits per step with SWAR arithmetic. Floating point uses
+// Clinger's fast path when exact, then Eisel-Lemire (exactly rounded with a
+// 128-bit power-of-five table); only inputs with more than 19 significant
+// digits that land on a rounding boundary fall back to strtod in the "C"
+// locale.
+//
+// Accepted syntax: optional leading whitespace, optional sign, decimal digits,
+// for floats an optional fraction / exponent and inf, infinity, nan
+// (any case). Parsing stops at the first byte that does not fit.
+
+typedef enum {
+     AG_PARSE_OK = 0,
+     AG_PARSE_INVALID,   // no number at the start of the input, *out untouched
+     AG_PARSE_OVERFLOW,  // out of range, *out is clamped (or +-inf for floats)
+} ag_parse_status;
+
+typedef struct {
+     ag_parse_status status;
+     size_t consumed;    // bytes read, including leading whitespace (0 if INVALID)
+} ag_parse_result;
+
+ag_parse_result sv_parse_int(ag_string_view sv, int *out);
+ag_parse_result sv_parse_ll(ag_string_view sv, long long *out);
+ag_parse_result sv_parse_i64(ag_string_view sv, int64_t *out);
+ag_parse_result sv_parse_u64(ag_string_view sv, uint64_t *out);
+ag_parse_result sv_parse_f(ag_string_view sv, float *out);
+ag_parse_result sv_parse_d(ag_string_view sv, double *out);
+ag_parse_result sv_parse_ld(ag_string_view sv, long double *out);
+
+// sto_int / sto_ll / sto_f / sto_d / sto_ld (aegis_string.h) use these and
+// return 0 when the string holds no number; call sv_parse_* directly to
+// see the status and consumed length.
+
+#endif //AEGIS_NUMPARSE_H
@@ -0,0 +1,76 @@
+#ifndef AEGIS_RINGBUF_H
+#define AEGIS_RINGBUF_H
+
+#include "aegis_vector.h"
+
+#include <stdatomic.h>
+
+// Bounded lock-free queue of element_size-byte records.
+//
+// ringbuf_init makes a multi-producer / multi-consumer ring (Vyukov's
+// bounded queue: every cell carries a sequence number telling producers and
+// consumers whose turn it is, so each operation is one CAS on the shared
+// position plus plain copies). ringbuf_init_spsc makes a ring for exactly
+// one producer thread and one consumer thread: no CAS, no per-cell sequence,
+// each side only rereads the other's position when its cached copy says the
+// ring looks full / empty, and batches are at most two memcpy.
+//
+// Capacity is rounded up to a power of two. Nothing blocks: push fails on a
+// full ring and pop on an empty one. The shared positions sit on their own
+// cache lines.
+//
+// Syntax => ag_ringbuf *q = ringbuf_init(1024, sizeof(record));
+//           ringbuf_try_push(q, &rec);          // false when full
+//           ringbuf_push(q, int, 42);           // value form
+//           while(ringbuf_try_pop(q, &rec)) ... // false when empty
+
+#define AG_RING_PAD 64
+
+// Ring flags
+#define AG_RING_SPSC (1u << 0) // single producer / single consumer layout
+
+typedef struct __AG_RINGBUF__{
+     // private read-only
+     byte *cells;
+     size_t capacity;         // Power of two
+     size_t element_size;
+     size_t cell_size;        // Stride of cells, element_size for SPSC rings
+     size_t data_offset;      // Offset of the record inside a cell
+     ag_allocator *allocator;
+     unsigned int flags;      // AG_RING_* flags
+
+     byte __pad0[AG_RING_PAD];
+     _Atomic size_t head;     // Next position to write
+     size_t cached_tail;      // SPSC: producer's copy of tail
+     byte __pad1[AG_RING_PAD];
+     _Atomic size_t tail;     // Next position to read
+     size_t cached_head;      // SPSC: consumer's copy of head
+     byte __pad2[AG_RING_PAD];
+} ag_ringbuf;
+
+ag_ringbuf *ringbuf_init(size_t capacity, size_t element_size);
+ag_ringbuf *ringbuf_init_with_alloc(size_t capacity, size_t element_size, ag_allocator *alloc);
+ag_ringbuf *ringbuf_init_spsc(size_t capacity, size_t element_size);
+ag_ringbuf *ringbuf_init_spsc_with_alloc(size_t capacity, size_t element_size, ag_allocator *alloc);
+void ringbuf_clean(ag_ringbuf *ring);
+
+bool ringbuf_try_push(ag_ringbuf *ring, const void *elem);
+bool ringbuf_try_pop(ag_ringbuf *ring, void *out);
+
+// Batches move up to n contiguous records and return how many moved. On an
+// MPMC ring the records of one batch stay adjacent in queue order.
+size_t ringbuf_push_n(ag_ringbuf *ring, const void *src, size_t n);
+size_t ringbuf_pop_n(ag_ringbuf *ring, void *dst, size_t n);
+
+// Exact when quiescent, a snapshot otherwise
+size_t ringbuf_size(const ag_ringbuf *ring);
+
+#define ringbuf_capacity(__ring__) ((__ring__)->capacity)
+#define ringbuf_empty(__ring__) (ringbuf_size(__ring__) == 0)
+
+// User API .
+
+#define ringbuf_push(__ring__, type, val) \
+          ringbuf_try_push(__ring__, vec_wrap_val(type, val))
+
+#endif //AEGIS_RINGBUF_H
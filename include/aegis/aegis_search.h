@@ -0,0 +1,35 @@
+#ifndef AEGIS_SEARCH_H
+#define AEGIS_SEARCH_H
+
+#include "aegis_string_view.h"
+
+// Length-aware substring search.
+//
+// Needles of 1 byte go to memchr, needles up to AG_SEARCH_SHORT_NEEDLE bytes
+// use a SIMD first/last-byte filter (AVX2 or SSE2, picked at runtime) with a
+// memcmp on candidates, longer needles use Two-Way (linear worst case, no
+// allocation). None of this needs NUL-terminated input.
+
+#ifndef AG_SEARCH_SHORT_NEEDLE
+#define AG_SEARCH_SHORT_NEEDLE 32
+#endif
+
+// First / last occurrence of needle in hay, or NULL. An empty needle
+// matches at hay (ag_memmem) or at hay + hlen (ag_memrmem).
+const char *ag_memmem(const char *hay, size_t hlen, const char *needle, size_t nlen);
+const char *ag_memrmem(const char *hay, size_t hlen, const char *needle, size_t nlen);
+
+// View variants, offsets or AG_NPOS. count / find_all report
+// non-overlapping matches scanning left to right.
+size_t sv_rfind(ag_string_view hay, ag_string_view needle);
+size_t sv_count(ag_string_view hay, ag_string_view needle);
+// Pushes each match offset (size_t) into out, returns the number of matches
+size_t sv_find_all(ag_string_view hay, ag_string_view needle, vector *out);
+
+// ag_string variants
+size_t string_find(const ag_string str, ag_string_view needle);
+size_t string_rfind(const ag_string str, ag_string_view needle);
+size_t string_count(const ag_string str, ag_string_view needle);
+size_t string_find_all(const ag_string str, ag_string_view needle, vector *out);
+
+#endif //AEGIS_SEARCH_H
@@ -0,0 +1,358 @@
+#ifndef AEGIS_SORT_H
+#define AEGIS_SORT_H
+
+#include "aegis_vector.h"
+
+// Type-specialized sorting and searching.
+//
+// AG_SORT_DEFINE(name, type, less) generates a family of `static inline`
+// functions on `type*` arrays with `less` inlined, plus vector wrappers used
+// by the vec_sort / vec_lower_bound / ... macros below. `less(a, b)` is any
+// function or function-like macro taking two values and defining a strict
+// weak ordering (so no NaN with AG_LESS on floats).
+//
+//   name_sort(a, n)              introsort, not stable
+//   name_stable_sort(a, n)       merge sort, n/2 elements of scratch
+//   name_lower_bound(a, n, key)  first index with !less(a[i], key)
+//   name_upper_bound(a, n, key)  first index with less(key, a[i])
+//   name_binary_search(a, n, key)
+//   name_nth_element(a, n, k)    a[k] in sorted position, smaller before it
+//   name_unique(a, n)            drops consecutive equivalents, returns new n
+//
+// Syntax => AG_SORT_DEFINE(by_score, entry, ENTRY_LESS)
+//           vec_sort(v, by_score);
+//           size_t i = vec_lower_bound(v, by_score, probe);
+//
+// Families for the common scalar types are predefined: ag_sort_int,
+// ag_sort_uint, ag_sort_i32, ag_sort_u32, ag_sort_i64, ag_sort_u64,
+// ag_sort_size, ag_sort_float and ag_sort_double.
+//
+// The ag_radix_sort_* functions are LSD radix sorts for plain integer and
+// floating-point arrays (floats in IEEE total order: -nan < -inf < ... < -0.0
+// < 0.0 < ... < inf < nan).
+
+#define AG_LESS(a, b) ((a) < (b))
+#define AG_GREATER(a, b) ((b) < (a))
+
+// Ranges up to this many elements are finished with insertion sort
+#define AG_SORT_INSERTION_MAX 16
+
+// User API .
+
+#define vec_sort(__ptrvec__, name) name##_vec_sort(__ptrvec__)
+
+#define vec_stable_sort(__ptrvec__, name) name##_vec_stable_sort(__ptrvec__)
+
+#define vec_lower_bound(__ptrvec__, name, key) \
+          name##_vec_lower_bound(__ptrvec__, key)
+
+#define vec_upper_bound(__ptrvec__, name, key) \
+          name##_vec_upper_bound(__ptrvec__, key)
+
+#define vec_binary_search(__ptrvec__, name, key) \
+          name##_vec_binary_search(__ptrvec__, key)
+
+#define vec_nth_element(__ptrvec__, name, k) \
+          name##_vec_nth_element(__ptrvec__, k)
+
+// Shrinks the vector to the unique prefix, returns the new size
+#define vec_unique(__ptrvec__, name) name##_vec_unique(__ptrvec__)
+
+// kind is one of u32, i32, u64, i64, f32, f64
+#define vec_radix_sort(__ptrvec__, kind) \
+          __vec_radix_sort_##kind(__ptrvec__)
+
+// Radix sorts, stable, scratch of n elements from malloc. Small inputs and
+// failed scratch allocations fall back to a comparison sort.
+void ag_radix_sort_u32(uint32_t *a, size_t n);
+void ag_radix_sort_i32(int32_t *a, size_t n);
+void ag_radix_sort_u64(uint64_t *a, size_t n);
+void ag_radix_sort_i64(int64_t *a, size_t n);
+void ag_radix_sort_f32(float *a, size_t n);
+void ag_radix_sort_f64(double *a, size_t n);
+
+#define __AG_RADIX_VEC(kind, type)                                               \
+static inline void                                                               \
+__vec_radix_sort_##kind(vector *vec)                                             \
+{                                                                                \
+     assert(vec->element_size == sizeof(type));                                  \
+     ag_radix_sort_##kind((type*)vec->data, vec->size);                          \
+}
+
+__AG_RADIX_VEC(u32, uint32_t)
+__AG_RADIX_VEC(i32, int32_t)
+__AG_RADIX_VEC(u64, uint64_t)
+__AG_RADIX_VEC(i64, int64_t)
+__AG_RADIX_VEC(f32, float)
+__AG_RADIX_VEC(f64, double)
+
+#define AG_SORT_DEFINE(name, type, less)                                         \
+                                                                                 \
+static inline void                                                               \
+name##_insertion_sort(type *a, size_t n)                                         \
+{                                                                                \
+     for(size_t i = 1; i < n; i++) {                                             \
+          type val = a[i];                                                       \
+          size_t j = i;                                                          \
+          for(; j > 0 && less(val, a[j - 1]); j--)                               \
+               a[j] = a[j - 1];                                                  \
+          a[j] = val;                                                            \
+     }                                                                           \
+}                                                                                \
+                                                                                 \
+static inline void                                                               \
+name##_sift_down(type *a, size_t root, size_t n)                                 \
+{                                                                                \
+     type val = a[root];                                                         \
+     for(size_t child; (child = 2 * root + 1) < n; root = child) {               \
+          if(child + 1 < n && less(a[child], a[child + 1])) child++;             \
+          if(!less(val, a[child])) break;                                        \
+          a[root] = a[child];                                                    \
+     }                                                                           \
+     a[root] = val;                                                              \
+}                                                                                \
+                                                                                 \
+static inline void                                                               \
+name##_heap_sort(type *a, size_t n)                                              \
+{                                                                                \
+     for(size_t i = n / 2; i-- > 0;)                                             \
+          name##_sift_down(a, i, n);                                             \
+     for(size_t end = n; end-- > 1;) {                                           \
+          type top = a[0];                                                       \
+          a[0] = a[end];                                                         \
+          a[end] = top;                                                          \
+          name##_sift_down(a, 0, end);                                           \
+     }                                                                           \
+}                                                                                \
+                                                                                 \
+/* Orders a[i] <= a[j] <= a[k] */                                                \
+static inline void                                                               \
+name##_sort3(type *a, size_t i, size_t j, size_t k)                              \
+{                                                                                \
+     type t;                                                                     \
+     if(less(a[j], a[i])) { t = a[i]; a[i] = a[j]; a[j] = t; }                   \
+     if(less(a[k], a[j])) {                                                      \
+          t = a[j]; a[j] = a[k]; a[k] = t;                                       \
+          if(less(a[j], a[i])) { t = a[i]; a[i] = a[j]; a[j] = t; }              \
+     }                                                                           \
+}                                                                                \
+                                                                                 \
+/* Hoare partition around the median of 3 (ninther for large n), placed at */    \
+/* the middle. Returns p with [0, p) <= pivot <= [p, n), 0 < p < n. */           \
+static inline size_t                                                             \
+name##_partition(type *a, size_t n)                                              \
+{                                                                                \
+     size_t mid = (n - 1) / 2;                                                   \
+     if(n >= 128) {                                                              \
+          size_t s = n / 8;                                                      \
+          name##_sort3(a, 0, s, 2 * s);                                          \
+          name##_sort3(a, mid - s, mid, mid + s);                                \
+          name##_sort3(a, n - 1 - 2 * s, n - 1 - s, n - 1);                      \
+          name##_sort3(a, s, mid, n - 1 - s);                                    \
+     }                                                                           \
+     else name##_sort3(a, 0, mid, n - 1);                                        \
+                                                                                 \
+     type pivot = a[mid];                                                        \
+     size_t i = (size_t)-1, j = n;                                               \
+     for(;;) {                                                                   \
+          do i++; while(less(a[i], pivot));                                      \
+          do j--; while(less(pivot, a[j]));                                      \
+          if(i >= j) return j + 1;                                               \
+          type t = a[i]; a[i] = a[j]; a[j] = t;                                  \
+     }                                                                           \
+}                                                                                \
+                                                                                 \
+static inline void                                                               \
+name##_introsort(type *a, size_t n, int depth)                                   \
+{                                                                                \
+     while(n > AG_SORT_INSERTION_MAX) {                                          \
+          if(depth-- == 0) {                                                     \
+               name##_heap_sort(a, n);                                           \
+               return;                                                           \
+          }                                                                      \
+          size_t p = name##_partition(a, n);                                     \
+          /* Recurse into the smaller side, loop on the larger */                \
+          if(p < n - p) {                                                        \
+               name##_introsort(a, p, depth);                                    \
+               a += p;                                                           \
+               n -= p;                                                           \
+          }                                                                      \
+          else {                                                                 \
+               name##_introsort(a + p, n - p, depth);                            \
+               n = p;                                                            \
+          }                                                                      \
+     }                                                                           \
+     name##_insertion_sort(a, n);                                                \
+}                                                                                \
+                                                                                 \
+static inline void                                                               \
+name##_sort(type *a, size_t n)                                                   \
+{                                                                                \
+     if(n < 2) return;                                                           \
+     int depth = 2 * (63 - __builtin_clzll((unsigned long long)n));              \
+     name##_introsort(a, n, depth);                                              \
+}                                                                                \
+                                                                                 \
+static inline void                                                               \
+name##_merge_sort(type *a, size_t n, type *buf)                                  \
+{                                                                                \
+     if(n <= AG_SORT_INSERTION_MAX) {                                            \
+          name##_insertion_sort(a, n);                                           \
+          return;                                                                \
+     }                                                                           \
+     size_t mid = n / 2;                                                         \
+     name##_merge_sort(a, mid, buf);                                             \
+     name##_merge_sort(a + mid, n - mid, buf);                                   \
+     if(!less(a[mid], a[mid - 1])) return;                                       \
+                                                                                 \
+     /* Left half to scratch, merge back; ties take the left side */             \
+     memcpy(buf, a, mid * sizeof(type));                                         \
+     size_t i = 0, j = mid, k = 0;                                               \
+     while(i < mid && j < n) {                                                   \
+          if(less(a[j], buf[i])) a[k++] = a[j++];                                \
+          else a[k++] = buf[i++];                                                \
+     }                                                                           \
+     while(i < mid) a[k++] = buf[i++];                                           \
+}                                                                                \
+                                                                                 \
+static inline void                                                               \
+name##_stable_sort(type *a, size_t n)                                            \
+{                                                                                \
+     if(n <= AG_SORT_INSERTION_MAX) {                                            \
+          name##_insertion_sort(a, n);                                           \
+          return;                                                                \
+     }                                                                           \
+     type *buf = (type*)malloc((n / 2 + 1) * sizeof(type));                      \
+     if(buf == NULL) {                                                           \
+          fprintf(stderr, "Error: Memory allocation failed for stable sort\n");  \
+          exit(EXIT_FAILURE);                                                    \
+     }                                                                           \
+     name##_merge_sort(a, n, buf);                                               \
+     free(buf);                                                                  \
+}                                                                                \
+                                                                                 \
+static inline size_t                                                             \
+name##_lower_bound(const type *a, size_t n, type key)                            \
+{                                                                                \
+     if(n == 0) return 0;                                                        \
+     const type *base = a;                                                       \
+     /* Branch-free halving, compiles to cmov */                                 \
+     while(n > 1) {                                                              \
+          size_t half = n / 2;                                                   \
+          base = less(base[half], key) ? base + half : base;                     \
+          n -= half;                                                             \
+     }                                                                           \
+     return (size_t)(base - a) + (less(*base, key) ? 1 : 0);                     \
+}                                                                                \
+                                                                                 \
+static inline size_t                                                             \
+name##_upper_bound(const type *a, size_t n, type key)                            \
+{                                                                                \
+     if(n == 0) return 0;                                                        \
+     const type *base = a;                                                       \
+     while(n > 1) {                                                              \
+          size_t half = n / 2;                                                   \
+          base = less(key, base[half]) ? base : base + half;                     \
+          n -= half;                                                             \
+     }                                                                           \
+     return (size_t)(base - a) + (less(key, *base) ? 0 : 1);                     \
+}                                                                                \
+                                                                                 \
+static inline bool                                                               \
+name##_binary_search(const type *a, size_t n, type key)                          \
+{                                                                                \
+     size_t i = name##_lower_bound(a, n, key);                                   \
+     return i < n && !less(key, a[i]);                                           \
+}                                                                                \
+                                                                                 \
+static inline void                                                               \
+name##_nth_element(type *a, size_t n, size_t k)                                  \
+{                                                                                \
+     if(k >= n) return;                                                          \
+     int depth = n > 1 ? 2 * (63 - __builtin_clzll((unsigned long long)n)) : 0; \
+     while(n > AG_SORT_INSERTION_MAX) {                                          \
+          if(depth-- == 0) {                                                     \
+               name##_heap_sort(a, n);                                           \
+               return;                                                           \
+          }                                                                      \
+          size_t p = name##_partition(a, n);                                     \
+          if(k < p) n = p;                                                       \
+          else {                                                                 \
+               a += p;                                                           \
+               n -= p;                                                           \
+               k -= p;                                                           \
+          }                                                                      \
+     }                                                                           \
+     name##_insertion_sort(a, n);                                                \
+}                                                                                \
+                                                                                 \
+static inline size_t                                                             \
+name##_unique(type *a, size_t n)                                                 \
+{                                                                                \
+     if(n == 0) return 0;                                                        \
+     size_t w = 1;                                                               \
+     for(size_t i = 1; i < n; i++) {                                             \
+          if(less(a[w - 1], a[i]) || less(a[i], a[w - 1]))                       \
+               a[w++] = a[i];                                                    \
+     }                                                                           \
+     return w;                                                                   \
+}                                                                                \
+                                                                                 \
+static inline void                                                               \
+name##_vec_sort(vector *vec)                                                     \
+{                                                                                \
+     assert(vec->element_size == sizeof(type));                                  \
+     name##_sort((type*)vec->data, vec->size);                                   \
+}                                                                                \
+                                                                                 \
+static inline void                                                               \
+name##_vec_stable_sort(vector *vec)                                              \
+{                                                                                \
+     assert(vec->element_size == sizeof(type));                                  \
+     name##_stable_sort((type*)vec->data, vec->size);                            \
+}                                                                                \
+                                                                                 \
+static inline size_t                                                             \
+name##_vec_lower_bound(const vector *vec, type key)                              \
+{                                                                                \
+     return name##_lower_bound((const type*)vec->data, vec->size, key);          \
+}                                                                                \
+                                                                                 \
+static inline size_t                                                             \
+name##_vec_upper_bound(const vector *vec, type key)                              \
+{                                                                                \
+     return name##_upper_bound((const type*)vec->data, vec->size, key);          \
+}                                                                                \
+                                                                                 \
+static inline bool                                                               \
+name##_vec_binary_search(const vector *vec, type key)                            \
+{                                                                                \
+     return name##_binary_search((const type*)vec->data, vec->size, key);        \
+}                                                                                \
+                                                                                 \
+static inline void                                                               \
+name##_vec_nth_element(vector *vec, size_t k)                                    \
+{                                                                                \
+     assert(vec->element_size == sizeof(type));                                  \
+     name##_nth_element((type*)vec->data, vec->size, k);                         \
+}                                                                                \
+                                                                                 \
+static inline size_t                                                             \
+name##_vec_unique(vector *vec)                                                   \
+{                                                                                \
+     assert(vec->element_size == sizeof(type));                                  \
+     vec->size = name##_unique((type*)vec->data, vec->size);                     \
+     return vec->size;                                                           \
+}
+
+AG_SORT_DEFINE(ag_sort_int, int, AG_LESS)
+AG_SORT_DEFINE(ag_sort_uint, unsigned int, AG_LESS)
+AG_SORT_DEFINE(ag_sort_i32, int32_t, AG_LESS)
+AG_SORT_DEFINE(ag_sort_u32, uint32_t, AG_LESS)
+AG_SORT_DEFINE(ag_sort_i64, int64_t, AG_LESS)
+AG_SORT_DEFINE(ag_sort_u64, uint64_t, AG_LESS)
+AG_SORT_DEFINE(ag_sort_size, size_t, AG_LESS)
+AG_SORT_DEFINE(ag_sort_float, float, AG_LESS)
+AG_SORT_DEFINE(ag_sort_double, double, AG_LESS)
+
+#endif //AEGIS_SORT_H
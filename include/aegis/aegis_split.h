@@ -0,0 +1,112 @@
+#ifndef AEGIS_SPLIT_H
+#define AEGIS_SPLIT_H
+
+#include "aegis_string_view.h"
+
+// Zero-copy tokenizing.
+//
+// Tokens are (offset, size) pairs into the source text, nothing is copied or
+// allocated per token. Byte delimiters (a single byte, a set of bytes, line
+// ends) are found by classifying 64 input bytes at a time into a bitmask
+// (AVX2 nibble lookup when the CPU has it, picked at runtime) and walking the
+// set bits; a multi-byte delimiter goes through ag_memmem.
+//
+// Like Python's str.split(sep): n delimiters give n + 1 tokens, empty ones
+// included, unless AG_SPLIT_SKIP_EMPTY is passed. Lines end at "\n" with an
+// optional "\r" before it, and a final line ending does not start another line.
+//
+// Syntax => vector *toks = vec_init(0, ag_token, false);
+//           string_split(csv_line, sv_from_cstr(","), 0, toks);
+//           ag_string_view field = sv_token(sv_from_string(csv_line), vec_at(toks, ag_token, 2));
+//
+//           ag_split_iter it;                   // streaming, no token list
+//           ag_string_view line;
+//           split_iter_init_lines(&it, text);
+//           while(split_next(&it, &line)) ...
+
+#define AG_SPLIT_SKIP_EMPTY (1u << 0) // drop empty tokens
+#define AG_SPLIT_LINES      (1u << 1) // line mode (set by split_iter_init_lines)
+
+typedef struct __AG_TOKEN__{
+     size_t offset;
+     size_t size;
+} ag_token;
+
+// Exact membership for all 256 byte values as two nibble lookup tables: byte
+// b is in the set when bit (b >> 4) & 7 of low8[b & 15] (b < 0x80) or of
+// high8[b & 15] (b >= 0x80) is set
+typedef struct __AG_BYTE_SET__{
+     uint8_t low8[16];
+     uint8_t high8[16];
+} ag_byte_set;
+
+typedef struct __AG_SPLIT_ITER__{
+     // private
+     ag_string_view src;
+     ag_string_view delim;    // Multi-byte delimiter, size 0 in byte-set mode
+     size_t pos;              // Start of the next token
+     size_t block;            // Offset of the 64-byte block mask describes
+     uint64_t mask;           // Unconsumed delimiters in that block
+     unsigned flags;
+     bool done;
+     ag_byte_set set;
+} ag_split_iter;
+
+static inline ag_string_view
+sv_token(ag_string_view src, ag_token tok)
+{
+     return (ag_string_view){ src.data + tok.offset, tok.size };
+}
+
+void byte_set_init(ag_byte_set *set, ag_string_view bytes);
+
+static inline bool
+byte_set_has(const ag_byte_set *set, unsigned char b)
+{
+     const uint8_t *table = (b & 0x80) ? set->high8 : set->low8;
+     return (table[b & 15] >> ((b >> 4) & 7)) & 1;
+}
+
+// Iterators keep a view of src: the text must outlive them
+void split_iter_init(ag_split_iter *it, ag_string_view src, ag_string_view delim, unsigned flags);
+void split_iter_init_any(ag_split_iter *it, ag_string_view src, ag_string_view delims, unsigned flags);
+void split_iter_init_lines(ag_split_iter *it, ag_string_view src);
+// Next token into *tok, false once the text is exhausted
+bool split_next(ag_split_iter *it, ag_string_view *tok);
+
+// Push each token (ag_token) into out, NULL only counts; returns the count
+size_t sv_split(ag_string_view src, ag_string_view delim, unsigned flags, vector *out);
+size_t sv_split_any(ag_string_view src, ag_string_view delims, unsigned flags, vector *out);
+size_t sv_lines(ag_string_view src, vector *out);
+
+// Concatenates the ag_string_view elements of parts with sep in between,
+// in one allocation
+ag_string sv_join(const vector *parts, ag_string_view sep);
+// Same for ag_token elements of src
+ag_string sv_join_tokens(ag_string_view src, const vector *tokens, ag_string_view sep);
+
+static inline size_t
+string_split(const ag_string str, ag_string_view delim, unsigned flags, vector *out)
+{
+     return sv_split(sv_from_string(str), delim, flags, out);
+}
+
+static inline size_t
+string_split_any(const ag_string str, ag_string_view delims, unsigned flags, vector *out)
+{
+     return sv_split_any(sv_from_string(str), delims, flags, out);
+}
+
+static inline size_t
+string_lines(const ag_string str, vector *out)
+{
+     return sv_lines(sv_from_string(str), out);
+}
+
+static inline ag_string
+string_join(const vector *parts, ag_string_view sep)
+{
+     return sv_join(parts, sep);
+}
+
+#endif //AEGIS_SPLIT_H
@@ -0,0 +1,95 @@
+#ifndef AEGIS_STATS_H
+#define AEGIS_STATS_H
+
+#include "aegis_common.h"
+
+// Allocation and growth statistics for vectors (and ag_strings, which are
+// vectors).
+//
+// Off unless the library and its users are built with -DAEGIS_STATS: then
+// every vector carries the call site that created it, and creation, each
+// capacity change and vec_clean update global and per-site counters (relaxed
+// atomics, safe from any thread) and call the hook if one is set. Without
+// AEGIS_STATS the hooks compile to nothing, vectors keep their usual layout
+// and the functions below only report that stats are disabled.
+//
+// The vec_init* / small_vec_init macros record their call site. Vectors made
+// elsewhere (new_string, library internals) count globally and can be
+// attributed with ag_stats_tag. Tagging a vector that already has a site
+// moves its live bytes to the new site; the old site keeps its event counts:
+//
+// Syntax => ag_string s = ag_stats_tag(new_string(""));
+//           ...
+//           ag_stats_dump(stderr);   // sites sorted by reallocations
+
+typedef struct __AG_STATS_COUNTERS__{
+     uint64_t inits;          // Vectors created
+     uint64_t frees;          // Vectors cleaned
+     uint64_t grows;          // Capacity increases
+     uint64_t shrinks;        // Capacity decreases (shrink_to_fit)
+     uint64_t bytes_copied;   // Live bytes moved to a new buffer by capacity changes
+     uint64_t waste_at_free;  // Sum of (capacity - size) bytes at vec_clean
+     uint64_t peak_capacity;  // Largest capacity of a single vector, bytes
+     uint64_t live_bytes;     // Capacity bytes of vectors not yet cleaned
+     uint64_t peak_live_bytes;
+} ag_stats_counters;
+
+typedef struct __AG_STATS_SITE__{
+     const char *file;
+     const char *func;
+     int line;
+     int registered;          // Linked into the site list on first event
+     struct __AG_STATS_SITE__ *next;
+     ag_stats_counters counters;
+} ag_stats_site;
+
+enum {
+     AG_STATS_INIT,
+     AG_STATS_GROW,
+     AG_STATS_SHRINK,
+     AG_STATS_FREE,
+};
+
+typedef struct __AG_STATS_EVENT__{
+     int kind;                // AG_STATS_*
+     const ag_stats_site *site; // NULL for untagged vectors
+     size_t element_size;
+     size_t old_capacity;     // Elements
+     size_t new_capacity;
+     size_t size;
+     bool copied;             // The data moved to a new buffer
+} ag_stats_event;
+
+typedef void (*ag_stats_hook)(const ag_stats_event *event, void *ctx);
+
+// Called on every event from the thread that caused it, NULL removes it
+void ag_stats_set_hook(ag_stats_hook hook, void *ctx);
+ag_stats_counters ag_stats_global(void);
+// Zeroes every counter except live_bytes
+void ag_stats_reset(void);
+// Global totals then one line per site, most reallocations first
+void ag_stats_dump(FILE *out);
+
+#ifdef AEGIS_STATS
+
+// One static site per expansion
+#define AG_STATS_SITE() \
+          ({ static ag_stats_site __ag_site = { __FILE__, __func__, __LINE__, 0, NULL, { 0 } }; &__ag_site; })
+
+#define ag_stats_tag(__ptrvec__) \
+          __ag_stats_tag(__ptrvec__, AG_STATS_SITE())
+
+// Vector struct member, see aegis_vector.h / aegis_typed_vector.h
+#define __AG_VEC_STATS_FIELD ag_stats_site *site;
+
+void __ag_stats_record(ag_stats_site *site, int kind, size_t element_size,
+                       size_t old_capacity, size_t new_capacity, size_t size, bool copied);
+
+#else
+
+#define ag_stats_tag(__ptrvec__) (__ptrvec__)
+#define __AG_VEC_STATS_FIELD
+
+#endif // AEGIS_STATS
+
+#endif //AEGIS_STATS_H
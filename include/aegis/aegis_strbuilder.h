@@ -0,0 +1,149 @@
+#ifndef AEGIS_STRBUILDER_H
+#define AEGIS_STRBUILDER_H
+
+#include "aegis_string_view.h"
+#include "aegis_utils.h"
+
+// String builder.
+//
+// Appends go into a chain of chunks that never move: a full chunk is left
+// where it is and the next one is twice as large (up to
+// AG_STRBUILDER_MAX_CHUNK), so building a long string copies each byte
+// once on append and once more into the final ag_string, which is sized
+// exactly. Every append takes an explicit length, nothing calls strlen
+// except strbuilder_append.
+//
+// Syntax => ag_strbuilder *sb = strbuilder_init();
+//           strbuilder_append_n(sb, buf, len);
+//           strbuilder_append_char(sb, '\n');
+//           ag_string out = strbuilder_to_string(sb);
+//           strbuilder_clean(sb);
+
+#ifndef AG_STRBUILDER_MIN_CHUNK
+#define AG_STRBUILDER_MIN_CHUNK 256
+#endif
+#ifndef AG_STRBUILDER_MAX_CHUNK
+#define AG_STRBUILDER_MAX_CHUNK ((size_t)1 << 20)
+#endif
+
+typedef struct __AG_SB_CHUNK__{
+     struct __AG_SB_CHUNK__ *next;
+     size_t size;
+     size_t capacity;
+     char data[];
+} ag_sb_chunk;
+
+typedef struct __AG_STRBUILDER__{
+     // private read-only
+     ag_sb_chunk *head;
+     ag_sb_chunk *tail;       // Appends go here
+     size_t size;             // Total bytes over all chunks
+     size_t next_chunk;       // Capacity of the next chunk
+     ag_allocator *allocator;
+} ag_strbuilder;
+
+ag_strbuilder *strbuilder_init(void);
+ag_strbuilder *strbuilder_init_with_alloc(ag_allocator *alloc);
+void strbuilder_clean(ag_strbuilder *sb);
+// Drops the contents, keeps the last chunk for reuse
+void strbuilder_clear(ag_strbuilder *sb);
+
+// The next n appended bytes need no allocation
+void strbuilder_reserve(ag_strbuilder *sb, size_t n);
+
+void strbuilder_append_n(ag_strbuilder *sb, const char *buf, size_t len);
+AG_COLD void __strbuilder_append_slow(ag_strbuilder *sb, char c);
+
+// One allocation with the exact size; the builder keeps its contents
+ag_string strbuilder_to_string(const ag_strbuilder *sb);
+ag_string strbuilder_to_string_with_alloc(const ag_strbuilder *sb, ag_allocator *alloc);
+
+#define strbuilder_size(__sb__) ((__sb__)->size)
+
+static inline void
+strbuilder_append(ag_strbuilder *sb, const char *cstr)
+{
+     strbuilder_append_n(sb, cstr, strlen(cstr));
+}
+
+static inline void
+strbuilder_append_view(ag_strbuilder *sb, ag_string_view sv)
+{
+     strbuilder_append_n(sb, sv.data, sv.size);
+}
+
+static inline void
+strbuilder_append_string(ag_strbuilder *sb, const ag_string str)
+{
+     strbuilder_append_n(sb, (const char*)str->data, str->size);
+}
+
+static inline void
+strbuilder_append_char(ag_strbuilder *sb, char c)
+{
+     ag_sb_chunk *tail = sb->tail;
+     if(tail != NULL && tail->size < tail->capacity) {
+          tail->data[tail->size++] = c;
+          sb->size++;
+     }
+     else __strbuilder_append_slow(sb, c);
+}
+
+// ---------------------------------------------------------------------------
+// Rope: an immutable string as a balanced (AVL) tree of leaves of at most
+// AG_ROPE_LEAF_BYTES bytes. Concatenation and slicing share subtrees with
+// their inputs and cost O(log n) instead of copying the text. Nodes are
+// reference counted (not atomically: share a rope between threads only
+// read-only). NULL is the empty rope.
+//
+// Syntax => ag_rope *a = rope_from_buf(text, len);
+//           ag_rope *b = rope_concat(a, a);     // a stays valid
+//           ag_rope *c = rope_slice(b, 10, 100);
+//           ag_string s = rope_to_string(c);
+//           rope_release(a); rope_release(b); rope_release(c);
+
+#ifndef AG_ROPE_LEAF_BYTES
+#define AG_ROPE_LEAF_BYTES 1024
+#endif
+
+typedef struct __AG_ROPE__{
+     // private read-only
+     struct __AG_ROPE__ *left;  // NULL for a leaf
+     struct __AG_ROPE__ *right;
+     size_t size;               // Bytes in this subtree
+     uint32_t height;           // 0 for a leaf
+     uint32_t refs;
+     ag_allocator *allocator;
+     char data[];               // Leaf bytes
+} ag_rope;
+
+ag_rope *rope_from_buf(const char *buf, size_t len);
+ag_rope *rope_from_buf_with_alloc(const char *buf, size_t len, ag_allocator *alloc);
+ag_rope *strbuilder_to_rope(const ag_strbuilder *sb);
+
+// New references; the arguments keep theirs
+ag_rope *rope_concat(ag_rope *a, ag_rope *b);
+// Same clamping rules as sv_slice
+ag_rope *rope_slice(ag_rope *r, size_t pos, size_t len);
+
+char rope_at(const ag_rope *r, size_t index);
+// Copies [pos, pos + len) to dst, clamped to the rope; returns bytes copied
+size_t rope_copy(const ag_rope *r, size_t pos, size_t len, char *dst);
+ag_string rope_to_string(const ag_rope *r);
+
+void rope_release(ag_rope *r);
+
+static inline ag_rope*
+rope_retain(ag_rope *r)
+{
+     if(r != NULL) r->refs++;
+     return r;
+}
+
+static inline size_t
+rope_size(const ag_rope *r)
+{
+     return r != NULL ? r->size : 0;
+}
+
+#endif //AEGIS_STRBUILDER_H
@@ -5,18 +5,36 @@
 #include "aegis_utils.h"
 
 // Syntax => sget(<__string__>)[<index>]
-#define sget(__string__) ((char*)(__string__)->data))
+#define sget(__string__) ((char*)(__string__)->data)
+
+// Strings up to AG_STRING_SSO_CAPACITY - 1 characters are stored inline with
+// their header (one allocation), longer ones spill to a heap buffer.
+#define AG_STRING_SSO_CAPACITY AG_VEC_TRAILING_BYTES
 
 typedef vector* ag_string;
 ag_string new_string(const char *cstr);
+ag_string new_string_with_alloc(const char *cstr, ag_allocator *alloc);
+// Builds from len bytes of buf, which need not be NUL-terminated
+ag_string new_string_n(const char *buf, size_t len);
+ag_string new_string_n_with_alloc(const char *buf, size_t len, ag_allocator *alloc);
 void string_append(ag_string  str,const char *cstr);
+void string_append_n(ag_string  str,const char *buf, size_t len);
+
+// Capacity for n characters (plus the terminator), exact
+void string_reserve(ag_string str, size_t n);
+
+// Direct writes into spare capacity:
+// char *tail = string_spare(str, max_len);  ... write k <= max_len bytes ...
+// string_commit(str, k);
+char *string_spare(ag_string str, size_t extra);
+void string_commit(ag_string str, size_t written);
 
 ag_string sub_string(const ag_string str, size_t pos, size_t len);
 
-inline void string_ncopy(const ag_string  _src, const ag_string  _dest , size_t n);
-inline void string_copy(const ag_string  _src, const ag_string  _dest);
-inline ag_string string_rep(const ag_string str);
-inline char * find_substr(const ag_string src_str, const ag_string str_to_search);
+void string_ncopy(const ag_string  _dest, const ag_string  _src, size_t n);
+void string_copy(const ag_string  _dest, const ag_string  _src);
+ag_string string_rep(const ag_string str);
+char * find_substr(const ag_string src_str, const ag_string str_to_search);
 
 int sto_int(const ag_string str);
 long long sto_ll(const ag_string str);
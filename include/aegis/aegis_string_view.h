@@ -0,0 +1,100 @@
+#ifndef AEGIS_STRING_VIEW_H
+#define AEGIS_STRING_VIEW_H
+
+#include "aegis_string.h"
+#include "aegis_hash.h"
+
+// Non-owning (pointer, length) view over bytes of an ag_string or any buffer.
+// Views never allocate; the viewed bytes must outlive the view and are not
+// NUL-terminated in general (print with printf("%.*s", SV_ARG(sv))).
+typedef struct __AG_STRING_VIEW__{
+     const char *data;
+     size_t size;
+} ag_string_view;
+
+// Returned by the find functions when nothing matches
+#define AG_NPOS ((size_t)-1)
+
+#define SV_ARG(__sv__) (int)(__sv__).size, (__sv__).data
+
+static inline ag_string_view
+sv_from_buf(const char *buf, size_t len)
+{
+     return (ag_string_view){ buf, len };
+}
+
+static inline ag_string_view
+sv_from_cstr(const char *cstr)
+{
+     return (ag_string_view){ cstr, strlen(cstr) };
+}
+
+static inline ag_string_view
+sv_from_string(const ag_string str)
+{
+     return (ag_string_view){ (const char*)str->data, str->size };
+}
+
+// Same clamping rules as sub_string, but an out-of-range pos gives an empty view
+static inline ag_string_view
+sv_slice(ag_string_view sv, size_t pos, size_t len)
+{
+     if(pos >= sv.size) return (ag_string_view){ sv.data + sv.size, 0 };
+     if(len > sv.size - pos) len = sv.size - pos;
+     return (ag_string_view){ sv.data + pos, len };
+}
+
+static inline bool
+sv_equal(ag_string_view a, ag_string_view b)
+{
+     return a.size == b.size && (a.size == 0 || memcmp(a.data, b.data, a.size) == 0);
+}
+
+static inline bool
+sv_starts_with(ag_string_view sv, ag_string_view prefix)
+{
+     if(prefix.size == 0) return true;
+     return sv.size >= prefix.size && memcmp(sv.data, prefix.data, prefix.size) == 0;
+}
+
+static inline bool
+sv_ends_with(ag_string_view sv, ag_string_view suffix)
+{
+     if(suffix.size == 0) return true;
+     return sv.size >= suffix.size
+          && memcmp(sv.data + (sv.size - suffix.size), suffix.data, suffix.size) == 0;
+}
+
+static inline uint64_t
+sv_hash(ag_string_view sv)
+{
+     return ag_hash_bytes(sv.data, sv.size, AG_HASH_SEED);
+}
+
+// Lexicographic byte comparison: <0, 0, >0
+int sv_compare(ag_string_view a, ag_string_view b);
+
+// Offset of the first match or AG_NPOS
+size_t sv_find(ag_string_view hay, ag_string_view needle);
+size_t sv_find_char(ag_string_view hay, char c);
+
+// Materializes a view: the only string_view calls that allocate
+static inline ag_string
+string_from_view(ag_string_view sv)
+{
+     return new_string_n(sv.data, sv.size);
+}
+
+static inline ag_string
+string_from_view_with_alloc(ag_string_view sv, ag_allocator *alloc)
+{
+     return new_string_n_with_alloc(sv.data, sv.size, alloc);
+}
+
+static inline void
+string_append_view(ag_string str, ag_string_view sv)
+{
+     string_append_n(str, sv.data, sv.size);
+}
+
+#endif //AEGIS_STRING_VIEW_H
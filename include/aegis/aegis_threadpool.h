@@ -0,0 +1,187 @@
+#ifndef AEGIS_THREADPOOL_H
+#define AEGIS_THREADPOOL_H
+
+#include "aegis_vector.h"
+#include "aegis_sort.h"
+#include "aegis_utils.h"
+
+// Work-stealing thread pool and parallel vector algorithms.
+//
+// Each participant (the worker threads plus the thread that starts a
+// parallel call) owns a Chase-Lev deque. A parallel loop splits its range in
+// halves, pushes one half onto the owner's deque and keeps working on the
+// other; idle workers steal the oldest (largest) halves. Split points of the
+// vec_* operations fall on 64-byte boundaries of the vector's data so two
+// threads never write the same cache line.
+//
+// Every parallel call blocks until done and runs serially on the caller when
+// the pool is NULL, has one thread, or the input is below the pool's serial
+// threshold. Parallel calls may nest (a body can start another one); calls
+// from several non-pool threads on the same pool are serialized.
+//
+// Syntax => ag_threadpool *pool = ag_threadpool_init(0);
+//           vec_for_each(v, scale, &factor, pool);
+//           vec_parallel_sort(v, ag_sort_double, pool);
+//           ag_threadpool_clean(pool);
+
+typedef struct __AG_THREADPOOL__ ag_threadpool;
+
+// Smallest automatic chunk, in elements
+#ifndef AG_PARALLEL_MIN_GRAIN
+#define AG_PARALLEL_MIN_GRAIN 1024
+#endif
+
+// Inputs with fewer elements run serially by default
+#ifndef AG_PARALLEL_SERIAL_THRESHOLD
+#define AG_PARALLEL_SERIAL_THRESHOLD 16384
+#endif
+
+// nthreads counts the calling thread, 0 means one per online CPU
+ag_threadpool *ag_threadpool_init(size_t nthreads);
+void ag_threadpool_clean(ag_threadpool *pool);
+size_t ag_threadpool_size(const ag_threadpool *pool);
+
+// Minimum elements per chunk for the vec_* operations, 0 = automatic
+// (about 8 chunks per thread, at least AG_PARALLEL_MIN_GRAIN)
+void ag_threadpool_set_grain(ag_threadpool *pool, size_t grain);
+void ag_threadpool_set_serial_threshold(ag_threadpool *pool, size_t n);
+size_t ag_threadpool_serial_threshold(const ag_threadpool *pool);
+
+// Calls body(begin, end, ctx) on disjoint subranges covering [0, n), none
+// longer than max(grain, 1) unless they cannot be split
+void ag_parallel_for(ag_threadpool *pool, size_t n, size_t grain,
+                     void (*body)(size_t begin, size_t end, void *ctx), void *ctx);
+
+// User API .
+
+#define vec_for_each(__ptrvec__, fn, ctx, pool) \
+          __vec_for_each(__ptrvec__, fn, ctx, pool)
+
+// dest gets src->size elements, dest[i] = fn(src[i])
+#define vec_transform(__dest__, __src__, fn, ctx, pool) \
+          __vec_transform(__dest__, __src__, fn, ctx, pool)
+
+// *acc holds the identity on entry and the result on return. Chunks are
+// fixed by the grain, not by scheduling, so the result is deterministic.
+#define vec_reduce(__ptrvec__, acc, fn, combine, ctx, pool) \
+          __vec_reduce(__ptrvec__, acc, sizeof(*(acc)), fn, combine, ctx, pool)
+
+#define vec_parallel_fill(__ptrvec__, begin, end, type, val, pool) \
+          __vec_parallel_fill(__ptrvec__, begin, end, vec_wrap_val(type, val), pool)
+
+// name is a family from AG_SORT_DEFINE with AG_PARALLEL_SORT_DEFINE applied
+#define vec_parallel_sort(__ptrvec__, name, pool) \
+          name##_vec_parallel_sort(__ptrvec__, pool)
+
+void __vec_for_each(vector *vec, void (*fn)(void *elem, void *ctx), void *ctx, ag_threadpool *pool);
+void __vec_transform(vector *dest, const vector *src,
+                     void (*fn)(void *out, const void *in, void *ctx), void *ctx, ag_threadpool *pool);
+void __vec_reduce(const vector *vec, void *acc, size_t acc_size,
+                  void (*fn)(void *acc, const void *elem, void *ctx),
+                  void (*combine)(void *acc, const void *other, void *ctx),
+                  void *ctx, ag_threadpool *pool);
+void __vec_parallel_fill(vector *vec, size_t begin, size_t end, const void *val, ag_threadpool *pool);
+
+// Parallel merge sort on top of an AG_SORT_DEFINE family: chunks are sorted
+// with name##_sort, then merged pairwise, every merge round split across the
+// pool by merge-path co-ranking. Needs n elements of scratch.
+#define AG_PARALLEL_SORT_DEFINE(name, type, less)                                \
+                                                                                 \
+typedef struct {                                                                 \
+     type *src;                                                                  \
+     type *dst;                                                                  \
+     size_t n;                                                                   \
+     size_t run;                                                                 \
+} name##_par_sort_ctx;                                                           \
+                                                                                 \
+static inline void                                                               \
+name##_par_sort_runs(size_t begin, size_t end, void *ctx)                        \
+{                                                                                \
+     name##_par_sort_ctx *c = (name##_par_sort_ctx*)ctx;                         \
+     for(size_t i = begin; i < end; i++) {                                       \
+          size_t lo = i * c->run;                                                \
+          size_t hi = agmin(lo + c->run, c->n);                                  \
+          if(lo < hi) name##_sort(c->src + lo, hi - lo);                         \
+     }                                                                           \
+}                                                                                \
+                                                                                 \
+/* Elements of A among the first k outputs of a merge of A and B */              \
+static inline size_t                                                             \
+name##_co_rank(const type *A, size_t na, const type *B, size_t nb, size_t k)     \
+{                                                                                \
+     size_t lo = k > nb ? k - nb : 0, hi = agmin(k, na);                         \
+     while(lo < hi) {                                                            \
+          size_t i = lo + (hi - lo) / 2, j = k - i;                              \
+          if(j > 0 && !less(B[j - 1], A[i])) lo = i + 1;                         \
+          else hi = i;                                                           \
+     }                                                                           \
+     return lo;                                                                  \
+}                                                                                \
+                                                                                 \
+/* Writes outputs [begin, end) of the current round */                           \
+static inline void                                                               \
+name##_par_merge(size_t begin, size_t end, void *ctx)                            \
+{                                                                                \
+     name##_par_sort_ctx *c = (name##_par_sort_ctx*)ctx;                         \
+     for(size_t o = begin; o < end;) {                                           \
+          size_t pair = o - o % (2 * c->run);                                    \
+          size_t mid = agmin(pair + c->run, c->n);                               \
+          size_t pair_end = agmin(pair + 2 * c->run, c->n);                      \
+          size_t stop = agmin(end, pair_end);                                    \
+          const type *A = c->src + pair, *B = c->src + mid;                      \
+          size_t na = mid - pair, nb = pair_end - mid;                           \
+          size_t i = name##_co_rank(A, na, B, nb, o - pair);                     \
+          size_t j = (o - pair) - i;                                             \
+          type *out = c->dst + o, *out_end = c->dst + stop;                      \
+          while(out < out_end) {                                                 \
+               if(j < nb && (i == na || less(B[j], A[i]))) *out++ = B[j++];      \
+               else *out++ = A[i++];                                             \
+          }                                                                      \
+          o = stop;                                                              \
+     }                                                                           \
+}                                                                                \
+                                                                                 \
+static inline void                                                               \
+name##_parallel_sort(type *a, size_t n, ag_threadpool *pool)                     \
+{                                                                                \
+     size_t threads = pool != NULL ? ag_threadpool_size(pool) : 1;              \
+     if(threads < 2 || n < ag_threadpool_serial_threshold(pool)) {               \
+          name##_sort(a, n);                                                     \
+          return;                                                                \
+     }                                                                           \
+     type *buf = (type*)malloc(n * sizeof(type));                                \
+     if(buf == NULL) {                                                           \
+          name##_sort(a, n);                                                     \
+          return;                                                                \
+     }                                                                           \
+     size_t runs = 2 * threads;                                                  \
+     name##_par_sort_ctx c = { a, buf, n, (n + runs - 1) / runs };               \
+     ag_parallel_for(pool, runs, 1, name##_par_sort_runs, &c);                   \
+                                                                                 \
+     size_t grain = agmax(n / (4 * threads), (size_t)AG_PARALLEL_MIN_GRAIN);     \
+     for(; c.run < n; c.run *= 2) {                                              \
+          ag_parallel_for(pool, n, grain, name##_par_merge, &c);                 \
+          type *t = c.src; c.src = c.dst; c.dst = t;                             \
+     }                                                                           \
+     if(c.src != a) memcpy(a, c.src, n * sizeof(type));                          \
+     free(buf);                                                                  \
+}                                                                                \
+                                                                                 \
+static inline void                                                               \
+name##_vec_parallel_sort(vector *vec, ag_threadpool *pool)                       \
+{                                                                                \
+     assert(vec->element_size == sizeof(type));                                  \
+     name##_parallel_sort((type*)vec->data, vec->size, pool);                    \
+}
+
+AG_PARALLEL_SORT_DEFINE(ag_sort_int, int, AG_LESS)
+AG_PARALLEL_SORT_DEFINE(ag_sort_uint, unsigned int, AG_LESS)
+AG_PARALLEL_SORT_DEFINE(ag_sort_i32, int32_t, AG_LESS)
+AG_PARALLEL_SORT_DEFINE(ag_sort_u32, uint32_t, AG_LESS)
+AG_PARALLEL_SORT_DEFINE(ag_sort_i64, int64_t, AG_LESS)
+AG_PARALLEL_SORT_DEFINE(ag_sort_u64, uint64_t, AG_LESS)
+AG_PARALLEL_SORT_DEFINE(ag_sort_size, size_t, AG_LESS)
+AG_PARALLEL_SORT_DEFINE(ag_sort_float, float, AG_LESS)
+AG_PARALLEL_SORT_DEFINE(ag_sort_double, double, AG_LESS)
+
+#endif //AEGIS_THREADPOOL_H
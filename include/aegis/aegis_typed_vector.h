@@ -0,0 +1,125 @@
+#ifndef AEGIS_TYPED_VECTOR_H
+#define AEGIS_TYPED_VECTOR_H
+
+#include "aegis_vector.h"
+#include "aegis_utils.h"
+
+// Type-specialized vectors.
+//
+// AG_VECTOR_DEFINE(type) generates `ag_vec_<type>` and a family of
+// `static inline` functions working directly on `type*`, so a push_back is a
+// store plus a size increment and loops over `->data` can be vectorized.
+//
+// The generated struct has the same layout as `vector`: memory is still owned
+// by __vec_init / __vec_set_capacity / __vec_clean, and a typed vector can be
+// handed to any generic __vec_* routine through <name>_as_vector().
+//
+// Syntax => AG_VECTOR_DEFINE(int)
+//           ag_vec_int *v = ag_vec_int_init(0, false);
+//           ag_vec_int_push_back(v, 42);
+//
+// Use AG_VECTOR_DEFINE_NAMED(<name>, <type>) for types that are not a single
+// identifier (e.g. `unsigned int`, `char*`).
+
+#define AG_VECTOR_DEFINE(type) AG_VECTOR_DEFINE_NAMED(ag_vec_##type, type)
+
+#define AG_VECTOR_DEFINE_NAMED(name, type)                                       \
+typedef struct {                                                                 \
+     type *data;                                                                 \
+     size_t size;                                                                \
+     size_t capacity;                                                            \
+     size_t element_size;                                                        \
+     ag_allocator *allocator;                                                    \
+     unsigned int flags;                                                         \
+     __AG_VEC_STATS_FIELD                                                        \
+} name;                                                                          \
+                                                                                 \
+_Static_assert(sizeof(name) == sizeof(vector)                                    \
+               && offsetof(name, size) == offsetof(vector, size)                 \
+               && offsetof(name, capacity) == offsetof(vector, capacity)         \
+               && offsetof(name, element_size) == offsetof(vector, element_size)\
+               && offsetof(name, allocator) == offsetof(vector, allocator)       \
+               && offsetof(name, flags) == offsetof(vector, flags),              \
+               #name " must share the layout of vector");                        \
+                                                                                 \
+static inline vector *                                                           \
+name##_as_vector(name *vec) { return (vector*)vec; }                             \
+                                                                                 \
+static inline name *                                                             \
+name##_from_vector(vector *vec)                                                  \
+{                                                                                \
+     assert(vec->element_size == sizeof(type));                                  \
+     return (name*)vec;                                                          \
+}                                                                                \
+                                                                                 \
+static inline name *                                                             \
+name##_init(size_t init_size, bool set_zero)                                     \
+{                                                                                \
+     return (name*)__vec_init(init_size, sizeof(type), set_zero);                \
+}                                                                                \
+                                                                                 \
+static inline name *                                                             \
+name##_init_with_alloc(size_t init_size, bool set_zero, ag_allocator *alloc)     \
+{                                                                                \
+     return (name*)__vec_init_with_alloc(init_size, sizeof(type), set_zero, alloc);\
+}                                                                                \
+                                                                                 \
+static inline void                                                               \
+name##_clean(name *vec) { __vec_clean((vector*)vec); }                           \
+                                                                                 \
+static inline type *                                                             \
+name##_at_ptr(name *vec, size_t index) { return vec->data + index; }             \
+                                                                                 \
+static inline type                                                               \
+name##_at(const name *vec, size_t index) { return vec->data[index]; }            \
+                                                                                 \
+static inline void                                                               \
+name##_reserve(name *vec, size_t new_capacity)                                   \
+{                                                                                \
+     if(new_capacity > vec->capacity)                                            \
+          __vec_set_capacity((vector*)vec, new_capacity);                        \
+}                                                                                \
+                                                                                 \
+static inline void                                                               \
+name##_push_back(name *vec, type val)                                            \
+{                                                                                \
+     if(__builtin_expect(vec->size == vec->capacity, 0))                         \
+          __vec_grow((vector*)vec, vec->size + 1);                               \
+     vec->data[vec->size++] = val;                                               \
+}                                                                                \
+                                                                                 \
+static inline void                                                               \
+name##_pop_back(name *vec) { if(vec->size > 0) vec->size--; }                    \
+                                                                                 \
+/* Unlike __vec_insert, pos == size is allowed and appends. */                   \
+static inline void                                                               \
+name##_insert(name *vec, size_t pos, type val)                                   \
+{                                                                                \
+     assert(pos <= vec->size);                                                   \
+     if(__builtin_expect(vec->size == vec->capacity, 0))                         \
+          __vec_grow((vector*)vec, vec->size + 1);                               \
+     memmove(vec->data + pos + 1, vec->data + pos,                               \
+             (vec->size - pos) * sizeof(type));                                  \
+     vec->data[pos] = val;                                                       \
+     vec->size++;                                                                \
+}                                                                                \
+                                                                                 \
+static inline void                                                               \
+name##_erase(name *vec, size_t pos)                                              \
+{                                                                                \
+     assert(pos < vec->size);                                                    \
+     memmove(vec->data + pos, vec->data + pos + 1,                               \
+             (vec->size - pos - 1) * sizeof(type));                              \
+     vec->size--;                                                                \
+}                                                                                \
+                                                                                 \
+static inline void                                                               \
+name##_fill(name *vec, size_t begin, size_t end, type val)                       \
+{                                                                                \
+     type *restrict it = vec->data;                                              \
+     size_t itend = agmin(vec->size, end);                                       \
+     for(size_t i = begin; i < itend; i++)                                       \
+          it[i] = val;                                                           \
+}
+
+#endif //AEGIS_TYPED_VECTOR_H
@@ -0,0 +1,93 @@
+#ifndef AEGIS_UTF8_H
+#define AEGIS_UTF8_H
+
+#include "aegis_string_view.h"
+
+// UTF-8 validation, code point counting and indexing, and transcoding to and
+// from UTF-16 / UTF-32.
+//
+// Validation follows Unicode's well-formedness rules (no overlongs, no
+// surrogates, nothing above U+10FFFF) and checks 32 or 16 bytes per step with
+// the nibble-lookup method (AVX2, else SSE4.1, picked at runtime; scalar
+// otherwise). Counting uses the same dispatch; transcoders convert ASCII runs
+// a vector at a time and decode everything else one sequence at a time.
+//
+// Counting and indexing assume valid input (they count bytes that are not
+// continuation bytes); the transcoders validate as they go and return
+// AG_NPOS on ill-formed input.
+//
+// Syntax => if(!string_validate_utf8(str)) ...
+//           ag_string_view first3 = string_utf8_slice(str, 0, 3);   // 3 code points
+//
+//           uint16_t *w = malloc(utf16_length_from_utf8(sv) * sizeof(uint16_t));
+//           size_t units = utf8_to_utf16(sv, w);                    // AG_NPOS if ill-formed
+
+// Returned by sv_utf8_decode for an ill-formed sequence
+#define AG_UTF_INVALID ((uint32_t)-1)
+
+bool sv_utf8_valid(ag_string_view s);
+// Offset of the first ill-formed sequence, AG_NPOS when s is valid
+size_t sv_utf8_error(ag_string_view s);
+// Code points in s
+size_t sv_utf8_length(ag_string_view s);
+// Byte offset of code point index, s.size for index == length, AG_NPOS past it
+size_t sv_utf8_offset(ag_string_view s, size_t index);
+// Code points [pos, pos + len), clamped like sv_slice
+ag_string_view sv_utf8_slice(ag_string_view s, size_t pos, size_t len);
+// Code point at byte offset *pos, moving *pos past it; AG_UTF_INVALID and a
+// one-byte step on an ill-formed sequence
+uint32_t sv_utf8_decode(ag_string_view s, size_t *pos);
+
+// Output sizes, in units, for the transcoders below. Exact for valid input
+// and never too small for ill-formed input.
+size_t utf16_length_from_utf8(ag_string_view s);
+size_t utf8_length_from_utf16(const uint16_t *src, size_t n);
+size_t utf8_length_from_utf32(const uint32_t *src, size_t n);
+
+// Units written to out, AG_NPOS on ill-formed input (out then holds a prefix).
+// Unpaired surrogates and UTF-32 values that are surrogates or above
+// U+10FFFF are ill-formed.
+size_t utf8_to_utf16(ag_string_view s, uint16_t *out);
+size_t utf8_to_utf32(ag_string_view s, uint32_t *out);
+size_t utf16_to_utf8(const uint16_t *src, size_t n, char *out);
+size_t utf32_to_utf8(const uint32_t *src, size_t n, char *out);
+
+// Append to a vector of uint16_t / uint32_t; units appended, or AG_NPOS with
+// out unchanged
+size_t sv_to_utf16(ag_string_view s, vector *out);
+size_t sv_to_utf32(ag_string_view s, vector *out);
+// NULL on ill-formed input
+ag_string string_from_utf16(const uint16_t *src, size_t n);
+ag_string string_from_utf32(const uint32_t *src, size_t n);
+
+static inline bool
+string_validate_utf8(const ag_string str)
+{
+     return sv_utf8_valid(sv_from_string(str));
+}
+
+static inline size_t
+string_utf8_length(const ag_string str)
+{
+     return sv_utf8_length(sv_from_string(str));
+}
+
+static inline ag_string_view
+string_utf8_slice(const ag_string str, size_t pos, size_t len)
+{
+     return sv_utf8_slice(sv_from_string(str), pos, len);
+}
+
+static inline size_t
+string_to_utf16(const ag_string str, vector *out)
+{
+     return sv_to_utf16(sv_from_string(str), out);
+}
+
+static inline size_t
+string_to_utf32(const ag_string str, vector *out)
+{
+     return sv_to_utf32(sv_from_string(str), out);
+}
+
+#endif //AEGIS_UTF8_H
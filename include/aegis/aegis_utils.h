@@ -1,6 +1,8 @@
 #ifndef AEGIS_UTILS
 #define AEGIS_UTILS
 
+#include "aegis_common.h"
+
 
 
 
@@ -18,5 +20,30 @@
           _a > _b ? _b :_a;         \
      })
 
+// Runtime CPU dispatch for the SIMD kernels.
+//
+// A module keeps one `static const void *slot` per kernel table and reads it
+// with __ag_dispatch(&slot, pick). The first call runs pick() with the
+// AG_CPU_* features of this CPU and publishes its table; later calls are one
+// relaxed atomic load. Off x86 (or without GCC's cpu builtins) the feature
+// set is empty and pick() must return its scalar table.
+
+#define AG_CPU_SSE2   (1u << 0)
+#define AG_CPU_SSE41  (1u << 1)
+#define AG_CPU_POPCNT (1u << 2)
+#define AG_CPU_AVX2   (1u << 3)
+
+typedef const void *(*__ag_dispatch_pick)(unsigned cpu);
+
+unsigned __ag_cpu_features(void);
+AG_COLD const void *__ag_dispatch_resolve(const void **slot, __ag_dispatch_pick pick);
+
+static inline const void*
+__ag_dispatch(const void **slot, __ag_dispatch_pick pick)
+{
+     const void *k = __atomic_load_n(slot, __ATOMIC_RELAXED);
+     if(__builtin_expect(k != NULL, 1)) return k;
+     return __ag_dispatch_resolve(slot, pick);
+}
 
 #endif // AEGIS_UTILS
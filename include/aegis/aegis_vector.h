@@ -2,6 +2,8 @@
 #define AEGIS_VECTOR_H
 
 #include "aegis_common.h"
+#include "aegis_allocator.h"
+#include "aegis_stats.h"
 typedef struct __VECTOR__{
      // Public :
      void* data;         // Pointer to the raw memory buffer
@@ -11,8 +13,50 @@ typedef struct __VECTOR__{
      size_t size;        // Number of elements currently stored
      size_t capacity;    // Total slots available before realloc needed
      size_t element_size;// Size of a single element in bytes (e.g., 4 for int)
+     ag_allocator *allocator; // Owner of both the header and data
+     unsigned int flags; // AG_VEC_* storage flags
+     __AG_VEC_STATS_FIELD // ag_stats_site *site with AEGIS_STATS, else nothing
 } vector;
 
+// Storage flags
+#define AG_VEC_MMAPPED  (1u << 0) // data lives in an anonymous mapping (large-vector mode)
+#define AG_VEC_INLINE   (1u << 1) // data points at storage not owned by the allocator, growth copies it out
+#define AG_VEC_TRAILING (1u << 2) // header was allocated with AG_VEC_TRAILING_BYTES of storage behind it
+#define AG_VEC_FILE_MAPPED (1u << 3) // data lives in a mapping of a vec_save file, growth copies it out
+#define AG_VEC_EXTERNAL (1u << 4) // header is owned by the caller (small vectors), clean frees only the data
+
+#define AG_VEC_TRAILING_BYTES 32
+
+// Default size in bytes above which default-allocated vectors switch to
+// mmap-backed storage. Override at build time or with vec_set_mmap_threshold.
+#ifndef AG_VEC_MMAP_THRESHOLD
+#define AG_VEC_MMAP_THRESHOLD ((size_t)64 << 20)
+#endif
+
+// Small vectors: a vector header followed by N elements of storage, declared
+// where it is used (a local or a struct member). Nothing is allocated until
+// the vector outgrows N, then the data moves to the allocator like any other
+// vector and the header stays where it is. The object must not be copied or
+// moved while it is in use, data may point into it.
+//
+// Syntax => ag_small_vector(int, 16) ids;
+//           vector *v = small_vec_init(&ids);
+//           vec_push_back(v, int, 42);    // the whole vec_* API applies
+//           vec_clean(v);                 // frees heap data if it spilled
+#define ag_small_vector(type, N) \
+          struct { vector vec; type storage[N]; }
+
+// Persistent vector files (vec_save / vec_map_file): one page of header
+// (magic, version, element_size, size, checksum of the data), then the raw
+// elements starting on the next page, in native byte order.
+#define AG_VEC_FILE_VERSION 1
+#define AG_VEC_FILE_DATA_OFFSET 4096
+
+// vec_map_file flags
+#define AG_VEC_MAP_READONLY 0         // shared read-only pages, writing to data faults
+#define AG_VEC_MAP_COW      (1u << 0) // private copy-on-write pages, writes stay in this process
+#define AG_VEC_MAP_VERIFY   (1u << 1) // check the checksum up front (reads every page)
+
 
 
 // User API .
@@ -20,10 +64,13 @@ typedef struct __VECTOR__{
 #define vec_wrap_val(type, val) ((type[]){val})
 
 #define vec_init(__size__, type, set_zero) \ 
-     __vec_init(__size__, sizeof(type), set_zero  )
+     ag_stats_tag(__vec_init(__size__, sizeof(type), set_zero))
+
+#define vec_init_with_alloc(__size__, type, set_zero, __alloc__) \
+     ag_stats_tag(__vec_init_with_alloc(__size__, sizeof(type), set_zero, __alloc__))
 
 #define vec_init_fill(__size__ , type , val) \ 
-     __vec_init_fill(__size__, sizeof(type), vec_wrap_val(type, val) )
+     ag_stats_tag(__vec_init_fill(__size__, sizeof(type), vec_wrap_val(type, val)))
 
 #define vec_fill(__ptrvec__, begin, end, type ,val) \ 
      __vec_fill(__ptrvec__, begin, end, vec_wrap_val(type, val))
@@ -47,19 +94,104 @@ typedef struct __VECTOR__{
 
 #define vec_clean(__ptrvec__) \
           __vec_clean(__ptrvec__)
+
+#define vec_reserve(__ptrvec__, __capacity__) \
+          __vec_reserve(__ptrvec__, __capacity__)
+
+// Range operations
+// Syntax => vec_push_back_n(<vector>, <const type*>, <count>)
+#define vec_push_back_n(__ptrvec__, __src__, __n__) \
+          __vec_push_back_n(__ptrvec__, __src__, __n__)
+
+// Inserts __n__ elements before __it__ (__it__ == size appends)
+#define vec_insert_range(__ptrvec__, __it__, __src__, __n__) \
+          __vec_insert_range(__ptrvec__, __it__, __src__, __n__)
+
+// Erases [__begin__, __end__)
+#define vec_erase_range(__ptrvec__, __begin__, __end__) \
+          __vec_erase_range(__ptrvec__, __begin__, __end__)
+
+#define vec_append(__dest__, __src__) \
+          __vec_append(__dest__, __src__)
+
+// Removes every element for which pred(elem, ctx) is true, keeps the order
+// of the rest and returns the number of removed elements
+#define vec_erase_if(__ptrvec__, __pred__, __ctx__) \
+          __vec_erase_if(__ptrvec__, __pred__, __ctx__)
+
+// Initializes an ag_small_vector and returns its vector
+#define small_vec_init(__small__) \
+          small_vec_init_with_alloc(__small__, &ag_default_allocator)
+
+#define small_vec_init_with_alloc(__small__, __alloc__) \
+          ag_stats_tag(__vec_init_inline(&(__small__)->vec, (__small__)->storage, \
+                            sizeof((__small__)->storage) / sizeof((__small__)->storage[0]), \
+                            sizeof((__small__)->storage[0]), __alloc__))
+
+// Large-vector mode tuning (0 disables mmap-backed growth)
+#define vec_set_mmap_threshold(bytes) __vec_set_mmap_threshold(bytes)
+#define vec_set_hugepages(enable) __vec_set_hugepages(enable)
+
+// Writes the vector to path through a temporary file and a rename, so a
+// process that mapped the old file keeps a valid mapping. False on I/O error.
+#define vec_save(__ptrvec__, path) __vec_save(__ptrvec__, path)
+
+// Maps a vec_save file as a vector of type without parsing or copying. NULL
+// if the file cannot be opened, is not a vector file of this version and
+// element size, or fails AG_VEC_MAP_VERIFY. The mapped vector has
+// capacity == size; anything that grows it first copies it to the heap.
+// Release with vec_clean as usual.
+#define vec_map_file(path, type, flags) __vec_map_file(path, sizeof(type), flags)
 // Core Functions
 vector *__vec_init(size_t init_size,size_t element_size, bool set_zero);
+vector *__vec_init_with_alloc(size_t init_size, size_t element_size, bool set_zero, ag_allocator *alloc);
+vector *__vec_init_trailing(size_t element_size, ag_allocator *alloc);
+vector *__vec_init_inline(vector *vec, void *storage, size_t capacity, size_t element_size, ag_allocator *alloc);
 vector *__vec_init_fill(size_t init_size, size_t element_size,void *val);
 
 void __vec_fill(vector* vec, size_t begin, size_t end,void *val);
 
-void __vec_push_back(vector* vec, void* element);
-void __vec_pop_back(vector* vec);
 void __vec_shrink_to_fit(vector *vec);
 void __vec_clean(vector* vec);
 void __vec_insert(vector* vec, size_t pos,void *val);
 void __vec_erase(vector* vec, size_t pos);
 
+void __vec_reserve(vector* vec, size_t new_capacity);
+
+void __vec_push_back_n(vector* vec, const void *src, size_t n);
+void __vec_insert_range(vector* vec, size_t pos, const void *src, size_t n);
+void __vec_erase_range(vector* vec, size_t begin, size_t end);
+void __vec_append(vector* dest, const vector* src);
+size_t __vec_erase_if(vector* vec, bool (*pred)(const void *elem, void *ctx), void *ctx);
+
 void __vec_set_capacity(vector* vec,size_t new_capacity);
+AG_COLD void __vec_grow(vector* vec, size_t min_capacity);
+
+void __vec_set_mmap_threshold(size_t bytes);
+void __vec_set_hugepages(bool enable);
+
+bool __vec_save(const vector* vec, const char *path);
+// element_size 0 accepts any element size
+vector *__vec_map_file(const char *path, size_t element_size, unsigned int flags);
+
+#ifdef AEGIS_STATS
+vector *__ag_stats_tag(vector *vec, ag_stats_site *site);
+#endif
+
+// Hot paths, inline so a push_back is a compare, a copy and an increment
+static inline void
+__vec_push_back(vector* vec, void* element)
+{
+     if(__builtin_expect(vec->size == vec->capacity, 0))
+          __vec_grow(vec, vec->size + 1);
+     memcpy((byte*)vec->data + vec->size * vec->element_size, element, vec->element_size);
+     vec->size++;
+}
+
+static inline void
+__vec_pop_back(vector* vec)
+{
+     if(vec->size > 0) vec->size--;
+}
 
 #endif //AEGIS_VECTOR_H
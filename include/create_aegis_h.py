@@ -1,6 +1,8 @@
 #!/usr/bin/env python3
 """
-Auto-generate aegis.h by including all .h headers located in include/aegis/.
+Auto-generate aegis.h by including all .h headers located in include/aegis/,
+plus the single translation unit section that includes every src/*.c file
+when AEGIS_IMPLEMENTATION is defined.
 Works on Linux, macOS, and Windows.
 """
 
@@ -10,6 +12,7 @@ def main():
     script_dir = Path(__file__).resolve().parent      # <project>/include/
     aegis_dir = script_dir / "aegis"                  # <project>/include/aegis/
     output_file = script_dir / "aegis.h"              # <project>/include/aegis.h
+    src_dir = script_dir.parent / "src"               # <project>/src/
 
     if not aegis_dir.exists():
         print(f"Error: directory not found: {aegis_dir}")
@@ -22,6 +25,8 @@ def main():
         print(f"No .h files found in {aegis_dir}")
         return
 
+    sources = sorted([p.name for p in src_dir.glob("*.c")])
+
     print("Generating:", output_file)
 
     with output_file.open("w", encoding="utf-8") as out:
@@ -29,10 +34,30 @@ def main():
         out.write("#ifndef AEGIS_H\n")
         out.write("#define AEGIS_H\n\n")
 
+        out.write("/*\n"
+                  " * Single translation unit mode: define AEGIS_IMPLEMENTATION in exactly\n"
+                  " * one .c file and include this header there before any system header\n"
+                  " * (the sources need _GNU_SOURCE). The whole library then compiles into\n"
+                  " * that file, nothing needs linking but -lm -lpthread, and the compiler\n"
+                  " * can inline every call without LTO. Other files include it plainly.\n"
+                  " * Build with -I<aegis>/include. This needs the source tree: the .c files\n"
+                  " * are included from ../src, and the aegis.h installed by CMake carries no\n"
+                  " * sources, so there AEGIS_IMPLEMENTATION stops with an #error.\n"
+                  " */\n")
+        out.write("#if defined(AEGIS_IMPLEMENTATION) && !defined(_GNU_SOURCE)\n")
+        out.write("#define _GNU_SOURCE\n")
+        out.write("#endif\n\n")
+
         # Use POSIX-style include paths even on Windows (<aegis/file.h>)
         for header in headers:
             out.write(f"#include \"aegis/{header}\"\n")
 
+        if sources:
+            out.write("\n#ifdef AEGIS_IMPLEMENTATION\n")
+            for source in sources:
+                out.write(f"#include \"../src/{source}\"\n")
+            out.write("#endif /* AEGIS_IMPLEMENTATION */\n")
+
         out.write("\n#endif /* AEGIS_H */\n")
 
     print("Done!")
@@ -0,0 +1,253 @@
+#include "aegis/aegis_utils.h"
+#include "aegis/aegis_common.h"
+#include "aegis/aegis_allocator.h"
+
+#include <stdalign.h>
+
+#define AG_ALLOC_ALIGN alignof(max_align_t)
+#define AG_ALIGN_UP(n, a) (((n) + ((a) - 1)) & ~((size_t)(a) - 1))
+
+// ---------------------------------------------------------------------------
+// libc
+// ---------------------------------------------------------------------------
+
+static void*
+__libc_alloc(void *ctx, size_t size)
+{
+     (void)ctx;
+     return malloc(size);
+}
+
+static void*
+__libc_realloc(void *ctx, void *ptr, size_t old_size, size_t new_size)
+{
+     (void)ctx; (void)old_size;
+     return realloc(ptr, new_size);
+}
+
+static void
+__libc_free(void *ctx, void *ptr, size_t size)
+{
+     (void)ctx; (void)size;
+     free(ptr);
+}
+
+ag_allocator ag_default_allocator = {
+     .alloc   = __libc_alloc,
+     .realloc = __libc_realloc,
+     .free    = __libc_free,
+     .ctx     = NULL,
+};
+
+// ---------------------------------------------------------------------------
+// Arena
+// ---------------------------------------------------------------------------
+
+struct __AG_ARENA_CHUNK__{
+     ag_arena_chunk *next;
+     size_t capacity;
+     size_t used;
+     alignas(max_align_t) byte data[];
+};
+
+static ag_arena_chunk*
+__arena_new_chunk(size_t capacity)
+{
+     ag_arena_chunk *chunk = (ag_arena_chunk*)malloc(sizeof(ag_arena_chunk) + capacity);
+     assert(chunk != NULL);
+     chunk->next = NULL;
+     chunk->capacity = capacity;
+     chunk->used = 0;
+     return chunk;
+}
+
+static void*
+__arena_alloc(void *ctx, size_t size)
+{
+     ag_arena *arena = (ag_arena*)ctx;
+     size = AG_ALIGN_UP(agmax(size, (size_t)1), AG_ALLOC_ALIGN);
+
+     // Walk forward through chunks kept by a previous reset before growing
+     ag_arena_chunk *chunk = arena->current;
+     while(chunk->used + size > chunk->capacity) {
+          if(chunk->next == NULL) {
+               ag_arena_chunk *fresh = __arena_new_chunk(agmax(size, arena->chunk_size));
+               chunk->next = fresh;
+          }
+          chunk = chunk->next;
+     }
+     arena->current = chunk;
+
+     void *ptr = chunk->data + chunk->used;
+     chunk->used += size;
+     return ptr;
+}
+
+static inline bool
+__arena_is_last(ag_arena_chunk *chunk, void *ptr, size_t size)
+{
+     return (byte*)ptr + AG_ALIGN_UP(agmax(size, (size_t)1), AG_ALLOC_ALIGN) == chunk->data + chunk->used;
+}
+
+static void*
+__arena_realloc(void *ctx, void *ptr, size_t old_size, size_t new_size)
+{
+     ag_arena *arena = (ag_arena*)ctx;
+     if(ptr == NULL) return __arena_alloc(ctx, new_size);
+
+     // The most recent block can grow or shrink in place
+     ag_arena_chunk *chunk = arena->current;
+     if(__arena_is_last(chunk, ptr, old_size)) {
+          size_t begin = (size_t)((byte*)ptr - chunk->data);
+          size_t nused = begin + AG_ALIGN_UP(agmax(new_size, (size_t)1), AG_ALLOC_ALIGN);
+          if(nused <= chunk->capacity) {
+               chunk->used = nused;
+               return ptr;
+          }
+     }
+     if(new_size <= old_size) return ptr;
+
+     void *fresh = __arena_alloc(ctx, new_size);
+     memcpy(fresh, ptr, old_size);
+     return fresh;
+}
+
+static void
+__arena_free(void *ctx, void *ptr, size_t size)
+{
+     ag_arena *arena = (ag_arena*)ctx;
+     if(ptr != NULL && __arena_is_last(arena->current, ptr, size))
+          arena->current->used = (size_t)((byte*)ptr - arena->current->data);
+}
+
+ag_arena*
+ag_arena_init(size_t chunk_size)
+{
+     ag_arena *arena = (ag_arena*)malloc(sizeof(ag_arena));
+     assert(arena != NULL);
+
+     arena->chunk_size = AG_ALIGN_UP(agmax(chunk_size, (size_t)AG_ALLOC_ALIGN), AG_ALLOC_ALIGN);
+     arena->first = arena->current = __arena_new_chunk(arena->chunk_size);
+     arena->allocator = (ag_allocator){
+          .alloc   = __arena_alloc,
+          .realloc = __arena_realloc,
+          .free    = __arena_free,
+          .ctx     = arena,
+     };
+     return arena;
+}
+
+void
+ag_arena_reset(ag_arena *arena)
+{
+     for(ag_arena_chunk *chunk = arena->first; chunk != NULL; chunk = chunk->next)
+          chunk->used = 0;
+     arena->current = arena->first;
+}
+
+void
+ag_arena_clean(ag_arena *arena)
+{
+     ag_arena_chunk *chunk = arena->first;
+     while(chunk != NULL) {
+          ag_arena_chunk *next = chunk->next;
+          free(chunk);
+          chunk = next;
+     }
+     free(arena);
+}
+
+// ---------------------------------------------------------------------------
+// Pool
+// ---------------------------------------------------------------------------
+
+static void
+__pool_add_slab(ag_pool *pool)
+{
+     // First block of every slab links the slab list, the rest feed free_list
+     byte *slab = (byte*)malloc(pool->block_size * (pool->blocks_per_slab + 1));
+     assert(slab != NULL);
+
+     *(void**)slab = pool->slabs;
+     pool->slabs = slab;
+
+     for(size_t i = 1; i <= pool->blocks_per_slab; i++) {
+          void *block = slab + i * pool->block_size;
+          *(void**)block = pool->free_list;
+          pool->free_list = block;
+     }
+}
+
+static void*
+__pool_alloc(void *ctx, size_t size)
+{
+     ag_pool *pool = (ag_pool*)ctx;
+     if(size > pool->block_size) return malloc(size);
+
+     if(pool->free_list == NULL) __pool_add_slab(pool);
+     void *block = pool->free_list;
+     pool->free_list = *(void**)block;
+     return block;
+}
+
+static void
+__pool_free(void *ctx, void *ptr, size_t size)
+{
+     ag_pool *pool = (ag_pool*)ctx;
+     if(ptr == NULL) return;
+     if(size > pool->block_size) {
+          free(ptr);
+          return;
+     }
+     *(void**)ptr = pool->free_list;
+     pool->free_list = ptr;
+}
+
+static void*
+__pool_realloc(void *ctx, void *ptr, size_t old_size, size_t new_size)
+{
+     ag_pool *pool = (ag_pool*)ctx;
+     if(ptr == NULL) return __pool_alloc(ctx, new_size);
+
+     bool old_in_pool = old_size <= pool->block_size;
+     bool new_in_pool = new_size <= pool->block_size;
+     if(old_in_pool && new_in_pool) return ptr;
+     if(!old_in_pool && !new_in_pool) return realloc(ptr, new_size);
+
+     void *fresh = __pool_alloc(ctx, new_size);
+     if(fresh == NULL) return NULL;
+     memcpy(fresh, ptr, agmin(old_size, new_size));
+     __pool_free(ctx, ptr, old_size);
+     return fresh;
+}
+
+ag_pool*
+ag_pool_init(size_t block_size, size_t blocks_per_slab)
+{
+     ag_pool *pool = (ag_pool*)malloc(sizeof(ag_pool));
+     assert(pool != NULL);
+
+     pool->block_size = AG_ALIGN_UP(agmax(block_size, sizeof(void*)), AG_ALLOC_ALIGN);
+     pool->blocks_per_slab = agmax(blocks_per_slab, (size_t)1);
+     pool->free_list = NULL;
+     pool->slabs = NULL;
+     pool->allocator = (ag_allocator){
+          .alloc   = __pool_alloc,
+          .realloc = __pool_realloc,
+          .free    = __pool_free,
+          .ctx     = pool,
+     };
+     return pool;
+}
+
+void
+ag_pool_clean(ag_pool *pool)
+{
+     void *slab = pool->slabs;
+     while(slab != NULL) {
+          void *next = *(void**)slab;
+          free(slab);
+          slab = next;
+     }
+     free(pool);
+}
@@ -0,0 +1,440 @@
+#include "aegis/aegis_bitvec.h"
+#include "aegis/aegis_utils.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <immintrin.h>
+#define BITVEC_HAS_X86 1
+#else
+#define BITVEC_HAS_X86 0
+#endif
+
+#define BITVEC_MIN_WORDS 1
+#define BITVEC_BLOCK_WORDS (AG_BITVEC_RANK_BLOCK / AG_BITVEC_WORD_BITS)
+
+typedef void (*__bitvec_op_fn)(uint64_t *dst, const uint64_t *src, size_t n);
+typedef size_t (*__bitvec_count_fn)(const uint64_t *words, size_t n);
+
+typedef struct {
+     __bitvec_op_fn and_op;
+     __bitvec_op_fn or_op;
+     __bitvec_op_fn xor_op;
+     __bitvec_op_fn andnot_op;
+     __bitvec_count_fn count;
+} __bitvec_kernels;
+
+// ---------------------------------------------------------------------------
+// Kernels
+// ---------------------------------------------------------------------------
+
+#define BITVEC_SCALAR_OP(name, expr)                                             \
+static void                                                                      \
+__bitvec_##name##_scalar(uint64_t *dst, const uint64_t *src, size_t n)           \
+{                                                                                \
+     for(size_t i = 0; i < n; i++) dst[i] = (expr);                              \
+}
+
+BITVEC_SCALAR_OP(and, dst[i] & src[i])
+BITVEC_SCALAR_OP(or, dst[i] | src[i])
+BITVEC_SCALAR_OP(xor, dst[i] ^ src[i])
+BITVEC_SCALAR_OP(andnot, dst[i] & ~src[i])
+
+static size_t
+__bitvec_count_scalar(const uint64_t *words, size_t n)
+{
+     size_t total = 0;
+     for(size_t i = 0; i < n; i++) total += (size_t)__builtin_popcountll(words[i]);
+     return total;
+}
+
+#if BITVEC_HAS_X86
+
+// Same loop, compiled to the POPCNT instruction
+__attribute__((target("popcnt")))
+static size_t
+__bitvec_count_popcnt(const uint64_t *words, size_t n)
+{
+     size_t total = 0;
+     for(size_t i = 0; i < n; i++) total += (size_t)__builtin_popcountll(words[i]);
+     return total;
+}
+
+// 4 words per step, one 256-bit load of each side
+#define BITVEC_AVX2_OP(name, vexpr, sexpr)                                       \
+__attribute__((target("avx2")))                                                  \
+static void                                                                      \
+__bitvec_##name##_avx2(uint64_t *dst, const uint64_t *src, size_t n)             \
+{                                                                                \
+     size_t i = 0;                                                               \
+     for(; i + 4 <= n; i += 4) {                                                 \
+          __m256i d = _mm256_loadu_si256((const __m256i*)(dst + i));             \
+          __m256i s = _mm256_loadu_si256((const __m256i*)(src + i));             \
+          _mm256_storeu_si256((__m256i*)(dst + i), (vexpr));                     \
+     }                                                                           \
+     for(; i < n; i++) dst[i] = (sexpr);                                         \
+}
+
+BITVEC_AVX2_OP(and, _mm256_and_si256(d, s), dst[i] & src[i])
+BITVEC_AVX2_OP(or, _mm256_or_si256(d, s), dst[i] | src[i])
+BITVEC_AVX2_OP(xor, _mm256_xor_si256(d, s), dst[i] ^ src[i])
+BITVEC_AVX2_OP(andnot, _mm256_andnot_si256(s, d), dst[i] & ~src[i])
+
+// Nibble lookup popcount (Mula): vpshufb counts each nibble, bytes add up
+// for at most 31 steps (31 * 8 < 256), then vpsadbw folds them into the
+// four 64-bit lanes.
+__attribute__((target("avx2,popcnt")))
+static size_t
+__bitvec_count_avx2(const uint64_t *words, size_t n)
+{
+     const __m256i lut = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                          0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+     const __m256i low = _mm256_set1_epi8(0x0f);
+     const __m256i zero = _mm256_setzero_si256();
+     __m256i acc = zero;
+     size_t i = 0;
+
+     while(i + 4 <= n) {
+          __m256i local = zero;
+          for(int step = 0; step < 31 && i + 4 <= n; step++, i += 4) {
+               __m256i v = _mm256_loadu_si256((const __m256i*)(words + i));
+               __m256i lo = _mm256_shuffle_epi8(lut, _mm256_and_si256(v, low));
+               __m256i hi = _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(v, 4), low));
+               local = _mm256_add_epi8(local, _mm256_add_epi8(lo, hi));
+          }
+          acc = _mm256_add_epi64(acc, _mm256_sad_epu8(local, zero));
+     }
+
+     uint64_t lanes[4];
+     _mm256_storeu_si256((__m256i*)lanes, acc);
+     size_t total = (size_t)(lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+     for(; i < n; i++) total += (size_t)__builtin_popcountll(words[i]);
+     return total;
+}
+
+#endif // BITVEC_HAS_X86
+
+// ---------------------------------------------------------------------------
+// Runtime dispatch: the first bulk call picks the kernels for this CPU.
+// ---------------------------------------------------------------------------
+
+static const __bitvec_kernels __bitvec_scalar = {
+     __bitvec_and_scalar, __bitvec_or_scalar, __bitvec_xor_scalar, __bitvec_andnot_scalar,
+     __bitvec_count_scalar,
+};
+
+#if BITVEC_HAS_X86
+static const __bitvec_kernels __bitvec_popcnt = {
+     __bitvec_and_scalar, __bitvec_or_scalar, __bitvec_xor_scalar, __bitvec_andnot_scalar,
+     __bitvec_count_popcnt,
+};
+
+static const __bitvec_kernels __bitvec_avx2 = {
+     __bitvec_and_avx2, __bitvec_or_avx2, __bitvec_xor_avx2, __bitvec_andnot_avx2,
+     __bitvec_count_avx2,
+};
+#endif
+
+static const void*
+__bitvec_pick(unsigned cpu)
+{
+#if BITVEC_HAS_X86
+     if((cpu & AG_CPU_AVX2) && (cpu & AG_CPU_POPCNT)) return &__bitvec_avx2;
+     if(cpu & AG_CPU_POPCNT) return &__bitvec_popcnt;
+#else
+     (void)cpu;
+#endif
+     return &__bitvec_scalar;
+}
+
+static const void *__bitvec_impl = NULL;
+
+static inline const __bitvec_kernels*
+__bitvec_kernels_get(void)
+{
+     return (const __bitvec_kernels*)__ag_dispatch(&__bitvec_impl, __bitvec_pick);
+}
+
+// ---------------------------------------------------------------------------
+// Storage
+// ---------------------------------------------------------------------------
+
+ag_bitvec*
+bitvec_init(size_t nbits)
+{
+     return bitvec_init_with_alloc(nbits, &ag_default_allocator);
+}
+
+ag_bitvec*
+bitvec_init_with_alloc(size_t nbits, ag_allocator *alloc)
+{
+     ag_bitvec *bv = (ag_bitvec*)ag_alloc(alloc, sizeof(ag_bitvec));
+     if(bv == NULL) {
+          fprintf(stderr, "Error: Memory allocation failed for bit vector\n");
+          exit(EXIT_FAILURE);
+     }
+
+     size_t nwords = agmax(__BITVEC_WORDS(nbits), (size_t)BITVEC_MIN_WORDS);
+     // calloc keeps the lazily-zeroed pages of libc for huge vectors
+     if(alloc == &ag_default_allocator)
+          bv->words = (uint64_t*)calloc(nwords, sizeof(uint64_t));
+     else {
+          bv->words = (uint64_t*)ag_alloc(alloc, nwords * sizeof(uint64_t));
+          if(bv->words != NULL) memset(bv->words, 0, nwords * sizeof(uint64_t));
+     }
+     if(bv->words == NULL) {
+          fprintf(stderr, "Error: Memory allocation failed for bit vector\n");
+          exit(EXIT_FAILURE);
+     }
+
+     bv->size = nbits;
+     bv->capacity = nwords;
+     bv->allocator = alloc;
+     bv->rank = NULL;
+     bv->select = NULL;
+     bv->rank_blocks = 0;
+     bv->select_samples = 0;
+     return bv;
+}
+
+void
+bitvec_drop_rank(ag_bitvec *bv)
+{
+     if(bv->rank != NULL)
+          ag_free(bv->allocator, bv->rank, (bv->rank_blocks + 1) * sizeof(uint64_t));
+     if(bv->select != NULL)
+          ag_free(bv->allocator, bv->select, bv->select_samples * sizeof(size_t));
+     bv->rank = NULL;
+     bv->select = NULL;
+     bv->rank_blocks = 0;
+     bv->select_samples = 0;
+}
+
+void
+bitvec_clean(ag_bitvec *bv)
+{
+     if(bv == NULL) return;
+     bitvec_drop_rank(bv);
+     ag_free(bv->allocator, bv->words, bv->capacity * sizeof(uint64_t));
+     ag_free(bv->allocator, bv, sizeof(ag_bitvec));
+}
+
+// Clears the bits past size in the last word
+static inline void
+__bitvec_trim(ag_bitvec *bv)
+{
+     size_t tail = bv->size % AG_BITVEC_WORD_BITS;
+     if(tail != 0) bv->words[bv->size / AG_BITVEC_WORD_BITS] &= ((uint64_t)1 << tail) - 1;
+}
+
+void
+bitvec_resize(ag_bitvec *bv, size_t nbits)
+{
+     bitvec_drop_rank(bv);
+     size_t old_words = __BITVEC_WORDS(bv->size);
+     size_t new_words = __BITVEC_WORDS(nbits);
+
+     // Every allocated word past size stays zero, so growing within the
+     // capacity never has to clear anything
+     if(new_words > bv->capacity) {
+          size_t ncap = agmax(new_words, bv->capacity + bv->capacity / 2);
+          uint64_t *temp = (uint64_t*)ag_realloc(bv->allocator, bv->words,
+                                                 bv->capacity * sizeof(uint64_t), ncap * sizeof(uint64_t));
+          assert(temp != NULL);
+          memset(temp + bv->capacity, 0, (ncap - bv->capacity) * sizeof(uint64_t));
+          bv->words = temp;
+          bv->capacity = ncap;
+     }
+     else if(new_words < old_words)
+          memset(bv->words + new_words, 0, (old_words - new_words) * sizeof(uint64_t));
+
+     bv->size = nbits;
+     __bitvec_trim(bv);
+}
+
+void
+bitvec_push_back(ag_bitvec *bv, bool bit)
+{
+     if(bv->size == bv->capacity * AG_BITVEC_WORD_BITS)
+          bitvec_resize(bv, bv->size + 1);
+     else {
+          bitvec_drop_rank(bv);
+          bv->size++;
+     }
+     bitvec_assign(bv, bv->size - 1, bit);
+}
+
+void
+bitvec_set_all(ag_bitvec *bv)
+{
+     memset(bv->words, 0xff, __BITVEC_WORDS(bv->size) * sizeof(uint64_t));
+     __bitvec_trim(bv);
+}
+
+void
+bitvec_clear_all(ag_bitvec *bv)
+{
+     memset(bv->words, 0, __BITVEC_WORDS(bv->size) * sizeof(uint64_t));
+}
+
+void
+bitvec_not(ag_bitvec *bv)
+{
+     size_t n = __BITVEC_WORDS(bv->size);
+     for(size_t i = 0; i < n; i++) bv->words[i] = ~bv->words[i];
+     __bitvec_trim(bv);
+}
+
+// ---------------------------------------------------------------------------
+// Bulk operations
+// ---------------------------------------------------------------------------
+
+void
+bitvec_and(ag_bitvec *dst, const ag_bitvec *src)
+{
+     assert(dst->size == src->size);
+     __bitvec_kernels_get()->and_op(dst->words, src->words, __BITVEC_WORDS(dst->size));
+}
+
+void
+bitvec_or(ag_bitvec *dst, const ag_bitvec *src)
+{
+     assert(dst->size == src->size);
+     __bitvec_kernels_get()->or_op(dst->words, src->words, __BITVEC_WORDS(dst->size));
+}
+
+void
+bitvec_xor(ag_bitvec *dst, const ag_bitvec *src)
+{
+     assert(dst->size == src->size);
+     __bitvec_kernels_get()->xor_op(dst->words, src->words, __BITVEC_WORDS(dst->size));
+}
+
+void
+bitvec_andnot(ag_bitvec *dst, const ag_bitvec *src)
+{
+     assert(dst->size == src->size);
+     __bitvec_kernels_get()->andnot_op(dst->words, src->words, __BITVEC_WORDS(dst->size));
+}
+
+size_t
+bitvec_count(const ag_bitvec *bv)
+{
+     return __bitvec_kernels_get()->count(bv->words, __BITVEC_WORDS(bv->size));
+}
+
+size_t
+bitvec_find_next(const ag_bitvec *bv, size_t from)
+{
+     if(from >= bv->size) return AG_NPOS;
+     size_t n = __BITVEC_WORDS(bv->size);
+     size_t i = from / AG_BITVEC_WORD_BITS;
+     uint64_t w = bv->words[i] & (~(uint64_t)0 << (from % AG_BITVEC_WORD_BITS));
+
+     while(w == 0) {
+          if(++i == n) return AG_NPOS;
+          w = bv->words[i];
+     }
+     return i * AG_BITVEC_WORD_BITS + (size_t)__builtin_ctzll(w);
+}
+
+// ---------------------------------------------------------------------------
+// Rank / select
+// ---------------------------------------------------------------------------
+
+// Position of the set bit with rank k inside w (k < popcount(w))
+static inline size_t
+__bitvec_select_word(uint64_t w, size_t k)
+{
+     size_t shift = 0;
+     for(;;) {
+          size_t c = (size_t)__builtin_popcountll(w & 0xff);
+          if(k < c) break;
+          k -= c;
+          w >>= 8;
+          shift += 8;
+     }
+     while(k-- > 0) w &= w - 1;
+     return shift + (size_t)__builtin_ctzll(w);
+}
+
+void
+bitvec_build_rank(ag_bitvec *bv)
+{
+     bitvec_drop_rank(bv);
+     size_t n = __BITVEC_WORDS(bv->size);
+     size_t blocks = (n + BITVEC_BLOCK_WORDS - 1) / BITVEC_BLOCK_WORDS;
+     const __bitvec_kernels *k = __bitvec_kernels_get();
+
+     uint64_t *rank = (uint64_t*)ag_alloc(bv->allocator, (blocks + 1) * sizeof(uint64_t));
+     assert(rank != NULL);
+     uint64_t total = 0;
+     for(size_t b = 0; b < blocks; b++) {
+          rank[b] = total;
+          size_t first = b * BITVEC_BLOCK_WORDS;
+          total += k->count(bv->words + first, agmin((size_t)BITVEC_BLOCK_WORDS, n - first));
+     }
+     rank[blocks] = total;
+
+     // Block holding each AG_BITVEC_SELECT_SAMPLE-th set bit
+     size_t samples = (size_t)((total + AG_BITVEC_SELECT_SAMPLE - 1) / AG_BITVEC_SELECT_SAMPLE);
+     size_t *select = NULL;
+     if(samples > 0) {
+          select = (size_t*)ag_alloc(bv->allocator, samples * sizeof(size_t));
+          assert(select != NULL);
+          size_t s = 0;
+          for(size_t b = 0; b < blocks && s < samples; b++) {
+               while(s < samples && (uint64_t)s * AG_BITVEC_SELECT_SAMPLE < rank[b + 1])
+                    select[s++] = b;
+          }
+     }
+
+     bv->rank = rank;
+     bv->select = select;
+     bv->rank_blocks = blocks;
+     bv->select_samples = samples;
+}
+
+size_t
+bitvec_rank(const ag_bitvec *bv, size_t pos)
+{
+     pos = agmin(pos, bv->size);
+     size_t word = pos / AG_BITVEC_WORD_BITS;
+     size_t first = 0, base = 0;
+     if(bv->rank != NULL) {
+          first = word / BITVEC_BLOCK_WORDS * BITVEC_BLOCK_WORDS;
+          base = (size_t)bv->rank[word / BITVEC_BLOCK_WORDS];
+     }
+     size_t count = base + __bitvec_kernels_get()->count(bv->words + first, word - first);
+     if(pos % AG_BITVEC_WORD_BITS != 0)
+          count += (size_t)__builtin_popcountll(bv->words[word] & (((uint64_t)1 << (pos % AG_BITVEC_WORD_BITS)) - 1));
+     return count;
+}
+
+size_t
+bitvec_select(const ag_bitvec *bv, size_t k)
+{
+     size_t n = __BITVEC_WORDS(bv->size);
+     size_t word = 0, seen = 0;
+
+     if(bv->rank != NULL) {
+          if(k >= bv->rank[bv->rank_blocks]) return AG_NPOS;
+          // Samples bound the blocks, binary search for the last block starting at or before k
+          size_t s = k / AG_BITVEC_SELECT_SAMPLE;
+          size_t lo = bv->select[s];
+          size_t hi = (s + 1 < bv->select_samples) ? bv->select[s + 1] + 1 : bv->rank_blocks;
+          while(hi - lo > 1) {
+               size_t mid = lo + (hi - lo) / 2;
+               if(bv->rank[mid] <= k) lo = mid;
+               else hi = mid;
+          }
+          word = lo * BITVEC_BLOCK_WORDS;
+          seen = (size_t)bv->rank[lo];
+     }
+
+     for(; word < n; word++) {
+          size_t c = (size_t)__builtin_popcountll(bv->words[word]);
+          if(k - seen < c)
+               return word * AG_BITVEC_WORD_BITS + __bitvec_select_word(bv->words[word], k - seen);
+          seen += c;
+     }
+     return AG_NPOS;
+}
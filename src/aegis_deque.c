@@ -0,0 +1,211 @@
+#include "aegis/aegis_deque.h"
+#include "aegis/aegis_utils.h"
+
+#define DEQUE_MIN_INDEX 8
+
+static inline size_t
+__deque_block_elems(const ag_deque *dq)
+{
+     return (size_t)1 << dq->block_shift;
+}
+
+static inline size_t
+__deque_block_bytes(const ag_deque *dq)
+{
+     return __deque_block_elems(dq) * dq->element_size;
+}
+
+static inline byte**
+__deque_slot(ag_deque *dq, size_t block)
+{
+     return &dq->blocks[(dq->first_block + block) & (dq->index_capacity - 1)];
+}
+
+ag_deque*
+__deque_init(size_t element_size, ag_allocator *alloc)
+{
+     assert(element_size > 0);
+     ag_deque *dq = (ag_deque*)ag_alloc(alloc, sizeof(ag_deque));
+     if(dq == NULL) {
+          fprintf(stderr, "Error: Memory allocation failed for deque\n");
+          exit(EXIT_FAILURE);
+     }
+
+     // Largest power of two that fits the target, but never tiny blocks
+     size_t elems = agmax(AG_DEQUE_BLOCK_BYTES / element_size, (size_t)AG_DEQUE_MIN_BLOCK_ELEMS);
+     size_t shift = 0;
+     while(((size_t)2 << shift) <= elems) shift++;
+
+     dq->blocks = NULL;
+     dq->index_capacity = 0;
+     dq->first_block = 0;
+     dq->nblocks = 0;
+     dq->start = 0;
+     dq->size = 0;
+     dq->element_size = element_size;
+     dq->block_shift = shift;
+     dq->spare = NULL;
+     dq->allocator = alloc;
+     return dq;
+}
+
+static byte*
+__deque_block_alloc(ag_deque *dq)
+{
+     byte *block = dq->spare;
+     if(block != NULL) {
+          dq->spare = NULL;
+          return block;
+     }
+     block = (byte*)ag_alloc(dq->allocator, __deque_block_bytes(dq));
+     if(block == NULL) {
+          fprintf(stderr, "Error: Memory allocation failed for deque block\n");
+          exit(EXIT_FAILURE);
+     }
+     return block;
+}
+
+static void
+__deque_block_release(ag_deque *dq, byte *block)
+{
+     if(dq->spare == NULL) dq->spare = block;
+     else ag_free(dq->allocator, block, __deque_block_bytes(dq));
+}
+
+// Doubles the index and unrolls the ring to slot 0. Only block pointers
+// move, the blocks themselves stay put.
+static void
+__deque_grow_index(ag_deque *dq)
+{
+     size_t ncap = agmax(dq->index_capacity * 2, (size_t)DEQUE_MIN_INDEX);
+     byte **index = (byte**)ag_alloc(dq->allocator, ncap * sizeof(byte*));
+     if(index == NULL) {
+          fprintf(stderr, "Error: Memory allocation failed for deque index\n");
+          exit(EXIT_FAILURE);
+     }
+     for(size_t i = 0; i < dq->nblocks; i++)
+          index[i] = *__deque_slot(dq, i);
+
+     if(dq->blocks != NULL)
+          ag_free(dq->allocator, dq->blocks, dq->index_capacity * sizeof(byte*));
+     dq->blocks = index;
+     dq->index_capacity = ncap;
+     dq->first_block = 0;
+}
+
+static void
+__deque_add_back_block(ag_deque *dq)
+{
+     if(dq->nblocks == dq->index_capacity) __deque_grow_index(dq);
+     *__deque_slot(dq, dq->nblocks) = __deque_block_alloc(dq);
+     dq->nblocks++;
+}
+
+static void
+__deque_add_front_block(ag_deque *dq)
+{
+     if(dq->nblocks == dq->index_capacity) __deque_grow_index(dq);
+     dq->first_block = (dq->first_block - 1) & (dq->index_capacity - 1);
+     *__deque_slot(dq, 0) = __deque_block_alloc(dq);
+     dq->nblocks++;
+     dq->start += __deque_block_elems(dq);
+}
+
+void*
+__deque_push_back(ag_deque *dq, const void *val)
+{
+     if(dq->start + dq->size == dq->nblocks << dq->block_shift)
+          __deque_add_back_block(dq);
+
+     dq->size++;
+     void *slot = __deque_at_ptr(dq, dq->size - 1);
+     memcpy(slot, val, dq->element_size);
+     return slot;
+}
+
+void*
+__deque_push_front(ag_deque *dq, const void *val)
+{
+     if(dq->start == 0)
+          __deque_add_front_block(dq);
+
+     dq->start--;
+     dq->size++;
+     void *slot = __deque_at_ptr(dq, 0);
+     memcpy(slot, val, dq->element_size);
+     return slot;
+}
+
+void
+__deque_push_back_n(ag_deque *dq, const void *src, size_t n)
+{
+     const byte *it = (const byte*)src;
+     size_t mask = __deque_block_elems(dq) - 1;
+
+     // One memcpy per block touched
+     while(n > 0) {
+          size_t end = dq->start + dq->size;
+          if(end == dq->nblocks << dq->block_shift)
+               __deque_add_back_block(dq);
+
+          size_t offset = end & mask;
+          size_t chunk = agmin(n, mask + 1 - offset);
+          byte *block = *__deque_slot(dq, end >> dq->block_shift);
+          memcpy(block + offset * dq->element_size, it, chunk * dq->element_size);
+          dq->size += chunk;
+          it += chunk * dq->element_size;
+          n -= chunk;
+     }
+}
+
+void
+__deque_pop_back(ag_deque *dq)
+{
+     if(dq->size == 0) return;
+     dq->size--;
+
+     // Back block emptied
+     if(dq->start + dq->size <= (dq->nblocks - 1) << dq->block_shift) {
+          dq->nblocks--;
+          __deque_block_release(dq, *__deque_slot(dq, dq->nblocks));
+     }
+}
+
+void
+__deque_pop_front(ag_deque *dq)
+{
+     if(dq->size == 0) return;
+     dq->size--;
+     dq->start++;
+
+     // Front block emptied
+     if(dq->start == __deque_block_elems(dq) || dq->size == 0) {
+          __deque_block_release(dq, *__deque_slot(dq, 0));
+          dq->first_block = (dq->first_block + 1) & (dq->index_capacity - 1);
+          dq->nblocks--;
+          dq->start = 0;
+     }
+}
+
+void
+__deque_clear(ag_deque *dq)
+{
+     for(size_t i = 0; i < dq->nblocks; i++)
+          __deque_block_release(dq, *__deque_slot(dq, i));
+     dq->nblocks = 0;
+     dq->first_block = 0;
+     dq->start = 0;
+     dq->size = 0;
+}
+
+void
+__deque_clean(ag_deque *dq)
+{
+     if(dq == NULL) return;
+     __deque_clear(dq);
+     if(dq->spare != NULL)
+          ag_free(dq->allocator, dq->spare, __deque_block_bytes(dq));
+     if(dq->blocks != NULL)
+          ag_free(dq->allocator, dq->blocks, dq->index_capacity * sizeof(byte*));
+     ag_free(dq->allocator, dq, sizeof(ag_deque));
+}
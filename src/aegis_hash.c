@@ -0,0 +1,94 @@
+#include "aegis/aegis_common.h"
+#include "aegis/aegis_hash.h"
+
+static const uint64_t __hash_secret[4] = {
+     0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull,
+     0x4b33a62ed433d4a3ull, 0x4d5a2da51de1aa47ull,
+};
+
+static inline void
+__hash_mum(uint64_t *a, uint64_t *b)
+{
+     __uint128_t r = (__uint128_t)*a * *b;
+     *a = (uint64_t)r;
+     *b = (uint64_t)(r >> 64);
+}
+
+static inline uint64_t
+__hash_mix(uint64_t a, uint64_t b)
+{
+     __hash_mum(&a, &b);
+     return a ^ b;
+}
+
+static inline uint64_t
+__hash_r8(const byte *p)
+{
+     uint64_t v;
+     memcpy(&v, p, 8);
+     return v;
+}
+
+static inline uint64_t
+__hash_r4(const byte *p)
+{
+     uint32_t v;
+     memcpy(&v, p, 4);
+     return v;
+}
+
+// 1..3 bytes: first, middle and last byte
+static inline uint64_t
+__hash_r3(const byte *p, size_t k)
+{
+     return ((uint64_t)p[0] << 16) | ((uint64_t)p[k >> 1] << 8) | p[k - 1];
+}
+
+uint64_t
+ag_hash_bytes(const void *data, size_t len, uint64_t seed)
+{
+     const byte *p = (const byte*)data;
+     const uint64_t *secret = __hash_secret;
+     uint64_t a, b;
+
+     seed ^= __hash_mix(seed ^ secret[0], secret[1]);
+
+     if(__builtin_expect(len <= 16, 1)) {
+          if(len >= 4) {
+               // Two overlapping 4-byte reads from each end cover 4..16 bytes
+               a = (__hash_r4(p) << 32) | __hash_r4(p + ((len >> 3) << 2));
+               b = (__hash_r4(p + len - 4) << 32) | __hash_r4(p + len - 4 - ((len >> 3) << 2));
+          }
+          else if(len > 0) {
+               a = __hash_r3(p, len);
+               b = 0;
+          }
+          else a = b = 0;
+     }
+     else {
+          size_t i = len;
+          if(__builtin_expect(i > 48, 0)) {
+               uint64_t see1 = seed, see2 = seed;
+               do {
+                    seed = __hash_mix(__hash_r8(p) ^ secret[1], __hash_r8(p + 8) ^ seed);
+                    see1 = __hash_mix(__hash_r8(p + 16) ^ secret[2], __hash_r8(p + 24) ^ see1);
+                    see2 = __hash_mix(__hash_r8(p + 32) ^ secret[3], __hash_r8(p + 40) ^ see2);
+                    p += 48;
+                    i -= 48;
+               } while(__builtin_expect(i > 48, 1));
+               seed ^= see1 ^ see2;
+          }
+          while(__builtin_expect(i > 16, 0)) {
+               seed = __hash_mix(__hash_r8(p) ^ secret[1], __hash_r8(p + 8) ^ seed);
+               i -= 16;
+               p += 16;
+          }
+          a = __hash_r8(p + i - 16);
+          b = __hash_r8(p + i - 8);
+     }
+
+     a ^= secret[1];
+     b ^= seed;
+     __hash_mum(&a, &b);
+     return __hash_mix(a ^ secret[0] ^ len, b ^ secret[1]);
+}
@@ -0,0 +1,396 @@
+#include "aegis/aegis_hashmap.h"
+#include "aegis/aegis_utils.h"
+
+#include <stdalign.h>
+
+#define HMAP_MIN_CAPACITY AG_HMAP_GROUP
+// Max load factor 7/8
+#define HMAP_MAX_LOAD(capacity) ((capacity) - (capacity) / 8)
+#define HMAP_ALIGN_UP(n, a) (((n) + ((a) - 1)) & ~((size_t)(a) - 1))
+
+// Largest power of two dividing n, capped at max_align_t's alignment: the
+// alignment any object of n bytes can need
+static size_t
+__hmap_align_of_size(size_t n)
+{
+     if(n == 0) return 1;
+     return agmin(n & (0 - n), (size_t)alignof(max_align_t));
+}
+
+// Table block: [ctrl | hashes | slots]
+static size_t
+__hmap_table_bytes(const ag_hashmap *map, size_t capacity, size_t *hashes_off, size_t *slots_off)
+{
+     *hashes_off = HMAP_ALIGN_UP(capacity + AG_HMAP_GROUP, alignof(uint32_t));
+     *slots_off = HMAP_ALIGN_UP(*hashes_off + capacity * sizeof(uint32_t), alignof(max_align_t));
+     return *slots_off + capacity * map->slot_size;
+}
+
+static inline void
+__hmap_set_ctrl(ag_hashmap *map, size_t i, int8_t tag)
+{
+     map->ctrl[i] = tag;
+     // Mirror the first group behind the end so unaligned group loads never wrap
+     if(i < AG_HMAP_GROUP) map->ctrl[map->capacity + i] = tag;
+}
+
+static inline byte*
+__hmap_slot(const ag_hashmap *map, size_t i)
+{
+     return map->slots + i * map->slot_size;
+}
+
+// First empty slot at or after the home position of hash
+static size_t
+__hmap_find_empty(const ag_hashmap *map, uint64_t hash)
+{
+     size_t mask = map->capacity - 1;
+     size_t pos = (size_t)hash & mask;
+     for(;;) {
+          uint32_t empty = __hmap_match(map->ctrl + pos, AG_HMAP_EMPTY);
+          if(empty) return (pos + (size_t)__builtin_ctz(empty)) & mask;
+          pos = (pos + AG_HMAP_GROUP) & mask;
+     }
+}
+
+static void
+__hmap_resize(ag_hashmap *map, size_t capacity)
+{
+     assert(capacity >= HMAP_MIN_CAPACITY && (capacity & (capacity - 1)) == 0);
+     // Home positions come from the 32 stored hash bits
+     assert(capacity <= ((size_t)1 << 32));
+
+     size_t hashes_off, slots_off;
+     size_t bytes = __hmap_table_bytes(map, capacity, &hashes_off, &slots_off);
+     byte *table = (byte*)ag_alloc(map->allocator, bytes);
+     if(table == NULL) {
+          fprintf(stderr, "Error: Memory allocation failed for hashmap\n");
+          exit(EXIT_FAILURE);
+     }
+
+     ag_hashmap old = *map;
+     map->ctrl = (int8_t*)table;
+     map->hashes = (uint32_t*)(table + hashes_off);
+     map->slots = table + slots_off;
+     map->capacity = capacity;
+     memset(map->ctrl, (byte)AG_HMAP_EMPTY, capacity + AG_HMAP_GROUP);
+
+     // Reinsert in old slot order; the tag does not depend on the capacity
+     for(size_t i = 0; i < old.capacity; i++) {
+          if(old.ctrl[i] == AG_HMAP_EMPTY) continue;
+          uint32_t hash = old.hashes[i];
+          size_t slot = __hmap_find_empty(map, hash);
+          __hmap_set_ctrl(map, slot, old.ctrl[i]);
+          map->hashes[slot] = hash;
+          memcpy(__hmap_slot(map, slot), old.slots + i * old.slot_size, map->slot_size);
+     }
+
+     if(old.capacity > 0)
+          ag_free(map->allocator, old.ctrl, __hmap_table_bytes(&old, old.capacity, &hashes_off, &slots_off));
+}
+
+static size_t
+__hmap_capacity_for(size_t n)
+{
+     size_t capacity = HMAP_MIN_CAPACITY;
+     while(HMAP_MAX_LOAD(capacity) < n) capacity <<= 1;
+     return capacity;
+}
+
+// Claims the empty slot `slot` for hash and returns it; the caller writes the key
+static size_t
+__hmap_claim(ag_hashmap *map, size_t slot, uint64_t hash)
+{
+     if(map->size + 1 > HMAP_MAX_LOAD(map->capacity)) {
+          __hmap_resize(map, map->capacity ? map->capacity * 2 : HMAP_MIN_CAPACITY);
+          slot = __hmap_find_empty(map, hash);
+     }
+     __hmap_set_ctrl(map, slot, __hmap_tag(hash));
+     map->hashes[slot] = (uint32_t)hash;
+     memset(__hmap_slot(map, slot) + map->value_offset, 0, map->value_size);
+     map->size++;
+     return slot;
+}
+
+// Backward-shift deletion: pull every following entry of the run one step
+// closer to its home until an empty slot or an entry already at home
+static void
+__hmap_remove_slot(ag_hashmap *map, size_t hole)
+{
+     size_t mask = map->capacity - 1;
+     size_t j = (hole + 1) & mask;
+     while(map->ctrl[j] != AG_HMAP_EMPTY) {
+          size_t home = map->hashes[j] & mask;
+          // Movable unless its home lies cyclically in (hole, j]
+          if(((j - home) & mask) >= ((j - hole) & mask)) {
+               __hmap_set_ctrl(map, hole, map->ctrl[j]);
+               map->hashes[hole] = map->hashes[j];
+               memcpy(__hmap_slot(map, hole), __hmap_slot(map, j), map->slot_size);
+               hole = j;
+          }
+          j = (j + 1) & mask;
+     }
+     __hmap_set_ctrl(map, hole, AG_HMAP_EMPTY);
+     map->size--;
+}
+
+// ---------------------------------------------------------------------------
+// Lifetime
+// ---------------------------------------------------------------------------
+
+static ag_hashmap*
+__hmap_init(size_t key_size, size_t value_size, ag_allocator *alloc, unsigned int flags)
+{
+     ag_hashmap *map = (ag_hashmap*)ag_alloc(alloc, sizeof(ag_hashmap));
+     if(map == NULL) {
+          fprintf(stderr, "Error: Memory allocation failed for hashmap\n");
+          exit(EXIT_FAILURE);
+     }
+
+     size_t key_align = __hmap_align_of_size(key_size);
+     size_t value_align = __hmap_align_of_size(value_size);
+
+     *map = (ag_hashmap){
+          .ctrl = NULL,
+          .hashes = NULL,
+          .slots = NULL,
+          .size = 0,
+          .capacity = 0,
+          .key_size = key_size,
+          .value_size = value_size,
+          .value_offset = HMAP_ALIGN_UP(key_size, value_align),
+          .allocator = alloc,
+          .flags = flags,
+     };
+     map->slot_size = HMAP_ALIGN_UP(map->value_offset + value_size, agmax(key_align, value_align));
+     return map;
+}
+
+ag_hashmap*
+hashmap_init(size_t key_size, size_t value_size)
+{
+     return __hmap_init(key_size, value_size, &ag_default_allocator, 0);
+}
+
+ag_hashmap*
+hashmap_init_with_alloc(size_t key_size, size_t value_size, ag_allocator *alloc)
+{
+     return __hmap_init(key_size, value_size, alloc, 0);
+}
+
+ag_hashmap*
+hashmap_init_string(size_t value_size)
+{
+     return __hmap_init(sizeof(ag_string), value_size, &ag_default_allocator, AG_HMAP_STRING_KEYS);
+}
+
+ag_hashmap*
+hashmap_init_string_with_alloc(size_t value_size, ag_allocator *alloc)
+{
+     return __hmap_init(sizeof(ag_string), value_size, alloc, AG_HMAP_STRING_KEYS);
+}
+
+static void
+__hmap_free_keys(ag_hashmap *map)
+{
+     if(!(map->flags & AG_HMAP_STRING_KEYS)) return;
+     for(size_t i = 0; i < map->capacity; i++) {
+          if(map->ctrl[i] == AG_HMAP_EMPTY) continue;
+          __vec_clean(*(ag_string*)__hmap_slot(map, i));
+     }
+}
+
+void
+hashmap_clear(ag_hashmap *map)
+{
+     if(map->size == 0) return;
+     __hmap_free_keys(map);
+     memset(map->ctrl, (byte)AG_HMAP_EMPTY, map->capacity + AG_HMAP_GROUP);
+     map->size = 0;
+}
+
+void
+hashmap_clean(ag_hashmap *map)
+{
+     if(map == NULL) return;
+     if(map->capacity > 0) {
+          size_t hashes_off, slots_off;
+          __hmap_free_keys(map);
+          ag_free(map->allocator, map->ctrl, __hmap_table_bytes(map, map->capacity, &hashes_off, &slots_off));
+     }
+     ag_free(map->allocator, map, sizeof(ag_hashmap));
+}
+
+void
+hashmap_reserve(ag_hashmap *map, size_t n)
+{
+     if(n > HMAP_MAX_LOAD(map->capacity))
+          __hmap_resize(map, __hmap_capacity_for(n));
+}
+
+void
+hashmap_rehash(ag_hashmap *map, size_t capacity)
+{
+     size_t target = __hmap_capacity_for(map->size);
+     while(target < capacity) target <<= 1;
+     if(target != map->capacity)
+          __hmap_resize(map, target);
+}
+
+// ---------------------------------------------------------------------------
+// Byte keys
+// ---------------------------------------------------------------------------
+
+uint64_t
+hashmap_hash(const ag_hashmap *map, const void *key)
+{
+     return __hmap_hash_bytes(key, map->key_size);
+}
+
+void*
+hashmap_find_hashed(const ag_hashmap *map, const void *key, uint64_t hash)
+{
+     assert(!(map->flags & AG_HMAP_STRING_KEYS));
+     size_t i = __hmap_probe_bytes(map, key, map->key_size, hash);
+     return i == AG_NPOS ? NULL : __hmap_slot(map, i) + map->value_offset;
+}
+
+void*
+hashmap_find(const ag_hashmap *map, const void *key)
+{
+     return hashmap_find_hashed(map, key, hashmap_hash(map, key));
+}
+
+size_t
+__hmap_insert_bytes(ag_hashmap *map, const void *key, uint64_t hash, bool *inserted)
+{
+     size_t i = __hmap_probe_bytes(map, key, map->key_size, hash);
+     if(inserted != NULL) *inserted = (i == AG_NPOS);
+     if(i != AG_NPOS) return i;
+
+     i = __hmap_claim(map, map->capacity ? __hmap_find_empty(map, hash) : 0, hash);
+     memcpy(__hmap_slot(map, i), key, map->key_size);
+     return i;
+}
+
+void*
+hashmap_insert_hashed(ag_hashmap *map, const void *key, uint64_t hash, bool *inserted)
+{
+     assert(!(map->flags & AG_HMAP_STRING_KEYS));
+     return __hmap_slot(map, __hmap_insert_bytes(map, key, hash, inserted)) + map->value_offset;
+}
+
+void*
+hashmap_insert(ag_hashmap *map, const void *key, bool *inserted)
+{
+     return hashmap_insert_hashed(map, key, hashmap_hash(map, key), inserted);
+}
+
+void
+hashmap_put(ag_hashmap *map, const void *key, const void *value)
+{
+     memcpy(hashmap_insert(map, key, NULL), value, map->value_size);
+}
+
+bool
+hashmap_erase(ag_hashmap *map, const void *key)
+{
+     assert(!(map->flags & AG_HMAP_STRING_KEYS));
+     size_t i = __hmap_probe_bytes(map, key, map->key_size, hashmap_hash(map, key));
+     if(i == AG_NPOS) return false;
+     __hmap_remove_slot(map, i);
+     return true;
+}
+
+// ---------------------------------------------------------------------------
+// ag_string keys
+// ---------------------------------------------------------------------------
+
+static size_t
+__hmap_probe_sv(const ag_hashmap *map, ag_string_view key, uint64_t hash)
+{
+     assert(map->flags & AG_HMAP_STRING_KEYS);
+     if(map->size == 0) return AG_NPOS;
+
+     size_t mask = map->capacity - 1;
+     size_t pos = (size_t)hash & mask;
+     int8_t tag = __hmap_tag(hash);
+     for(;;) {
+          uint32_t match = __hmap_match(map->ctrl + pos, tag);
+          uint32_t empty = __hmap_match(map->ctrl + pos, AG_HMAP_EMPTY);
+          if(empty) match &= (empty & (0u - empty)) - 1;
+          while(match) {
+               size_t i = (pos + (size_t)__builtin_ctz(match)) & mask;
+               ag_string stored = *(ag_string*)__hmap_slot(map, i);
+               if(sv_equal(sv_from_string(stored), key)) return i;
+               match &= match - 1;
+          }
+          if(empty) return AG_NPOS;
+          pos = (pos + AG_HMAP_GROUP) & mask;
+     }
+}
+
+void*
+hashmap_find_sv_hashed(const ag_hashmap *map, ag_string_view key, uint64_t hash)
+{
+     size_t i = __hmap_probe_sv(map, key, hash);
+     return i == AG_NPOS ? NULL : __hmap_slot(map, i) + map->value_offset;
+}
+
+void*
+hashmap_find_sv(const ag_hashmap *map, ag_string_view key)
+{
+     return hashmap_find_sv_hashed(map, key, hashmap_hash_sv(key));
+}
+
+void*
+hashmap_insert_sv_hashed(ag_hashmap *map, ag_string_view key, uint64_t hash, bool *inserted)
+{
+     size_t i = __hmap_probe_sv(map, key, hash);
+     if(inserted != NULL) *inserted = (i == AG_NPOS);
+     if(i == AG_NPOS) {
+          i = __hmap_claim(map, map->capacity ? __hmap_find_empty(map, hash) : 0, hash);
+          *(ag_string*)__hmap_slot(map, i) = new_string_n_with_alloc(key.data, key.size, map->allocator);
+     }
+     return __hmap_slot(map, i) + map->value_offset;
+}
+
+void*
+hashmap_insert_sv(ag_hashmap *map, ag_string_view key, bool *inserted)
+{
+     return hashmap_insert_sv_hashed(map, key, hashmap_hash_sv(key), inserted);
+}
+
+void
+hashmap_put_sv(ag_hashmap *map, ag_string_view key, const void *value)
+{
+     memcpy(hashmap_insert_sv(map, key, NULL), value, map->value_size);
+}
+
+bool
+hashmap_erase_sv(ag_hashmap *map, ag_string_view key)
+{
+     size_t i = __hmap_probe_sv(map, key, hashmap_hash_sv(key));
+     if(i == AG_NPOS) return false;
+     __vec_clean(*(ag_string*)__hmap_slot(map, i));
+     __hmap_remove_slot(map, i);
+     return true;
+}
+
+// ---------------------------------------------------------------------------
+// Iteration
+// ---------------------------------------------------------------------------
+
+bool
+hashmap_next(const ag_hashmap *map, size_t *it, void **key, void **value)
+{
+     for(size_t i = *it; i < map->capacity; i++) {
+          if(map->ctrl[i] == AG_HMAP_EMPTY) continue;
+          if(key != NULL) *key = __hmap_slot(map, i);
+          if(value != NULL) *value = __hmap_slot(map, i) + map->value_offset;
+          *it = i + 1;
+          return true;
+     }
+     *it = map->capacity;
+     return false;
+}
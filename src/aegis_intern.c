@@ -0,0 +1,272 @@
+#include "aegis/aegis_intern.h"
+#include <pthread.h>
+#include <stdalign.h>
+
+#define INTERN_MIN_TABLE 64
+#define INTERN_DIR_BASE 64   // Ids in directory bucket 0, each next bucket doubles
+#define INTERN_DIR_BUCKETS 32
+#define INTERN_BATCH 256
+#define INTERN_MAX_LOCAL ((UINT32_MAX >> AG_INTERN_SHARD_BITS) - 1)
+#define INTERN_ARENA_CHUNK (64 << 10)
+
+typedef struct {
+     alignas(64) pthread_rwlock_t lock;
+     ag_interned **table;     // Open addressing on the hash, NULL = empty slot
+     size_t capacity;         // Power of two, 0 before the first string
+     size_t count;            // Strings in this shard, the next local id
+     ag_arena *arena;         // Entries
+
+     // Local id -> entry. Buckets are allocated once and never move, so
+     // intern_entry reads them without the lock.
+     ag_interned **dir[INTERN_DIR_BUCKETS];
+} __intern_shard;
+
+struct __AG_INTERN__{
+     __intern_shard shards[AG_INTERN_SHARDS];
+};
+
+// Table slots use the low hash bits, the shard comes from higher ones
+static inline unsigned
+__intern_shard_of(uint64_t hash)
+{
+     return (unsigned)(hash >> 32) & (AG_INTERN_SHARDS - 1);
+}
+
+static inline size_t
+__intern_dir_bucket(size_t local, size_t *offset)
+{
+     size_t b = 63 - (size_t)__builtin_clzll(local / INTERN_DIR_BASE + 1);
+     *offset = local - INTERN_DIR_BASE * (((size_t)1 << b) - 1);
+     return b;
+}
+
+ag_intern*
+intern_init(void)
+{
+     ag_intern *pool = (ag_intern*)aligned_alloc(alignof(ag_intern), sizeof(ag_intern));
+     if(pool == NULL) {
+          fprintf(stderr, "Error: Memory allocation failed for intern pool\n");
+          exit(EXIT_FAILURE);
+     }
+     for(unsigned i = 0; i < AG_INTERN_SHARDS; i++) {
+          __intern_shard *sh = &pool->shards[i];
+          pthread_rwlock_init(&sh->lock, NULL);
+          sh->table = NULL;
+          sh->capacity = 0;
+          sh->count = 0;
+          sh->arena = ag_arena_init(INTERN_ARENA_CHUNK);
+          memset(sh->dir, 0, sizeof(sh->dir));
+     }
+     return pool;
+}
+
+void
+intern_clean(ag_intern *pool)
+{
+     if(pool == NULL) return;
+     for(unsigned i = 0; i < AG_INTERN_SHARDS; i++) {
+          __intern_shard *sh = &pool->shards[i];
+          pthread_rwlock_destroy(&sh->lock);
+          free(sh->table);
+          for(size_t b = 0; b < INTERN_DIR_BUCKETS; b++) free(sh->dir[b]);
+          ag_arena_clean(sh->arena);
+     }
+     free(pool);
+}
+
+// ---------------------------------------------------------------------------
+// Shard table, callers hold the shard lock
+// ---------------------------------------------------------------------------
+
+static ag_interned*
+__intern_probe(const __intern_shard *sh, ag_string_view s, uint64_t hash)
+{
+     if(sh->capacity == 0) return NULL;
+     size_t mask = sh->capacity - 1;
+     for(size_t i = hash & mask;; i = (i + 1) & mask) {
+          ag_interned *e = sh->table[i];
+          if(e == NULL) return NULL;
+          if(e->hash == hash && e->size == s.size && (s.size == 0 || memcmp(e->data, s.data, s.size) == 0))
+               return e;
+     }
+}
+
+static void
+__intern_table_put(ag_interned **table, size_t capacity, ag_interned *e)
+{
+     size_t mask = capacity - 1;
+     size_t i = e->hash & mask;
+     while(table[i] != NULL) i = (i + 1) & mask;
+     table[i] = e;
+}
+
+static void
+__intern_grow(__intern_shard *sh)
+{
+     size_t ncap = sh->capacity ? sh->capacity * 2 : INTERN_MIN_TABLE;
+     ag_interned **table = (ag_interned**)calloc(ncap, sizeof(ag_interned*));
+     if(table == NULL) {
+          fprintf(stderr, "Error: Memory allocation failed for intern table\n");
+          exit(EXIT_FAILURE);
+     }
+     for(size_t i = 0; i < sh->capacity; i++)
+          if(sh->table[i] != NULL) __intern_table_put(table, ncap, sh->table[i]);
+     free(sh->table);
+     sh->table = table;
+     sh->capacity = ncap;
+}
+
+// Caller holds the write lock and has seen s missing
+static ag_interned*
+__intern_add(__intern_shard *sh, unsigned shard, ag_string_view s, uint64_t hash)
+{
+     if(sh->count >= INTERN_MAX_LOCAL || s.size >= UINT32_MAX) {
+          fprintf(stderr, "Error: intern pool is full\n");
+          exit(EXIT_FAILURE);
+     }
+     // Load factor at most 3/4
+     if((sh->count + 1) * 4 > sh->capacity * 3) __intern_grow(sh);
+
+     size_t local = sh->count;
+     ag_interned *e = (ag_interned*)ag_alloc(&sh->arena->allocator, sizeof(ag_interned) + s.size + 1);
+     if(e == NULL) {
+          fprintf(stderr, "Error: Memory allocation failed for interned string\n");
+          exit(EXIT_FAILURE);
+     }
+     e->hash = hash;
+     e->size = (uint32_t)s.size;
+     e->id = (uint32_t)(local << AG_INTERN_SHARD_BITS) | shard;
+     if(s.size > 0) memcpy(e->data, s.data, s.size);
+     e->data[s.size] = '\0';
+
+     size_t offset, b = __intern_dir_bucket(local, &offset);
+     if(sh->dir[b] == NULL) {
+          ag_interned **bucket = (ag_interned**)calloc((size_t)INTERN_DIR_BASE << b, sizeof(ag_interned*));
+          if(bucket == NULL) {
+               fprintf(stderr, "Error: Memory allocation failed for intern directory\n");
+               exit(EXIT_FAILURE);
+          }
+          __atomic_store_n(&sh->dir[b], bucket, __ATOMIC_RELEASE);
+     }
+     // Publishes the filled entry to lock-free intern_entry readers
+     __atomic_store_n(&sh->dir[b][offset], e, __ATOMIC_RELEASE);
+
+     __intern_table_put(sh->table, sh->capacity, e);
+     __atomic_store_n(&sh->count, local + 1, __ATOMIC_RELAXED);
+     return e;
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+
+uint32_t
+intern_sv_hashed(ag_intern *pool, ag_string_view s, uint64_t hash)
+{
+     unsigned shard = __intern_shard_of(hash);
+     __intern_shard *sh = &pool->shards[shard];
+
+     pthread_rwlock_rdlock(&sh->lock);
+     ag_interned *e = __intern_probe(sh, s, hash);
+     pthread_rwlock_unlock(&sh->lock);
+     if(e != NULL) return e->id;
+
+     // Another thread may add it between the two locks
+     pthread_rwlock_wrlock(&sh->lock);
+     e = __intern_probe(sh, s, hash);
+     if(e == NULL) e = __intern_add(sh, shard, s, hash);
+     pthread_rwlock_unlock(&sh->lock);
+     return e->id;
+}
+
+uint32_t
+intern_sv(ag_intern *pool, ag_string_view s)
+{
+     return intern_sv_hashed(pool, s, sv_hash(s));
+}
+
+uint32_t
+intern_find_sv(ag_intern *pool, ag_string_view s)
+{
+     uint64_t hash = sv_hash(s);
+     __intern_shard *sh = &pool->shards[__intern_shard_of(hash)];
+
+     pthread_rwlock_rdlock(&sh->lock);
+     ag_interned *e = __intern_probe(sh, s, hash);
+     pthread_rwlock_unlock(&sh->lock);
+     return e != NULL ? e->id : AG_INTERN_NONE;
+}
+
+void
+intern_tokens(ag_intern *pool, ag_string_view src, const vector *tokens, uint32_t *ids)
+{
+     assert(tokens->element_size == sizeof(ag_token));
+     const ag_token *toks = (const ag_token*)tokens->data;
+     uint64_t hashes[INTERN_BATCH];
+     uint16_t order[INTERN_BATCH];
+     size_t starts[AG_INTERN_SHARDS + 1];
+
+     for(size_t base = 0; base < tokens->size; base += INTERN_BATCH) {
+          size_t n = agmin(tokens->size - base, (size_t)INTERN_BATCH);
+
+          // Hash the batch and bucket it by shard (counting sort)
+          memset(starts, 0, sizeof(starts));
+          for(size_t i = 0; i < n; i++) {
+               hashes[i] = sv_hash(sv_token(src, toks[base + i]));
+               starts[__intern_shard_of(hashes[i]) + 1]++;
+          }
+          for(unsigned s = 0; s < AG_INTERN_SHARDS; s++) starts[s + 1] += starts[s];
+          size_t fill[AG_INTERN_SHARDS];
+          memcpy(fill, starts, sizeof(fill));
+          for(size_t i = 0; i < n; i++)
+               order[fill[__intern_shard_of(hashes[i])]++] = (uint16_t)i;
+
+          for(unsigned s = 0; s < AG_INTERN_SHARDS; s++) {
+               if(starts[s] == starts[s + 1]) continue;
+               __intern_shard *sh = &pool->shards[s];
+               bool missing = false;
+
+               pthread_rwlock_rdlock(&sh->lock);
+               for(size_t k = starts[s]; k < starts[s + 1]; k++) {
+                    size_t i = order[k];
+                    ag_interned *e = __intern_probe(sh, sv_token(src, toks[base + i]), hashes[i]);
+                    ids[base + i] = e != NULL ? e->id : AG_INTERN_NONE;
+                    missing |= e == NULL;
+               }
+               pthread_rwlock_unlock(&sh->lock);
+               if(!missing) continue;
+
+               pthread_rwlock_wrlock(&sh->lock);
+               for(size_t k = starts[s]; k < starts[s + 1]; k++) {
+                    size_t i = order[k];
+                    if(ids[base + i] != AG_INTERN_NONE) continue;
+                    ag_string_view tok = sv_token(src, toks[base + i]);
+                    ag_interned *e = __intern_probe(sh, tok, hashes[i]);
+                    if(e == NULL) e = __intern_add(sh, s, tok, hashes[i]);
+                    ids[base + i] = e->id;
+               }
+               pthread_rwlock_unlock(&sh->lock);
+          }
+     }
+}
+
+const ag_interned*
+intern_entry(const ag_intern *pool, uint32_t id)
+{
+     const __intern_shard *sh = &pool->shards[id & (AG_INTERN_SHARDS - 1)];
+     size_t offset, b = __intern_dir_bucket(id >> AG_INTERN_SHARD_BITS, &offset);
+     ag_interned **bucket = __atomic_load_n(&sh->dir[b], __ATOMIC_ACQUIRE);
+     assert(bucket != NULL);
+     ag_interned *e = __atomic_load_n(&bucket[offset], __ATOMIC_ACQUIRE);
+     assert(e != NULL);
+     return e;
+}
+
+size_t
+intern_size(const ag_intern *pool)
+{
+     size_t total = 0;
+     for(unsigned i = 0; i < AG_INTERN_SHARDS; i++)
+          total += __atomic_load_n(&pool->shards[i].count, __ATOMIC_RELAXED);
+     return total;
+}
@@ -0,0 +1,279 @@
+#include "aegis/aegis_io.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#define IO_HAS_MMAP 1
+#else
+#define IO_HAS_MMAP 0
+#endif
+
+struct __AG_READER__{
+     const char *data;        // buf->data, or the mapping
+     size_t size;             // Valid bytes in data
+     size_t start;            // First byte not yet returned
+     size_t scan;             // [start, scan) holds no delimiter
+     ag_string buf;           // NULL for a mapped file
+     size_t chunk;            // Bytes asked of each read
+     void *map;
+     size_t map_size;
+     int fd;
+     int error;
+     bool owns_fd;
+     bool eof;                // No more bytes will arrive in data
+};
+
+struct __AG_WRITER__{
+     ag_string buf;
+     size_t chunk;            // Flush when buf would pass this
+     int fd;
+     int error;
+     bool owns_fd;
+};
+
+// ---------------------------------------------------------------------------
+// Reader
+// ---------------------------------------------------------------------------
+
+static bool
+__reader_map(ag_reader *r)
+{
+#if IO_HAS_MMAP
+     struct stat st;
+     if(fstat(r->fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0) return false;
+     void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, r->fd, 0);
+     if(map == MAP_FAILED) return false;
+     madvise(map, (size_t)st.st_size, MADV_SEQUENTIAL);
+     r->map = map;
+     r->map_size = (size_t)st.st_size;
+     r->data = (const char*)map;
+     r->size = r->map_size;
+     r->eof = true;
+     return true;
+#else
+     (void)r;
+     return false;
+#endif
+}
+
+ag_reader*
+reader_from_fd(int fd, size_t buffer_size, unsigned flags)
+{
+     ag_reader *r = (ag_reader*)calloc(1, sizeof(ag_reader));
+     if(r == NULL) {
+          fprintf(stderr, "Error: Memory allocation failed for reader\n");
+          exit(EXIT_FAILURE);
+     }
+     r->fd = fd;
+     r->chunk = buffer_size > 0 ? buffer_size : AG_IO_BUFFER;
+     if((flags & AG_READER_MMAP) && __reader_map(r)) return r;
+
+     r->buf = new_string("");
+     string_reserve(r->buf, r->chunk);
+     r->data = (const char*)r->buf->data;
+#if defined(POSIX_FADV_SEQUENTIAL)
+     posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+     return r;
+}
+
+ag_reader*
+reader_open(const char *path, unsigned flags)
+{
+     int fd = open(path, O_RDONLY | O_CLOEXEC);
+     if(fd < 0) return NULL;
+     ag_reader *r = reader_from_fd(fd, 0, flags);
+     r->owns_fd = true;
+     return r;
+}
+
+void
+reader_close(ag_reader *r)
+{
+     if(r == NULL) return;
+#if IO_HAS_MMAP
+     if(r->map != NULL) munmap(r->map, r->map_size);
+#endif
+     if(r->buf != NULL) vec_clean(r->buf);
+     if(r->owns_fd) close(r->fd);
+     free(r);
+}
+
+int
+reader_error(const ag_reader *r)
+{
+     return r->error;
+}
+
+// Drops the returned bytes and appends one read. A pending record of more
+// than half a chunk grows the buffer, so reads stay chunk-sized.
+static void
+__reader_fill(ag_reader *r)
+{
+     ag_string buf = r->buf;
+     size_t pending = r->size - r->start;
+     if(r->start > 0) {
+          memmove(buf->data, (char*)buf->data + r->start, pending);
+          r->scan -= r->start;
+          r->start = 0;
+          buf->size = pending;
+     }
+
+     char *dst = string_spare(buf, pending > r->chunk / 2 ? r->chunk : r->chunk - pending);
+     size_t room = buf->capacity - 1 - buf->size;
+     ssize_t got;
+     do got = read(r->fd, dst, room);
+     while(got < 0 && errno == EINTR);
+
+     if(got <= 0) {
+          if(got < 0) r->error = errno;
+          r->eof = true;
+     } else {
+          string_commit(buf, (size_t)got);
+     }
+     r->data = (const char*)buf->data;
+     r->size = buf->size;
+}
+
+static bool
+__reader_next(ag_reader *r, char delim, ag_string_view *out, bool *ended)
+{
+     for(;;) {
+          if(r->scan < r->size) {
+               const char *hit = (const char*)memchr(r->data + r->scan, delim, r->size - r->scan);
+               if(hit != NULL) {
+                    size_t end = (size_t)(hit - r->data);
+                    *out = (ag_string_view){ r->data + r->start, end - r->start };
+                    *ended = true;
+                    r->start = r->scan = end + 1;
+                    return true;
+               }
+               r->scan = r->size;
+          }
+          if(r->eof) {
+               if(r->start == r->size) return false;
+               *out = (ag_string_view){ r->data + r->start, r->size - r->start };
+               *ended = false;
+               r->start = r->size;
+               return true;
+          }
+          __reader_fill(r);
+     }
+}
+
+bool
+reader_next_record(ag_reader *r, char delim, ag_string_view *out)
+{
+     bool ended;
+     return __reader_next(r, delim, out, &ended);
+}
+
+bool
+reader_next_line(ag_reader *r, ag_string_view *out)
+{
+     bool ended;
+     if(!__reader_next(r, '\n', out, &ended)) return false;
+     if(ended && out->size > 0 && out->data[out->size - 1] == '\r') out->size--;
+     return true;
+}
+
+// ---------------------------------------------------------------------------
+// Writer
+// ---------------------------------------------------------------------------
+
+ag_writer*
+writer_from_fd(int fd, size_t buffer_size)
+{
+     ag_writer *w = (ag_writer*)calloc(1, sizeof(ag_writer));
+     if(w == NULL) {
+          fprintf(stderr, "Error: Memory allocation failed for writer\n");
+          exit(EXIT_FAILURE);
+     }
+     w->fd = fd;
+     w->chunk = buffer_size > 0 ? buffer_size : AG_IO_BUFFER;
+     w->buf = new_string("");
+     string_reserve(w->buf, w->chunk);
+     return w;
+}
+
+ag_writer*
+writer_open(const char *path, unsigned flags)
+{
+     int mode = (flags & AG_WRITER_APPEND) ? O_APPEND : O_TRUNC;
+     int fd = open(path, O_WRONLY | O_CREAT | O_CLOEXEC | mode, 0644);
+     if(fd < 0) return NULL;
+     ag_writer *w = writer_from_fd(fd, 0);
+     w->owns_fd = true;
+     return w;
+}
+
+int
+writer_error(const ag_writer *w)
+{
+     return w->error;
+}
+
+static bool
+__writer_write_all(ag_writer *w, const char *p, size_t n)
+{
+     while(n > 0) {
+          ssize_t put = write(w->fd, p, n);
+          if(put < 0) {
+               if(errno == EINTR) continue;
+               w->error = errno;
+               return false;
+          }
+          p += put;
+          n -= (size_t)put;
+     }
+     return true;
+}
+
+bool
+writer_flush(ag_writer *w)
+{
+     if(w->error != 0) return false;
+     bool ok = __writer_write_all(w, (const char*)w->buf->data, w->buf->size);
+     w->buf->size = 0;
+     sget(w->buf)[0] = '\0';
+     return ok;
+}
+
+bool
+writer_write(ag_writer *w, ag_string_view s)
+{
+     if(w->error != 0) return false;
+     if(w->buf->size + s.size > w->chunk) {
+          if(!writer_flush(w)) return false;
+          if(s.size > w->chunk / 2) return __writer_write_all(w, s.data, s.size);
+     }
+     if(s.size > 0) string_append_n(w->buf, s.data, s.size);
+     return true;
+}
+
+bool
+writer_write_char(ag_writer *w, char c)
+{
+     if(w->error != 0) return false;
+     if(w->buf->size == w->chunk && !writer_flush(w)) return false;
+     string_append_n(w->buf, &c, 1);
+     return true;
+}
+
+bool
+writer_close(ag_writer *w)
+{
+     if(w == NULL) return true;
+     bool ok = writer_flush(w);
+     if(w->owns_fd && close(w->fd) != 0 && ok) {
+          w->error = errno;
+          ok = false;
+     }
+     vec_clean(w->buf);
+     free(w);
+     return ok;
+}
@@ -0,0 +1,421 @@
+#include "aegis/aegis_numformat.h"
+
+#include <stdarg.h>
+
+// ---------------------------------------------------------------------------
+// Integers
+// ---------------------------------------------------------------------------
+
+static const char __digit_pairs[201] =
+     "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+     "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+     "8081828384858687888990919293949596979899";
+
+static inline size_t
+__u64_digits(uint64_t v)
+{
+     // floor(log10(v)) from the bit length, corrected by one compare
+     static const uint64_t pow10[20] = {
+          1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull,
+          100000000ull, 1000000000ull, 10000000000ull, 100000000000ull, 1000000000000ull,
+          10000000000000ull, 100000000000000ull, 1000000000000000ull, 10000000000000000ull,
+          100000000000000000ull, 1000000000000000000ull, 10000000000000000000ull,
+     };
+     if(v == 0) return 1;
+     size_t guess = ((size_t)(64 - __builtin_clzll(v)) * 1233) >> 12;
+     return guess + (v >= pow10[guess]);
+}
+
+size_t
+ag_format_u64(char *buf, uint64_t v)
+{
+     size_t len = __u64_digits(v);
+     char *it = buf + len;
+
+     // Two digits per division from the back
+     while(v >= 100) {
+          size_t pair = (size_t)(v % 100) * 2;
+          v /= 100;
+          *--it = __digit_pairs[pair + 1];
+          *--it = __digit_pairs[pair];
+     }
+     if(v >= 10) {
+          *--it = __digit_pairs[v * 2 + 1];
+          *--it = __digit_pairs[v * 2];
+     }
+     else *--it = (char)('0' + v);
+     return len;
+}
+
+size_t
+ag_format_i64(char *buf, int64_t v)
+{
+     if(v >= 0) return ag_format_u64(buf, (uint64_t)v);
+     buf[0] = '-';
+     return 1 + ag_format_u64(buf + 1, 0 - (uint64_t)v);
+}
+
+// ---------------------------------------------------------------------------
+// Doubles: Grisu2 (Loitsch, "Printing Floating-Point Numbers Quickly and
+// Accurately with Integers", 2010), with alpha = -60 and gamma = -32.
+// ---------------------------------------------------------------------------
+
+typedef struct {
+     uint64_t f;
+     int e;
+} __diyfp;
+
+static inline __diyfp
+__diyfp_sub(__diyfp x, __diyfp y)
+{
+     return (__diyfp){ x.f - y.f, x.e };
+}
+
+// Upper 64 bits of the 128-bit product, rounded
+static inline __diyfp
+__diyfp_mul(__diyfp x, __diyfp y)
+{
+     __uint128_t p = (__uint128_t)x.f * y.f;
+     uint64_t h = (uint64_t)(p >> 64) + (uint64_t)((p >> 63) & 1);
+     return (__diyfp){ h, x.e + y.e + 64 };
+}
+
+static inline __diyfp
+__diyfp_normalize(__diyfp x)
+{
+     int shift = __builtin_clzll(x.f);
+     return (__diyfp){ x.f << shift, x.e - shift };
+}
+
+static inline __diyfp
+__diyfp_normalize_to(__diyfp x, int target_exponent)
+{
+     return (__diyfp){ x.f << (x.e - target_exponent), target_exponent };
+}
+
+// v and its rounding boundaries m- / m+, all on the exponent of normalized m+
+static void
+__compute_boundaries(double value, __diyfp *minus, __diyfp *v, __diyfp *plus)
+{
+     const uint64_t hidden = (uint64_t)1 << 52;
+     const int bias = 1023 + 52;
+
+     uint64_t bits;
+     memcpy(&bits, &value, sizeof(bits));
+     uint64_t E = bits >> 52;
+     uint64_t F = bits & (hidden - 1);
+
+     __diyfp w = (E == 0) ? (__diyfp){ F, 1 - bias }
+                          : (__diyfp){ F + hidden, (int)E - bias };
+
+     // The gap below is half as wide when F is the smallest mantissa of a binade
+     bool lower_closer = (F == 0 && E > 1);
+     __diyfp m_plus = { 2 * w.f + 1, w.e - 1 };
+     __diyfp m_minus = lower_closer ? (__diyfp){ 4 * w.f - 1, w.e - 2 }
+                                    : (__diyfp){ 2 * w.f - 1, w.e - 1 };
+
+     *plus = __diyfp_normalize(m_plus);
+     *minus = __diyfp_normalize_to(m_minus, plus->e);
+     *v = __diyfp_normalize(w);
+}
+
+typedef struct {
+     uint64_t f;
+     int e;
+     int k;
+} __cached_power;
+
+// Normalized 10^k for k = -300, -292, ..., 324
+static const __cached_power __cached_powers[] = {
+     { 0xAB70FE17C79AC6CAull, -1060, -300 },
+     { 0xFF77B1FCBEBCDC4Full, -1034, -292 },
+     { 0xBE5691EF416BD60Cull, -1007, -284 },
+     { 0x8DD01FAD907FFC3Cull,  -980, -276 },
+     { 0xD3515C2831559A83ull,  -954, -268 },
+     { 0x9D71AC8FADA6C9B5ull,  -927, -260 },
+     { 0xEA9C227723EE8BCBull,  -901, -252 },
+     { 0xAECC49914078536Dull,  -874, -244 },
+     { 0x823C12795DB6CE57ull,  -847, -236 },
+     { 0xC21094364DFB5637ull,  -821, -228 },
+     { 0x9096EA6F3848984Full,  -794, -220 },
+     { 0xD77485CB25823AC7ull,  -768, -212 },
+     { 0xA086CFCD97BF97F4ull,  -741, -204 },
+     { 0xEF340A98172AACE5ull,  -715, -196 },
+     { 0xB23867FB2A35B28Eull,  -688, -188 },
+     { 0x84C8D4DFD2C63F3Bull,  -661, -180 },
+     { 0xC5DD44271AD3CDBAull,  -635, -172 },
+     { 0x936B9FCEBB25C996ull,  -608, -164 },
+     { 0xDBAC6C247D62A584ull,  -582, -156 },
+     { 0xA3AB66580D5FDAF6ull,  -555, -148 },
+     { 0xF3E2F893DEC3F126ull,  -529, -140 },
+     { 0xB5B5ADA8AAFF80B8ull,  -502, -132 },
+     { 0x87625F056C7C4A8Bull,  -475, -124 },
+     { 0xC9BCFF6034C13053ull,  -449, -116 },
+     { 0x964E858C91BA2655ull,  -422, -108 },
+     { 0xDFF9772470297EBDull,  -396, -100 },
+     { 0xA6DFBD9FB8E5B88Full,  -369,  -92 },
+     { 0xF8A95FCF88747D94ull,  -343,  -84 },
+     { 0xB94470938FA89BCFull,  -316,  -76 },
+     { 0x8A08F0F8BF0F156Bull,  -289,  -68 },
+     { 0xCDB02555653131B6ull,  -263,  -60 },
+     { 0x993FE2C6D07B7FACull,  -236,  -52 },
+     { 0xE45C10C42A2B3B06ull,  -210,  -44 },
+     { 0xAA242499697392D3ull,  -183,  -36 },
+     { 0xFD87B5F28300CA0Eull,  -157,  -28 },
+     { 0xBCE5086492111AEBull,  -130,  -20 },
+     { 0x8CBCCC096F5088CCull,  -103,  -12 },
+     { 0xD1B71758E219652Cull,   -77,   -4 },
+     { 0x9C40000000000000ull,   -50,    4 },
+     { 0xE8D4A51000000000ull,   -24,   12 },
+     { 0xAD78EBC5AC620000ull,     3,   20 },
+     { 0x813F3978F8940984ull,    30,   28 },
+     { 0xC097CE7BC90715B3ull,    56,   36 },
+     { 0x8F7E32CE7BEA5C70ull,    83,   44 },
+     { 0xD5D238A4ABE98068ull,   109,   52 },
+     { 0x9F4F2726179A2245ull,   136,   60 },
+     { 0xED63A231D4C4FB27ull,   162,   68 },
+     { 0xB0DE65388CC8ADA8ull,   189,   76 },
+     { 0x83C7088E1AAB65DBull,   216,   84 },
+     { 0xC45D1DF942711D9Aull,   242,   92 },
+     { 0x924D692CA61BE758ull,   269,  100 },
+     { 0xDA01EE641A708DEAull,   295,  108 },
+     { 0xA26DA3999AEF774Aull,   322,  116 },
+     { 0xF209787BB47D6B85ull,   348,  124 },
+     { 0xB454E4A179DD1877ull,   375,  132 },
+     { 0x865B86925B9BC5C2ull,   402,  140 },
+     { 0xC83553C5C8965D3Dull,   428,  148 },
+     { 0x952AB45CFA97A0B3ull,   455,  156 },
+     { 0xDE469FBD99A05FE3ull,   481,  164 },
+     { 0xA59BC234DB398C25ull,   508,  172 },
+     { 0xF6C69A72A3989F5Cull,   534,  180 },
+     { 0xB7DCBF5354E9BECEull,   561,  188 },
+     { 0x88FCF317F22241E2ull,   588,  196 },
+     { 0xCC20CE9BD35C78A5ull,   614,  204 },
+     { 0x98165AF37B2153DFull,   641,  212 },
+     { 0xE2A0B5DC971F303Aull,   667,  220 },
+     { 0xA8D9D1535CE3B396ull,   694,  228 },
+     { 0xFB9B7CD9A4A7443Cull,   720,  236 },
+     { 0xBB764C4CA7A44410ull,   747,  244 },
+     { 0x8BAB8EEFB6409C1Aull,   774,  252 },
+     { 0xD01FEF10A657842Cull,   800,  260 },
+     { 0x9B10A4E5E9913129ull,   827,  268 },
+     { 0xE7109BFBA19C0C9Dull,   853,  276 },
+     { 0xAC2820D9623BF429ull,   880,  284 },
+     { 0x80444B5E7AA7CF85ull,   907,  292 },
+     { 0xBF21E44003ACDD2Dull,   933,  300 },
+     { 0x8E679C2F5E44FF8Full,   960,  308 },
+     { 0xD433179D9C8CB841ull,   986,  316 },
+     { 0x9E19DB92B4E31BA9ull,  1013,  324 },
+};
+
+static __cached_power
+__cached_power_for(int e)
+{
+     // Pick c = 10^-k with alpha <= e_c + e + 64 <= gamma
+     const int alpha = -60;
+     const int min_dec_exp = -300, dec_step = 8;
+     int f = alpha - e - 1;
+     int k = (f * 78913) / (1 << 18) + (f > 0);
+     int index = (-min_dec_exp + k + (dec_step - 1)) / dec_step;
+     return __cached_powers[index];
+}
+
+static inline int
+__largest_pow10(uint32_t n, uint32_t *pow10)
+{
+     static const uint32_t p[10] = {
+          1u, 10u, 100u, 1000u, 10000u, 100000u, 1000000u, 10000000u, 100000000u, 1000000000u,
+     };
+     int k = 9;
+     while(k > 0 && n < p[k]) k--;
+     *pow10 = p[k];
+     return k + 1;
+}
+
+static inline void
+__grisu2_round(char *buf, size_t len, uint64_t dist, uint64_t delta, uint64_t rest, uint64_t ten_k)
+{
+     // Walk the last digit down while it stays inside the rounding interval
+     // and gets closer to w
+     while(rest < dist && delta - rest >= ten_k &&
+           (rest + ten_k < dist || dist - rest > rest + ten_k - dist)) {
+          buf[len - 1]--;
+          rest += ten_k;
+     }
+}
+
+static void
+__grisu2_digit_gen(char *buf, size_t *len, int *dec_exp, __diyfp M_minus, __diyfp w, __diyfp M_plus)
+{
+     uint64_t delta = __diyfp_sub(M_plus, M_minus).f;
+     uint64_t dist = __diyfp_sub(M_plus, w).f;
+
+     const __diyfp one = { (uint64_t)1 << -M_plus.e, M_plus.e };
+     uint32_t p1 = (uint32_t)(M_plus.f >> -one.e);  // integral part
+     uint64_t p2 = M_plus.f & (one.f - 1);          // fractional part
+
+     uint32_t pow10;
+     int n = __largest_pow10(p1, &pow10);
+     size_t length = 0;
+
+     while(n > 0) {
+          buf[length++] = (char)('0' + p1 / pow10);
+          p1 %= pow10;
+          n--;
+
+          uint64_t rest = ((uint64_t)p1 << -one.e) + p2;
+          if(rest <= delta) {
+               *dec_exp += n;
+               __grisu2_round(buf, length, dist, delta, rest, (uint64_t)pow10 << -one.e);
+               *len = length;
+               return;
+          }
+          pow10 /= 10;
+     }
+
+     int m = 0;
+     for(;;) {
+          p2 *= 10;
+          buf[length++] = (char)('0' + (p2 >> -one.e));
+          p2 &= one.f - 1;
+          m++;
+          delta *= 10;
+          dist *= 10;
+          if(p2 <= delta) break;
+     }
+     *dec_exp -= m;
+     __grisu2_round(buf, length, dist, delta, p2, one.f);
+     *len = length;
+}
+
+// Digits of a finite positive double into buf, value = digits * 10^dec_exp
+static size_t
+__grisu2(char *buf, double value, int *dec_exp)
+{
+     __diyfp m_minus, v, m_plus;
+     __compute_boundaries(value, &m_minus, &v, &m_plus);
+
+     __cached_power cached = __cached_power_for(m_plus.e);
+     __diyfp c_minus_k = { cached.f, cached.e };
+
+     __diyfp w = __diyfp_mul(v, c_minus_k);
+     __diyfp w_minus = __diyfp_mul(m_minus, c_minus_k);
+     __diyfp w_plus = __diyfp_mul(m_plus, c_minus_k);
+
+     // Shrink the interval by one unit on each side to stay inside it
+     __diyfp M_minus = { w_minus.f + 1, w_minus.e };
+     __diyfp M_plus = { w_plus.f - 1, w_plus.e };
+
+     size_t len = 0;
+     *dec_exp = -cached.k;
+     __grisu2_digit_gen(buf, &len, dec_exp, M_minus, w, M_plus);
+     return len;
+}
+
+// Places the decimal point: plain notation for 1e-4 <= |v| < 1e15,
+// d.ddde[-]x otherwise
+static size_t
+__format_decimal(char *buf, size_t k, int dec_exp)
+{
+     const int min_exp = -4, max_exp = 15;
+     int n = (int)k + dec_exp; // position of the decimal point
+
+     if((int)k <= n && n <= max_exp) {
+          // digits000.0
+          memset(buf + k, '0', (size_t)n - k);
+          buf[n] = '.';
+          buf[n + 1] = '0';
+          return (size_t)n + 2;
+     }
+     if(0 < n && n <= max_exp) {
+          // dig.its
+          memmove(buf + n + 1, buf + n, k - (size_t)n);
+          buf[n] = '.';
+          return k + 1;
+     }
+     if(min_exp < n && n <= 0) {
+          // 0.000digits
+          memmove(buf + 2 + (-n), buf, k);
+          buf[0] = '0';
+          buf[1] = '.';
+          memset(buf + 2, '0', (size_t)(-n));
+          return 2 + (size_t)(-n) + k;
+     }
+
+     size_t len;
+     if(k == 1) len = 1;
+     else {
+          memmove(buf + 2, buf + 1, k - 1);
+          buf[1] = '.';
+          len = k + 1;
+     }
+     buf[len++] = 'e';
+     return len + ag_format_i64(buf + len, n - 1);
+}
+
+size_t
+ag_format_double(char *buf, double v)
+{
+     size_t len = 0;
+     if(signbit(v)) {
+          buf[len++] = '-';
+          v = -v;
+     }
+     if(isnan(v)) {
+          // No signed nan in the output
+          memcpy(buf, "nan", 3);
+          return 3;
+     }
+     if(isinf(v)) {
+          memcpy(buf + len, "inf", 3);
+          return len + 3;
+     }
+     if(v == 0.0) {
+          memcpy(buf + len, "0.0", 3);
+          return len + 3;
+     }
+
+     int dec_exp;
+     size_t k = __grisu2(buf + len, v, &dec_exp);
+     return len + __format_decimal(buf + len, k, dec_exp);
+}
+
+// ---------------------------------------------------------------------------
+// ag_string appends
+// ---------------------------------------------------------------------------
+
+void
+string_append_u64(ag_string str, uint64_t v)
+{
+     string_commit(str, ag_format_u64(string_spare(str, AG_FORMAT_U64_MAX), v));
+}
+
+void
+string_append_int(ag_string str, long long v)
+{
+     string_commit(str, ag_format_i64(string_spare(str, AG_FORMAT_I64_MAX), (int64_t)v));
+}
+
+void
+string_append_double(ag_string str, double v)
+{
+     string_commit(str, ag_format_double(string_spare(str, AG_FORMAT_DOUBLE_MAX), v));
+}
+
+void
+string_appendf(ag_string str, const char *fmt, ...)
+{
+     va_list ap, retry;
+     va_start(ap, fmt);
+     va_copy(retry, ap);
+
+     // Try the spare capacity first, grow once to the exact size if short
+     size_t room = str->capacity - str->size;
+     int n = vsnprintf(((char*)str->data) + str->size, room, fmt, ap);
+     if(n >= 0 && (size_t)n >= room)
+          vsnprintf(string_spare(str, (size_t)n), (size_t)n + 1, fmt, retry);
+     if(n > 0) string_commit(str, (size_t)n);
+
+     va_end(retry);
+     va_end(ap);
+}
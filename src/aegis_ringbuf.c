@@ -0,0 +1,294 @@
+#include "aegis/aegis_ringbuf.h"
+#include "aegis/aegis_utils.h"
+
+#include <stdalign.h>
+
+#define RING_ALIGN_UP(n, a) (((n) + ((a) - 1)) & ~((size_t)(a) - 1))
+
+typedef _Atomic size_t __ring_seq;
+
+static inline __ring_seq*
+__ring_cell_seq(const ag_ringbuf *ring, size_t pos)
+{
+     return (__ring_seq*)(ring->cells + (pos & (ring->capacity - 1)) * ring->cell_size);
+}
+
+static inline byte*
+__ring_cell_data(const ag_ringbuf *ring, size_t pos)
+{
+     return ring->cells + (pos & (ring->capacity - 1)) * ring->cell_size + ring->data_offset;
+}
+
+// Signed distance between two wrapping positions
+static inline intptr_t
+__ring_diff(size_t a, size_t b)
+{
+     return (intptr_t)(a - b);
+}
+
+static ag_ringbuf*
+__ring_init(size_t capacity, size_t element_size, ag_allocator *alloc, unsigned int flags)
+{
+     assert(element_size > 0);
+     size_t cap = 2;
+     while(cap < capacity) cap <<= 1;
+
+     ag_ringbuf *ring = (ag_ringbuf*)ag_alloc(alloc, sizeof(ag_ringbuf));
+     if(ring == NULL) {
+          fprintf(stderr, "Error: Memory allocation failed for ring buffer\n");
+          exit(EXIT_FAILURE);
+     }
+
+     ring->capacity = cap;
+     ring->element_size = element_size;
+     ring->allocator = alloc;
+     ring->flags = flags;
+     if(flags & AG_RING_SPSC) {
+          ring->data_offset = 0;
+          ring->cell_size = element_size;
+     }
+     else {
+          // [sequence | record], record aligned for its size
+          size_t align = agmin(element_size & (0 - element_size), (size_t)alignof(max_align_t));
+          ring->data_offset = RING_ALIGN_UP(sizeof(__ring_seq), align);
+          ring->cell_size = RING_ALIGN_UP(ring->data_offset + element_size,
+                                          agmax(align, (size_t)alignof(__ring_seq)));
+     }
+
+     ring->cells = (byte*)ag_alloc(alloc, cap * ring->cell_size);
+     if(ring->cells == NULL) {
+          fprintf(stderr, "Error: Memory allocation failed for ring buffer\n");
+          exit(EXIT_FAILURE);
+     }
+
+     // Cell i starts out waiting for the producer of position i
+     if(!(flags & AG_RING_SPSC)) {
+          for(size_t i = 0; i < cap; i++)
+               atomic_init(__ring_cell_seq(ring, i), i);
+     }
+     atomic_init(&ring->head, 0);
+     atomic_init(&ring->tail, 0);
+     ring->cached_head = ring->cached_tail = 0;
+     return ring;
+}
+
+ag_ringbuf*
+ringbuf_init(size_t capacity, size_t element_size)
+{
+     return __ring_init(capacity, element_size, &ag_default_allocator, 0);
+}
+
+ag_ringbuf*
+ringbuf_init_with_alloc(size_t capacity, size_t element_size, ag_allocator *alloc)
+{
+     return __ring_init(capacity, element_size, alloc, 0);
+}
+
+ag_ringbuf*
+ringbuf_init_spsc(size_t capacity, size_t element_size)
+{
+     return __ring_init(capacity, element_size, &ag_default_allocator, AG_RING_SPSC);
+}
+
+ag_ringbuf*
+ringbuf_init_spsc_with_alloc(size_t capacity, size_t element_size, ag_allocator *alloc)
+{
+     return __ring_init(capacity, element_size, alloc, AG_RING_SPSC);
+}
+
+void
+ringbuf_clean(ag_ringbuf *ring)
+{
+     if(ring == NULL) return;
+     ag_free(ring->allocator, ring->cells, ring->capacity * ring->cell_size);
+     ag_free(ring->allocator, ring, sizeof(ag_ringbuf));
+}
+
+size_t
+ringbuf_size(const ag_ringbuf *ring)
+{
+     size_t tail = atomic_load_explicit(&((ag_ringbuf*)ring)->tail, memory_order_acquire);
+     size_t head = atomic_load_explicit(&((ag_ringbuf*)ring)->head, memory_order_acquire);
+     intptr_t size = __ring_diff(head, tail);
+     if(size < 0) return 0;
+     return agmin((size_t)size, ring->capacity);
+}
+
+// ---------------------------------------------------------------------------
+// SPSC
+// ---------------------------------------------------------------------------
+
+// Copies n records between the ring at pos and a flat buffer, in at most two
+// pieces around the wrap
+static inline void
+__spsc_copy_in(ag_ringbuf *ring, size_t pos, const byte *src, size_t n)
+{
+     size_t start = pos & (ring->capacity - 1);
+     size_t first = agmin(n, ring->capacity - start);
+     memcpy(ring->cells + start * ring->element_size, src, first * ring->element_size);
+     if(first < n)
+          memcpy(ring->cells, src + first * ring->element_size, (n - first) * ring->element_size);
+}
+
+static inline void
+__spsc_copy_out(const ag_ringbuf *ring, size_t pos, byte *dst, size_t n)
+{
+     size_t start = pos & (ring->capacity - 1);
+     size_t first = agmin(n, ring->capacity - start);
+     memcpy(dst, ring->cells + start * ring->element_size, first * ring->element_size);
+     if(first < n)
+          memcpy(dst + first * ring->element_size, ring->cells, (n - first) * ring->element_size);
+}
+
+static size_t
+__spsc_push_n(ag_ringbuf *ring, const void *src, size_t n)
+{
+     size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+     size_t room = ring->capacity - (head - ring->cached_tail);
+     if(room < n) {
+          ring->cached_tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+          room = ring->capacity - (head - ring->cached_tail);
+     }
+     n = agmin(n, room);
+     if(n == 0) return 0;
+
+     __spsc_copy_in(ring, head, (const byte*)src, n);
+     atomic_store_explicit(&ring->head, head + n, memory_order_release);
+     return n;
+}
+
+static size_t
+__spsc_pop_n(ag_ringbuf *ring, void *dst, size_t n)
+{
+     size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+     size_t ready = ring->cached_head - tail;
+     if(ready < n) {
+          ring->cached_head = atomic_load_explicit(&ring->head, memory_order_acquire);
+          ready = ring->cached_head - tail;
+     }
+     n = agmin(n, ready);
+     if(n == 0) return 0;
+
+     __spsc_copy_out(ring, tail, (byte*)dst, n);
+     atomic_store_explicit(&ring->tail, tail + n, memory_order_release);
+     return n;
+}
+
+// ---------------------------------------------------------------------------
+// MPMC
+// ---------------------------------------------------------------------------
+
+bool
+ringbuf_try_push(ag_ringbuf *ring, const void *elem)
+{
+     if(ring->flags & AG_RING_SPSC) return __spsc_push_n(ring, elem, 1) == 1;
+
+     size_t pos = atomic_load_explicit(&ring->head, memory_order_relaxed);
+     for(;;) {
+          size_t seq = atomic_load_explicit(__ring_cell_seq(ring, pos), memory_order_acquire);
+          intptr_t diff = __ring_diff(seq, pos);
+          if(diff == 0) {
+               // Cell is free for this lap, claim the position
+               if(atomic_compare_exchange_weak_explicit(&ring->head, &pos, pos + 1,
+                         memory_order_relaxed, memory_order_relaxed))
+                    break;
+          }
+          else if(diff < 0) return false; // Still holds last lap's record: full
+          else pos = atomic_load_explicit(&ring->head, memory_order_relaxed);
+     }
+
+     memcpy(__ring_cell_data(ring, pos), elem, ring->element_size);
+     atomic_store_explicit(__ring_cell_seq(ring, pos), pos + 1, memory_order_release);
+     return true;
+}
+
+bool
+ringbuf_try_pop(ag_ringbuf *ring, void *out)
+{
+     if(ring->flags & AG_RING_SPSC) return __spsc_pop_n(ring, out, 1) == 1;
+
+     size_t pos = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+     for(;;) {
+          size_t seq = atomic_load_explicit(__ring_cell_seq(ring, pos), memory_order_acquire);
+          intptr_t diff = __ring_diff(seq, pos + 1);
+          if(diff == 0) {
+               if(atomic_compare_exchange_weak_explicit(&ring->tail, &pos, pos + 1,
+                         memory_order_relaxed, memory_order_relaxed))
+                    break;
+          }
+          else if(diff < 0) return false; // Not published yet: empty
+          else pos = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+     }
+
+     memcpy(out, __ring_cell_data(ring, pos), ring->element_size);
+     // Hand the cell to the producer of the next lap
+     atomic_store_explicit(__ring_cell_seq(ring, pos), pos + ring->capacity, memory_order_release);
+     return true;
+}
+
+// Batches claim k positions with one CAS after checking that all k cells are
+// in the expected state. A cell in that state cannot leave it before someone
+// claims its position, so a successful CAS owns all k.
+size_t
+ringbuf_push_n(ag_ringbuf *ring, const void *src, size_t n)
+{
+     if(ring->flags & AG_RING_SPSC) return __spsc_push_n(ring, src, n);
+
+     n = agmin(n, ring->capacity);
+     size_t pos = atomic_load_explicit(&ring->head, memory_order_relaxed);
+     size_t k;
+     for(;;) {
+          for(k = 0; k < n; k++) {
+               size_t seq = atomic_load_explicit(__ring_cell_seq(ring, pos + k), memory_order_acquire);
+               if(seq != pos + k) break;
+          }
+          if(k == 0) {
+               size_t seq = atomic_load_explicit(__ring_cell_seq(ring, pos), memory_order_acquire);
+               if(__ring_diff(seq, pos) < 0) return 0;
+               pos = atomic_load_explicit(&ring->head, memory_order_relaxed);
+               continue;
+          }
+          if(atomic_compare_exchange_weak_explicit(&ring->head, &pos, pos + k,
+                    memory_order_relaxed, memory_order_relaxed))
+               break;
+     }
+
+     const byte *it = (const byte*)src;
+     for(size_t i = 0; i < k; i++, it += ring->element_size) {
+          memcpy(__ring_cell_data(ring, pos + i), it, ring->element_size);
+          atomic_store_explicit(__ring_cell_seq(ring, pos + i), pos + i + 1, memory_order_release);
+     }
+     return k;
+}
+
+size_t
+ringbuf_pop_n(ag_ringbuf *ring, void *dst, size_t n)
+{
+     if(ring->flags & AG_RING_SPSC) return __spsc_pop_n(ring, dst, n);
+
+     n = agmin(n, ring->capacity);
+     size_t pos = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+     size_t k;
+     for(;;) {
+          for(k = 0; k < n; k++) {
+               size_t seq = atomic_load_explicit(__ring_cell_seq(ring, pos + k), memory_order_acquire);
+               if(seq != pos + k + 1) break;
+          }
+          if(k == 0) {
+               size_t seq = atomic_load_explicit(__ring_cell_seq(ring, pos), memory_order_acquire);
+               if(__ring_diff(seq, pos + 1) < 0) return 0;
+               pos = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+               continue;
+          }
+          if(atomic_compare_exchange_weak_explicit(&ring->tail, &pos, pos + k,
+                    memory_order_relaxed, memory_order_relaxed))
+               break;
+     }
+
+     byte *it = (byte*)dst;
+     for(size_t i = 0; i < k; i++, it += ring->element_size) {
+          memcpy(it, __ring_cell_data(ring, pos + i), ring->element_size);
+          atomic_store_explicit(__ring_cell_seq(ring, pos + i), pos + i + ring->capacity, memory_order_release);
+     }
+     return k;
+}
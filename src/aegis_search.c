@@ -0,0 +1,399 @@
+#define _GNU_SOURCE // memrchr
+#include "aegis/aegis_search.h"
+#include "aegis/aegis_utils.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <immintrin.h>
+#define SEARCH_HAS_X86 1
+#else
+#define SEARCH_HAS_X86 0
+#endif
+
+typedef const char *(*__search_fn)(const char *hay, size_t hlen, const char *needle, size_t nlen);
+
+// ---------------------------------------------------------------------------
+// First/last-byte filter kernels.
+// A candidate start i must match needle[0] at i and needle[nlen - 1] at
+// i + nlen - 1; only candidates passing both compares reach memcmp.
+// All kernels require 2 <= nlen <= hlen.
+// ---------------------------------------------------------------------------
+
+static inline bool
+__search_verify(const char *at, const char *needle, size_t nlen)
+{
+     return memcmp(at + 1, needle + 1, nlen - 2) == 0;
+}
+
+static const char*
+__search_scalar(const char *hay, size_t hlen, const char *needle, size_t nlen)
+{
+     const char first = needle[0], last = needle[nlen - 1];
+     const char *end = hay + (hlen - nlen) + 1; // one past the last candidate
+     const char *it = hay;
+
+     while(it < end) {
+          it = (const char*)memchr(it, first, (size_t)(end - it));
+          if(it == NULL) return NULL;
+          if(it[nlen - 1] == last && __search_verify(it, needle, nlen)) return it;
+          it++;
+     }
+     return NULL;
+}
+
+static const char*
+__search_scalar_rev(const char *hay, size_t hlen, const char *needle, size_t nlen)
+{
+     const char first = needle[0], last = needle[nlen - 1];
+     for(size_t i = hlen - nlen + 1; i-- > 0; ) {
+          if(hay[i] == first && hay[i + nlen - 1] == last && __search_verify(hay + i, needle, nlen))
+               return hay + i;
+     }
+     return NULL;
+}
+
+#if SEARCH_HAS_X86
+
+__attribute__((target("sse2")))
+static const char*
+__search_sse2(const char *hay, size_t hlen, const char *needle, size_t nlen)
+{
+     const __m128i first = _mm_set1_epi8(needle[0]);
+     const __m128i last  = _mm_set1_epi8(needle[nlen - 1]);
+     size_t candidates = hlen - nlen + 1;
+     size_t i = 0;
+
+     for(; i + 16 <= candidates; i += 16) {
+          __m128i bf = _mm_loadu_si128((const __m128i*)(hay + i));
+          __m128i bl = _mm_loadu_si128((const __m128i*)(hay + i + nlen - 1));
+          uint32_t mask = (uint32_t)_mm_movemask_epi8(
+               _mm_and_si128(_mm_cmpeq_epi8(bf, first), _mm_cmpeq_epi8(bl, last)));
+          while(mask) {
+               size_t at = i + (size_t)__builtin_ctz(mask);
+               if(__search_verify(hay + at, needle, nlen)) return hay + at;
+               mask &= mask - 1;
+          }
+     }
+     return __search_scalar(hay + i, hlen - i, needle, nlen);
+}
+
+__attribute__((target("avx2")))
+static const char*
+__search_avx2(const char *hay, size_t hlen, const char *needle, size_t nlen)
+{
+     const __m256i first = _mm256_set1_epi8(needle[0]);
+     const __m256i last  = _mm256_set1_epi8(needle[nlen - 1]);
+     size_t candidates = hlen - nlen + 1;
+     size_t i = 0;
+
+     for(; i + 32 <= candidates; i += 32) {
+          __m256i bf = _mm256_loadu_si256((const __m256i*)(hay + i));
+          __m256i bl = _mm256_loadu_si256((const __m256i*)(hay + i + nlen - 1));
+          uint32_t mask = (uint32_t)_mm256_movemask_epi8(
+               _mm256_and_si256(_mm256_cmpeq_epi8(bf, first), _mm256_cmpeq_epi8(bl, last)));
+          while(mask) {
+               size_t at = i + (size_t)__builtin_ctz(mask);
+               if(__search_verify(hay + at, needle, nlen)) return hay + at;
+               mask &= mask - 1;
+          }
+     }
+     return __search_scalar(hay + i, hlen - i, needle, nlen);
+}
+
+// Backward variants walk one register of candidates at a time from the end
+// and test the highest set bit first
+__attribute__((target("sse2")))
+static const char*
+__search_sse2_rev(const char *hay, size_t hlen, const char *needle, size_t nlen)
+{
+     const __m128i first = _mm_set1_epi8(needle[0]);
+     const __m128i last  = _mm_set1_epi8(needle[nlen - 1]);
+     size_t candidates = hlen - nlen + 1;
+
+     while(candidates >= 16) {
+          size_t i = candidates - 16;
+          __m128i bf = _mm_loadu_si128((const __m128i*)(hay + i));
+          __m128i bl = _mm_loadu_si128((const __m128i*)(hay + i + nlen - 1));
+          uint32_t mask = (uint32_t)_mm_movemask_epi8(
+               _mm_and_si128(_mm_cmpeq_epi8(bf, first), _mm_cmpeq_epi8(bl, last)));
+          while(mask) {
+               unsigned bit = 31u - (unsigned)__builtin_clz(mask);
+               if(__search_verify(hay + i + bit, needle, nlen)) return hay + i + bit;
+               mask &= ~(1u << bit);
+          }
+          candidates = i;
+     }
+     if(candidates == 0) return NULL;
+     return __search_scalar_rev(hay, candidates + nlen - 1, needle, nlen);
+}
+
+__attribute__((target("avx2")))
+static const char*
+__search_avx2_rev(const char *hay, size_t hlen, const char *needle, size_t nlen)
+{
+     const __m256i first = _mm256_set1_epi8(needle[0]);
+     const __m256i last  = _mm256_set1_epi8(needle[nlen - 1]);
+     size_t candidates = hlen - nlen + 1;
+
+     while(candidates >= 32) {
+          size_t i = candidates - 32;
+          __m256i bf = _mm256_loadu_si256((const __m256i*)(hay + i));
+          __m256i bl = _mm256_loadu_si256((const __m256i*)(hay + i + nlen - 1));
+          uint32_t mask = (uint32_t)_mm256_movemask_epi8(
+               _mm256_and_si256(_mm256_cmpeq_epi8(bf, first), _mm256_cmpeq_epi8(bl, last)));
+          while(mask) {
+               unsigned bit = 31u - (unsigned)__builtin_clz(mask);
+               if(__search_verify(hay + i + bit, needle, nlen)) return hay + i + bit;
+               mask &= ~(1u << bit);
+          }
+          candidates = i;
+     }
+     if(candidates == 0) return NULL;
+     return __search_scalar_rev(hay, candidates + nlen - 1, needle, nlen);
+}
+
+#endif // SEARCH_HAS_X86
+
+// ---------------------------------------------------------------------------
+// Runtime dispatch: the first call picks the kernels for this CPU.
+// ---------------------------------------------------------------------------
+
+typedef struct {
+     __search_fn fwd;
+     __search_fn rev;
+} __search_kernels;
+
+static const __search_kernels __search_kernels_scalar = { __search_scalar, __search_scalar_rev };
+
+#if SEARCH_HAS_X86
+static const __search_kernels __search_kernels_sse2 = { __search_sse2, __search_sse2_rev };
+static const __search_kernels __search_kernels_avx2 = { __search_avx2, __search_avx2_rev };
+#endif
+
+static const void*
+__search_pick(unsigned cpu)
+{
+#if SEARCH_HAS_X86
+     if(cpu & AG_CPU_AVX2) return &__search_kernels_avx2;
+     if(cpu & AG_CPU_SSE2) return &__search_kernels_sse2;
+#else
+     (void)cpu;
+#endif
+     return &__search_kernels_scalar;
+}
+
+static const void *__search_impl = NULL;
+
+static inline const __search_kernels*
+__search_kernels_get(void)
+{
+     return (const __search_kernels*)__ag_dispatch(&__search_impl, __search_pick);
+}
+
+// ---------------------------------------------------------------------------
+// Two-Way (Crochemore-Perrin) with a last-byte skip table.
+// O(hlen + nlen) time, O(1) extra space beyond the 256-entry tables.
+//
+// __twoway_max_suffix and __search_twoway are adapted from twoway_memmem in
+// musl libc (src/string/memmem.c), used under the MIT license:
+//
+//   Copyright (c) 2005-2020 Rich Felker, et al.
+//
+//   Permission is hereby granted, free of charge, to any person obtaining
+//   a copy of this software and associated documentation files (the
+//   "Software"), to deal in the Software without restriction, including
+//   without limitation the rights to use, copy, modify, merge, publish,
+//   distribute, sublicense, and/or sell copies of the Software, and to
+//   permit persons to whom the Software is furnished to do so, subject to
+//   the following conditions:
+//
+//   The above copyright notice and this permission notice shall be
+//   included in all copies or substantial portions of the Software.
+//
+//   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//   EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+//   IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+//   CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+//   TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+//   SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// ---------------------------------------------------------------------------
+
+// Maximal suffix of needle under (reversed ? >) or (<) ordering
+static size_t
+__twoway_max_suffix(const byte *n, size_t nlen, bool reversed, size_t *period)
+{
+     size_t ip = (size_t)-1, jp = 0, k = 1, p = 1;
+     while(jp + k < nlen) {
+          byte a = n[ip + k], b = n[jp + k];
+          if(a == b) {
+               if(k == p) {
+                    jp += p;
+                    k = 1;
+               }
+               else k++;
+          }
+          else if(reversed ? (a < b) : (a > b)) {
+               jp += k;
+               k = 1;
+               p = jp - ip;
+          }
+          else {
+               ip = jp++;
+               k = p = 1;
+          }
+     }
+     *period = p;
+     return ip;
+}
+
+static const char*
+__search_twoway(const char *hay_, size_t hlen, const char *needle_, size_t nlen)
+{
+     const byte *h = (const byte*)hay_;
+     const byte *z = h + hlen;
+     const byte *n = (const byte*)needle_;
+     size_t byteset[32 / sizeof(size_t)] = {0};
+     size_t shift[256];
+
+     for(size_t i = 0; i < nlen; i++) {
+          byteset[n[i] / (8 * sizeof(size_t))] |= (size_t)1 << (n[i] % (8 * sizeof(size_t)));
+          shift[n[i]] = i + 1;
+     }
+
+     // Critical factorization: the larger of the two maximal suffixes
+     size_t p, p0;
+     size_t ms = __twoway_max_suffix(n, nlen, false, &p0);
+     size_t ip = __twoway_max_suffix(n, nlen, true, &p);
+     if(ip + 1 > ms + 1) ms = ip;
+     else p = p0;
+
+     size_t mem0;
+     if(memcmp(n, n + p, ms + 1) != 0) {
+          // Non-periodic needle
+          mem0 = 0;
+          p = agmax(ms, nlen - ms - 1) + 1;
+     }
+     else mem0 = nlen - p;
+
+     size_t mem = 0, k;
+     for(;;) {
+          if((size_t)(z - h) < nlen) return NULL;
+
+          // Check the last byte first; skip on mismatch
+          byte tail = h[nlen - 1];
+          if(byteset[tail / (8 * sizeof(size_t))] & ((size_t)1 << (tail % (8 * sizeof(size_t))))) {
+               k = nlen - shift[tail];
+               if(k) {
+                    if(k < mem) k = mem;
+                    h += k;
+                    mem = 0;
+                    continue;
+               }
+          }
+          else {
+               h += nlen;
+               mem = 0;
+               continue;
+          }
+
+          // Right half
+          for(k = agmax(ms + 1, mem); k < nlen && n[k] == h[k]; k++);
+          if(k < nlen) {
+               h += k - ms;
+               mem = 0;
+               continue;
+          }
+          // Left half
+          for(k = ms + 1; k > mem && n[k - 1] == h[k - 1]; k--);
+          if(k <= mem) return (const char*)h;
+          h += p;
+          mem = mem0;
+     }
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+
+const char*
+ag_memmem(const char *hay, size_t hlen, const char *needle, size_t nlen)
+{
+     if(nlen == 0) return hay;
+     if(nlen > hlen) return NULL;
+     if(nlen == 1) return (const char*)memchr(hay, needle[0], hlen);
+     if(nlen <= AG_SEARCH_SHORT_NEEDLE)
+          return __search_kernels_get()->fwd(hay, hlen, needle, nlen);
+     return __search_twoway(hay, hlen, needle, nlen);
+}
+
+const char*
+ag_memrmem(const char *hay, size_t hlen, const char *needle, size_t nlen)
+{
+     if(nlen == 0) return hay + hlen;
+     if(nlen > hlen) return NULL;
+     if(nlen == 1) {
+#if defined(__GLIBC__)
+          return (const char*)memrchr(hay, needle[0], hlen);
+#else
+          for(size_t i = hlen; i-- > 0; )
+               if(hay[i] == needle[0]) return hay + i;
+          return NULL;
+#endif
+     }
+     return __search_kernels_get()->rev(hay, hlen, needle, nlen);
+}
+
+size_t
+sv_rfind(ag_string_view hay, ag_string_view needle)
+{
+     const char *hit = ag_memrmem(hay.data, hay.size, needle.data, needle.size);
+     return hit ? (size_t)(hit - hay.data) : AG_NPOS;
+}
+
+size_t
+sv_find_all(ag_string_view hay, ag_string_view needle, vector *out)
+{
+     assert(out == NULL || out->element_size == sizeof(size_t));
+     if(needle.size == 0) return 0;
+
+     size_t count = 0, pos = 0;
+     while(pos + needle.size <= hay.size) {
+          const char *hit = ag_memmem(hay.data + pos, hay.size - pos, needle.data, needle.size);
+          if(hit == NULL) break;
+          size_t at = (size_t)(hit - hay.data);
+          if(out != NULL) vec_push_back(out, size_t, at);
+          count++;
+          pos = at + needle.size;
+     }
+     return count;
+}
+
+size_t
+sv_count(ag_string_view hay, ag_string_view needle)
+{
+     return sv_find_all(hay, needle, NULL);
+}
+
+size_t
+string_find(const ag_string str, ag_string_view needle)
+{
+     return sv_find(sv_from_string(str), needle);
+}
+
+size_t
+string_rfind(const ag_string str, ag_string_view needle)
+{
+     return sv_rfind(sv_from_string(str), needle);
+}
+
+size_t
+string_count(const ag_string str, ag_string_view needle)
+{
+     return sv_count(sv_from_string(str), needle);
+}
+
+size_t
+string_find_all(const ag_string str, ag_string_view needle, vector *out)
+{
+     return sv_find_all(sv_from_string(str), needle, out);
+}
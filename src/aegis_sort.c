@@ -0,0 +1,193 @@
+#include "aegis/aegis_sort.h"
+
+// Below this many elements a comparison sort beats the histogram passes
+#define RADIX_MIN 256
+#define RADIX_BITS 8
+#define RADIX_BUCKETS (1 << RADIX_BITS)
+
+// Keys are first mapped to unsigned integers whose order is the wanted order
+// (sign bit flip for signed, sign-magnitude flip for floats), sorted as
+// unsigned, then mapped back. Signed keys are mapped in place; float keys
+// are copied out, see ag_radix_sort_f32.
+
+static inline uint32_t __radix_enc_i32(uint32_t k) { return k ^ 0x80000000u; }
+static inline uint64_t __radix_enc_i64(uint64_t k) { return k ^ 0x8000000000000000ull; }
+
+static inline uint32_t
+__radix_enc_f32(uint32_t k)
+{
+     return k ^ ((uint32_t)((int32_t)k >> 31) | 0x80000000u);
+}
+
+static inline uint32_t
+__radix_dec_f32(uint32_t k)
+{
+     return k ^ (((k >> 31) - 1) | 0x80000000u);
+}
+
+static inline uint64_t
+__radix_enc_f64(uint64_t k)
+{
+     return k ^ ((uint64_t)((int64_t)k >> 63) | 0x8000000000000000ull);
+}
+
+static inline uint64_t
+__radix_dec_f64(uint64_t k)
+{
+     return k ^ (((k >> 63) - 1) | 0x8000000000000000ull);
+}
+
+// One histogram pass for all digits, then one scatter pass per digit that
+// is not the same for every key. Returns false if scratch could not be had.
+#define RADIX_SORT_IMPL(fname, utype)                                            \
+static bool                                                                      \
+fname(utype *a, size_t n)                                                        \
+{                                                                                \
+     enum { DIGITS = sizeof(utype) };                                            \
+     utype *buf = (utype*)malloc(n * sizeof(utype));                             \
+     if(buf == NULL) return false;                                               \
+                                                                                 \
+     size_t (*counts)[RADIX_BUCKETS] =                                           \
+          (size_t(*)[RADIX_BUCKETS])calloc(DIGITS, sizeof(*counts));             \
+     if(counts == NULL) {                                                        \
+          free(buf);                                                             \
+          return false;                                                          \
+     }                                                                           \
+     for(size_t i = 0; i < n; i++) {                                             \
+          utype k = a[i];                                                        \
+          for(int d = 0; d < DIGITS; d++)                                        \
+               counts[d][(k >> (d * RADIX_BITS)) & (RADIX_BUCKETS - 1)]++;       \
+     }                                                                           \
+                                                                                 \
+     utype *src = a, *dst = buf;                                                 \
+     for(int d = 0; d < DIGITS; d++) {                                           \
+          size_t *count = counts[d];                                             \
+          /* Every key has the same digit: nothing to do */                      \
+          if(count[(src[0] >> (d * RADIX_BITS)) & (RADIX_BUCKETS - 1)] == n)     \
+               continue;                                                         \
+                                                                                 \
+          size_t offset = 0;                                                     \
+          for(int b = 0; b < RADIX_BUCKETS; b++) {                               \
+               size_t c = count[b];                                              \
+               count[b] = offset;                                                \
+               offset += c;                                                      \
+          }                                                                      \
+          for(size_t i = 0; i < n; i++) {                                        \
+               utype k = src[i];                                                 \
+               dst[count[(k >> (d * RADIX_BITS)) & (RADIX_BUCKETS - 1)]++] = k;  \
+          }                                                                      \
+          utype *t = src; src = dst; dst = t;                                    \
+     }                                                                           \
+     if(src != a) memcpy(a, src, n * sizeof(utype));                             \
+                                                                                 \
+     free(counts);                                                               \
+     free(buf);                                                                  \
+     return true;                                                                \
+}
+
+RADIX_SORT_IMPL(__radix_sort32, uint32_t)
+RADIX_SORT_IMPL(__radix_sort64, uint64_t)
+
+void
+ag_radix_sort_u32(uint32_t *a, size_t n)
+{
+     if(n < RADIX_MIN || !__radix_sort32(a, n))
+          ag_sort_u32_sort(a, n);
+}
+
+void
+ag_radix_sort_u64(uint64_t *a, size_t n)
+{
+     if(n < RADIX_MIN || !__radix_sort64(a, n))
+          ag_sort_u64_sort(a, n);
+}
+
+void
+ag_radix_sort_i32(int32_t *a, size_t n)
+{
+     if(n < RADIX_MIN) {
+          ag_sort_i32_sort(a, n);
+          return;
+     }
+     uint32_t *k = (uint32_t*)a;
+     for(size_t i = 0; i < n; i++) k[i] = __radix_enc_i32(k[i]);
+     bool sorted = __radix_sort32(k, n);
+     for(size_t i = 0; i < n; i++) k[i] = __radix_enc_i32(k[i]);
+     if(!sorted) ag_sort_i32_sort(a, n);
+}
+
+void
+ag_radix_sort_i64(int64_t *a, size_t n)
+{
+     if(n < RADIX_MIN) {
+          ag_sort_i64_sort(a, n);
+          return;
+     }
+     uint64_t *k = (uint64_t*)a;
+     for(size_t i = 0; i < n; i++) k[i] = __radix_enc_i64(k[i]);
+     bool sorted = __radix_sort64(k, n);
+     for(size_t i = 0; i < n; i++) k[i] = __radix_enc_i64(k[i]);
+     if(!sorted) ag_sort_i64_sort(a, n);
+}
+
+// Float keys are sorted in their own uint32_t / uint64_t buffer: the
+// caller's array is only touched through memcpy, never through an integer
+// pointer, which strict aliasing would let the compiler reorder. Small arrays
+// and failed allocations use a comparison sort on the same total order, so
+// NaN and -0.0 land in the same place whichever path sorts them.
+
+static inline uint32_t
+__radix_key_f32(float f)
+{
+     uint32_t k;
+     memcpy(&k, &f, sizeof(k));
+     return __radix_enc_f32(k);
+}
+
+static inline uint64_t
+__radix_key_f64(double f)
+{
+     uint64_t k;
+     memcpy(&k, &f, sizeof(k));
+     return __radix_enc_f64(k);
+}
+
+#define __RADIX_LESS_F32(a, b) (__radix_key_f32(a) < __radix_key_f32(b))
+#define __RADIX_LESS_F64(a, b) (__radix_key_f64(a) < __radix_key_f64(b))
+
+AG_SORT_DEFINE(__radix_total_f32, float, __RADIX_LESS_F32)
+AG_SORT_DEFINE(__radix_total_f64, double, __RADIX_LESS_F64)
+
+void
+ag_radix_sort_f32(float *a, size_t n)
+{
+     uint32_t *k = n < RADIX_MIN ? NULL : (uint32_t*)malloc(n * sizeof(uint32_t));
+     if(k == NULL) {
+          __radix_total_f32_sort(a, n);
+          return;
+     }
+     for(size_t i = 0; i < n; i++) k[i] = __radix_key_f32(a[i]);
+     if(!__radix_sort32(k, n)) ag_sort_u32_sort(k, n);
+     for(size_t i = 0; i < n; i++) {
+          uint32_t u = __radix_dec_f32(k[i]);
+          memcpy(&a[i], &u, sizeof(u));
+     }
+     free(k);
+}
+
+void
+ag_radix_sort_f64(double *a, size_t n)
+{
+     uint64_t *k = n < RADIX_MIN ? NULL : (uint64_t*)malloc(n * sizeof(uint64_t));
+     if(k == NULL) {
+          __radix_total_f64_sort(a, n);
+          return;
+     }
+     for(size_t i = 0; i < n; i++) k[i] = __radix_key_f64(a[i]);
+     if(!__radix_sort64(k, n)) ag_sort_u64_sort(k, n);
+     for(size_t i = 0; i < n; i++) {
+          uint64_t u = __radix_dec_f64(k[i]);
+          memcpy(&a[i], &u, sizeof(u));
+     }
+     free(k);
+}
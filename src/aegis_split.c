@@ -0,0 +1,305 @@
+#include "aegis/aegis_split.h"
+#include "aegis/aegis_search.h"
+#include "aegis/aegis_utils.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <immintrin.h>
+#define SPLIT_HAS_X86 1
+#else
+#define SPLIT_HAS_X86 0
+#endif
+
+#define SPLIT_BLOCK 64
+
+typedef uint64_t (*__split_classify_fn)(const ag_byte_set *set, const char *p);
+
+void
+byte_set_init(ag_byte_set *set, ag_string_view bytes)
+{
+     memset(set, 0, sizeof(*set));
+     for(size_t i = 0; i < bytes.size; i++) {
+          unsigned char b = (unsigned char)bytes.data[i];
+          uint8_t *table = (b & 0x80) ? set->high8 : set->low8;
+          table[b & 15] |= (uint8_t)(1u << ((b >> 4) & 7));
+     }
+}
+
+// ---------------------------------------------------------------------------
+// Classification kernels: bit i of the result is set when p[i] is in the set.
+// Kernels read exactly SPLIT_BLOCK bytes.
+// ---------------------------------------------------------------------------
+
+static inline uint64_t
+__split_classify_tail(const ag_byte_set *set, const char *p, size_t n)
+{
+     uint64_t mask = 0;
+     for(size_t i = 0; i < n; i++)
+          mask |= (uint64_t)byte_set_has(set, (unsigned char)p[i]) << i;
+     return mask;
+}
+
+static uint64_t
+__split_classify_scalar(const ag_byte_set *set, const char *p)
+{
+     return __split_classify_tail(set, p, SPLIT_BLOCK);
+}
+
+#if SPLIT_HAS_X86
+
+// Low nibble picks a table row (high8 when the byte's top bit is set, via
+// blendv), high nibble picks the bit in that row
+__attribute__((target("avx2")))
+static uint64_t
+__split_classify_avx2(const ag_byte_set *set, const char *p)
+{
+     const __m256i low8 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)set->low8));
+     const __m256i high8 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)set->high8));
+     const __m256i bits = _mm256_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128,
+                                           1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+     const __m256i nibble = _mm256_set1_epi8(0x0F);
+
+     uint64_t mask = 0;
+     for(int half = 0; half < 2; half++) {
+          __m256i in = _mm256_loadu_si256((const __m256i*)(p + 32 * half));
+          __m256i lo = _mm256_and_si256(in, nibble);
+          __m256i hi = _mm256_and_si256(_mm256_srli_epi16(in, 4), nibble);
+          __m256i row = _mm256_blendv_epi8(_mm256_shuffle_epi8(low8, lo), _mm256_shuffle_epi8(high8, lo), in);
+          __m256i bit = _mm256_shuffle_epi8(bits, hi);
+          __m256i hit = _mm256_cmpeq_epi8(_mm256_and_si256(row, bit), bit);
+          mask |= (uint64_t)(uint32_t)_mm256_movemask_epi8(hit) << (32 * half);
+     }
+     return mask;
+}
+
+#endif // SPLIT_HAS_X86
+
+// ---------------------------------------------------------------------------
+// Runtime dispatch: the first call picks the kernel for this CPU.
+// ---------------------------------------------------------------------------
+
+typedef struct {
+     __split_classify_fn classify;
+} __split_kernels;
+
+static const __split_kernels __split_scalar = { __split_classify_scalar };
+
+#if SPLIT_HAS_X86
+static const __split_kernels __split_avx2 = { __split_classify_avx2 };
+#endif
+
+static const void*
+__split_pick(unsigned cpu)
+{
+#if SPLIT_HAS_X86
+     if(cpu & AG_CPU_AVX2) return &__split_avx2;
+#else
+     (void)cpu;
+#endif
+     return &__split_scalar;
+}
+
+static const void *__split_impl = NULL;
+
+static inline const __split_kernels*
+__split_kernels_get(void)
+{
+     return (const __split_kernels*)__ag_dispatch(&__split_impl, __split_pick);
+}
+
+// ---------------------------------------------------------------------------
+// Iterator
+// ---------------------------------------------------------------------------
+
+static uint64_t
+__split_classify_block(const ag_split_iter *it)
+{
+     size_t n = agmin(it->src.size - it->block, (size_t)SPLIT_BLOCK);
+     const char *p = it->src.data + it->block;
+     if(n == SPLIT_BLOCK) return __split_kernels_get()->classify(&it->set, p);
+     return __split_classify_tail(&it->set, p, n);
+}
+
+static void
+__split_iter_start(ag_split_iter *it, ag_string_view src, unsigned flags)
+{
+     it->src = src;
+     it->delim = (ag_string_view){ NULL, 0 };
+     it->pos = 0;
+     it->block = 0;
+     it->mask = 0;
+     it->flags = flags;
+     it->done = false;
+}
+
+static void
+__split_iter_start_set(ag_split_iter *it, ag_string_view src, ag_string_view bytes, unsigned flags)
+{
+     __split_iter_start(it, src, flags);
+     byte_set_init(&it->set, bytes);
+     if(src.size > 0) it->mask = __split_classify_block(it);
+}
+
+void
+split_iter_init(ag_split_iter *it, ag_string_view src, ag_string_view delim, unsigned flags)
+{
+     assert(delim.size > 0);
+     if(delim.size == 1) {
+          __split_iter_start_set(it, src, delim, flags);
+          return;
+     }
+     __split_iter_start(it, src, flags);
+     it->delim = delim;
+}
+
+void
+split_iter_init_any(ag_split_iter *it, ag_string_view src, ag_string_view delims, unsigned flags)
+{
+     __split_iter_start_set(it, src, delims, flags);
+}
+
+void
+split_iter_init_lines(ag_split_iter *it, ag_string_view src)
+{
+     __split_iter_start_set(it, src, sv_from_buf("\n", 1), AG_SPLIT_LINES);
+}
+
+// Offset of the next delimiter into *at, false when there is none
+static inline bool
+__split_next_delim(ag_split_iter *it, size_t *at)
+{
+     if(it->delim.size > 0) {
+          const char *hit = ag_memmem(it->src.data + it->pos, it->src.size - it->pos,
+                                      it->delim.data, it->delim.size);
+          if(hit == NULL) return false;
+          *at = (size_t)(hit - it->src.data);
+          return true;
+     }
+
+     while(it->mask == 0) {
+          if(it->src.size - it->block <= SPLIT_BLOCK) return false;
+          it->block += SPLIT_BLOCK;
+          it->mask = __split_classify_block(it);
+     }
+     *at = it->block + (size_t)__builtin_ctzll(it->mask);
+     it->mask &= it->mask - 1;
+     return true;
+}
+
+bool
+split_next(ag_split_iter *it, ag_string_view *tok)
+{
+     while(!it->done) {
+          size_t start = it->pos, end;
+          if(__split_next_delim(it, &end))
+               it->pos = end + (it->delim.size > 0 ? it->delim.size : 1);
+          else {
+               end = it->src.size;
+               it->done = true;
+          }
+
+          if(it->flags & AG_SPLIT_LINES) {
+               // Nothing after the last line end is a line
+               if(it->done && start == end) return false;
+               if(!it->done && end > start && it->src.data[end - 1] == '\r') end--;
+          }
+          if(start == end && (it->flags & AG_SPLIT_SKIP_EMPTY)) continue;
+
+          *tok = (ag_string_view){ it->src.data + start, end - start };
+          return true;
+     }
+     return false;
+}
+
+// ---------------------------------------------------------------------------
+// Token lists
+// ---------------------------------------------------------------------------
+
+static size_t
+__split_collect(ag_split_iter *it, vector *out)
+{
+     assert(out == NULL || out->element_size == sizeof(ag_token));
+     size_t count = 0;
+     ag_string_view tok;
+     while(split_next(it, &tok)) {
+          if(out != NULL)
+               vec_push_back(out, ag_token, ((ag_token){ (size_t)(tok.data - it->src.data), tok.size }));
+          count++;
+     }
+     return count;
+}
+
+size_t
+sv_split(ag_string_view src, ag_string_view delim, unsigned flags, vector *out)
+{
+     ag_split_iter it;
+     split_iter_init(&it, src, delim, flags);
+     return __split_collect(&it, out);
+}
+
+size_t
+sv_split_any(ag_string_view src, ag_string_view delims, unsigned flags, vector *out)
+{
+     ag_split_iter it;
+     split_iter_init_any(&it, src, delims, flags);
+     return __split_collect(&it, out);
+}
+
+size_t
+sv_lines(ag_string_view src, vector *out)
+{
+     ag_split_iter it;
+     split_iter_init_lines(&it, src);
+     return __split_collect(&it, out);
+}
+
+// ---------------------------------------------------------------------------
+// Join
+// ---------------------------------------------------------------------------
+
+// Element i of parts (ag_string_view) or of tokens (ag_token) into src
+static inline ag_string_view
+__join_item(const char *src, bool tokens, const vector *items, size_t i)
+{
+     if(!tokens) return ((const ag_string_view*)items->data)[i];
+     ag_token tok = ((const ag_token*)items->data)[i];
+     return (ag_string_view){ src + tok.offset, tok.size };
+}
+
+static ag_string
+__join(const char *src, bool tokens, const vector *items, ag_string_view sep)
+{
+     size_t total = items->size > 0 ? sep.size * (items->size - 1) : 0;
+     for(size_t i = 0; i < items->size; i++)
+          total += __join_item(src, tokens, items, i).size;
+
+     ag_string out = new_string("");
+     string_reserve(out, total);
+     char *dst = (char*)out->data;
+     for(size_t i = 0; i < items->size; i++) {
+          ag_string_view part = __join_item(src, tokens, items, i);
+          if(i > 0 && sep.size > 0) {
+               memcpy(dst, sep.data, sep.size);
+               dst += sep.size;
+          }
+          if(part.size > 0) {
+               memcpy(dst, part.data, part.size);
+               dst += part.size;
+          }
+     }
+     string_commit(out, total);
+     return out;
+}
+
+ag_string
+sv_join(const vector *parts, ag_string_view sep)
+{
+     assert(parts->element_size == sizeof(ag_string_view));
+     return __join(NULL, false, parts, sep);
+}
+
+ag_string
+sv_join_tokens(ag_string_view src, const vector *tokens, ag_string_view sep)
+{
+     assert(tokens->element_size == sizeof(ag_token));
+     return __join(src.data, true, tokens, sep);
+}
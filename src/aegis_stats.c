@@ -0,0 +1,222 @@
+#include "aegis/aegis_stats.h"
+#include "aegis/aegis_vector.h"
+
+#ifdef AEGIS_STATS
+
+static ag_stats_counters __stats_global;
+static ag_stats_site *__stats_sites;     // Every site that saw an event
+static ag_stats_hook __stats_hook;
+static void *__stats_hook_ctx;
+
+static inline void
+__stats_max(uint64_t *slot, uint64_t value)
+{
+     uint64_t cur = __atomic_load_n(slot, __ATOMIC_RELAXED);
+     while(value > cur && !__atomic_compare_exchange_n(slot, &cur, value, true,
+                                                       __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+          ;
+}
+
+static inline void
+__stats_add(uint64_t *slot, uint64_t value)
+{
+     if(value != 0) __atomic_fetch_add(slot, value, __ATOMIC_RELAXED);
+}
+
+static void
+__stats_apply(ag_stats_counters *c, int kind, size_t element_size,
+              size_t old_capacity, size_t new_capacity, size_t size, bool copied)
+{
+     uint64_t old_bytes = (uint64_t)old_capacity * element_size;
+     uint64_t new_bytes = (uint64_t)new_capacity * element_size;
+     uint64_t live;
+
+     switch(kind) {
+     case AG_STATS_INIT:
+          __stats_add(&c->inits, 1);
+          live = __atomic_add_fetch(&c->live_bytes, new_bytes, __ATOMIC_RELAXED);
+          break;
+     case AG_STATS_GROW:
+          __stats_add(&c->grows, 1);
+          live = __atomic_add_fetch(&c->live_bytes, new_bytes - old_bytes, __ATOMIC_RELAXED);
+          break;
+     case AG_STATS_SHRINK:
+          __stats_add(&c->shrinks, 1);
+          live = __atomic_sub_fetch(&c->live_bytes, old_bytes - new_bytes, __ATOMIC_RELAXED);
+          break;
+     default: // AG_STATS_FREE
+          __stats_add(&c->frees, 1);
+          __stats_add(&c->waste_at_free, (uint64_t)(old_capacity - size) * element_size);
+          __atomic_sub_fetch(&c->live_bytes, old_bytes, __ATOMIC_RELAXED);
+          return;
+     }
+     if(copied) __stats_add(&c->bytes_copied, (uint64_t)size * element_size);
+     __stats_max(&c->peak_capacity, new_bytes);
+     __stats_max(&c->peak_live_bytes, live);
+}
+
+static void
+__stats_register(ag_stats_site *site)
+{
+     int expected = 0;
+     if(__atomic_load_n(&site->registered, __ATOMIC_RELAXED)
+        || !__atomic_compare_exchange_n(&site->registered, &expected, 1, false,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+          return;
+     ag_stats_site *head = __atomic_load_n(&__stats_sites, __ATOMIC_RELAXED);
+     do site->next = head;
+     while(!__atomic_compare_exchange_n(&__stats_sites, &head, site, true,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+void
+__ag_stats_record(ag_stats_site *site, int kind, size_t element_size,
+                  size_t old_capacity, size_t new_capacity, size_t size, bool copied)
+{
+     __stats_apply(&__stats_global, kind, element_size, old_capacity, new_capacity, size, copied);
+     if(site != NULL) {
+          __stats_register(site);
+          __stats_apply(&site->counters, kind, element_size, old_capacity, new_capacity, size, copied);
+     }
+
+     ag_stats_hook hook = __atomic_load_n(&__stats_hook, __ATOMIC_ACQUIRE);
+     if(hook != NULL) {
+          ag_stats_event ev = { kind, site, element_size, old_capacity, new_capacity, size, copied };
+          hook(&ev, __atomic_load_n(&__stats_hook_ctx, __ATOMIC_RELAXED));
+     }
+}
+
+// The global counters saw this vector's creation already. A vector that
+// had a site hands its live bytes over, so neither site's live_bytes drifts
+// when it is later grown or freed under the new one.
+vector*
+__ag_stats_tag(vector *vec, ag_stats_site *site)
+{
+     if(vec->site == site) return vec;
+     if(vec->site != NULL)
+          __atomic_sub_fetch(&vec->site->counters.live_bytes,
+                             (uint64_t)vec->capacity * vec->element_size, __ATOMIC_RELAXED);
+     __stats_register(site);
+     __stats_apply(&site->counters, AG_STATS_INIT, vec->element_size, 0, vec->capacity, vec->size, false);
+     vec->site = site;
+     return vec;
+}
+
+void
+ag_stats_set_hook(ag_stats_hook hook, void *ctx)
+{
+     __atomic_store_n(&__stats_hook_ctx, ctx, __ATOMIC_RELAXED);
+     __atomic_store_n(&__stats_hook, hook, __ATOMIC_RELEASE);
+}
+
+static ag_stats_counters
+__stats_snapshot(ag_stats_counters *c)
+{
+     ag_stats_counters s;
+     uint64_t *dst = (uint64_t*)&s, *src = (uint64_t*)c;
+     for(size_t i = 0; i < sizeof(s) / sizeof(uint64_t); i++)
+          dst[i] = __atomic_load_n(&src[i], __ATOMIC_RELAXED);
+     return s;
+}
+
+static void
+__stats_zero(ag_stats_counters *c)
+{
+     uint64_t live = __atomic_load_n(&c->live_bytes, __ATOMIC_RELAXED);
+     uint64_t *slot = (uint64_t*)c;
+     for(size_t i = 0; i < sizeof(*c) / sizeof(uint64_t); i++)
+          if(&slot[i] != &c->live_bytes) __atomic_store_n(&slot[i], 0, __ATOMIC_RELAXED);
+     __atomic_store_n(&c->peak_live_bytes, live, __ATOMIC_RELAXED);
+}
+
+ag_stats_counters
+ag_stats_global(void)
+{
+     return __stats_snapshot(&__stats_global);
+}
+
+void
+ag_stats_reset(void)
+{
+     __stats_zero(&__stats_global);
+     for(ag_stats_site *s = __atomic_load_n(&__stats_sites, __ATOMIC_ACQUIRE); s != NULL; s = s->next)
+          __stats_zero(&s->counters);
+}
+
+typedef struct {
+     const ag_stats_site *site;
+     ag_stats_counters c;
+} __stats_row;
+
+static int
+__stats_row_cmp(const void *a, const void *b)
+{
+     const __stats_row *x = (const __stats_row*)a, *y = (const __stats_row*)b;
+     uint64_t rx = x->c.grows + x->c.shrinks, ry = y->c.grows + y->c.shrinks;
+     if(rx != ry) return rx < ry ? 1 : -1;
+     return x->c.bytes_copied < y->c.bytes_copied ? 1 : x->c.bytes_copied > y->c.bytes_copied ? -1 : 0;
+}
+
+void
+ag_stats_dump(FILE *out)
+{
+     ag_stats_counters g = ag_stats_global();
+     fprintf(out, "aegis stats: %llu vectors created, %llu cleaned, %llu reallocations (%llu grow, %llu shrink)\n",
+             (unsigned long long)g.inits, (unsigned long long)g.frees,
+             (unsigned long long)(g.grows + g.shrinks), (unsigned long long)g.grows, (unsigned long long)g.shrinks);
+     fprintf(out, "  bytes copied by reallocation: %llu\n", (unsigned long long)g.bytes_copied);
+     fprintf(out, "  live capacity: %llu bytes (peak %llu), largest vector: %llu bytes\n",
+             (unsigned long long)g.live_bytes, (unsigned long long)g.peak_live_bytes,
+             (unsigned long long)g.peak_capacity);
+     fprintf(out, "  unused capacity at clean: %llu bytes\n", (unsigned long long)g.waste_at_free);
+
+     size_t n = 0;
+     for(ag_stats_site *s = __atomic_load_n(&__stats_sites, __ATOMIC_ACQUIRE); s != NULL; s = s->next) n++;
+     if(n == 0) return;
+     __stats_row *rows = (__stats_row*)malloc(n * sizeof(__stats_row));
+     if(rows == NULL) return;
+     size_t i = 0;
+     for(ag_stats_site *s = __atomic_load_n(&__stats_sites, __ATOMIC_ACQUIRE); s != NULL && i < n; s = s->next)
+          rows[i++] = (__stats_row){ s, __stats_snapshot(&s->counters) };
+     qsort(rows, i, sizeof(__stats_row), __stats_row_cmp);
+
+     fprintf(out, "  %10s %10s %10s %14s %14s %15s  %s\n",
+             "created", "grows", "shrinks", "bytes_copied", "peak_capacity", "unused_at_clean", "site");
+     for(size_t k = 0; k < i; k++) {
+          const ag_stats_counters *c = &rows[k].c;
+          fprintf(out, "  %10llu %10llu %10llu %14llu %14llu %15llu  %s:%d (%s)\n",
+                  (unsigned long long)c->inits, (unsigned long long)c->grows, (unsigned long long)c->shrinks,
+                  (unsigned long long)c->bytes_copied, (unsigned long long)c->peak_capacity,
+                  (unsigned long long)c->waste_at_free, rows[k].site->file, rows[k].site->line,
+                  rows[k].site->func);
+     }
+     free(rows);
+}
+
+#else // !AEGIS_STATS
+
+void
+ag_stats_set_hook(ag_stats_hook hook, void *ctx)
+{
+     (void)hook;
+     (void)ctx;
+}
+
+ag_stats_counters
+ag_stats_global(void)
+{
+     return (ag_stats_counters){ 0 };
+}
+
+void
+ag_stats_reset(void)
+{
+}
+
+void
+ag_stats_dump(FILE *out)
+{
+     fprintf(out, "aegis stats: disabled (build with -DAEGIS_STATS)\n");
+}
+
+#endif // AEGIS_STATS
@@ -0,0 +1,380 @@
+#include "aegis/aegis_strbuilder.h"
+
+// ---------------------------------------------------------------------------
+// String builder
+
+ag_strbuilder*
+strbuilder_init(void)
+{
+     return strbuilder_init_with_alloc(&ag_default_allocator);
+}
+
+ag_strbuilder*
+strbuilder_init_with_alloc(ag_allocator *alloc)
+{
+     ag_strbuilder *sb = (ag_strbuilder*)ag_alloc(alloc, sizeof(ag_strbuilder));
+     if(sb == NULL) {
+          fprintf(stderr, "Error: Memory allocation failed for strbuilder\n");
+          exit(EXIT_FAILURE);
+     }
+     sb->head = NULL;
+     sb->tail = NULL;
+     sb->size = 0;
+     sb->next_chunk = AG_STRBUILDER_MIN_CHUNK;
+     sb->allocator = alloc;
+     return sb;
+}
+
+static inline size_t
+__strbuilder_chunk_bytes(const ag_sb_chunk *chunk)
+{
+     return sizeof(ag_sb_chunk) + chunk->capacity;
+}
+
+// Appends an empty chunk of at least min bytes
+static ag_sb_chunk*
+__strbuilder_add_chunk(ag_strbuilder *sb, size_t min)
+{
+     size_t cap = agmax(sb->next_chunk, min);
+     ag_sb_chunk *chunk = (ag_sb_chunk*)ag_alloc(sb->allocator, sizeof(ag_sb_chunk) + cap);
+     if(chunk == NULL) {
+          fprintf(stderr, "Error: Memory allocation failed for strbuilder chunk\n");
+          exit(EXIT_FAILURE);
+     }
+     chunk->next = NULL;
+     chunk->size = 0;
+     chunk->capacity = cap;
+
+     if(sb->tail != NULL) sb->tail->next = chunk;
+     else sb->head = chunk;
+     sb->tail = chunk;
+     sb->next_chunk = agmin(sb->next_chunk * 2, AG_STRBUILDER_MAX_CHUNK);
+     return chunk;
+}
+
+void
+strbuilder_clear(ag_strbuilder *sb)
+{
+     ag_sb_chunk *chunk = sb->head;
+     while(chunk != sb->tail) {
+          ag_sb_chunk *next = chunk->next;
+          ag_free(sb->allocator, chunk, __strbuilder_chunk_bytes(chunk));
+          chunk = next;
+     }
+     sb->head = sb->tail;
+     if(sb->tail != NULL) sb->tail->size = 0;
+     sb->size = 0;
+}
+
+void
+strbuilder_clean(ag_strbuilder *sb)
+{
+     if(sb == NULL) return;
+     strbuilder_clear(sb);
+     if(sb->tail != NULL)
+          ag_free(sb->allocator, sb->tail, __strbuilder_chunk_bytes(sb->tail));
+     ag_free(sb->allocator, sb, sizeof(ag_strbuilder));
+}
+
+void
+strbuilder_reserve(ag_strbuilder *sb, size_t n)
+{
+     // The rest of the current tail is skipped, chunks need not be full
+     if(sb->tail == NULL || sb->tail->capacity - sb->tail->size < n)
+          __strbuilder_add_chunk(sb, n);
+}
+
+void
+strbuilder_append_n(ag_strbuilder *sb, const char *buf, size_t len)
+{
+     if(len == 0) return;
+     sb->size += len;
+
+     ag_sb_chunk *tail = sb->tail;
+     if(tail != NULL) {
+          size_t n = agmin(tail->capacity - tail->size, len);
+          memcpy(tail->data + tail->size, buf, n);
+          tail->size += n;
+          buf += n;
+          len -= n;
+     }
+     // The rest goes to one new chunk in one copy
+     if(len > 0) {
+          tail = __strbuilder_add_chunk(sb, len);
+          memcpy(tail->data, buf, len);
+          tail->size = len;
+     }
+}
+
+AG_COLD void
+__strbuilder_append_slow(ag_strbuilder *sb, char c)
+{
+     strbuilder_append_n(sb, &c, 1);
+}
+
+ag_string
+strbuilder_to_string(const ag_strbuilder *sb)
+{
+     return strbuilder_to_string_with_alloc(sb, sb->allocator);
+}
+
+ag_string
+strbuilder_to_string_with_alloc(const ag_strbuilder *sb, ag_allocator *alloc)
+{
+     ag_string str = new_string_with_alloc("", alloc);
+     string_reserve(str, sb->size);
+
+     char *dst = (char*)str->data;
+     for(const ag_sb_chunk *chunk = sb->head; chunk != NULL; chunk = chunk->next) {
+          memcpy(dst, chunk->data, chunk->size);
+          dst += chunk->size;
+     }
+     string_commit(str, sb->size);
+     return str;
+}
+
+// ---------------------------------------------------------------------------
+// Rope
+//
+// Nodes are immutable once built, so sharing them between ropes is safe and
+// every operation that changes shape builds new nodes along one path
+// (retaining the untouched subtrees) instead of editing in place.
+
+static inline size_t
+__rope_bytes(const ag_rope *r)
+{
+     return sizeof(ag_rope) + (r->left == NULL ? r->size : 0);
+}
+
+static ag_rope*
+__rope_leaf(const char *buf, size_t len, ag_allocator *alloc)
+{
+     ag_rope *r = (ag_rope*)ag_alloc(alloc, sizeof(ag_rope) + len);
+     if(r == NULL) {
+          fprintf(stderr, "Error: Memory allocation failed for rope leaf\n");
+          exit(EXIT_FAILURE);
+     }
+     r->left = NULL;
+     r->right = NULL;
+     r->size = len;
+     r->height = 0;
+     r->refs = 1;
+     r->allocator = alloc;
+     memcpy(r->data, buf, len);
+     return r;
+}
+
+// Takes over the references to l and r
+static ag_rope*
+__rope_node(ag_rope *l, ag_rope *r)
+{
+     ag_rope *n = (ag_rope*)ag_alloc(l->allocator, sizeof(ag_rope));
+     if(n == NULL) {
+          fprintf(stderr, "Error: Memory allocation failed for rope node\n");
+          exit(EXIT_FAILURE);
+     }
+     n->left = l;
+     n->right = r;
+     n->size = l->size + r->size;
+     n->height = agmax(l->height, r->height) + 1;
+     n->refs = 1;
+     n->allocator = l->allocator;
+     return n;
+}
+
+void
+rope_release(ag_rope *r)
+{
+     // Recurse on the left, loop down the right
+     while(r != NULL && --r->refs == 0) {
+          ag_rope *right = r->right;
+          rope_release(r->left);
+          ag_free(r->allocator, r, __rope_bytes(r));
+          r = right;
+     }
+}
+
+// Joins two AVL trees whose heights differ by at most 2 (consumes both)
+static ag_rope*
+__rope_balance(ag_rope *a, ag_rope *b)
+{
+     if(b->height > a->height + 1) {
+          ag_rope *bl = b->left, *br = b->right;
+          ag_rope *res;
+          if(br->height >= bl->height)
+               res = __rope_node(__rope_node(a, rope_retain(bl)), rope_retain(br));
+          else
+               res = __rope_node(__rope_node(a, rope_retain(bl->left)),
+                                 __rope_node(rope_retain(bl->right), rope_retain(br)));
+          rope_release(b);
+          return res;
+     }
+     if(a->height > b->height + 1) {
+          ag_rope *al = a->left, *ar = a->right;
+          ag_rope *res;
+          if(al->height >= ar->height)
+               res = __rope_node(rope_retain(al), __rope_node(rope_retain(ar), b));
+          else
+               res = __rope_node(__rope_node(rope_retain(al), rope_retain(ar->left)),
+                                 __rope_node(rope_retain(ar->right), b));
+          rope_release(a);
+          return res;
+     }
+     return __rope_node(a, b);
+}
+
+// AVL join: descends the taller tree's inner spine to a subtree of about the
+// other's height, O(|height difference|) new nodes (consumes l and r)
+static ag_rope*
+__rope_join(ag_rope *l, ag_rope *r)
+{
+     if(l == NULL) return r;
+     if(r == NULL) return l;
+
+     // Small neighbours become one leaf
+     if(l->left == NULL && r->left == NULL && l->size + r->size <= AG_ROPE_LEAF_BYTES) {
+          ag_rope *leaf = (ag_rope*)ag_alloc(l->allocator, sizeof(ag_rope) + l->size + r->size);
+          if(leaf == NULL) {
+               fprintf(stderr, "Error: Memory allocation failed for rope leaf\n");
+               exit(EXIT_FAILURE);
+          }
+          *leaf = (ag_rope){ NULL, NULL, l->size + r->size, 0, 1, l->allocator };
+          memcpy(leaf->data, l->data, l->size);
+          memcpy(leaf->data + l->size, r->data, r->size);
+          rope_release(l);
+          rope_release(r);
+          return leaf;
+     }
+
+     if(l->height > r->height + 1) {
+          ag_rope *ll = rope_retain(l->left), *lr = rope_retain(l->right);
+          rope_release(l);
+          return __rope_balance(ll, __rope_join(lr, r));
+     }
+     if(r->height > l->height + 1) {
+          ag_rope *rl = rope_retain(r->left), *rr = rope_retain(r->right);
+          rope_release(r);
+          return __rope_balance(__rope_join(l, rl), rr);
+     }
+     return __rope_node(l, r);
+}
+
+// Perfectly balanced tree of full leaves
+static ag_rope*
+__rope_build(const char *buf, size_t len, ag_allocator *alloc)
+{
+     if(len == 0) return NULL;
+     if(len <= AG_ROPE_LEAF_BYTES) return __rope_leaf(buf, len, alloc);
+
+     size_t leaves = (len + AG_ROPE_LEAF_BYTES - 1) / AG_ROPE_LEAF_BYTES;
+     size_t half = (leaves / 2) * AG_ROPE_LEAF_BYTES;
+     return __rope_node(__rope_build(buf, half, alloc), __rope_build(buf + half, len - half, alloc));
+}
+
+ag_rope*
+rope_from_buf(const char *buf, size_t len)
+{
+     return __rope_build(buf, len, &ag_default_allocator);
+}
+
+ag_rope*
+rope_from_buf_with_alloc(const char *buf, size_t len, ag_allocator *alloc)
+{
+     return __rope_build(buf, len, alloc);
+}
+
+ag_rope*
+strbuilder_to_rope(const ag_strbuilder *sb)
+{
+     ag_rope *r = NULL;
+     for(const ag_sb_chunk *chunk = sb->head; chunk != NULL; chunk = chunk->next)
+          r = __rope_join(r, __rope_build(chunk->data, chunk->size, sb->allocator));
+     return r;
+}
+
+ag_rope*
+rope_concat(ag_rope *a, ag_rope *b)
+{
+     return __rope_join(rope_retain(a), rope_retain(b));
+}
+
+// The pieces cut off both edges are joined back along the two split paths,
+// which telescopes to O(log n) in total
+static ag_rope*
+__rope_slice(ag_rope *r, size_t pos, size_t len)
+{
+     if(len == 0) return NULL;
+     if(pos == 0 && len == r->size) return rope_retain(r);
+     if(r->left == NULL) return __rope_leaf(r->data + pos, len, r->allocator);
+
+     size_t ln = r->left->size;
+     if(pos + len <= ln) return __rope_slice(r->left, pos, len);
+     if(pos >= ln) return __rope_slice(r->right, pos - ln, len);
+     return __rope_join(__rope_slice(r->left, pos, ln - pos),
+                        __rope_slice(r->right, 0, pos + len - ln));
+}
+
+ag_rope*
+rope_slice(ag_rope *r, size_t pos, size_t len)
+{
+     size_t size = rope_size(r);
+     if(pos >= size) return NULL;
+     if(len > size - pos) len = size - pos;
+     return __rope_slice(r, pos, len);
+}
+
+char
+rope_at(const ag_rope *r, size_t index)
+{
+     assert(index < rope_size(r));
+     while(r->left != NULL) {
+          if(index < r->left->size) r = r->left;
+          else {
+               index -= r->left->size;
+               r = r->right;
+          }
+     }
+     return r->data[index];
+}
+
+static void
+__rope_copy(const ag_rope *r, size_t pos, size_t len, char *dst)
+{
+     while(len > 0) {
+          if(r->left == NULL) {
+               memcpy(dst, r->data + pos, len);
+               return;
+          }
+          size_t ln = r->left->size;
+          if(pos < ln) {
+               size_t n = agmin(len, ln - pos);
+               __rope_copy(r->left, pos, n, dst);
+               dst += n;
+               len -= n;
+               pos = 0;
+          }
+          else pos -= ln;
+          r = r->right;
+     }
+}
+
+size_t
+rope_copy(const ag_rope *r, size_t pos, size_t len, char *dst)
+{
+     size_t size = rope_size(r);
+     if(pos >= size) return 0;
+     if(len > size - pos) len = size - pos;
+     __rope_copy(r, pos, len, dst);
+     return len;
+}
+
+ag_string
+rope_to_string(const ag_rope *r)
+{
+     ag_string str = new_string_with_alloc("", r != NULL ? r->allocator : &ag_default_allocator);
+     size_t size = rope_size(r);
+     string_reserve(str, size);
+     if(size > 0) __rope_copy(r, 0, size, (char*)str->data);
+     string_commit(str, size);
+     return str;
+}
@@ -1,57 +1,128 @@
 #include "../include/aegis/aegis_string.h"
+#include "../include/aegis/aegis_search.h"
 #include <string.h>
 
+// Strings keep a NUL at data[size], so capacity is always > size.
+// Anything that fits in AG_STRING_SSO_CAPACITY bytes (terminator included)
+// lives in storage allocated together with the header.
+
+// Copies len bytes of buf into a new NUL-terminated string owned by alloc
+static ag_string
+__string_from_buf(const char *buf, size_t len, ag_allocator *alloc)
+{
+     vector *buffer = (len + 1 <= AG_STRING_SSO_CAPACITY)
+          ? __vec_init_trailing(sizeof(char), alloc)
+          : __vec_init_with_alloc(len + 1, sizeof(char), 0, alloc);
+     memcpy(buffer->data, buf, len);
+     ((char*)buffer->data)[len] = '\0';
+     buffer->size = len;
+     return buffer;
+}
+
+// Makes room for nsize characters plus the terminator
+static inline void
+__string_reserve(ag_string str, size_t nsize)
+{
+     if(nsize >= str->capacity)
+          __vec_set_capacity(str, (size_t)(nsize * 1.5) + 1);
+}
+
+void
+string_reserve(ag_string str, size_t n)
+{
+     if(n >= str->capacity)
+          __vec_set_capacity(str, n + 1);
+}
+
+char*
+string_spare(ag_string str, size_t extra)
+{
+     __string_reserve(str, str->size + extra);
+     return ((char*)str->data) + str->size;
+}
+
+void
+string_commit(ag_string str, size_t written)
+{
+     assert(str->size + written < str->capacity);
+     str->size += written;
+     vec_at(str, char, str->size) = '\0';
+}
+
 ag_string 
 new_string(const char *cstr){
-     vector *buffer = vec_init(strlen(cstr), char, 1);
-     strcpy((char*)buffer->data, cstr); 
-     return buffer;
+     return __string_from_buf(cstr, strlen(cstr), &ag_default_allocator);
+}
+
+ag_string 
+new_string_with_alloc(const char *cstr, ag_allocator *alloc){
+     return __string_from_buf(cstr, strlen(cstr), alloc);
+}
+
+ag_string 
+new_string_n(const char *buf, size_t len){
+     return __string_from_buf(buf, len, &ag_default_allocator);
+}
+
+ag_string 
+new_string_n_with_alloc(const char *buf, size_t len, ag_allocator *alloc){
+     return __string_from_buf(buf, len, alloc);
 }
 
 void string_append(ag_string  str,const char *cstr){
-     size_t nsize = str->size + strlen(cstr);
-     if( nsize >= str->capacity) 
-          __vec_set_capacity(str, (size_t)(nsize * 1.5 )) ;
+     string_append_n(str, cstr, strlen(cstr));
+}
+
+void string_append_n(ag_string  str,const char *buf, size_t len){
+     size_t nsize = str->size + len;
+     // buf may point into str itself (e.g. string_append_view of a slice)
+     const char *data = (const char*)str->data;
+     bool alias = buf >= data && buf < data + str->capacity;
+     size_t offset = alias ? (size_t)(buf - data) : 0;
+     __string_reserve(str, nsize);
+     if(alias) buf = (const char*)str->data + offset;
+
      char *tail = ((char*)str->data) + str->size ;
-     strcpy(tail, cstr);
+     memcpy(tail, buf, len);
 
      str->size = nsize;
-     vec_at(str, char, nsize) = '\n';
+     vec_at(str, char, nsize) = '\0';
 }
 ag_string 
 sub_string(const ag_string str, size_t pos, size_t len){
      if (pos >= str->size) return NULL;
 
-     if(pos + len > str->size) len = str->size - len;
-     
-     char substring[len+1] = {'\n'};
-
-     strncpy(substring,((char *)str->data) + pos,  len);
+     if(pos + len > str->size) len = str->size - pos;
 
-     return new_string(substring); 
+     // Substrings live with the same allocator as their source
+     return __string_from_buf(((char *)str->data) + pos, len, str->allocator); 
 }
 
-inline ag_string 
+ag_string 
 string_rep(const ag_string str) {
-     return sub_string(str, 0, str->size); 
+     return __string_from_buf((char*)str->data, str->size, str->allocator); 
 }
 
-inline void 
+void 
 string_ncopy(const ag_string _dest, const ag_string _src, size_t n)
 {
-     strncpy(_dest->data, _src->data, agmax(n, _dest->size));
+     n = agmin(n, _src->size);
+     __string_reserve(_dest, n);
+     memmove(_dest->data, _src->data, n);
+     _dest->size = n;
+     vec_at(_dest, char, n) = '\0';
 }
 
-inline void
+void
 string_copy(const ag_string _dest ,const ag_string _src)
 {
-     strcpy(_dest->data, _src->data);
+     string_ncopy(_dest, _src, _src->size);
 }
 
-inline char*
+char*
 find_substr(const ag_string src_str, const ag_string str_to_search)
 {
-     return (!src_str->data && !str_to_search->data) ? NULL : strstr( (char*)src_str->data, (char*) str_to_search->data);
+     if(!src_str->data || !str_to_search->data) return NULL;
+     return (char*)ag_memmem((char*)src_str->data, src_str->size,
+                             (char*)str_to_search->data, str_to_search->size);
 }
-
-int main(){}
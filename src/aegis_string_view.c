@@ -0,0 +1,26 @@
+#include "aegis/aegis_string_view.h"
+#include "aegis/aegis_search.h"
+
+int
+sv_compare(ag_string_view a, ag_string_view b)
+{
+     size_t n = agmin(a.size, b.size);
+     int cmp = (n == 0) ? 0 : memcmp(a.data, b.data, n);
+     if(cmp != 0) return cmp;
+     return (a.size < b.size) ? -1 : (a.size > b.size);
+}
+
+size_t
+sv_find(ag_string_view hay, ag_string_view needle)
+{
+     const char *hit = ag_memmem(hay.data, hay.size, needle.data, needle.size);
+     return hit ? (size_t)(hit - hay.data) : AG_NPOS;
+}
+
+size_t
+sv_find_char(ag_string_view hay, char c)
+{
+     if(hay.size == 0) return AG_NPOS;
+     const char *hit = (const char*)memchr(hay.data, c, hay.size);
+     return hit ? (size_t)(hit - hay.data) : AG_NPOS;
+}
@@ -0,0 +1,563 @@
+#include "aegis/aegis_threadpool.h"
+
+#include <pthread.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+#define POOL_CACHE_LINE 64
+// Power of two. Fork-join keeps about log2(n / grain) tasks per deque, a
+// full deque just runs the would-be task inline.
+#define POOL_DEQUE_CAPACITY 1024
+// Failed steal rounds before an idle worker goes to sleep
+#define POOL_SPIN_ROUNDS 64
+
+static inline void
+__pool_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+     __builtin_ia32_pause();
+#endif
+}
+
+// ---------------------------------------------------------------------------
+// Tasks
+// ---------------------------------------------------------------------------
+
+typedef struct {
+     void (*body)(size_t begin, size_t end, void *ctx);
+     void *ctx;
+     size_t grain;
+     size_t align;            // Split points are align_offset + k * align
+     size_t align_offset;
+} __par_job;
+
+// Lives on the stack of the frame that forked it, which waits on `done`
+typedef struct {
+     __par_job *job;
+     size_t begin;
+     size_t end;
+     atomic_int done;
+} __par_task;
+
+// ---------------------------------------------------------------------------
+// Chase-Lev deque (Le, Pop, Cohen, Zappa Nardelli, PPoPP 2013)
+// ---------------------------------------------------------------------------
+
+typedef struct {
+     alignas(POOL_CACHE_LINE) atomic_long top;      // Thieves take here
+     alignas(POOL_CACHE_LINE) atomic_long bottom;   // The owner pushes / takes here
+     _Atomic(__par_task*) buffer[POOL_DEQUE_CAPACITY];
+} __deque;
+
+static bool
+__deque_push(__deque *dq, __par_task *task)
+{
+     long b = atomic_load_explicit(&dq->bottom, memory_order_relaxed);
+     long t = atomic_load_explicit(&dq->top, memory_order_acquire);
+     if(b - t >= POOL_DEQUE_CAPACITY) return false;
+     atomic_store_explicit(&dq->buffer[b & (POOL_DEQUE_CAPACITY - 1)], task, memory_order_relaxed);
+     // Release store rather than fence + relaxed store: same cost on x86 and
+     // it publishes the task fields in a form ThreadSanitizer understands
+     atomic_store_explicit(&dq->bottom, b + 1, memory_order_release);
+     return true;
+}
+
+static __par_task*
+__deque_take(__deque *dq)
+{
+     long b = atomic_load_explicit(&dq->bottom, memory_order_relaxed) - 1;
+     atomic_store_explicit(&dq->bottom, b, memory_order_relaxed);
+     atomic_thread_fence(memory_order_seq_cst);
+     long t = atomic_load_explicit(&dq->top, memory_order_relaxed);
+
+     __par_task *task = NULL;
+     if(t <= b) {
+          task = atomic_load_explicit(&dq->buffer[b & (POOL_DEQUE_CAPACITY - 1)], memory_order_relaxed);
+          if(t == b) {
+               // Last element, race the thieves for it
+               if(!atomic_compare_exchange_strong_explicit(&dq->top, &t, t + 1,
+                         memory_order_seq_cst, memory_order_relaxed))
+                    task = NULL;
+               atomic_store_explicit(&dq->bottom, b + 1, memory_order_relaxed);
+          }
+     }
+     else atomic_store_explicit(&dq->bottom, b + 1, memory_order_relaxed);
+     return task;
+}
+
+static __par_task*
+__deque_steal(__deque *dq)
+{
+     long t = atomic_load_explicit(&dq->top, memory_order_acquire);
+     atomic_thread_fence(memory_order_seq_cst);
+     long b = atomic_load_explicit(&dq->bottom, memory_order_acquire);
+     if(t >= b) return NULL;
+
+     __par_task *task = atomic_load_explicit(&dq->buffer[t & (POOL_DEQUE_CAPACITY - 1)], memory_order_relaxed);
+     if(!atomic_compare_exchange_strong_explicit(&dq->top, &t, t + 1,
+               memory_order_seq_cst, memory_order_relaxed))
+          return NULL;
+     return task;
+}
+
+// ---------------------------------------------------------------------------
+// Pool
+// ---------------------------------------------------------------------------
+
+typedef struct {
+     __deque deque;
+     ag_threadpool *pool;
+     pthread_t thread;
+     uint64_t rng;
+     size_t index;
+} __worker;
+
+struct __AG_THREADPOOL__{
+     __worker *workers;       // nthreads - 1 threads, then the slot of the calling thread
+     size_t nthreads;
+     size_t grain;
+     size_t serial_threshold;
+
+     pthread_mutex_t caller_lock;  // One non-pool caller at a time
+
+     // Sleep / wake
+     pthread_mutex_t sleep_lock;
+     pthread_cond_t wake;
+     atomic_uint epoch;       // Bumped on every push
+     atomic_uint sleepers;
+     atomic_bool stop;
+};
+
+static _Thread_local __worker *__current_worker = NULL;
+
+static inline uint64_t
+__worker_rand(__worker *w)
+{
+     w->rng ^= w->rng << 13;
+     w->rng ^= w->rng >> 7;
+     w->rng ^= w->rng << 17;
+     return w->rng;
+}
+
+static void
+__pool_notify(ag_threadpool *pool)
+{
+     atomic_fetch_add(&pool->epoch, 1);
+     if(atomic_load(&pool->sleepers) > 0) {
+          pthread_mutex_lock(&pool->sleep_lock);
+          pthread_cond_signal(&pool->wake);
+          pthread_mutex_unlock(&pool->sleep_lock);
+     }
+}
+
+// One pass over the other deques from a random start
+static __par_task*
+__pool_steal(__worker *self)
+{
+     ag_threadpool *pool = self->pool;
+     size_t count = pool->nthreads;
+     size_t start = (size_t)(__worker_rand(self) % count);
+     for(size_t k = 0; k < count; k++) {
+          __worker *victim = &pool->workers[(start + k) % count];
+          if(victim == self) continue;
+          __par_task *task = __deque_steal(&victim->deque);
+          if(task != NULL) return task;
+     }
+     return NULL;
+}
+
+static void __par_run(__worker *self, __par_job *job, size_t begin, size_t end);
+
+static void
+__par_execute(__worker *self, __par_task *task)
+{
+     __par_run(self, task->job, task->begin, task->end);
+     atomic_store_explicit(&task->done, 1, memory_order_release);
+}
+
+// Split point inside (begin, end) on the job's alignment grid, or begin
+static size_t
+__par_split(const __par_job *job, size_t begin, size_t end)
+{
+     size_t mid = begin + (end - begin) / 2;
+     if(job->align <= 1) return mid;
+     if(mid < job->align_offset) return job->align_offset < end ? job->align_offset : begin;
+
+     size_t down = mid - (mid - job->align_offset) % job->align;
+     if(down > begin) return down;
+     size_t up = down + job->align;
+     return up < end ? up : begin;
+}
+
+static void
+__par_run(__worker *self, __par_job *job, size_t begin, size_t end)
+{
+     size_t mid;
+     if(end - begin <= job->grain || (mid = __par_split(job, begin, end)) == begin) {
+          job->body(begin, end, job->ctx);
+          return;
+     }
+
+     __par_task right = { .job = job, .begin = mid, .end = end };
+     atomic_init(&right.done, 0);
+     if(!__deque_push(&self->deque, &right)) {
+          __par_run(self, job, begin, mid);
+          __par_run(self, job, mid, end);
+          return;
+     }
+     __pool_notify(self->pool);
+
+     __par_run(self, job, begin, mid);
+
+     // Join: everything pushed after `right` has been joined already, so the
+     // deque either still ends with it or it was stolen
+     __par_task *task = __deque_take(&self->deque);
+     if(task == &right) {
+          __par_run(self, job, mid, end);
+          return;
+     }
+     assert(task == NULL);
+
+     // Help out until the thief is done
+     while(!atomic_load_explicit(&right.done, memory_order_acquire)) {
+          task = __pool_steal(self);
+          if(task != NULL) __par_execute(self, task);
+          else __pool_relax();
+     }
+}
+
+static void*
+__worker_main(void *arg)
+{
+     __worker *self = (__worker*)arg;
+     ag_threadpool *pool = self->pool;
+     __current_worker = self;
+
+     unsigned idle = 0;
+     while(!atomic_load_explicit(&pool->stop, memory_order_relaxed)) {
+          unsigned epoch = atomic_load(&pool->epoch);
+          __par_task *task = __pool_steal(self);
+          if(task != NULL) {
+               __par_execute(self, task);
+               idle = 0;
+               continue;
+          }
+          if(++idle < POOL_SPIN_ROUNDS) {
+               __pool_relax();
+               continue;
+          }
+
+          // Sleep until something is pushed after the steal pass above
+          pthread_mutex_lock(&pool->sleep_lock);
+          atomic_fetch_add(&pool->sleepers, 1);
+          while(atomic_load(&pool->epoch) == epoch && !atomic_load(&pool->stop))
+               pthread_cond_wait(&pool->wake, &pool->sleep_lock);
+          atomic_fetch_sub(&pool->sleepers, 1);
+          pthread_mutex_unlock(&pool->sleep_lock);
+          idle = 0;
+     }
+     return NULL;
+}
+
+ag_threadpool*
+ag_threadpool_init(size_t nthreads)
+{
+     if(nthreads == 0) {
+          long online = sysconf(_SC_NPROCESSORS_ONLN);
+          nthreads = online > 0 ? (size_t)online : 1;
+     }
+
+     ag_threadpool *pool = (ag_threadpool*)malloc(sizeof(ag_threadpool));
+     assert(pool != NULL);
+     pool->workers = (__worker*)aligned_alloc(alignof(__worker), nthreads * sizeof(__worker));
+     assert(pool->workers != NULL);
+     pool->nthreads = nthreads;
+     pool->grain = 0;
+     pool->serial_threshold = AG_PARALLEL_SERIAL_THRESHOLD;
+     pthread_mutex_init(&pool->caller_lock, NULL);
+     pthread_mutex_init(&pool->sleep_lock, NULL);
+     pthread_cond_init(&pool->wake, NULL);
+     atomic_init(&pool->epoch, 0);
+     atomic_init(&pool->sleepers, 0);
+     atomic_init(&pool->stop, false);
+
+     for(size_t i = 0; i < nthreads; i++) {
+          __worker *w = &pool->workers[i];
+          atomic_init(&w->deque.top, 0);
+          atomic_init(&w->deque.bottom, 0);
+          w->pool = pool;
+          w->index = i;
+          w->rng = 0x9e3779b97f4a7c15ull * (i + 1);
+     }
+     // The last slot belongs to whichever thread calls in
+     for(size_t i = 0; i + 1 < nthreads; i++) {
+          if(pthread_create(&pool->workers[i].thread, NULL, __worker_main, &pool->workers[i]) != 0) {
+               fprintf(stderr, "Error: Failed to start thread pool worker\n");
+               exit(EXIT_FAILURE);
+          }
+     }
+     return pool;
+}
+
+void
+ag_threadpool_clean(ag_threadpool *pool)
+{
+     if(pool == NULL) return;
+     pthread_mutex_lock(&pool->sleep_lock);
+     atomic_store(&pool->stop, true);
+     pthread_cond_broadcast(&pool->wake);
+     pthread_mutex_unlock(&pool->sleep_lock);
+
+     for(size_t i = 0; i + 1 < pool->nthreads; i++)
+          pthread_join(pool->workers[i].thread, NULL);
+
+     pthread_cond_destroy(&pool->wake);
+     pthread_mutex_destroy(&pool->sleep_lock);
+     pthread_mutex_destroy(&pool->caller_lock);
+     free(pool->workers);
+     free(pool);
+}
+
+size_t
+ag_threadpool_size(const ag_threadpool *pool)
+{
+     return pool->nthreads;
+}
+
+void
+ag_threadpool_set_grain(ag_threadpool *pool, size_t grain)
+{
+     pool->grain = grain;
+}
+
+void
+ag_threadpool_set_serial_threshold(ag_threadpool *pool, size_t n)
+{
+     pool->serial_threshold = n;
+}
+
+size_t
+ag_threadpool_serial_threshold(const ag_threadpool *pool)
+{
+     return pool != NULL ? pool->serial_threshold : SIZE_MAX;
+}
+
+// ---------------------------------------------------------------------------
+// Parallel loops
+// ---------------------------------------------------------------------------
+
+static void
+__par_for(ag_threadpool *pool, size_t n, __par_job *job)
+{
+     if(n == 0) return;
+     if(pool == NULL || pool->nthreads < 2 || n <= job->grain) {
+          job->body(0, n, job->ctx);
+          return;
+     }
+
+     // Nested call from one of our workers: fork on its own deque
+     __worker *self = __current_worker;
+     if(self != NULL && self->pool == pool) {
+          __par_run(self, job, 0, n);
+          return;
+     }
+
+     pthread_mutex_lock(&pool->caller_lock);
+     __worker *caller = &pool->workers[pool->nthreads - 1];
+     __current_worker = caller;
+     __par_run(caller, job, 0, n);
+     __current_worker = self;
+     pthread_mutex_unlock(&pool->caller_lock);
+}
+
+void
+ag_parallel_for(ag_threadpool *pool, size_t n, size_t grain,
+                void (*body)(size_t begin, size_t end, void *ctx), void *ctx)
+{
+     __par_job job = { body, ctx, agmax(grain, (size_t)1), 1, 0 };
+     __par_for(pool, n, &job);
+}
+
+static size_t
+__par_grain(const ag_threadpool *pool, size_t n)
+{
+     if(pool->grain != 0) return pool->grain;
+     return agmax(n / (pool->nthreads * 8), (size_t)AG_PARALLEL_MIN_GRAIN);
+}
+
+// Whether a vector operation over n elements should stay on the caller
+static inline bool
+__par_serial(const ag_threadpool *pool, size_t n)
+{
+     return pool == NULL || pool->nthreads < 2 || n < pool->serial_threshold;
+}
+
+// Job over the elements of vec whose splits land on cache line boundaries
+static __par_job
+__par_vec_job(const ag_threadpool *pool, const vector *vec, size_t n,
+              void (*body)(size_t, size_t, void*), void *ctx)
+{
+     __par_job job = { body, ctx, __par_grain(pool, n), 1, 0 };
+
+     // Elements start on a line every `step` elements, from the first k that
+     // does; if none does (odd sizes on an odd address), keep plain halving
+     size_t es = vec->element_size;
+     size_t step = POOL_CACHE_LINE / agmin(es & (0 - es), (size_t)POOL_CACHE_LINE);
+     size_t misalign = (size_t)((uintptr_t)vec->data % POOL_CACHE_LINE);
+     for(size_t k = 0; k < step; k++) {
+          if((misalign + k * es) % POOL_CACHE_LINE == 0) {
+               job.align = step;
+               job.align_offset = k;
+               break;
+          }
+     }
+     return job;
+}
+
+typedef struct {
+     vector *vec;
+     const vector *src;
+     void (*each)(void *elem, void *ctx);
+     void (*map)(void *out, const void *in, void *ctx);
+     void *ctx;
+} __par_vec_ctx;
+
+static void
+__par_for_each_body(size_t begin, size_t end, void *ctx)
+{
+     __par_vec_ctx *c = (__par_vec_ctx*)ctx;
+     byte *it = (byte*)c->vec->data + begin * c->vec->element_size;
+     for(size_t i = begin; i < end; i++, it += c->vec->element_size)
+          c->each(it, c->ctx);
+}
+
+void
+__vec_for_each(vector *vec, void (*fn)(void *elem, void *ctx), void *ctx, ag_threadpool *pool)
+{
+     __par_vec_ctx c = { .vec = vec, .each = fn, .ctx = ctx };
+     if(__par_serial(pool, vec->size)) {
+          __par_for_each_body(0, vec->size, &c);
+          return;
+     }
+     __par_job job = __par_vec_job(pool, vec, vec->size, __par_for_each_body, &c);
+     __par_for(pool, vec->size, &job);
+}
+
+static void
+__par_transform_body(size_t begin, size_t end, void *ctx)
+{
+     __par_vec_ctx *c = (__par_vec_ctx*)ctx;
+     byte *out = (byte*)c->vec->data + begin * c->vec->element_size;
+     const byte *in = (const byte*)c->src->data + begin * c->src->element_size;
+     for(size_t i = begin; i < end; i++) {
+          c->map(out, in, c->ctx);
+          out += c->vec->element_size;
+          in += c->src->element_size;
+     }
+}
+
+void
+__vec_transform(vector *dest, const vector *src,
+                void (*fn)(void *out, const void *in, void *ctx), void *ctx, ag_threadpool *pool)
+{
+     // In place is fine; a different vector must not share src's buffer
+     assert(dest == src
+            || (const byte*)dest->data + dest->capacity * dest->element_size <= (const byte*)src->data
+            || (const byte*)src->data + src->capacity * src->element_size <= (const byte*)dest->data);
+     if(dest->capacity < src->size) __vec_set_capacity(dest, src->size);
+     dest->size = src->size;
+
+     __par_vec_ctx c = { .vec = dest, .src = src, .map = fn, .ctx = ctx };
+     if(__par_serial(pool, src->size)) {
+          __par_transform_body(0, src->size, &c);
+          return;
+     }
+     // Align on the output, that is where the writes go
+     __par_job job = __par_vec_job(pool, dest, src->size, __par_transform_body, &c);
+     __par_for(pool, src->size, &job);
+}
+
+typedef struct {
+     const vector *vec;
+     byte *partials;
+     size_t acc_size;
+     size_t chunk;
+     void (*fn)(void *acc, const void *elem, void *ctx);
+     void *ctx;
+} __par_reduce_ctx;
+
+// Over chunk indices: each chunk folds into its own partial
+static void
+__par_reduce_body(size_t begin, size_t end, void *ctx)
+{
+     __par_reduce_ctx *c = (__par_reduce_ctx*)ctx;
+     size_t es = c->vec->element_size;
+     for(size_t k = begin; k < end; k++) {
+          void *acc = c->partials + k * c->acc_size;
+          size_t lo = k * c->chunk, hi = agmin(lo + c->chunk, c->vec->size);
+          const byte *it = (const byte*)c->vec->data + lo * es;
+          for(size_t i = lo; i < hi; i++, it += es)
+               c->fn(acc, it, c->ctx);
+     }
+}
+
+void
+__vec_reduce(const vector *vec, void *acc, size_t acc_size,
+             void (*fn)(void *acc, const void *elem, void *ctx),
+             void (*combine)(void *acc, const void *other, void *ctx),
+             void *ctx, ag_threadpool *pool)
+{
+     if(__par_serial(pool, vec->size)) {
+          const byte *it = (const byte*)vec->data;
+          for(size_t i = 0; i < vec->size; i++, it += vec->element_size)
+               fn(acc, it, ctx);
+          return;
+     }
+
+     size_t chunk = __par_grain(pool, vec->size);
+     size_t chunks = (vec->size + chunk - 1) / chunk;
+     byte *partials = (byte*)malloc(chunks * acc_size);
+     assert(partials != NULL);
+     for(size_t k = 0; k < chunks; k++)
+          memcpy(partials + k * acc_size, acc, acc_size);
+
+     __par_reduce_ctx c = { vec, partials, acc_size, chunk, fn, ctx };
+     ag_parallel_for(pool, chunks, 1, __par_reduce_body, &c);
+
+     for(size_t k = 0; k < chunks; k++)
+          combine(acc, partials + k * acc_size, ctx);
+     free(partials);
+}
+
+typedef struct {
+     vector *vec;
+     size_t offset;
+     const void *val;
+} __par_fill_ctx;
+
+static void
+__par_fill_body(size_t begin, size_t end, void *ctx)
+{
+     __par_fill_ctx *c = (__par_fill_ctx*)ctx;
+     __vec_fill(c->vec, c->offset + begin, c->offset + end, (void*)c->val);
+}
+
+void
+__vec_parallel_fill(vector *vec, size_t begin, size_t end, const void *val, ag_threadpool *pool)
+{
+     end = agmin(end, vec->size);
+     if(begin >= end) return;
+     size_t n = end - begin;
+
+     __par_fill_ctx c = { vec, begin, val };
+     if(__par_serial(pool, n)) {
+          __par_fill_body(0, n, &c);
+          return;
+     }
+     __par_job job = __par_vec_job(pool, vec, n, __par_fill_body, &c);
+     // Job indices start at `begin` in the vector
+     size_t shift = begin % job.align;
+     job.align_offset = (job.align_offset + job.align - shift) % job.align;
+     __par_for(pool, n, &job);
+}
@@ -0,0 +1,835 @@
+#include "aegis/aegis_utf8.h"
+#include "aegis/aegis_utils.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <immintrin.h>
+#define UTF8_HAS_X86 1
+#else
+#define UTF8_HAS_X86 0
+#endif
+
+#define UTF8_COUNT_CHUNK 1024 // Bytes sv_utf8_offset skips per count call
+
+// Kernels work on whole vectors from the start of their input and leave the
+// rest to the scalar code.
+typedef struct {
+     // Offset of the block where an error shows up, AG_NPOS for valid input
+     size_t (*validate)(const uint8_t *s, size_t n);
+     // Non-continuation bytes, plus 4-byte leads when utf16 (UTF-16 units)
+     size_t (*count)(const uint8_t *s, size_t n, bool utf16);
+     // Convert the leading whole blocks of ASCII, return the units converted
+     size_t (*ascii_to_utf16)(const uint8_t *s, size_t n, uint16_t *out);
+     size_t (*ascii_to_utf32)(const uint8_t *s, size_t n, uint32_t *out);
+     size_t (*utf16_to_ascii)(const uint16_t *src, size_t n, uint8_t *out);
+     size_t (*utf32_to_ascii)(const uint32_t *src, size_t n, uint8_t *out);
+} __utf8_kernels;
+
+// ---------------------------------------------------------------------------
+// Scalar code
+// ---------------------------------------------------------------------------
+
+#define UTF8_HIGH_BITS 0x8080808080808080ull
+#define UTF8_LOW_BITS  0x0101010101010101ull
+
+static inline bool
+__utf8_is_cont(uint8_t b)
+{
+     return (b & 0xC0) == 0x80;
+}
+
+static inline uint64_t
+__utf8_load64(const uint8_t *p)
+{
+     uint64_t w;
+     memcpy(&w, p, sizeof(w));
+     return w;
+}
+
+// Decodes one sequence of s[0..n), n >= 1, per Unicode table 3-7
+static inline uint32_t
+__utf8_decode(const uint8_t *s, size_t n, size_t *len)
+{
+     uint32_t c = s[0];
+     *len = 1;
+     if(c < 0x80) return c;
+     if(c < 0xC2 || c > 0xF4) return AG_UTF_INVALID;
+     if(n < 2) return AG_UTF_INVALID;
+     if(c < 0xE0) {
+          if(!__utf8_is_cont(s[1])) return AG_UTF_INVALID;
+          *len = 2;
+          return ((c & 0x1F) << 6) | (s[1] & 0x3F);
+     }
+
+     // Second byte range rules out overlongs, surrogates and > U+10FFFF
+     uint8_t lo = 0x80, hi = 0xBF;
+     if(c == 0xE0) lo = 0xA0;
+     else if(c == 0xED) hi = 0x9F;
+     else if(c == 0xF0) lo = 0x90;
+     else if(c == 0xF4) hi = 0x8F;
+     if(s[1] < lo || s[1] > hi) return AG_UTF_INVALID;
+
+     if(c < 0xF0) {
+          if(n < 3 || !__utf8_is_cont(s[2])) return AG_UTF_INVALID;
+          *len = 3;
+          return ((c & 0x0F) << 12) | ((uint32_t)(s[1] & 0x3F) << 6) | (s[2] & 0x3F);
+     }
+     if(n < 4 || !__utf8_is_cont(s[2]) || !__utf8_is_cont(s[3])) return AG_UTF_INVALID;
+     *len = 4;
+     return ((c & 0x07) << 18) | ((uint32_t)(s[1] & 0x3F) << 12) | ((uint32_t)(s[2] & 0x3F) << 6) | (s[3] & 0x3F);
+}
+
+// cp is a scalar value (no surrogates, at most U+10FFFF)
+static inline size_t
+__utf8_encode(uint32_t cp, uint8_t *out)
+{
+     if(cp < 0x80) {
+          out[0] = (uint8_t)cp;
+          return 1;
+     }
+     if(cp < 0x800) {
+          out[0] = (uint8_t)(0xC0 | (cp >> 6));
+          out[1] = (uint8_t)(0x80 | (cp & 0x3F));
+          return 2;
+     }
+     if(cp < 0x10000) {
+          out[0] = (uint8_t)(0xE0 | (cp >> 12));
+          out[1] = (uint8_t)(0x80 | ((cp >> 6) & 0x3F));
+          out[2] = (uint8_t)(0x80 | (cp & 0x3F));
+          return 3;
+     }
+     out[0] = (uint8_t)(0xF0 | (cp >> 18));
+     out[1] = (uint8_t)(0x80 | ((cp >> 12) & 0x3F));
+     out[2] = (uint8_t)(0x80 | ((cp >> 6) & 0x3F));
+     out[3] = (uint8_t)(0x80 | (cp & 0x3F));
+     return 4;
+}
+
+// Exact: offset of the first ill-formed sequence
+static size_t
+__utf8_validate_scalar(const uint8_t *s, size_t n)
+{
+     size_t i = 0;
+     while(i < n) {
+          if(s[i] < 0x80) {
+               while(i + 8 <= n && (__utf8_load64(s + i) & UTF8_HIGH_BITS) == 0) i += 8;
+               while(i < n && s[i] < 0x80) i++;
+               continue;
+          }
+          size_t len;
+          if(__utf8_decode(s + i, n - i, &len) == AG_UTF_INVALID) return i;
+          i += len;
+     }
+     return AG_NPOS;
+}
+
+// Per byte of w: bit 0 set when the byte is not a continuation byte
+static inline uint64_t
+__utf8_starts64(uint64_t w)
+{
+     return ((~w >> 7) | (w >> 6)) & UTF8_LOW_BITS;
+}
+
+static size_t
+__utf8_count_scalar(const uint8_t *s, size_t n, bool utf16)
+{
+     size_t count = 0, i = 0;
+     for(; i + 8 <= n; i += 8) {
+          uint64_t w = __utf8_load64(s + i);
+          count += (size_t)__builtin_popcountll(__utf8_starts64(w));
+          if(utf16) count += (size_t)__builtin_popcountll((w >> 7) & (w >> 6) & (w >> 5) & (w >> 4) & UTF8_LOW_BITS);
+     }
+     for(; i < n; i++) count += !__utf8_is_cont(s[i]) + (utf16 && s[i] >= 0xF0);
+     return count;
+}
+
+static size_t
+__utf8_ascii_to_utf16_scalar(const uint8_t *s, size_t n, uint16_t *out)
+{
+     size_t i = 0;
+     for(; i + 8 <= n && (__utf8_load64(s + i) & UTF8_HIGH_BITS) == 0; i += 8)
+          for(size_t k = 0; k < 8; k++) out[i + k] = s[i + k];
+     return i;
+}
+
+static size_t
+__utf8_ascii_to_utf32_scalar(const uint8_t *s, size_t n, uint32_t *out)
+{
+     size_t i = 0;
+     for(; i + 8 <= n && (__utf8_load64(s + i) & UTF8_HIGH_BITS) == 0; i += 8)
+          for(size_t k = 0; k < 8; k++) out[i + k] = s[i + k];
+     return i;
+}
+
+// The callers' byte loops handle ASCII runs well enough without vectors
+static size_t
+__utf8_utf16_to_ascii_scalar(const uint16_t *src, size_t n, uint8_t *out)
+{
+     (void)src; (void)n; (void)out;
+     return 0;
+}
+
+static size_t
+__utf8_utf32_to_ascii_scalar(const uint32_t *src, size_t n, uint8_t *out)
+{
+     (void)src; (void)n; (void)out;
+     return 0;
+}
+
+#if UTF8_HAS_X86
+
+// ---------------------------------------------------------------------------
+// Vector validation (Keiser and Lemire, "Validating UTF-8 in less than one
+// instruction per byte").
+//
+// Every byte is checked against the one before it: the high nibble of the
+// previous byte, its low nibble and the high nibble of the current byte each
+// index a 16-entry table of error bits, and an error is any bit set in all
+// three. Third and fourth bytes of a sequence are checked against the lead
+// 2 and 3 bytes back. A block ending inside a sequence leaves "incomplete"
+// set for the next one.
+// ---------------------------------------------------------------------------
+
+#define UTF8_TOO_SHORT  (1 << 0) // Lead byte or ASCII followed by a lead byte or ASCII
+#define UTF8_TOO_LONG   (1 << 1) // ASCII followed by a continuation byte
+#define UTF8_OVERLONG_3 (1 << 2) // E0 80..9F
+#define UTF8_TOO_LARGE  (1 << 3) // F4 90..BF, F5..FF
+#define UTF8_SURROGATE  (1 << 4) // ED A0..BF
+#define UTF8_OVERLONG_2 (1 << 5) // C0..C1
+#define UTF8_TOO_LARGE_1000 (1 << 6)
+#define UTF8_OVERLONG_4 (1 << 6) // F0 80..8F
+#define UTF8_TWO_CONTS  (1 << 7) // Continuation byte after a continuation that ends the sequence
+#define UTF8_CARRY (UTF8_TOO_SHORT | UTF8_TOO_LONG | UTF8_TWO_CONTS)
+
+static const uint8_t __utf8_byte1_high[16] = {
+     UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+     UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+     UTF8_TWO_CONTS, UTF8_TWO_CONTS, UTF8_TWO_CONTS, UTF8_TWO_CONTS,
+     UTF8_TOO_SHORT | UTF8_OVERLONG_2,
+     UTF8_TOO_SHORT,
+     UTF8_TOO_SHORT | UTF8_OVERLONG_3 | UTF8_SURROGATE,
+     UTF8_TOO_SHORT | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4,
+};
+
+static const uint8_t __utf8_byte1_low[16] = {
+     UTF8_CARRY | UTF8_OVERLONG_3 | UTF8_OVERLONG_2 | UTF8_OVERLONG_4,
+     UTF8_CARRY | UTF8_OVERLONG_2,
+     UTF8_CARRY,
+     UTF8_CARRY,
+     UTF8_CARRY | UTF8_TOO_LARGE,
+     UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+     UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+     UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+     UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+     UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+     UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+     UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+     UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+     UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_SURROGATE,
+     UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+     UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+};
+
+static const uint8_t __utf8_byte2_high[16] = {
+     UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+     UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+     UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4,
+     UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 | UTF8_TOO_LARGE,
+     UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE | UTF8_TOO_LARGE,
+     UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE | UTF8_TOO_LARGE,
+     UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+};
+
+// Subtracted (saturating) from the last block bytes: non-zero where a lead
+// byte has no room for its sequence
+static const uint8_t __utf8_max_tail[32] = {
+     255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+     255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 0xF0 - 1, 0xE0 - 1, 0xC0 - 1,
+};
+
+__attribute__((target("avx2")))
+static size_t
+__utf8_validate_avx2(const uint8_t *s, size_t n)
+{
+     const __m256i byte1_high = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)__utf8_byte1_high));
+     const __m256i byte1_low = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)__utf8_byte1_low));
+     const __m256i byte2_high = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)__utf8_byte2_high));
+     const __m256i max_tail = _mm256_loadu_si256((const __m256i*)__utf8_max_tail);
+     const __m256i nibble = _mm256_set1_epi8(0x0F);
+     const __m256i zero = _mm256_setzero_si256();
+     __m256i prev = zero, incomplete = zero;
+     uint8_t tail[32];
+
+     // The last block is zero-padded, so it also reports a sequence cut off
+     // by the end of the input
+     for(size_t i = 0;; i += 32) {
+          bool last = n - i < 32;
+          __m256i in;
+          if(!last) {
+               in = _mm256_loadu_si256((const __m256i*)(s + i));
+          } else {
+               memset(tail, 0, sizeof(tail));
+               if(n > i) memcpy(tail, s + i, n - i);
+               in = _mm256_loadu_si256((const __m256i*)tail);
+          }
+
+          __m256i err;
+          if(_mm256_movemask_epi8(in) == 0) {
+               err = incomplete;
+               incomplete = zero;
+          } else {
+               __m256i shifted = _mm256_permute2x128_si256(prev, in, 0x21);
+               __m256i prev1 = _mm256_alignr_epi8(in, shifted, 15);
+               __m256i prev2 = _mm256_alignr_epi8(in, shifted, 14);
+               __m256i prev3 = _mm256_alignr_epi8(in, shifted, 13);
+               __m256i special = _mm256_and_si256(
+                    _mm256_and_si256(
+                         _mm256_shuffle_epi8(byte1_high, _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble)),
+                         _mm256_shuffle_epi8(byte1_low, _mm256_and_si256(prev1, nibble))),
+                    _mm256_shuffle_epi8(byte2_high, _mm256_and_si256(_mm256_srli_epi16(in, 4), nibble)));
+               // Only 111xxxxx two back / 1111xxxx three back reach 0x80
+               __m256i must23 = _mm256_or_si256(_mm256_subs_epu8(prev2, _mm256_set1_epi8((char)(0xE0 - 0x80))),
+                                                _mm256_subs_epu8(prev3, _mm256_set1_epi8((char)(0xF0 - 0x80))));
+               must23 = _mm256_and_si256(must23, _mm256_set1_epi8((char)0x80));
+               // A sequence cut short by the previous block fails here as TOO_SHORT
+               err = _mm256_xor_si256(must23, special);
+               incomplete = _mm256_subs_epu8(in, max_tail);
+          }
+          if(!_mm256_testz_si256(err, err)) return i;
+          if(last) return AG_NPOS;
+          prev = in;
+     }
+}
+
+__attribute__((target("sse4.1")))
+static size_t
+__utf8_validate_sse4(const uint8_t *s, size_t n)
+{
+     const __m128i byte1_high = _mm_loadu_si128((const __m128i*)__utf8_byte1_high);
+     const __m128i byte1_low = _mm_loadu_si128((const __m128i*)__utf8_byte1_low);
+     const __m128i byte2_high = _mm_loadu_si128((const __m128i*)__utf8_byte2_high);
+     const __m128i max_tail = _mm_loadu_si128((const __m128i*)(__utf8_max_tail + 16));
+     const __m128i nibble = _mm_set1_epi8(0x0F);
+     const __m128i zero = _mm_setzero_si128();
+     __m128i prev = zero, incomplete = zero;
+     uint8_t tail[16];
+
+     for(size_t i = 0;; i += 16) {
+          bool last = n - i < 16;
+          __m128i in;
+          if(!last) {
+               in = _mm_loadu_si128((const __m128i*)(s + i));
+          } else {
+               memset(tail, 0, sizeof(tail));
+               if(n > i) memcpy(tail, s + i, n - i);
+               in = _mm_loadu_si128((const __m128i*)tail);
+          }
+
+          __m128i err;
+          if(_mm_movemask_epi8(in) == 0) {
+               err = incomplete;
+               incomplete = zero;
+          } else {
+               __m128i prev1 = _mm_alignr_epi8(in, prev, 15);
+               __m128i prev2 = _mm_alignr_epi8(in, prev, 14);
+               __m128i prev3 = _mm_alignr_epi8(in, prev, 13);
+               __m128i special = _mm_and_si128(
+                    _mm_and_si128(_mm_shuffle_epi8(byte1_high, _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble)),
+                                  _mm_shuffle_epi8(byte1_low, _mm_and_si128(prev1, nibble))),
+                    _mm_shuffle_epi8(byte2_high, _mm_and_si128(_mm_srli_epi16(in, 4), nibble)));
+               __m128i must23 = _mm_or_si128(_mm_subs_epu8(prev2, _mm_set1_epi8((char)(0xE0 - 0x80))),
+                                             _mm_subs_epu8(prev3, _mm_set1_epi8((char)(0xF0 - 0x80))));
+               must23 = _mm_and_si128(must23, _mm_set1_epi8((char)0x80));
+               err = _mm_xor_si128(must23, special);
+               incomplete = _mm_subs_epu8(in, max_tail);
+          }
+          if(!_mm_testz_si128(err, err)) return i;
+          if(last) return AG_NPOS;
+          prev = in;
+     }
+}
+
+// ---------------------------------------------------------------------------
+// Vector counting and ASCII conversion. Counts add per-byte 0/-1 compare
+// results into byte counters, summed with psadbw before they can overflow.
+// ---------------------------------------------------------------------------
+
+#define UTF8_COUNT_FLUSH 127 // Blocks per byte-counter flush, at most 2 per block
+
+__attribute__((target("avx2")))
+static size_t
+__utf8_count_avx2(const uint8_t *s, size_t n, bool utf16)
+{
+     const __m256i cont_max = _mm256_set1_epi8((char)0xBF);   // Signed: continuation bytes are <= 0xBF
+     const __m256i lead4_min = _mm256_set1_epi8((char)0xF0);  // Unsigned: 4-byte leads are >= 0xF0
+     const __m256i zero = _mm256_setzero_si256();
+     __m256i total = zero;
+     size_t i = 0;
+     while(n - i >= 32) {
+          size_t end = i + 32 * agmin((n - i) / 32, (size_t)UTF8_COUNT_FLUSH);
+          __m256i acc = zero;
+          for(; i < end; i += 32) {
+               __m256i in = _mm256_loadu_si256((const __m256i*)(s + i));
+               acc = _mm256_sub_epi8(acc, _mm256_cmpgt_epi8(in, cont_max));
+               if(utf16) acc = _mm256_sub_epi8(acc, _mm256_cmpeq_epi8(_mm256_max_epu8(in, lead4_min), in));
+          }
+          total = _mm256_add_epi64(total, _mm256_sad_epu8(acc, zero));
+     }
+     uint64_t lanes[4];
+     _mm256_storeu_si256((__m256i*)lanes, total);
+     return (size_t)(lanes[0] + lanes[1] + lanes[2] + lanes[3]) + __utf8_count_scalar(s + i, n - i, utf16);
+}
+
+__attribute__((target("sse4.1")))
+static size_t
+__utf8_count_sse4(const uint8_t *s, size_t n, bool utf16)
+{
+     const __m128i cont_max = _mm_set1_epi8((char)0xBF);
+     const __m128i lead4_min = _mm_set1_epi8((char)0xF0);
+     const __m128i zero = _mm_setzero_si128();
+     __m128i total = zero;
+     size_t i = 0;
+     while(n - i >= 16) {
+          size_t end = i + 16 * agmin((n - i) / 16, (size_t)UTF8_COUNT_FLUSH);
+          __m128i acc = zero;
+          for(; i < end; i += 16) {
+               __m128i in = _mm_loadu_si128((const __m128i*)(s + i));
+               acc = _mm_sub_epi8(acc, _mm_cmpgt_epi8(in, cont_max));
+               if(utf16) acc = _mm_sub_epi8(acc, _mm_cmpeq_epi8(_mm_max_epu8(in, lead4_min), in));
+          }
+          total = _mm_add_epi64(total, _mm_sad_epu8(acc, zero));
+     }
+     uint64_t lanes[2];
+     _mm_storeu_si128((__m128i*)lanes, total);
+     return (size_t)(lanes[0] + lanes[1]) + __utf8_count_scalar(s + i, n - i, utf16);
+}
+
+__attribute__((target("avx2")))
+static size_t
+__utf8_ascii_to_utf16_avx2(const uint8_t *s, size_t n, uint16_t *out)
+{
+     size_t i = 0;
+     for(; n - i >= 32; i += 32) {
+          __m256i in = _mm256_loadu_si256((const __m256i*)(s + i));
+          if(_mm256_movemask_epi8(in) != 0) break;
+          _mm256_storeu_si256((__m256i*)(out + i), _mm256_cvtepu8_epi16(_mm256_castsi256_si128(in)));
+          _mm256_storeu_si256((__m256i*)(out + i + 16), _mm256_cvtepu8_epi16(_mm256_extracti128_si256(in, 1)));
+     }
+     return i;
+}
+
+__attribute__((target("avx2")))
+static size_t
+__utf8_ascii_to_utf32_avx2(const uint8_t *s, size_t n, uint32_t *out)
+{
+     size_t i = 0;
+     for(; n - i >= 32; i += 32) {
+          __m256i in = _mm256_loadu_si256((const __m256i*)(s + i));
+          if(_mm256_movemask_epi8(in) != 0) break;
+          __m128i lo = _mm256_castsi256_si128(in), hi = _mm256_extracti128_si256(in, 1);
+          _mm256_storeu_si256((__m256i*)(out + i), _mm256_cvtepu8_epi32(lo));
+          _mm256_storeu_si256((__m256i*)(out + i + 8), _mm256_cvtepu8_epi32(_mm_srli_si128(lo, 8)));
+          _mm256_storeu_si256((__m256i*)(out + i + 16), _mm256_cvtepu8_epi32(hi));
+          _mm256_storeu_si256((__m256i*)(out + i + 24), _mm256_cvtepu8_epi32(_mm_srli_si128(hi, 8)));
+     }
+     return i;
+}
+
+__attribute__((target("avx2")))
+static size_t
+__utf8_utf16_to_ascii_avx2(const uint16_t *src, size_t n, uint8_t *out)
+{
+     const __m256i high = _mm256_set1_epi16((short)0xFF80);
+     size_t i = 0;
+     for(; n - i >= 16; i += 16) {
+          __m256i in = _mm256_loadu_si256((const __m256i*)(src + i));
+          if(!_mm256_testz_si256(in, high)) break;
+          _mm_storeu_si128((__m128i*)(out + i),
+                           _mm_packus_epi16(_mm256_castsi256_si128(in), _mm256_extracti128_si256(in, 1)));
+     }
+     return i;
+}
+
+__attribute__((target("avx2")))
+static size_t
+__utf8_utf32_to_ascii_avx2(const uint32_t *src, size_t n, uint8_t *out)
+{
+     const __m256i high = _mm256_set1_epi32(~0x7F);
+     size_t i = 0;
+     for(; n - i >= 16; i += 16) {
+          __m256i a = _mm256_loadu_si256((const __m256i*)(src + i));
+          __m256i b = _mm256_loadu_si256((const __m256i*)(src + i + 8));
+          if(!_mm256_testz_si256(_mm256_or_si256(a, b), high)) break;
+          __m128i wa = _mm_packus_epi32(_mm256_castsi256_si128(a), _mm256_extracti128_si256(a, 1));
+          __m128i wb = _mm_packus_epi32(_mm256_castsi256_si128(b), _mm256_extracti128_si256(b, 1));
+          _mm_storeu_si128((__m128i*)(out + i), _mm_packus_epi16(wa, wb));
+     }
+     return i;
+}
+
+__attribute__((target("sse4.1")))
+static size_t
+__utf8_ascii_to_utf16_sse4(const uint8_t *s, size_t n, uint16_t *out)
+{
+     size_t i = 0;
+     for(; n - i >= 16; i += 16) {
+          __m128i in = _mm_loadu_si128((const __m128i*)(s + i));
+          if(_mm_movemask_epi8(in) != 0) break;
+          _mm_storeu_si128((__m128i*)(out + i), _mm_cvtepu8_epi16(in));
+          _mm_storeu_si128((__m128i*)(out + i + 8), _mm_cvtepu8_epi16(_mm_srli_si128(in, 8)));
+     }
+     return i;
+}
+
+__attribute__((target("sse4.1")))
+static size_t
+__utf8_ascii_to_utf32_sse4(const uint8_t *s, size_t n, uint32_t *out)
+{
+     size_t i = 0;
+     for(; n - i >= 16; i += 16) {
+          __m128i in = _mm_loadu_si128((const __m128i*)(s + i));
+          if(_mm_movemask_epi8(in) != 0) break;
+          _mm_storeu_si128((__m128i*)(out + i), _mm_cvtepu8_epi32(in));
+          _mm_storeu_si128((__m128i*)(out + i + 4), _mm_cvtepu8_epi32(_mm_srli_si128(in, 4)));
+          _mm_storeu_si128((__m128i*)(out + i + 8), _mm_cvtepu8_epi32(_mm_srli_si128(in, 8)));
+          _mm_storeu_si128((__m128i*)(out + i + 12), _mm_cvtepu8_epi32(_mm_srli_si128(in, 12)));
+     }
+     return i;
+}
+
+__attribute__((target("sse4.1")))
+static size_t
+__utf8_utf16_to_ascii_sse4(const uint16_t *src, size_t n, uint8_t *out)
+{
+     const __m128i high = _mm_set1_epi16((short)0xFF80);
+     size_t i = 0;
+     for(; n - i >= 16; i += 16) {
+          __m128i a = _mm_loadu_si128((const __m128i*)(src + i));
+          __m128i b = _mm_loadu_si128((const __m128i*)(src + i + 8));
+          if(!_mm_testz_si128(_mm_or_si128(a, b), high)) break;
+          _mm_storeu_si128((__m128i*)(out + i), _mm_packus_epi16(a, b));
+     }
+     return i;
+}
+
+__attribute__((target("sse4.1")))
+static size_t
+__utf8_utf32_to_ascii_sse4(const uint32_t *src, size_t n, uint8_t *out)
+{
+     const __m128i high = _mm_set1_epi32(~0x7F);
+     size_t i = 0;
+     for(; n - i >= 16; i += 16) {
+          __m128i a = _mm_loadu_si128((const __m128i*)(src + i));
+          __m128i b = _mm_loadu_si128((const __m128i*)(src + i + 4));
+          __m128i c = _mm_loadu_si128((const __m128i*)(src + i + 8));
+          __m128i d = _mm_loadu_si128((const __m128i*)(src + i + 12));
+          if(!_mm_testz_si128(_mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d)), high)) break;
+          _mm_storeu_si128((__m128i*)(out + i), _mm_packus_epi16(_mm_packus_epi32(a, b), _mm_packus_epi32(c, d)));
+     }
+     return i;
+}
+
+#endif // UTF8_HAS_X86
+
+// ---------------------------------------------------------------------------
+// Runtime dispatch: the first call picks the kernels for this CPU.
+// ---------------------------------------------------------------------------
+
+static const __utf8_kernels __utf8_scalar = {
+     __utf8_validate_scalar, __utf8_count_scalar,
+     __utf8_ascii_to_utf16_scalar, __utf8_ascii_to_utf32_scalar,
+     __utf8_utf16_to_ascii_scalar, __utf8_utf32_to_ascii_scalar,
+};
+
+#if UTF8_HAS_X86
+static const __utf8_kernels __utf8_sse4 = {
+     __utf8_validate_sse4, __utf8_count_sse4,
+     __utf8_ascii_to_utf16_sse4, __utf8_ascii_to_utf32_sse4,
+     __utf8_utf16_to_ascii_sse4, __utf8_utf32_to_ascii_sse4,
+};
+
+static const __utf8_kernels __utf8_avx2 = {
+     __utf8_validate_avx2, __utf8_count_avx2,
+     __utf8_ascii_to_utf16_avx2, __utf8_ascii_to_utf32_avx2,
+     __utf8_utf16_to_ascii_avx2, __utf8_utf32_to_ascii_avx2,
+};
+#endif
+
+static const void*
+__utf8_pick(unsigned cpu)
+{
+#if UTF8_HAS_X86
+     if(cpu & AG_CPU_AVX2) return &__utf8_avx2;
+     if(cpu & AG_CPU_SSE41) return &__utf8_sse4;
+#else
+     (void)cpu;
+#endif
+     return &__utf8_scalar;
+}
+
+static const void *__utf8_impl = NULL;
+
+static inline const __utf8_kernels*
+__utf8_kernels_get(void)
+{
+     return (const __utf8_kernels*)__ag_dispatch(&__utf8_impl, __utf8_pick);
+}
+
+// ---------------------------------------------------------------------------
+// Validation, counting and indexing
+// ---------------------------------------------------------------------------
+
+bool
+sv_utf8_valid(ag_string_view s)
+{
+     return __utf8_kernels_get()->validate((const uint8_t*)s.data, s.size) == AG_NPOS;
+}
+
+size_t
+sv_utf8_error(ag_string_view s)
+{
+     const uint8_t *p = (const uint8_t*)s.data;
+     size_t at = __utf8_kernels_get()->validate(p, s.size);
+     if(at == AG_NPOS) return AG_NPOS;
+
+     // Everything before the flagged block is well formed except possibly a
+     // sequence that starts in its last 3 bytes: rescan from that sequence
+     at = agmin(at, s.size);
+     size_t start = at - agmin(at, (size_t)3);
+     while(start < at && __utf8_is_cont(p[start])) start++;
+     size_t err = __utf8_validate_scalar(p + start, s.size - start);
+     assert(err != AG_NPOS);
+     return start + err;
+}
+
+size_t
+sv_utf8_length(ag_string_view s)
+{
+     return __utf8_kernels_get()->count((const uint8_t*)s.data, s.size, false);
+}
+
+size_t
+sv_utf8_offset(ag_string_view s, size_t index)
+{
+     const __utf8_kernels *k = __utf8_kernels_get();
+     const uint8_t *p = (const uint8_t*)s.data;
+     size_t i = 0;
+
+     // Skip whole chunks, then words, then find the byte
+     for(; s.size - i >= UTF8_COUNT_CHUNK; i += UTF8_COUNT_CHUNK) {
+          size_t c = k->count(p + i, UTF8_COUNT_CHUNK, false);
+          if(index < c) break;
+          index -= c;
+     }
+     for(; s.size - i >= 8; i += 8) {
+          size_t c = (size_t)__builtin_popcountll(__utf8_starts64(__utf8_load64(p + i)));
+          if(index < c) break;
+          index -= c;
+     }
+     for(; i < s.size; i++) {
+          if(__utf8_is_cont(p[i])) continue;
+          if(index == 0) return i;
+          index--;
+     }
+     return index == 0 ? s.size : AG_NPOS;
+}
+
+ag_string_view
+sv_utf8_slice(ag_string_view s, size_t pos, size_t len)
+{
+     size_t start = sv_utf8_offset(s, pos);
+     if(start == AG_NPOS) return (ag_string_view){ s.data + s.size, 0 };
+     ag_string_view rest = { s.data + start, s.size - start };
+     size_t end = sv_utf8_offset(rest, len);
+     if(end != AG_NPOS) rest.size = end;
+     return rest;
+}
+
+uint32_t
+sv_utf8_decode(ag_string_view s, size_t *pos)
+{
+     assert(*pos < s.size);
+     size_t len;
+     uint32_t cp = __utf8_decode((const uint8_t*)s.data + *pos, s.size - *pos, &len);
+     *pos += len;
+     return cp;
+}
+
+// ---------------------------------------------------------------------------
+// Transcoding
+// ---------------------------------------------------------------------------
+
+size_t
+utf16_length_from_utf8(ag_string_view s)
+{
+     return __utf8_kernels_get()->count((const uint8_t*)s.data, s.size, true);
+}
+
+// Surrogates count 2 each: 4 for a pair, and a lone one is never written
+size_t
+utf8_length_from_utf16(const uint16_t *src, size_t n)
+{
+     size_t len = 0;
+     for(size_t i = 0; i < n; i++) {
+          uint16_t c = src[i];
+          len += 1 + (c >= 0x80) + (c >= 0x800) - ((c & 0xF800) == 0xD800);
+     }
+     return len;
+}
+
+size_t
+utf8_length_from_utf32(const uint32_t *src, size_t n)
+{
+     size_t len = 0;
+     for(size_t i = 0; i < n; i++) {
+          uint32_t c = src[i];
+          len += 1 + (c >= 0x80) + (c >= 0x800) + (c >= 0x10000);
+     }
+     return len;
+}
+
+size_t
+utf8_to_utf16(ag_string_view s, uint16_t *out)
+{
+     const __utf8_kernels *k = __utf8_kernels_get();
+     const uint8_t *p = (const uint8_t*)s.data;
+     size_t i = 0, o = 0;
+     while(i < s.size) {
+          if(p[i] < 0x80) {
+               size_t run = k->ascii_to_utf16(p + i, s.size - i, out + o);
+               i += run;
+               o += run;
+               while(i < s.size && p[i] < 0x80) out[o++] = p[i++];
+               continue;
+          }
+          size_t len;
+          uint32_t cp = __utf8_decode(p + i, s.size - i, &len);
+          if(cp == AG_UTF_INVALID) return AG_NPOS;
+          if(cp >= 0x10000) {
+               cp -= 0x10000;
+               out[o++] = (uint16_t)(0xD800 | (cp >> 10));
+               out[o++] = (uint16_t)(0xDC00 | (cp & 0x3FF));
+          } else {
+               out[o++] = (uint16_t)cp;
+          }
+          i += len;
+     }
+     return o;
+}
+
+size_t
+utf8_to_utf32(ag_string_view s, uint32_t *out)
+{
+     const __utf8_kernels *k = __utf8_kernels_get();
+     const uint8_t *p = (const uint8_t*)s.data;
+     size_t i = 0, o = 0;
+     while(i < s.size) {
+          if(p[i] < 0x80) {
+               size_t run = k->ascii_to_utf32(p + i, s.size - i, out + o);
+               i += run;
+               o += run;
+               while(i < s.size && p[i] < 0x80) out[o++] = p[i++];
+               continue;
+          }
+          size_t len;
+          uint32_t cp = __utf8_decode(p + i, s.size - i, &len);
+          if(cp == AG_UTF_INVALID) return AG_NPOS;
+          out[o++] = cp;
+          i += len;
+     }
+     return o;
+}
+
+size_t
+utf16_to_utf8(const uint16_t *src, size_t n, char *out)
+{
+     const __utf8_kernels *k = __utf8_kernels_get();
+     uint8_t *q = (uint8_t*)out;
+     size_t i = 0, o = 0;
+     while(i < n) {
+          uint32_t c = src[i];
+          if(c < 0x80) {
+               size_t run = k->utf16_to_ascii(src + i, n - i, q + o);
+               i += run;
+               o += run;
+               while(i < n && src[i] < 0x80) q[o++] = (uint8_t)src[i++];
+               continue;
+          }
+          if((c & 0xF800) == 0xD800) {
+               if(c > 0xDBFF || i + 1 >= n || (src[i + 1] & 0xFC00) != 0xDC00) return AG_NPOS;
+               c = 0x10000 + ((c - 0xD800) << 10) + (src[i + 1] - 0xDC00u);
+               i += 2;
+          } else {
+               i++;
+          }
+          o += __utf8_encode(c, q + o);
+     }
+     return o;
+}
+
+size_t
+utf32_to_utf8(const uint32_t *src, size_t n, char *out)
+{
+     const __utf8_kernels *k = __utf8_kernels_get();
+     uint8_t *q = (uint8_t*)out;
+     size_t i = 0, o = 0;
+     while(i < n) {
+          uint32_t c = src[i];
+          if(c < 0x80) {
+               size_t run = k->utf32_to_ascii(src + i, n - i, q + o);
+               i += run;
+               o += run;
+               while(i < n && src[i] < 0x80) q[o++] = (uint8_t)src[i++];
+               continue;
+          }
+          if(c > 0x10FFFF || (c & 0xFFFFF800) == 0xD800) return AG_NPOS;
+          o += __utf8_encode(c, q + o);
+          i++;
+     }
+     return o;
+}
+
+size_t
+sv_to_utf16(ag_string_view s, vector *out)
+{
+     assert(out->element_size == sizeof(uint16_t));
+     vec_reserve(out, out->size + utf16_length_from_utf8(s));
+     size_t units = utf8_to_utf16(s, (uint16_t*)out->data + out->size);
+     if(units != AG_NPOS) out->size += units;
+     return units;
+}
+
+size_t
+sv_to_utf32(ag_string_view s, vector *out)
+{
+     assert(out->element_size == sizeof(uint32_t));
+     vec_reserve(out, out->size + sv_utf8_length(s));
+     size_t units = utf8_to_utf32(s, (uint32_t*)out->data + out->size);
+     if(units != AG_NPOS) out->size += units;
+     return units;
+}
+
+ag_string
+string_from_utf16(const uint16_t *src, size_t n)
+{
+     ag_string str = new_string("");
+     size_t len = utf16_to_utf8(src, n, string_spare(str, utf8_length_from_utf16(src, n)));
+     if(len == AG_NPOS) {
+          vec_clean(str);
+          return NULL;
+     }
+     string_commit(str, len);
+     return str;
+}
+
+ag_string
+string_from_utf32(const uint32_t *src, size_t n)
+{
+     ag_string str = new_string("");
+     size_t len = utf32_to_utf8(src, n, string_spare(str, utf8_length_from_utf32(src, n)));
+     if(len == AG_NPOS) {
+          vec_clean(str);
+          return NULL;
+     }
+     string_commit(str, len);
+     return str;
+}
@@ -0,0 +1,24 @@
+#include "aegis/aegis_utils.h"
+
+unsigned
+__ag_cpu_features(void)
+{
+     unsigned cpu = 0;
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+     __builtin_cpu_init();
+     if(__builtin_cpu_supports("sse2")) cpu |= AG_CPU_SSE2;
+     if(__builtin_cpu_supports("sse4.1")) cpu |= AG_CPU_SSE41;
+     if(__builtin_cpu_supports("popcnt")) cpu |= AG_CPU_POPCNT;
+     if(__builtin_cpu_supports("avx2")) cpu |= AG_CPU_AVX2;
+#endif
+     return cpu;
+}
+
+AG_COLD const void*
+__ag_dispatch_resolve(const void **slot, __ag_dispatch_pick pick)
+{
+     const void *k = pick(__ag_cpu_features());
+     // Benign race: every thread stores the same pointer
+     __atomic_store_n(slot, k, __ATOMIC_RELAXED);
+     return k;
+}
@@ -1,40 +1,242 @@
+#define _GNU_SOURCE // mremap
 #include "aegis/aegis_utils.h"
 #include "aegis/aegis_common.h"
 #include "aegis/aegis_vector.h"
+#include "aegis/aegis_allocator.h"
+#include "aegis/aegis_hash.h"
 
+#include <stdalign.h>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define VEC_HAS_MMAP 1
+#else
+#define VEC_HAS_MMAP 0
+#endif
 
 
 #define VEC_DEFLUAT_CAPACITY 8
 #define VEC_NEW_CAPACITY(CURR_SIZE) ((size_t)(CURR_SIZE * 1.5))
 #define VEC_MUST_INCREASE_CAPACITY(__ptrvec__) \
         if((__ptrvec__)->size == (__ptrvec__)->capacity) \
-               __vec_set_capacity(__ptrvec__ , VEC_NEW_CAPACITY((__ptrvec__)->capacity))
+               __vec_grow(__ptrvec__ , (__ptrvec__)->size + 1)
+
+// Instrumentation (aegis_stats.h), nothing without AEGIS_STATS
+#ifdef AEGIS_STATS
+#define VEC_STATS_INIT(__ptrvec__) \
+        ((__ptrvec__)->site = NULL, \
+         __ag_stats_record(NULL, AG_STATS_INIT, (__ptrvec__)->element_size, 0, \
+                           (__ptrvec__)->capacity, (__ptrvec__)->size, false))
+#define VEC_STATS(__ptrvec__, kind, old_capacity, copied) \
+        __ag_stats_record((__ptrvec__)->site, kind, (__ptrvec__)->element_size, \
+                          old_capacity, (__ptrvec__)->capacity, (__ptrvec__)->size, copied)
+#else
+#define VEC_STATS_INIT(__ptrvec__) ((void)0)
+#define VEC_STATS(__ptrvec__, kind, old_capacity, copied) ((void)0)
+#endif
+
+// ---------------------------------------------------------------------------
+// Large-vector mode.
+// Once a default-allocated vector needs more than __vec_mmap_threshold bytes
+// its data moves (one last copy) into a private anonymous mapping. From then
+// on growth is an mremap, which extends in place or moves page-table entries
+// instead of copying the buffer. Mappings are sized in VEC_MMAP_GRANULE units
+// and the capacity is widened to fill the whole mapping, so the mapping length
+// can always be recomputed from capacity * element_size.
+// ---------------------------------------------------------------------------
+
+#define VEC_MMAP_GRANULE ((size_t)2 << 20) // 2 MiB, one x86-64 huge page
+#define VEC_MMAP_LENGTH(bytes) \
+        ((agmax((bytes), (size_t)1) + VEC_MMAP_GRANULE - 1) & ~(VEC_MMAP_GRANULE - 1))
+
+static size_t __vec_mmap_threshold = AG_VEC_MMAP_THRESHOLD;
+static bool   __vec_hugepages = false;
+
+void
+__vec_set_mmap_threshold(size_t bytes)
+{
+     __vec_mmap_threshold = bytes;
+}
+
+void
+__vec_set_hugepages(bool enable)
+{
+     __vec_hugepages = enable;
+}
+
+static inline bool
+__vec_wants_mmap(const vector *vec, size_t bytes)
+{
+     if(vec->flags & AG_VEC_MMAPPED) return true;
+     return VEC_HAS_MMAP && __vec_mmap_threshold != 0
+          && vec->allocator == &ag_default_allocator
+          && bytes >= __vec_mmap_threshold;
+}
+
+#if VEC_HAS_MMAP
+static void
+__vec_advise(void *addr, size_t len)
+{
+     if(__vec_hugepages) madvise(addr, len, MADV_HUGEPAGE);
+}
+
+// Maps len bytes (a granule multiple), aligned to the granule so THP can back it
+static void*
+__vec_mmap_alloc(size_t len)
+{
+     size_t span = len + VEC_MMAP_GRANULE;
+     byte *raw = (byte*)mmap(NULL, span, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+     if(raw == (byte*)MAP_FAILED) return NULL;
+
+     byte *aligned = (byte*)(((uintptr_t)raw + VEC_MMAP_GRANULE - 1) & ~(uintptr_t)(VEC_MMAP_GRANULE - 1));
+     if(aligned != raw) munmap(raw, (size_t)(aligned - raw));
+     size_t tail = (size_t)((raw + span) - (aligned + len));
+     if(tail != 0) munmap(aligned + len, tail);
+
+     __vec_advise(aligned, len);
+     return aligned;
+}
+
+static void
+__vec_mmap_set_capacity(vector *vec, size_t new_capacity)
+{
+     size_t new_len = VEC_MMAP_LENGTH(new_capacity * vec->element_size);
+     void *temp;
+
+     if(vec->flags & AG_VEC_MMAPPED) {
+          size_t old_len = VEC_MMAP_LENGTH(vec->capacity * vec->element_size);
+          temp = (old_len == new_len) ? vec->data : mremap(vec->data, old_len, new_len, MREMAP_MAYMOVE);
+          assert(temp != MAP_FAILED);
+          if(new_len > old_len) __vec_advise(temp, new_len);
+     }
+     else {
+          // Leaving the heap: the only copy this vector will ever pay for
+          temp = __vec_mmap_alloc(new_len);
+          assert(temp != NULL);
+          memcpy(temp, vec->data, agmin(vec->size, new_capacity) * vec->element_size);
+          ag_free(vec->allocator, vec->data, agmax(vec->capacity, (size_t)1) * vec->element_size);
+          vec->flags |= AG_VEC_MMAPPED;
+     }
+     vec->data = temp;
+     vec->capacity = new_len / vec->element_size;
+}
+#endif
 
 
 vector*
 __vec_init(size_t init_size,size_t element_size , bool set_zero)
 {
-     vector *vec = (vector*)malloc(sizeof(vector));
+     return __vec_init_with_alloc(init_size, element_size, set_zero, &ag_default_allocator);
+}
+
+vector*
+__vec_init_with_alloc(size_t init_size, size_t element_size, bool set_zero, ag_allocator *alloc)
+{
+     vector *vec = (vector*)ag_alloc(alloc, sizeof(vector));
      
      assert(vec != NULL);
 
-     size_t ncap = agmax(init_size, VEC_DEFLUAT_CAPACITY);
+     size_t ncap = agmax(init_size, (size_t)VEC_DEFLUAT_CAPACITY);
      vec->size = init_size;
      vec->capacity = ncap;
      vec->element_size = element_size; 
+     vec->allocator = alloc;
+     
+     vec->flags = 0;
      
-     // acllocating memory
-     vec->data = (set_zero) ? calloc(vec->capacity, element_size) : malloc(element_size * ncap);
+     // acllocating memory, calloc keeps the lazily-zeroed pages of libc
+#if VEC_HAS_MMAP
+     if(__vec_wants_mmap(vec, element_size * ncap)) {
+          // Anonymous mappings are already zeroed
+          size_t len = VEC_MMAP_LENGTH(element_size * ncap);
+          vec->data = __vec_mmap_alloc(len);
+          vec->capacity = len / element_size;
+          vec->flags |= AG_VEC_MMAPPED;
+     }
+     else
+#endif
+     if(alloc == &ag_default_allocator)
+          vec->data = (set_zero) ? calloc(ncap, element_size) : malloc(element_size * ncap);
+     else {
+          vec->data = ag_alloc(alloc, element_size * ncap);
+          if(set_zero && vec->data != NULL) memset(vec->data, 0, element_size * ncap);
+     }
 
      // check if data has been sussessfully acllocated
      if(vec->data == NULL) {
-          fprintf(stdin, "data wasn't sussessfully acllocated");
-          free(vec);
+          fprintf(stderr, "data wasn't sussessfully acllocated");
+          ag_free(alloc, vec, sizeof(vector));
           exit(1);
      }
+     VEC_STATS_INIT(vec);
      return vec;
 }
 
+// Header and AG_VEC_TRAILING_BYTES of element storage in one allocation.
+// Used for short strings: no second allocation and the bytes share the
+// header's cache lines until the vector outgrows them.
+typedef struct {
+     vector header;
+     alignas(max_align_t) byte storage[AG_VEC_TRAILING_BYTES];
+} __vec_trailing;
+
+static inline size_t
+__vec_header_size(const vector *vec)
+{
+     return (vec->flags & AG_VEC_TRAILING) ? sizeof(__vec_trailing) : sizeof(vector);
+}
+
+vector*
+__vec_init_trailing(size_t element_size, ag_allocator *alloc)
+{
+     assert(element_size <= AG_VEC_TRAILING_BYTES);
+
+     __vec_trailing *block = (__vec_trailing*)ag_alloc(alloc, sizeof(__vec_trailing));
+     assert(block != NULL);
+
+     vector *vec = &block->header;
+     vec->data = block->storage;
+     vec->size = 0;
+     vec->capacity = AG_VEC_TRAILING_BYTES / element_size;
+     vec->element_size = element_size;
+     vec->allocator = alloc;
+     vec->flags = AG_VEC_TRAILING | AG_VEC_INLINE;
+     VEC_STATS_INIT(vec);
+     return vec;
+}
+
+// Caller-owned header and storage (ag_small_vector)
+vector*
+__vec_init_inline(vector *vec, void *storage, size_t capacity, size_t element_size, ag_allocator *alloc)
+{
+     vec->data = storage;
+     vec->size = 0;
+     vec->capacity = capacity;
+     vec->element_size = element_size;
+     vec->allocator = alloc;
+     vec->flags = AG_VEC_EXTERNAL | AG_VEC_INLINE;
+     VEC_STATS_INIT(vec);
+     return vec;
+}
+
+// Moves inline data to an allocator-owned buffer
+static void
+__vec_spill(vector *vec, size_t new_capacity)
+{
+     if(new_capacity <= vec->capacity) return;
+
+     void *temp = ag_alloc(vec->allocator, new_capacity * vec->element_size);
+     assert(temp != NULL);
+     memcpy(temp, vec->data, vec->size * vec->element_size);
+     vec->data = temp;
+     vec->capacity = new_capacity;
+     vec->flags &= ~AG_VEC_INLINE;
+}
+
 
 vector* __vec_init_fill(size_t init_size,size_t element_size, void *val)
 {
@@ -47,39 +249,109 @@ vector* __vec_init_fill(size_t init_size,size_t element_size, void *val)
 void 
 __vec_fill(vector* vec, size_t begin, size_t end,void *val)
 {
-     size_t it = begin;
-
      // prevent iterate over size;
      size_t itend = agmin(vec->size,end);
-     
-     byte *idx = (byte*)vec->data;
-     for( ;it < itend; it++)
-          memcpy(idx + (it * vec->element_size), val, vec->element_size);
-}
+     if(begin >= itend) return;
 
-void 
-__vec_push_back(vector* vec, void *val)
-{
-     VEC_MUST_INCREASE_CAPACITY(vec);
+     size_t nsize = vec->element_size;
+     size_t total = (itend - begin) * nsize;
+     byte *first = (byte*)vec->data + (begin * nsize);
 
-     byte *begin = (byte*)vec->data;
-     memcpy(begin + (vec->size * vec->element_size), val, vec->element_size);
-     vec->size++;
+     // Seed one element, then keep doubling the filled prefix so the
+     // whole range costs O(log n) memcpy calls instead of one per element
+     memcpy(first, val, nsize);
+     size_t filled = nsize;
+     while(filled < total) {
+          size_t chunk = agmin(filled, total - filled);
+          memcpy(first + filled, first, chunk);
+          filled += chunk;
+     }
 }
 
-  void 
-__vec_pop_back(vector *vec)
+#if VEC_HAS_MMAP
+// A vec_map_file mapping covers the header page plus exactly capacity elements
+#define VEC_FILE_MAP_LENGTH(__ptrvec__) \
+        (AG_VEC_FILE_DATA_OFFSET + (__ptrvec__)->capacity * (__ptrvec__)->element_size)
+
+static void
+__vec_file_unmap(vector *vec)
 {
-     if(vec->size > 0) vec->size--;
+     munmap((byte*)vec->data - AG_VEC_FILE_DATA_OFFSET, VEC_FILE_MAP_LENGTH(vec));
 }
 
-void 
-__vec_set_capacity(vector *vec, size_t new_capacity)
+// Moves file-mapped data to an allocator-owned buffer and drops the mapping
+static void
+__vec_file_spill(vector *vec, size_t new_capacity)
 {
+     if(new_capacity <= vec->capacity) return;
+
+     void *temp = ag_alloc(vec->allocator, new_capacity * vec->element_size);
+     assert(temp != NULL);
+     memcpy(temp, vec->data, vec->size * vec->element_size);
+     __vec_file_unmap(vec);
+     vec->data = temp;
      vec->capacity = new_capacity;
-     void *temp = realloc(vec->data, new_capacity * vec->element_size); 
+     vec->flags &= ~AG_VEC_FILE_MAPPED;
+}
+#endif
+
+static void
+__vec_move_storage(vector *vec, size_t new_capacity)
+{
+     if(vec->flags & AG_VEC_INLINE) {
+          __vec_spill(vec, new_capacity);
+          return;
+     }
+#if VEC_HAS_MMAP
+     if(vec->flags & AG_VEC_FILE_MAPPED) {
+          __vec_file_spill(vec, new_capacity);
+          return;
+     }
+     if(__vec_wants_mmap(vec, new_capacity * vec->element_size)) {
+          __vec_mmap_set_capacity(vec, new_capacity);
+          return;
+     }
+#endif
+     // realloc(ptr, 0) may free and return NULL, keep one slot around instead
+     void *temp = ag_realloc(vec->allocator, vec->data,
+                             agmax(vec->capacity, (size_t)1) * vec->element_size,
+                             agmax(new_capacity, (size_t)1) * vec->element_size);
      assert(temp != NULL);
      vec->data = temp;
+     vec->capacity = new_capacity;
+}
+
+void
+__vec_set_capacity(vector *vec, size_t new_capacity)
+{
+#ifdef AEGIS_STATS
+     size_t old_capacity = vec->capacity;
+     void *old_data = vec->data;
+     bool was_mapped = (vec->flags & AG_VEC_MMAPPED) != 0;
+     __vec_move_storage(vec, new_capacity);
+     if(vec->capacity == old_capacity) return;
+     // mremap of an existing mapping moves page-table entries, not bytes
+     bool copied = vec->data != old_data && !was_mapped;
+     VEC_STATS(vec, vec->capacity > old_capacity ? AG_STATS_GROW : AG_STATS_SHRINK, old_capacity, copied);
+#else
+     __vec_move_storage(vec, new_capacity);
+#endif
+}
+
+// Slow path shared by every growing operation (generic and typed vectors).
+// Never grows below VEC_DEFLUAT_CAPACITY, so a vector shrunk to 0 can grow again.
+AG_COLD void
+__vec_grow(vector *vec, size_t min_capacity)
+{
+     size_t ncap = agmax(VEC_NEW_CAPACITY(vec->capacity), (size_t)VEC_DEFLUAT_CAPACITY);
+     __vec_set_capacity(vec, agmax(ncap, min_capacity));
+}
+
+void
+__vec_reserve(vector *vec, size_t new_capacity)
+{
+     if(new_capacity > vec->capacity)
+          __vec_set_capacity(vec, new_capacity);
 }
 
   void  
@@ -128,7 +400,278 @@ __vec_erase(vector* vec, size_t pos)
 void 
 __vec_clean(vector* vec)
 {
-     free(vec->data);
-     free(vec);
+     ag_allocator *alloc = vec->allocator;
+     VEC_STATS(vec, AG_STATS_FREE, vec->capacity, false);
+     if(vec->flags & AG_VEC_INLINE)
+          ; // storage is part of the header
+#if VEC_HAS_MMAP
+     else if(vec->flags & AG_VEC_MMAPPED)
+          munmap(vec->data, VEC_MMAP_LENGTH(vec->capacity * vec->element_size));
+     else if(vec->flags & AG_VEC_FILE_MAPPED)
+          __vec_file_unmap(vec);
+#endif
+     else
+          ag_free(alloc, vec->data, agmax(vec->capacity, (size_t)1) * vec->element_size);
+     if(!(vec->flags & AG_VEC_EXTERNAL))
+          ag_free(alloc, vec, __vec_header_size(vec));
      vec = NULL;
 }
+
+// ---------------------------------------------------------------------------
+// Range operations: one capacity check and at most one memmove per call.
+// ---------------------------------------------------------------------------
+
+static inline bool
+__vec_aliases(const vector *vec, const void *ptr)
+{
+     const byte *begin = (const byte*)vec->data;
+     return (const byte*)ptr >= begin && (const byte*)ptr < begin + (vec->capacity * vec->element_size);
+}
+
+void
+__vec_push_back_n(vector *vec, const void *src, size_t n)
+{
+     if(n == 0) return;
+
+     size_t nsize = vec->element_size;
+     if(vec->size + n > vec->capacity) {
+          // src may point into our own buffer (e.g. vec_append(v, v))
+          size_t offset = (size_t)((const byte*)src - (const byte*)vec->data);
+          bool alias = __vec_aliases(vec, src);
+          __vec_grow(vec, vec->size + n);
+          if(alias) src = (const byte*)vec->data + offset;
+     }
+     memcpy((byte*)vec->data + (vec->size * nsize), src, n * nsize);
+     vec->size += n;
+}
+
+void
+__vec_insert_range(vector *vec, size_t pos, const void *src, size_t n)
+{
+     assert(pos <= vec->size);
+     if(n == 0) return;
+
+     size_t nsize = vec->element_size;
+     void *copy = NULL;
+     if(__vec_aliases(vec, src)) {
+          // Both growth and the shift below could move the source bytes
+          copy = ag_alloc(vec->allocator, n * nsize);
+          assert(copy != NULL);
+          memcpy(copy, src, n * nsize);
+          src = copy;
+     }
+
+     if(vec->size + n > vec->capacity)
+          __vec_grow(vec, vec->size + n);
+
+     byte *begin = (byte*)vec->data;
+     memmove(begin + ((pos + n) * nsize),
+             begin + (pos * nsize),
+             (vec->size - pos) * nsize);
+     memcpy(begin + (pos * nsize), src, n * nsize);
+     vec->size += n;
+
+     if(copy != NULL) ag_free(vec->allocator, copy, n * nsize);
+}
+
+void
+__vec_erase_range(vector *vec, size_t begin, size_t end)
+{
+     end = agmin(end, vec->size);
+     if(begin >= end) return;
+
+     size_t nsize = vec->element_size;
+     byte *data = (byte*)vec->data;
+     memmove(data + (begin * nsize),
+             data + (end * nsize),
+             (vec->size - end) * nsize);
+     vec->size -= end - begin;
+}
+
+void
+__vec_append(vector *dest, const vector *src)
+{
+     assert(dest->element_size == src->element_size);
+     __vec_push_back_n(dest, src->data, src->size);
+}
+
+size_t
+__vec_erase_if(vector *vec, bool (*pred)(const void *elem, void *ctx), void *ctx)
+{
+     size_t nsize = vec->element_size;
+     byte *data = (byte*)vec->data;
+     size_t write = 0;
+     size_t it = 0;
+
+     // Compact runs of kept elements with one memmove per run
+     while(it < vec->size) {
+          size_t run = it;
+          while(run < vec->size && !pred(data + (run * nsize), ctx)) run++;
+
+          if(run > it) {
+               if(write != it)
+                    memmove(data + (write * nsize), data + (it * nsize), (run - it) * nsize);
+               write += run - it;
+          }
+          it = run + 1; // skip the element the predicate matched
+     }
+
+     size_t removed = vec->size - write;
+     vec->size = write;
+     return removed;
+}
+
+// ---------------------------------------------------------------------------
+// Persistent vectors.
+// vec_save writes one header page and the raw elements; vec_map_file maps the
+// file and points data at the element page, so loading costs one mmap no
+// matter how large the vector is and read-only mappings of the same file
+// share the page cache across processes.
+// ---------------------------------------------------------------------------
+
+#define VEC_FILE_MAGIC "AEGISVEC"
+#define VEC_FILE_ENDIAN 0x01020304u // reads back byte-swapped on the other byte order
+
+typedef struct {
+     char magic[8];
+     uint32_t version;
+     uint32_t endian;
+     uint64_t element_size;
+     uint64_t size;
+     uint64_t data_offset;
+     uint64_t checksum;       // ag_hash_bytes of the elements, AG_HASH_SEED
+} __vec_file_header;
+
+_Static_assert(sizeof(__vec_file_header) <= AG_VEC_FILE_DATA_OFFSET,
+               "vector file header must fit in the header page");
+
+static bool
+__vec_file_header_ok(const __vec_file_header *hdr, size_t element_size, uint64_t file_size)
+{
+     if(memcmp(hdr->magic, VEC_FILE_MAGIC, sizeof(hdr->magic)) != 0
+          || hdr->version != AG_VEC_FILE_VERSION
+          || hdr->endian != VEC_FILE_ENDIAN
+          || hdr->data_offset != AG_VEC_FILE_DATA_OFFSET
+          || hdr->element_size == 0
+          || (element_size != 0 && hdr->element_size != element_size))
+          return false;
+
+     // size * element_size must not overflow and must be backed by the file
+     uint64_t limit = (uint64_t)SIZE_MAX - AG_VEC_FILE_DATA_OFFSET;
+     if(hdr->size > limit / hdr->element_size) return false;
+     return AG_VEC_FILE_DATA_OFFSET + hdr->size * hdr->element_size <= file_size;
+}
+
+bool
+__vec_save(const vector *vec, const char *path)
+{
+     size_t bytes = vec->size * vec->element_size;
+     byte page[AG_VEC_FILE_DATA_OFFSET] = { 0 };
+     __vec_file_header hdr = {
+          .version = AG_VEC_FILE_VERSION,
+          .endian = VEC_FILE_ENDIAN,
+          .element_size = vec->element_size,
+          .size = vec->size,
+          .data_offset = AG_VEC_FILE_DATA_OFFSET,
+          .checksum = ag_hash_bytes(vec->data, bytes, AG_HASH_SEED),
+     };
+     memcpy(hdr.magic, VEC_FILE_MAGIC, sizeof(hdr.magic));
+     memcpy(page, &hdr, sizeof(hdr));
+
+     // path + ".tmp", renamed over path once complete
+     size_t len = strlen(path);
+     char *tmp = (char*)malloc(len + 5);
+     if(tmp == NULL) return false;
+     memcpy(tmp, path, len);
+     memcpy(tmp + len, ".tmp", 5);
+
+     FILE *file = fopen(tmp, "wb");
+     if(file == NULL) {
+          free(tmp);
+          return false;
+     }
+     bool ok = fwrite(page, 1, sizeof(page), file) == sizeof(page)
+          && (bytes == 0 || fwrite(vec->data, 1, bytes, file) == bytes)
+          && fflush(file) == 0;
+#if VEC_HAS_MMAP
+     ok = ok && fsync(fileno(file)) == 0;
+#endif
+     ok = (fclose(file) == 0) && ok;
+     ok = ok && rename(tmp, path) == 0;
+     if(!ok) remove(tmp);
+     free(tmp);
+     return ok;
+}
+
+#if VEC_HAS_MMAP
+vector*
+__vec_map_file(const char *path, size_t element_size, unsigned int flags)
+{
+     int fd = open(path, O_RDONLY | O_CLOEXEC);
+     if(fd < 0) return NULL;
+
+     struct stat st;
+     __vec_file_header hdr;
+     if(fstat(fd, &st) != 0
+          || pread(fd, &hdr, sizeof(hdr), 0) != (ssize_t)sizeof(hdr)
+          || !__vec_file_header_ok(&hdr, element_size, (uint64_t)st.st_size)) {
+          close(fd);
+          return NULL;
+     }
+
+     size_t bytes = (size_t)(hdr.size * hdr.element_size);
+     bool cow = (flags & AG_VEC_MAP_COW) != 0;
+     byte *base = (byte*)mmap(NULL, AG_VEC_FILE_DATA_OFFSET + bytes,
+                              cow ? PROT_READ | PROT_WRITE : PROT_READ,
+                              cow ? MAP_PRIVATE : MAP_SHARED, fd, 0);
+     close(fd); // the mapping keeps the file alive
+     if(base == (byte*)MAP_FAILED) return NULL;
+
+     if((flags & AG_VEC_MAP_VERIFY)
+          && ag_hash_bytes(base + AG_VEC_FILE_DATA_OFFSET, bytes, AG_HASH_SEED) != hdr.checksum) {
+          munmap(base, AG_VEC_FILE_DATA_OFFSET + bytes);
+          return NULL;
+     }
+
+     vector *vec = (vector*)ag_alloc(&ag_default_allocator, sizeof(vector));
+     assert(vec != NULL);
+     vec->data = base + AG_VEC_FILE_DATA_OFFSET;
+     vec->size = vec->capacity = (size_t)hdr.size;
+     vec->element_size = (size_t)hdr.element_size;
+     vec->allocator = &ag_default_allocator;
+     vec->flags = AG_VEC_FILE_MAPPED;
+     VEC_STATS_INIT(vec);
+     return vec;
+}
+#else
+// No mmap: read the elements into an ordinary heap vector
+vector*
+__vec_map_file(const char *path, size_t element_size, unsigned int flags)
+{
+     FILE *file = fopen(path, "rb");
+     if(file == NULL) return NULL;
+
+     __vec_file_header hdr;
+     long file_size = -1;
+     if(fseek(file, 0, SEEK_END) == 0) file_size = ftell(file);
+     if(file_size < 0 || fseek(file, 0, SEEK_SET) != 0
+          || fread(&hdr, sizeof(hdr), 1, file) != 1
+          || !__vec_file_header_ok(&hdr, element_size, (uint64_t)file_size)
+          || fseek(file, AG_VEC_FILE_DATA_OFFSET, SEEK_SET) != 0) {
+          fclose(file);
+          return NULL;
+     }
+
+     size_t bytes = (size_t)(hdr.size * hdr.element_size);
+     vector *vec = __vec_init((size_t)hdr.size, (size_t)hdr.element_size, false);
+     bool ok = bytes == 0 || fread(vec->data, 1, bytes, file) == bytes;
+     fclose(file);
+     if(ok && (flags & AG_VEC_MAP_VERIFY))
+          ok = ag_hash_bytes(vec->data, bytes, AG_HASH_SEED) == hdr.checksum;
+     if(!ok) {
+          __vec_clean(vec);
+          return NULL;
+     }
+     return vec;
+}
+#endif
@@ -0,0 +1,223 @@
+#include "aegis_bitvec.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <assert.h>
+
+int test_count = 0;
+int fail_count = 0;
+
+#define TEST_ASSERT(condition, message) \
+    do { \
+        test_count++; \
+        if (!(condition)) { \
+            fail_count++; \
+            fprintf(stderr, "\n[FAIL] %s:%d: %s\n       Condition: %s\n", __FILE__, __LINE__, message, #condition); \
+        } else { \
+            printf("[PASS] %s\n", message); \
+        } \
+    } while (0)
+
+static uint64_t rng_state = 0x9e3779b97f4a7c15ull;
+
+static uint64_t rng(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+// Random bit vector of n bits (density in 1/256 units) and its bool mirror
+static ag_bitvec *random_bits(size_t n, unsigned density, bool *ref) {
+    ag_bitvec *bv = bitvec_init(n);
+    for (size_t i = 0; i < n; i++) {
+        ref[i] = (rng() & 255) < density;
+        bitvec_assign(bv, i, ref[i]);
+    }
+    return bv;
+}
+
+// =========================================================================
+// TEST 1: Single-bit access and resizing
+// =========================================================================
+void test_bits() {
+    printf("\n--- Running Test 1: Single-bit access and resizing ---\n");
+    ag_bitvec *bv = bitvec_init(130);
+    TEST_ASSERT(bitvec_size(bv) == 130 && bitvec_count(bv) == 0, "T1.1: bitvec_init starts cleared");
+
+    bitvec_set(bv, 0);
+    bitvec_set(bv, 63);
+    bitvec_set(bv, 64);
+    bitvec_set(bv, 129);
+    TEST_ASSERT(bitvec_test(bv, 0) && bitvec_test(bv, 63) && bitvec_test(bv, 64) && bitvec_test(bv, 129), "T1.2: set across word boundaries");
+    TEST_ASSERT(!bitvec_test(bv, 1) && !bitvec_test(bv, 128), "T1.3: neighbours untouched");
+    bitvec_clear(bv, 63);
+    bitvec_flip(bv, 64);
+    bitvec_flip(bv, 65);
+    TEST_ASSERT(!bitvec_test(bv, 63) && !bitvec_test(bv, 64) && bitvec_test(bv, 65), "T1.4: clear and flip");
+    TEST_ASSERT(bitvec_count(bv) == 3, "T1.5: count after edits");
+
+    bitvec_set_all(bv);
+    TEST_ASSERT(bitvec_count(bv) == 130 && (bv->words[2] >> 2) == 0, "T1.6: set_all keeps bits past size clear");
+    bitvec_resize(bv, 100);
+    bitvec_resize(bv, 300);
+    TEST_ASSERT(bitvec_count(bv) == 100 && !bitvec_test(bv, 100) && !bitvec_test(bv, 299), "T1.7: shrink then grow reads back zeros");
+    bitvec_not(bv);
+    TEST_ASSERT(bitvec_count(bv) == 200 && !bitvec_test(bv, 99) && bitvec_test(bv, 100), "T1.8: not stays inside size");
+    bitvec_clear_all(bv);
+    TEST_ASSERT(bitvec_count(bv) == 0, "T1.9: clear_all");
+    bitvec_clean(bv);
+
+    ag_arena *arena = ag_arena_init(0);
+    bv = bitvec_init_with_alloc(0, &arena->allocator);
+    for (int i = 0; i < 1000; i++) bitvec_push_back(bv, i % 3 == 0);
+    bool ok = bitvec_size(bv) == 1000 && bitvec_count(bv) == 334;
+    for (int i = 0; i < 1000; i++) ok &= bitvec_test(bv, i) == (i % 3 == 0);
+    TEST_ASSERT(ok, "T1.10: push_back grows through the allocator");
+    bitvec_clean(bv);
+    ag_arena_clean(arena);
+}
+
+// =========================================================================
+// TEST 2: Bulk operations
+// =========================================================================
+void test_bulk_ops() {
+    printf("\n--- Running Test 2: Bulk operations ---\n");
+    // Odd word count so the SIMD tail runs too
+    enum { N = 64 * 37 + 11 };
+    static bool ra[N], rb[N];
+    ag_bitvec *a = random_bits(N, 128, ra);
+    ag_bitvec *b = random_bits(N, 64, rb);
+    ag_bitvec *t = bitvec_init(N);
+
+    bool ok_and = true, ok_or = true, ok_xor = true, ok_andnot = true;
+    bitvec_or(t, a);
+    bitvec_and(t, b);
+    for (size_t i = 0; i < N; i++) ok_and &= bitvec_test(t, i) == (ra[i] && rb[i]);
+    bitvec_clear_all(t);
+    bitvec_or(t, a);
+    bitvec_or(t, b);
+    for (size_t i = 0; i < N; i++) ok_or &= bitvec_test(t, i) == (ra[i] || rb[i]);
+    bitvec_xor(t, a);
+    for (size_t i = 0; i < N; i++) ok_xor &= bitvec_test(t, i) == ((ra[i] || rb[i]) != ra[i]);
+    bitvec_clear_all(t);
+    bitvec_or(t, a);
+    bitvec_andnot(t, b);
+    for (size_t i = 0; i < N; i++) ok_andnot &= bitvec_test(t, i) == (ra[i] && !rb[i]);
+    TEST_ASSERT(ok_and, "T2.1: and");
+    TEST_ASSERT(ok_or, "T2.2: or");
+    TEST_ASSERT(ok_xor, "T2.3: xor");
+    TEST_ASSERT(ok_andnot, "T2.4: andnot");
+
+    bitvec_clean(a);
+    bitvec_clean(b);
+    bitvec_clean(t);
+}
+
+// =========================================================================
+// TEST 3: Popcount and find
+// =========================================================================
+void test_find_and_count() {
+    printf("\n--- Running Test 3: Popcount and find ---\n");
+    enum { N = 100003 };
+    static bool ref[N];
+    ag_bitvec *bv = random_bits(N, 3, ref);
+
+    size_t expect = 0;
+    for (size_t i = 0; i < N; i++) expect += ref[i];
+    TEST_ASSERT(bitvec_count(bv) == expect, "T3.1: count matches the reference");
+
+    bool ok = true;
+    size_t next = 0, visited = 0;
+    for (size_t i = bitvec_find_first(bv); i != AG_NPOS; i = bitvec_find_next(bv, i + 1)) {
+        while (next < i) ok &= !ref[next++];
+        ok &= ref[i];
+        next = i + 1;
+        visited++;
+    }
+    while (next < N) ok &= !ref[next++];
+    TEST_ASSERT(ok && visited == expect, "T3.2: find_first / find_next visit every set bit");
+    TEST_ASSERT(bitvec_find_next(bv, N) == AG_NPOS, "T3.3: find past the end");
+
+    ag_bitvec *empty = bitvec_init(500);
+    TEST_ASSERT(bitvec_find_first(empty) == AG_NPOS, "T3.4: find on an all-zero vector");
+    bitvec_set(empty, 499);
+    TEST_ASSERT(bitvec_find_next(empty, 10) == 499, "T3.5: find the last bit");
+    bitvec_clean(empty);
+    bitvec_clean(bv);
+}
+
+// =========================================================================
+// TEST 4: Rank and select
+// =========================================================================
+static bool check_rank_select(const ag_bitvec *bv, const bool *ref, size_t n) {
+    bool ok = true;
+    size_t rank = 0;
+    for (size_t i = 0; i < n; i++) {
+        if ((i & 7) == 0 || ref[i]) ok &= bitvec_rank(bv, i) == rank;
+        if (ref[i]) {
+            ok &= bitvec_select(bv, rank) == i;
+            rank++;
+        }
+    }
+    ok &= bitvec_rank(bv, n) == rank;
+    ok &= bitvec_select(bv, rank) == AG_NPOS;
+    return ok;
+}
+
+void test_rank_select() {
+    printf("\n--- Running Test 4: Rank and select ---\n");
+    enum { N = 200000 };
+    static bool ref[N];
+
+    // Dense, sparse and clustered inputs
+    const unsigned densities[] = { 200, 1, 40 };
+    bool scan_ok = true, index_ok = true;
+    for (int d = 0; d < 3; d++) {
+        ag_bitvec *bv = random_bits(N, densities[d], ref);
+        if (d == 2) {
+            for (size_t i = 50000; i < 90000; i++) { ref[i] = true; bitvec_set(bv, i); }
+        }
+        scan_ok &= check_rank_select(bv, ref, N);
+        bitvec_build_rank(bv);
+        index_ok &= bv->rank != NULL && check_rank_select(bv, ref, N);
+        bitvec_clean(bv);
+    }
+    TEST_ASSERT(scan_ok, "T4.1: rank / select by scanning");
+    TEST_ASSERT(index_ok, "T4.2: rank / select through the directory");
+
+    ag_bitvec *bv = bitvec_init(1000);
+    bitvec_build_rank(bv);
+    TEST_ASSERT(bitvec_rank(bv, 1000) == 0 && bitvec_select(bv, 0) == AG_NPOS, "T4.3: directory of an all-zero vector");
+    bitvec_resize(bv, 2000);
+    TEST_ASSERT(bv->rank == NULL, "T4.4: resize drops the directory");
+    bitvec_set(bv, 1999);
+    TEST_ASSERT(bitvec_select(bv, 0) == 1999 && bitvec_rank(bv, 1999) == 0, "T4.5: rank / select after resize");
+    bitvec_clean(bv);
+}
+
+// =========================================================================
+// MAIN TEST RUNNER
+// =========================================================================
+int main() {
+    test_bits();
+    test_bulk_ops();
+    test_find_and_count();
+    test_rank_select();
+
+    printf("\n============================================\n");
+    printf("TEST SUITE SUMMARY:\n");
+    printf("Total Tests Run: %d\n", test_count);
+    printf("Tests Passed:    %d\n", test_count - fail_count);
+    printf("Tests Failed:    %d\n", fail_count);
+    printf("============================================\n");
+
+    if (fail_count > 0) {
+        printf("!!! WARNING: %d test(s) failed. Review the FAIL messages above. !!!\n", fail_count);
+        return EXIT_FAILURE;
+    } else {
+        printf("SUCCESS! All tests passed.\n");
+        return EXIT_SUCCESS;
+    }
+}
@@ -0,0 +1,190 @@
+#include "aegis_deque.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <assert.h>
+
+int test_count = 0;
+int fail_count = 0;
+
+#define TEST_ASSERT(condition, message) \
+    do { \
+        test_count++; \
+        if (!(condition)) { \
+            fail_count++; \
+            fprintf(stderr, "\n[FAIL] %s:%d: %s\n       Condition: %s\n", __FILE__, __LINE__, message, #condition); \
+        } else { \
+            printf("[PASS] %s\n", message); \
+        } \
+    } while (0)
+
+typedef struct {
+    long id;
+    char name[24];
+} item;
+
+// =========================================================================
+// TEST 1: Push and pop at both ends
+// =========================================================================
+void test_push_pop() {
+    printf("\n--- Running Test 1: Push and pop at both ends ---\n");
+    ag_deque *dq = deque_init(int);
+    TEST_ASSERT(dq != NULL && deque_empty(dq), "T1.1: deque_init starts empty");
+    TEST_ASSERT(deque_block_elems(dq) == 1024, "T1.2: 4 KiB blocks of int");
+
+    for (int i = 0; i < 3000; i++) deque_push_back(dq, int, i);
+    for (int i = 1; i <= 3000; i++) deque_push_front(dq, int, -i);
+    TEST_ASSERT(deque_size(dq) == 6000, "T1.3: size after pushes at both ends");
+    TEST_ASSERT(deque_front(dq, int) == -3000 && deque_back(dq, int) == 2999, "T1.4: front and back");
+
+    bool ok = true;
+    for (size_t i = 0; i < 6000; i++) ok &= deque_at(dq, int, i) == (int)i - 3000;
+    TEST_ASSERT(ok, "T1.5: indexing crosses blocks in order");
+
+    for (int i = 0; i < 2500; i++) deque_pop_front(dq);
+    for (int i = 0; i < 2500; i++) deque_pop_back(dq);
+    TEST_ASSERT(deque_size(dq) == 1000 && deque_front(dq, int) == -500 && deque_back(dq, int) == 499, "T1.6: pops at both ends");
+    TEST_ASSERT(dq->nblocks <= 3, "T1.7: emptied blocks are released");
+
+    while (!deque_empty(dq)) deque_pop_front(dq);
+    deque_pop_front(dq);
+    deque_pop_back(dq);
+    TEST_ASSERT(deque_size(dq) == 0 && dq->nblocks == 0, "T1.8: pop on empty is a no-op");
+
+    // Queue usage keeps reusing the spare block
+    for (int round = 0; round < 10; round++) {
+        for (int i = 0; i < 1500; i++) deque_push_back(dq, int, i);
+        for (int i = 0; i < 1500; i++) deque_pop_front(dq);
+    }
+    TEST_ASSERT(deque_empty(dq) && dq->nblocks == 0 && dq->spare != NULL, "T1.9: FIFO churn keeps one spare block");
+
+    int src[5000];
+    for (int i = 0; i < 5000; i++) src[i] = i * 3;
+    deque_push_back(dq, int, -1);
+    deque_push_back_n(dq, src, 5000);
+    ok = deque_size(dq) == 5001 && deque_at(dq, int, 0) == -1;
+    for (size_t i = 0; i < 5000; i++) ok &= deque_at(dq, int, i + 1) == src[i];
+    TEST_ASSERT(ok, "T1.10: push_back_n copies block by block");
+
+    deque_clear(dq);
+    TEST_ASSERT(deque_empty(dq) && dq->nblocks == 0, "T1.11: clear drops every element");
+    deque_clean(dq);
+}
+
+// =========================================================================
+// TEST 2: Stable element addresses
+// =========================================================================
+void test_stable_addresses() {
+    printf("\n--- Running Test 2: Stable element addresses ---\n");
+    ag_arena *arena = ag_arena_init(0);
+    ag_deque *dq = deque_init_with_alloc(item, &arena->allocator);
+    TEST_ASSERT(deque_block_elems(dq) == 128, "T2.1: block holds a power of two of items");
+
+    item *first = deque_push_back(dq, item, ((item){ 1, "first" }));
+    item *mid = NULL;
+    for (long i = 2; i <= 10000; i++) {
+        item *p = deque_push_back(dq, item, ((item){ i, "" }));
+        if (i == 5000) mid = p;
+        deque_push_front(dq, item, ((item){ -i, "" }));
+    }
+    TEST_ASSERT(first->id == 1 && strcmp(first->name, "first") == 0, "T2.2: first element did not move");
+    TEST_ASSERT(mid->id == 5000 && mid == deque_at_ptr(dq, 9999 + 4999), "T2.3: pointer from push matches deque_at_ptr");
+
+    for (int i = 0; i < 9999; i++) deque_pop_front(dq);
+    TEST_ASSERT(deque_at_ptr(dq, 0) == first && first->id == 1, "T2.4: popping the other end leaves addresses alone");
+
+    deque_clean(dq);
+    ag_arena_clean(arena);
+}
+
+// =========================================================================
+// TEST 3: Block-wise iteration
+// =========================================================================
+void test_block_iteration() {
+    printf("\n--- Running Test 3: Block-wise iteration ---\n");
+    ag_deque *dq = deque_init(double);
+    for (int i = 0; i < 700; i++) deque_push_front(dq, double, -1.0 - i);
+    for (int i = 0; i < 1300; i++) deque_push_back(dq, double, i);
+
+    size_t it = 0, n, runs = 0, seen = 0;
+    void *run;
+    bool ok = true;
+    while (deque_next_block(dq, &it, &run, &n)) {
+        for (size_t k = 0; k < n; k++) ok &= ((double*)run)[k] == deque_at(dq, double, seen + k);
+        ok &= n <= deque_block_elems(dq);
+        seen += n;
+        runs++;
+    }
+    TEST_ASSERT(ok && seen == 2000, "T3.1: runs cover every element in order");
+    TEST_ASSERT(runs == dq->nblocks, "T3.2: one run per block");
+
+    it = 1500;
+    deque_next_block(dq, &it, &run, &n);
+    TEST_ASSERT(*(double*)run == 800.0 && it == 1500 + n, "T3.3: iteration can start mid-deque");
+    deque_clean(dq);
+}
+
+// =========================================================================
+// TEST 4: Random operations against a reference
+// =========================================================================
+void test_random_ops() {
+    printf("\n--- Running Test 4: Random operations ---\n");
+    enum { CAP = 200000 };
+    long *ref = malloc(2 * CAP * sizeof(long));
+    size_t lo = CAP, hi = CAP; // ref[lo, hi)
+    ag_deque *dq = deque_init(long);
+
+    uint64_t seed = 88172645463325252ull;
+    bool ok = true;
+    for (long step = 0; step < 300000; step++) {
+        seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17;
+        switch (seed % 5) {
+        case 0: case 1:
+            if (hi < 2 * CAP) { ref[hi++] = step; deque_push_back(dq, long, step); }
+            break;
+        case 2:
+            if (lo > 0) { ref[--lo] = step; deque_push_front(dq, long, step); }
+            break;
+        case 3:
+            if (hi > lo) { hi--; deque_pop_back(dq); }
+            break;
+        default:
+            if (hi > lo) { lo++; deque_pop_front(dq); }
+            break;
+        }
+        ok &= deque_size(dq) == hi - lo;
+        if (hi > lo) ok &= deque_front(dq, long) == ref[lo] && deque_back(dq, long) == ref[hi - 1];
+    }
+    for (size_t i = lo; i < hi; i++) ok &= deque_at(dq, long, i - lo) == ref[i];
+    TEST_ASSERT(ok, "T4.1: 300000 random ops match the reference");
+    TEST_ASSERT(dq->nblocks <= (deque_size(dq) >> dq->block_shift) + 2, "T4.2: no stray blocks");
+
+    deque_clean(dq);
+    free(ref);
+}
+
+// =========================================================================
+// MAIN TEST RUNNER
+// =========================================================================
+int main() {
+    test_push_pop();
+    test_stable_addresses();
+    test_block_iteration();
+    test_random_ops();
+
+    printf("\n============================================\n");
+    printf("TEST SUITE SUMMARY:\n");
+    printf("Total Tests Run: %d\n", test_count);
+    printf("Tests Passed:    %d\n", test_count - fail_count);
+    printf("Tests Failed:    %d\n", fail_count);
+    printf("============================================\n");
+
+    if (fail_count > 0) {
+        printf("!!! WARNING: %d test(s) failed. Review the FAIL messages above. !!!\n", fail_count);
+        return EXIT_FAILURE;
+    } else {
+        printf("SUCCESS! All tests passed.\n");
+        return EXIT_SUCCESS;
+    }
+}
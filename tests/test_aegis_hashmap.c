@@ -0,0 +1,229 @@
+#include "aegis_hashmap.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <assert.h>
+
+int test_count = 0;
+int fail_count = 0;
+
+#define TEST_ASSERT(condition, message) \
+    do { \
+        test_count++; \
+        if (!(condition)) { \
+            fail_count++; \
+            fprintf(stderr, "\n[FAIL] %s:%d: %s\n       Condition: %s\n", __FILE__, __LINE__, message, #condition); \
+        } else { \
+            printf("[PASS] %s\n", message); \
+        } \
+    } while (0)
+
+AG_HASHMAP_DEFINE(ag_map_u64_int, uint64_t, int)
+
+// =========================================================================
+// TEST 1: Byte keys
+// =========================================================================
+void test_byte_keys() {
+    printf("\n--- Running Test 1: Byte keys ---\n");
+    ag_hashmap *m = hashmap_init(sizeof(int), sizeof(double));
+    TEST_ASSERT(m != NULL && hashmap_size(m) == 0 && m->capacity == 0, "T1.1: hashmap_init starts without a table");
+
+    int missing = 3;
+    TEST_ASSERT(hashmap_find(m, &missing) == NULL, "T1.2: find on an empty map");
+
+    for (int i = 0; i < 1000; i++) {
+        double v = i * 0.5;
+        hashmap_put(m, &i, &v);
+    }
+    TEST_ASSERT(hashmap_size(m) == 1000, "T1.3: size after 1000 puts");
+    TEST_ASSERT(m->size <= m->capacity - m->capacity / 8, "T1.4: load factor stays <= 7/8");
+
+    bool all_found = true;
+    for (int i = 0; i < 1000; i++) {
+        double *v = hashmap_find(m, &i);
+        if (v == NULL || *v != i * 0.5) all_found = false;
+    }
+    TEST_ASSERT(all_found, "T1.5: every key is found with its value");
+
+    int k = 10;
+    double nv = -1.0;
+    hashmap_put(m, &k, &nv);
+    TEST_ASSERT(hashmap_size(m) == 1000 && *(double*)hashmap_find(m, &k) == -1.0, "T1.6: put on an existing key assigns");
+
+    bool inserted = true;
+    double *slot = hashmap_insert(m, &k, &inserted);
+    TEST_ASSERT(!inserted && *slot == -1.0, "T1.7: insert of an existing key returns its value");
+    int fresh = 5000;
+    slot = hashmap_insert(m, &fresh, &inserted);
+    TEST_ASSERT(inserted && *slot == 0.0, "T1.8: insert of a new key returns a zeroed value");
+
+    uint64_t h = hashmap_hash(m, &k);
+    TEST_ASSERT(hashmap_find_hashed(m, &k, h) == hashmap_find(m, &k), "T1.9: find_hashed matches find");
+
+    hashmap_clean(m);
+}
+
+// =========================================================================
+// TEST 2: Erase without tombstones
+// =========================================================================
+void test_erase() {
+    printf("\n--- Running Test 2: Erase ---\n");
+    ag_hashmap *m = hashmap_init(sizeof(uint64_t), sizeof(uint64_t));
+    const uint64_t n = 20000;
+    for (uint64_t i = 0; i < n; i++) {
+        uint64_t v = i * 3;
+        hashmap_put(m, &i, &v);
+    }
+    size_t capacity = m->capacity;
+
+    bool erased_ok = true;
+    for (uint64_t i = 0; i < n; i += 2)
+        if (!hashmap_erase(m, &i)) erased_ok = false;
+    TEST_ASSERT(erased_ok && hashmap_size(m) == n / 2, "T2.1: erase every even key");
+
+    bool lookups_ok = true;
+    for (uint64_t i = 0; i < n; i++) {
+        uint64_t *v = hashmap_find(m, &i);
+        if ((i % 2 == 0) != (v == NULL) || (v != NULL && *v != i * 3)) lookups_ok = false;
+    }
+    TEST_ASSERT(lookups_ok, "T2.2: odd keys survive backward-shift deletion");
+
+    uint64_t gone = 0;
+    TEST_ASSERT(!hashmap_erase(m, &gone), "T2.3: erase of a missing key returns false");
+
+    // Churn: reinserting what was erased must not grow a tombstone-free table
+    for (uint64_t i = 0; i < n; i += 2) {
+        uint64_t v = i * 3;
+        hashmap_put(m, &i, &v);
+    }
+    TEST_ASSERT(hashmap_size(m) == n && m->capacity == capacity, "T2.4: churn keeps the capacity");
+
+    size_t seen = 0;
+    void *key, *value;
+    for (size_t it = 0; hashmap_next(m, &it, &key, &value);) {
+        if (*(uint64_t*)value == *(uint64_t*)key * 3) seen++;
+    }
+    TEST_ASSERT(seen == n, "T2.5: hashmap_next visits every entry once");
+
+    hashmap_clear(m);
+    TEST_ASSERT(hashmap_size(m) == 0 && hashmap_find(m, &gone) == NULL, "T2.6: clear empties the map");
+    hashmap_clean(m);
+}
+
+// =========================================================================
+// TEST 3: Reserve / rehash
+// =========================================================================
+void test_reserve_rehash() {
+    printf("\n--- Running Test 3: Reserve and rehash ---\n");
+    ag_hashmap *m = hashmap_init(sizeof(int), sizeof(int));
+    hashmap_reserve(m, 1000);
+    size_t capacity = m->capacity;
+    TEST_ASSERT(capacity - capacity / 8 >= 1000, "T3.1: reserve makes room for 1000 entries");
+
+    for (int i = 0; i < 1000; i++) hashmap_put(m, &i, &i);
+    TEST_ASSERT(m->capacity == capacity, "T3.2: no rehash while filling the reserved room");
+
+    for (int i = 100; i < 1000; i++) hashmap_erase(m, &i);
+    hashmap_rehash(m, 0);
+    TEST_ASSERT(m->capacity < capacity && hashmap_size(m) == 100, "T3.3: rehash(0) shrinks to fit");
+
+    bool all_found = true;
+    for (int i = 0; i < 100; i++) {
+        int *v = hashmap_find(m, &i);
+        if (v == NULL || *v != i) all_found = false;
+    }
+    TEST_ASSERT(all_found, "T3.4: entries survive the shrink");
+    hashmap_clean(m);
+}
+
+// =========================================================================
+// TEST 4: ag_string keys
+// =========================================================================
+void test_string_keys() {
+    printf("\n--- Running Test 4: String keys ---\n");
+    ag_hashmap *m = hashmap_init_string(sizeof(int));
+
+    char buf[32];
+    for (int i = 0; i < 500; i++) {
+        snprintf(buf, sizeof(buf), "session-%d", i);
+        hashmap_put_sv(m, sv_from_cstr(buf), &i);
+    }
+    TEST_ASSERT(hashmap_size(m) == 500, "T4.1: 500 string keys inserted");
+
+    // The map owns copies, the buffer is gone
+    int *v = hashmap_find_sv(m, sv_from_cstr("session-123"));
+    TEST_ASSERT(v != NULL && *v == 123, "T4.2: find_sv by content");
+
+    ag_string key = new_string("session-7");
+    v = hashmap_find_sv(m, sv_from_string(key));
+    TEST_ASSERT(v != NULL && *v == 7, "T4.3: lookup through an ag_string");
+
+    uint64_t h = hashmap_hash_sv(sv_from_cstr("session-42"));
+    v = hashmap_find_sv_hashed(m, sv_from_cstr("session-42"), h);
+    TEST_ASSERT(v != NULL && *v == 42, "T4.4: find_sv_hashed with a precomputed hash");
+
+    TEST_ASSERT(hashmap_erase_sv(m, sv_from_cstr("session-7")) && hashmap_find_sv(m, sv_from_string(key)) == NULL,
+                "T4.5: erase_sv removes the key");
+    TEST_ASSERT(hashmap_find_sv(m, sv_from_cstr("session-")) == NULL, "T4.6: prefix is not a match");
+
+    bool inserted = false;
+    int *slot = hashmap_insert_sv(m, sv_from_buf("a\0b", 3), &inserted);
+    *slot = 99;
+    TEST_ASSERT(inserted && *(int*)hashmap_find_sv(m, sv_from_buf("a\0b", 3)) == 99, "T4.7: keys with embedded NUL");
+
+    __vec_clean(key);
+    hashmap_clean(m);
+}
+
+// =========================================================================
+// TEST 5: Typed flavor and custom allocator
+// =========================================================================
+void test_typed_map() {
+    printf("\n--- Running Test 5: Typed map ---\n");
+    ag_arena *arena = ag_arena_init(1 << 16);
+    ag_map_u64_int *m = ag_map_u64_int_init_with_alloc(&arena->allocator);
+
+    for (uint64_t i = 0; i < 5000; i++) ag_map_u64_int_put(m, i * 7919, (int)i);
+    TEST_ASSERT(ag_map_u64_int_size(m) == 5000, "T5.1: typed put size check");
+
+    int *v = ag_map_u64_int_find(m, 42 * 7919);
+    TEST_ASSERT(v != NULL && *v == 42, "T5.2: typed find");
+    TEST_ASSERT(!ag_map_u64_int_contains(m, 1), "T5.3: typed contains on a missing key");
+
+    TEST_ASSERT(ag_map_u64_int_erase(m, 42 * 7919) && ag_map_u64_int_find(m, 42 * 7919) == NULL, "T5.4: typed erase");
+
+    uint64_t h = ag_map_u64_int_hash(7919);
+    v = ag_map_u64_int_find_hashed(m, 7919, h);
+    TEST_ASSERT(v != NULL && *v == 1 && h == hashmap_hash(&m->base, &(uint64_t){7919}),
+                "T5.5: typed and generic hashes agree");
+
+    ag_map_u64_int_clean(m);
+    ag_arena_clean(arena);
+}
+
+// =========================================================================
+// MAIN TEST RUNNER
+// =========================================================================
+int main() {
+    test_byte_keys();
+    test_erase();
+    test_reserve_rehash();
+    test_string_keys();
+    test_typed_map();
+
+    printf("\n============================================\n");
+    printf("TEST SUITE SUMMARY:\n");
+    printf("Total Tests Run: %d\n", test_count);
+    printf("Tests Passed:    %d\n", test_count - fail_count);
+    printf("Tests Failed:    %d\n", fail_count);
+    printf("============================================\n");
+
+    if (fail_count > 0) {
+        printf("!!! WARNING: %d test(s) failed. Review the FAIL messages above. !!!\n", fail_count);
+        return EXIT_FAILURE;
+    } else {
+        printf("SUCCESS! All tests passed.\n");
+        return EXIT_SUCCESS;
+    }
+}
@@ -0,0 +1,119 @@
+// Single translation unit build: the library compiles into this file
+#define AEGIS_IMPLEMENTATION
+#include "aegis.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <math.h>
+
+int test_count = 0;
+int fail_count = 0;
+
+#define TEST_ASSERT(condition, message) \
+    do { \
+        test_count++; \
+        if (!(condition)) { \
+            fail_count++; \
+            fprintf(stderr, "\n[FAIL] %s:%d: %s\n       Condition: %s\n", __FILE__, __LINE__, message, #condition); \
+        } else { \
+            printf("[PASS] %s\n", message); \
+        } \
+    } while (0)
+
+// =========================================================================
+// TEST 1: The library works compiled into one file
+// =========================================================================
+void test_header_only() {
+    printf("\n--- Running Test 1: The library works compiled into one file ---\n");
+    vector *v = vec_init(0, int, false);
+    for (int i = 0; i < 1000; i++) vec_push_back(v, int, i);
+    vec_pop_back(v);
+    TEST_ASSERT(v->size == 999 && vec_at(v, int, 998) == 998, "T1.1: inline push_back and pop_back");
+    vec_clean(v);
+
+    ag_string s = new_string("a,b,\xc3\xa9");
+    TEST_ASSERT(string_split(s, sv_from_cstr(","), 0, NULL) == 3, "T1.2: split");
+    TEST_ASSERT(string_validate_utf8(s) && string_utf8_length(s) == 5, "T1.3: UTF-8");
+    vec_clean(s);
+
+    ag_hashmap *m = hashmap_init(sizeof(uint64_t), sizeof(int));
+    uint64_t k = 7;
+    int val = 49;
+    hashmap_put(m, &k, &val);
+    TEST_ASSERT(*(int*)hashmap_find(m, &k) == 49, "T1.4: hashmap");
+    hashmap_clean(m);
+}
+
+// =========================================================================
+// TEST 2: Float radix sorts inlined into the caller
+// =========================================================================
+// Ascending with -0.0 before 0.0, NaN last
+#define SORTED_TOTAL(a, n, ok)                                                  \
+    do {                                                                        \
+        ok = true;                                                              \
+        for (size_t i = 1; i < (n); i++) {                                      \
+            if (isnan((a)[i - 1])) ok = ok && isnan((a)[i]);                    \
+            else if (!isnan((a)[i]))                                            \
+                ok = ok && ((a)[i - 1] < (a)[i] ||                              \
+                            ((a)[i - 1] == (a)[i] && !!signbit((a)[i - 1]) >= !!signbit((a)[i]))); \
+        }                                                                       \
+    } while (0)
+
+void test_float_radix() {
+    printf("\n--- Running Test 2: Float radix sorts inlined into the caller ---\n");
+    bool ok;
+    double d[4] = { 4, 3, 2, 1 };
+    ag_radix_sort_f64(d, 4);
+    TEST_ASSERT(d[0] == 1 && d[1] == 2 && d[2] == 3 && d[3] == 4, "T2.1: small double array");
+
+    float f[6] = { 2.5f, NAN, -0.0f, 0.0f, -7.0f, -INFINITY };
+    ag_radix_sort_f32(f, 6);
+    SORTED_TOTAL(f, 6, ok);
+    TEST_ASSERT(ok && f[0] == -INFINITY && signbit(f[2]) && isnan(f[5]), "T2.2: small float array in total order");
+
+    enum { N = 5000 };
+    double *dl = malloc(N * sizeof(double));
+    float *fl = malloc(N * sizeof(float));
+    uint32_t x = 12345;
+    for (size_t i = 0; i < N; i++) {
+        x = x * 1664525u + 1013904223u;
+        dl[i] = ((double)x - 2147483648.0) / 3.0;
+        fl[i] = (float)dl[i];
+    }
+    dl[17] = -0.0;
+    dl[18] = 0.0;
+    fl[19] = NAN;
+    ag_radix_sort_f64(dl, N);
+    SORTED_TOTAL(dl, N, ok);
+    TEST_ASSERT(ok, "T2.3: large double array");
+    ag_radix_sort_f32(fl, N);
+    SORTED_TOTAL(fl, N, ok);
+    TEST_ASSERT(ok && isnan(fl[N - 1]), "T2.4: large float array, NaN last");
+    free(dl);
+    free(fl);
+}
+
+// =========================================================================
+// MAIN TEST RUNNER
+// =========================================================================
+int main() {
+    test_header_only();
+    test_float_radix();
+
+    printf("\n============================================\n");
+    printf("TEST SUITE SUMMARY:\n");
+    printf("Total Tests Run: %d\n", test_count);
+    printf("Tests Passed:    %d\n", test_count - fail_count);
+    printf("Tests Failed:    %d\n", fail_count);
+    printf("============================================\n");
+
+    if (fail_count > 0) {
+        printf("!!! WARNING: %d test(s) failed. Review the FAIL messages above. !!!\n", fail_count);
+        return EXIT_FAILURE;
+    } else {
+        printf("SUCCESS! All tests passed.\n");
+        return EXIT_SUCCESS;
+    }
+}
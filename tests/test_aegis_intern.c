@@ -0,0 +1,184 @@
+#include "aegis_intern.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <pthread.h>
+
+int test_count = 0;
+int fail_count = 0;
+
+#define TEST_ASSERT(condition, message) \
+    do { \
+        test_count++; \
+        if (!(condition)) { \
+            fail_count++; \
+            fprintf(stderr, "\n[FAIL] %s:%d: %s\n       Condition: %s\n", __FILE__, __LINE__, message, #condition); \
+        } else { \
+            printf("[PASS] %s\n", message); \
+        } \
+    } while (0)
+
+// =========================================================================
+// TEST 1: Ids, entries and lookups
+// =========================================================================
+void test_basic() {
+    printf("\n--- Running Test 1: Ids, entries and lookups ---\n");
+    ag_intern *pool = intern_init();
+
+    uint32_t get = intern_cstr(pool, "GET");
+    uint32_t post = intern_cstr(pool, "POST");
+    char buf[] = "GET";
+    TEST_ASSERT(get != post, "T1.1: distinct strings get distinct ids");
+    TEST_ASSERT(intern_sv(pool, sv_from_buf(buf, 3)) == get, "T1.2: equal strings share an id");
+    TEST_ASSERT(intern_size(pool) == 2, "T1.3: size counts distinct strings");
+
+    const ag_interned *e = intern_entry(pool, get);
+    TEST_ASSERT(strcmp(e->data, "GET") == 0 && e->size == 3 && e->id == get, "T1.4: entry holds the bytes");
+    TEST_ASSERT(e->hash == sv_hash(sv_from_cstr("GET")) && intern_hash(pool, get) == e->hash, "T1.5: hash is precomputed");
+
+    TEST_ASSERT(intern_find_sv(pool, sv_from_cstr("PUT")) == AG_INTERN_NONE, "T1.6: find misses without adding");
+    TEST_ASSERT(intern_size(pool) == 2 && intern_find_sv(pool, sv_from_cstr("POST")) == post, "T1.7: find hits");
+
+    uint32_t empty = intern_sv(pool, sv_from_buf(NULL, 0));
+    TEST_ASSERT(intern_view(pool, empty).size == 0 && intern_sv(pool, sv_from_cstr("")) == empty, "T1.8: empty string");
+
+    // Embedded NUL bytes are part of the key
+    uint32_t a = intern_sv(pool, sv_from_buf("a\0b", 3)), b = intern_sv(pool, sv_from_buf("a\0c", 3));
+    TEST_ASSERT(a != b && sv_equal(intern_view(pool, a), sv_from_buf("a\0b", 3)), "T1.9: binary keys");
+
+    // Many strings: tables grow, entry pointers stay put
+    bool ok = true;
+    uint32_t *ids = malloc(100000 * sizeof(uint32_t));
+    for (int i = 0; i < 100000; i++) {
+        char key[32];
+        int len = snprintf(key, sizeof(key), "key-%d", i);
+        ids[i] = intern_sv(pool, sv_from_buf(key, (size_t)len));
+    }
+    for (int i = 0; i < 100000; i++) {
+        char key[32];
+        int len = snprintf(key, sizeof(key), "key-%d", i);
+        ok &= intern_sv(pool, sv_from_buf(key, (size_t)len)) == ids[i];
+        ok &= strcmp(intern_entry(pool, ids[i])->data, key) == 0;
+    }
+    TEST_ASSERT(ok && intern_size(pool) == 100005, "T1.10: 100000 strings round trip");
+    TEST_ASSERT(intern_entry(pool, get) == e, "T1.11: entries do not move");
+
+    free(ids);
+    intern_clean(pool);
+}
+
+// =========================================================================
+// TEST 2: Bulk interning of split tokens
+// =========================================================================
+void test_tokens() {
+    printf("\n--- Running Test 2: Bulk interning of split tokens ---\n");
+    ag_intern *pool = intern_init();
+    ag_string text = new_string("");
+    for (int i = 0; i < 2000; i++) {
+        char word[16];
+        int len = snprintf(word, sizeof(word), "w%d ", i % 37);
+        string_append_n(text, word, (size_t)len);
+    }
+    ag_string_view src = sv_from_string(text);
+    vector *toks = vec_init(0, ag_token, false);
+    sv_split(src, sv_from_cstr(" "), AG_SPLIT_SKIP_EMPTY, toks);
+
+    uint32_t *ids = malloc(toks->size * sizeof(uint32_t));
+    intern_tokens(pool, src, toks, ids);
+    TEST_ASSERT(intern_size(pool) == 37, "T2.1: one entry per distinct token");
+
+    bool ok = true;
+    for (size_t i = 0; i < toks->size; i++) {
+        ag_string_view tok = sv_token(src, vec_at(toks, ag_token, i));
+        ok &= sv_equal(intern_view(pool, ids[i]), tok);
+        ok &= ids[i] == ids[i % 37];
+    }
+    TEST_ASSERT(ok && toks->size == 2000, "T2.2: ids match the single-string path");
+
+    // Second pass finds everything under read locks
+    uint32_t *again = malloc(toks->size * sizeof(uint32_t));
+    intern_tokens(pool, src, toks, again);
+    TEST_ASSERT(memcmp(ids, again, toks->size * sizeof(uint32_t)) == 0, "T2.3: repeat pass gives the same ids");
+
+    free(again);
+    free(ids);
+    __vec_clean(toks);
+    vec_clean(text);
+    intern_clean(pool);
+}
+
+// =========================================================================
+// TEST 3: Concurrent interning
+// =========================================================================
+#define THREADS 4
+#define KEYS 20000
+
+typedef struct {
+    ag_intern *pool;
+    int offset;
+    uint32_t ids[KEYS];
+} worker_arg;
+
+static void *worker(void *p) {
+    worker_arg *a = (worker_arg*)p;
+    // Every thread walks the same keys from a different start
+    for (int k = 0; k < KEYS; k++) {
+        int i = (k + a->offset) % KEYS;
+        char key[32];
+        int len = snprintf(key, sizeof(key), "shared-%d", i);
+        a->ids[i] = intern_sv(a->pool, sv_from_buf(key, (size_t)len));
+        if (strcmp(intern_entry(a->pool, a->ids[i])->data, key) != 0) a->ids[i] = AG_INTERN_NONE;
+    }
+    return NULL;
+}
+
+void test_concurrent() {
+    printf("\n--- Running Test 3: Concurrent interning ---\n");
+    ag_intern *pool = intern_init();
+    pthread_t threads[THREADS];
+    worker_arg *args = malloc(THREADS * sizeof(worker_arg));
+    for (int t = 0; t < THREADS; t++) {
+        args[t].pool = pool;
+        args[t].offset = t * (KEYS / THREADS);
+        pthread_create(&threads[t], NULL, worker, &args[t]);
+    }
+    for (int t = 0; t < THREADS; t++) pthread_join(threads[t], NULL);
+
+    bool same = true;
+    for (int t = 1; t < THREADS; t++)
+        same &= memcmp(args[0].ids, args[t].ids, sizeof(args[0].ids)) == 0;
+    bool valid = true;
+    for (int i = 0; i < KEYS; i++) valid &= args[0].ids[i] != AG_INTERN_NONE;
+    TEST_ASSERT(valid, "T3.1: every thread reads back its own strings");
+    TEST_ASSERT(same, "T3.2: all threads agree on every id");
+    TEST_ASSERT(intern_size(pool) == KEYS, "T3.3: no string added twice");
+
+    free(args);
+    intern_clean(pool);
+}
+
+// =========================================================================
+// MAIN TEST RUNNER
+// =========================================================================
+int main() {
+    test_basic();
+    test_tokens();
+    test_concurrent();
+
+    printf("\n============================================\n");
+    printf("TEST SUITE SUMMARY:\n");
+    printf("Total Tests Run: %d\n", test_count);
+    printf("Tests Passed:    %d\n", test_count - fail_count);
+    printf("Tests Failed:    %d\n", fail_count);
+    printf("============================================\n");
+
+    if (fail_count > 0) {
+        printf("!!! WARNING: %d test(s) failed. Review the FAIL messages above. !!!\n", fail_count);
+        return EXIT_FAILURE;
+    } else {
+        printf("SUCCESS! All tests passed.\n");
+        return EXIT_SUCCESS;
+    }
+}
@@ -0,0 +1,217 @@
+#include "aegis_io.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+int test_count = 0;
+int fail_count = 0;
+
+#define TEST_ASSERT(condition, message) \
+    do { \
+        test_count++; \
+        if (!(condition)) { \
+            fail_count++; \
+            fprintf(stderr, "\n[FAIL] %s:%d: %s\n       Condition: %s\n", __FILE__, __LINE__, message, #condition); \
+        } else { \
+            printf("[PASS] %s\n", message); \
+        } \
+    } while (0)
+
+static char path[] = "/tmp/aegis_io_testXXXXXX";
+
+// Line i of the test file: short, empty, CRLF-terminated and one very long line
+static ag_string make_line(int i) {
+    ag_string line = new_string("");
+    if (i == 500) {
+        for (int k = 0; k < 100000; k++) string_append_n(line, &"0123456789"[k % 10], 1);
+    } else if (i % 7 != 0) {
+        char buf[64];
+        int len = snprintf(buf, sizeof(buf), "line %d %.*s", i, i % 40, "........................................");
+        string_append_n(line, buf, (size_t)len);
+    }
+    return line;
+}
+
+static void write_file(ag_writer *w, int lines) {
+    for (int i = 0; i < lines; i++) {
+        ag_string line = make_line(i);
+        writer_write_string(w, line);
+        if (i % 3 == 0) writer_write_char(w, '\r');
+        writer_write_char(w, '\n');
+        vec_clean(line);
+    }
+}
+
+static bool read_matches(ag_reader *r, int lines) {
+    ag_string_view got;
+    bool ok = true;
+    int i = 0;
+    for (; reader_next_line(r, &got); i++) {
+        ag_string line = make_line(i);
+        ok &= sv_equal(got, sv_from_string(line));
+        vec_clean(line);
+    }
+    return ok && i == lines && reader_error(r) == 0;
+}
+
+static bool file_holds(const char *bytes, size_t len) {
+    FILE *f = fopen(path, "rb");
+    char buf[256];
+    size_t n = fread(buf, 1, sizeof(buf), f);
+    fclose(f);
+    return n == len && memcmp(buf, bytes, n) == 0;
+}
+
+// =========================================================================
+// TEST 1: Writer and reader round trip
+// =========================================================================
+void test_round_trip() {
+    printf("\n--- Running Test 1: Writer and reader round trip ---\n");
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    close(fd);
+
+    ag_writer *w = writer_open(path, 0);
+    write_file(w, 2000);
+    TEST_ASSERT(writer_close(w), "T1.1: default writer");
+
+    ag_reader *r = reader_open(path, 0);
+    TEST_ASSERT(read_matches(r, 2000), "T1.2: default reader sees every line");
+    reader_close(r);
+
+    // Tiny buffers: records straddle every read, the long one grows the buffer
+    fd = open(path, O_RDONLY);
+    r = reader_from_fd(fd, 16, 0);
+    TEST_ASSERT(read_matches(r, 2000), "T1.3: 16-byte reads");
+    reader_close(r);
+    close(fd);
+
+    r = reader_open(path, AG_READER_MMAP);
+    TEST_ASSERT(read_matches(r, 2000), "T1.4: mapped file");
+    reader_close(r);
+
+    // Small writer buffer: pieces larger than half of it bypass the buffer
+    fd = open(path, O_WRONLY | O_TRUNC);
+    w = writer_from_fd(fd, 64);
+    write_file(w, 1000);
+    TEST_ASSERT(writer_close(w), "T1.5: 64-byte writer");
+    close(fd);
+    r = reader_open(path, 0);
+    TEST_ASSERT(read_matches(r, 1000), "T1.6: small-buffer output reads back");
+    reader_close(r);
+
+    w = writer_open(path, AG_WRITER_APPEND);
+    writer_write_cstr(w, "tail");
+    writer_close(w);
+    r = reader_open(path, AG_READER_MMAP);
+    ag_string_view line, last = { NULL, 0 };
+    while (reader_next_line(r, &line)) last = line;
+    TEST_ASSERT(sv_equal(last, sv_from_cstr("tail")), "T1.7: append mode");
+    reader_close(r);
+}
+
+// =========================================================================
+// TEST 2: Line and record edge cases
+// =========================================================================
+static bool lines_are(const char *text, unsigned flags, const char **expect, int n) {
+    ag_writer *w = writer_open(path, 0);
+    writer_write(w, sv_from_buf(text, strlen(text)));
+    writer_close(w);
+    ag_reader *r = reader_open(path, flags);
+    ag_string_view line;
+    int i = 0;
+    bool ok = true;
+    for (; reader_next_line(r, &line); i++) ok &= i < n && sv_equal(line, sv_from_cstr(expect[i]));
+    reader_close(r);
+    return ok && i == n;
+}
+
+void test_edges() {
+    printf("\n--- Running Test 2: Line and record edge cases ---\n");
+    for (unsigned flags = 0; flags <= AG_READER_MMAP; flags += AG_READER_MMAP) {
+        const char *e1[] = { "x", "" };
+        const char *e2[] = { "a", "b\r" };
+        TEST_ASSERT(lines_are("", flags, NULL, 0), "T2.1: empty file has no lines");
+        TEST_ASSERT(lines_are("x\n\n", flags, e1, 2), "T2.2: final line end starts no line");
+        TEST_ASSERT(lines_are("a\r\nb\r", flags, e2, 2), "T2.3: CR kept without a line end");
+    }
+
+    ag_writer *w = writer_open(path, 0);
+    writer_write(w, sv_from_buf("k1\0v1\0\0last", 12));
+    writer_close(w);
+    TEST_ASSERT(file_holds("k1\0v1\0\0last", 12), "T2.4: writer keeps embedded NUL bytes");
+    ag_reader *r = reader_open(path, 0);
+    ag_string_view rec;
+    const char *e[] = { "k1", "v1", "", "last" };
+    int i = 0;
+    bool ok = true;
+    for (; reader_next_record(r, '\0', &rec); i++) ok &= i < 4 && sv_equal(rec, sv_from_cstr(e[i]));
+    TEST_ASSERT(ok && i == 4, "T2.5: NUL-delimited records");
+    reader_close(r);
+}
+
+// =========================================================================
+// TEST 3: Pipes and errors
+// =========================================================================
+void test_pipes_errors() {
+    printf("\n--- Running Test 3: Pipes and errors ---\n");
+    int fds[2];
+    int piped = pipe(fds);
+    assert(piped == 0);
+    (void)piped;
+    ag_writer *w = writer_from_fd(fds[1], 0);
+    writer_write_cstr(w, "one\ntwo\nthree");
+    writer_close(w);
+    close(fds[1]);
+
+    // A pipe cannot be mapped, the reader falls back to reads
+    ag_reader *r = reader_from_fd(fds[0], 0, AG_READER_MMAP);
+    ag_string_view line;
+    int n = 0;
+    while (reader_next_line(r, &line)) n++;
+    TEST_ASSERT(n == 3 && sv_equal(line, sv_from_cstr("three")), "T3.1: pipe input");
+    reader_close(r);
+    close(fds[0]);
+
+    errno = 0;
+    TEST_ASSERT(reader_open("/nonexistent/aegis", 0) == NULL && errno == ENOENT, "T3.2: missing file");
+
+    r = reader_from_fd(-1, 0, 0);
+    TEST_ASSERT(!reader_next_line(r, &line) && reader_error(r) == EBADF, "T3.3: read error is reported");
+    reader_close(r);
+
+    w = writer_from_fd(-1, 0);
+    TEST_ASSERT(writer_write_cstr(w, "buffered") && !writer_flush(w) && writer_error(w) == EBADF, "T3.4: write error on flush");
+    TEST_ASSERT(!writer_write_cstr(w, "more") && !writer_close(w), "T3.5: errors are sticky");
+
+    unlink(path);
+}
+
+// =========================================================================
+// MAIN TEST RUNNER
+// =========================================================================
+int main() {
+    test_round_trip();
+    test_edges();
+    test_pipes_errors();
+
+    printf("\n============================================\n");
+    printf("TEST SUITE SUMMARY:\n");
+    printf("Total Tests Run: %d\n", test_count);
+    printf("Tests Passed:    %d\n", test_count - fail_count);
+    printf("Tests Failed:    %d\n", fail_count);
+    printf("============================================\n");
+
+    if (fail_count > 0) {
+        printf("!!! WARNING: %d test(s) failed. Review the FAIL messages above. !!!\n", fail_count);
+        return EXIT_FAILURE;
+    } else {
+        printf("SUCCESS! All tests passed.\n");
+        return EXIT_SUCCESS;
+    }
+}
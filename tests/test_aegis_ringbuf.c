@@ -0,0 +1,231 @@
+#include "aegis_ringbuf.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+
+int test_count = 0;
+int fail_count = 0;
+
+#define TEST_ASSERT(condition, message) \
+    do { \
+        test_count++; \
+        if (!(condition)) { \
+            fail_count++; \
+            fprintf(stderr, "\n[FAIL] %s:%d: %s\n       Condition: %s\n", __FILE__, __LINE__, message, #condition); \
+        } else { \
+            printf("[PASS] %s\n", message); \
+        } \
+    } while (0)
+
+typedef struct {
+    uint32_t producer;
+    uint32_t seq;
+    char pad[20];
+} record;
+
+// =========================================================================
+// TEST 1: Single-threaded MPMC ring
+// =========================================================================
+void test_basic() {
+    printf("\n--- Running Test 1: Single-threaded MPMC ring ---\n");
+    ag_ringbuf *q = ringbuf_init(5, sizeof(int));
+    TEST_ASSERT(ringbuf_capacity(q) == 8, "T1.1: capacity rounds up to a power of two");
+    TEST_ASSERT(ringbuf_empty(q), "T1.2: new ring is empty");
+
+    int out;
+    TEST_ASSERT(!ringbuf_try_pop(q, &out), "T1.3: pop on an empty ring fails");
+
+    bool all = true;
+    for (int i = 0; i < 8; i++) all &= ringbuf_push(q, int, i * 10);
+    TEST_ASSERT(all && ringbuf_size(q) == 8, "T1.4: fills to capacity");
+    TEST_ASSERT(!ringbuf_push(q, int, 99), "T1.5: push on a full ring fails");
+
+    bool fifo = true;
+    // Several laps around the ring
+    for (int i = 0; i < 100; i++) {
+        fifo &= ringbuf_try_pop(q, &out) && out == i * 10;
+        fifo &= ringbuf_push(q, int, (i + 8) * 10);
+    }
+    TEST_ASSERT(fifo, "T1.6: FIFO order holds across laps");
+
+    int buf[16];
+    size_t got = ringbuf_pop_n(q, buf, 16);
+    bool ok = got == 8;
+    for (size_t i = 0; i < got; i++) ok &= buf[i] == (int)(100 + i) * 10;
+    TEST_ASSERT(ok && ringbuf_empty(q), "T1.7: pop_n drains at most what is there");
+
+    for (int i = 0; i < 16; i++) buf[i] = i;
+    TEST_ASSERT(ringbuf_push_n(q, buf, 5) == 5, "T1.8: push_n of 5");
+    TEST_ASSERT(ringbuf_push_n(q, buf + 5, 11) == 3, "T1.9: push_n stops at capacity");
+    got = ringbuf_pop_n(q, buf, 3);
+    ok = got == 3 && buf[0] == 0 && buf[1] == 1 && buf[2] == 2;
+    TEST_ASSERT(ok, "T1.10: pop_n keeps batch order");
+    TEST_ASSERT(ringbuf_size(q) == 5, "T1.11: size after partial drain");
+    ringbuf_clean(q);
+
+    // Odd-sized records
+    ag_ringbuf *r = ringbuf_init(4, 3);
+    char in[3] = { 'a', 'b', 'c' }, rec[3] = { 0 };
+    ringbuf_try_push(r, in);
+    TEST_ASSERT(ringbuf_try_pop(r, rec) && memcmp(in, rec, 3) == 0, "T1.12: 3-byte records round trip");
+    ringbuf_clean(r);
+}
+
+// =========================================================================
+// TEST 2: Single-threaded SPSC ring
+// =========================================================================
+void test_spsc_basic() {
+    printf("\n--- Running Test 2: Single-threaded SPSC ring ---\n");
+    ag_arena *arena = ag_arena_init(0);
+    ag_ringbuf *q = ringbuf_init_spsc_with_alloc(16, sizeof(double), &arena->allocator);
+    TEST_ASSERT(q->flags & AG_RING_SPSC, "T2.1: SPSC flag set");
+
+    double v[24], out[24];
+    for (int i = 0; i < 24; i++) v[i] = i + 0.5;
+
+    // Move the positions so the batches below wrap
+    for (int i = 0; i < 11; i++) ringbuf_try_push(q, &v[0]);
+    TEST_ASSERT(ringbuf_pop_n(q, out, 11) == 11, "T2.2: pop_n drains 11");
+
+    TEST_ASSERT(ringbuf_push_n(q, v, 24) == 16, "T2.3: push_n wraps and stops at capacity");
+    TEST_ASSERT(!ringbuf_push(q, double, 1.0), "T2.4: push on a full ring fails");
+    size_t got = ringbuf_pop_n(q, out, 24);
+    bool ok = got == 16;
+    for (size_t i = 0; i < got; i++) ok &= out[i] == v[i];
+    TEST_ASSERT(ok, "T2.5: wrapped batch comes out in order");
+    TEST_ASSERT(!ringbuf_try_pop(q, out), "T2.6: pop on an empty ring fails");
+
+    ringbuf_clean(q);
+    ag_arena_clean(arena);
+}
+
+// =========================================================================
+// TEST 3: Concurrent producers and consumers
+// =========================================================================
+#define PRODUCERS 4
+#define CONSUMERS 4
+#define PER_PRODUCER 50000
+
+typedef struct {
+    ag_ringbuf *q;
+    uint32_t id;
+    bool batch;
+    // Consumer results
+    size_t received;
+    uint64_t sum;
+    bool ordered;
+} worker_arg;
+
+static _Atomic size_t consumed_total;
+static size_t expected_total;
+
+static void *producer(void *p) {
+    worker_arg *a = (worker_arg*)p;
+    record batch[8];
+    uint32_t seq = 0;
+    while (seq < PER_PRODUCER) {
+        if (a->batch) {
+            size_t n = 0;
+            for (; n < 8 && seq + n < PER_PRODUCER; n++)
+                batch[n] = (record){ a->id, seq + (uint32_t)n, { 0 } };
+            size_t sent = ringbuf_push_n(a->q, batch, n);
+            seq += (uint32_t)sent;
+            if (sent == 0) sched_yield();
+        }
+        else {
+            record r = { a->id, seq, { 0 } };
+            if (ringbuf_try_push(a->q, &r)) seq++;
+            else sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static void *consumer(void *p) {
+    worker_arg *a = (worker_arg*)p;
+    uint32_t last[PRODUCERS];
+    for (int i = 0; i < PRODUCERS; i++) last[i] = UINT32_MAX;
+    record batch[8];
+    a->ordered = true;
+    while (atomic_load(&consumed_total) < expected_total) {
+        size_t got = a->batch ? ringbuf_pop_n(a->q, batch, 8) : ringbuf_try_pop(a->q, batch);
+        if (got == 0) {
+            sched_yield();
+            continue;
+        }
+        for (size_t i = 0; i < got; i++) {
+            record *r = &batch[i];
+            // Each producer's records reach any one consumer in push order
+            if (last[r->producer] != UINT32_MAX && r->seq <= last[r->producer]) a->ordered = false;
+            last[r->producer] = r->seq;
+            a->sum += r->seq;
+        }
+        a->received += got;
+        atomic_fetch_add(&consumed_total, got);
+    }
+    return NULL;
+}
+
+static bool run_threads(ag_ringbuf *q, int producers, int consumers, bool batch) {
+    pthread_t threads[PRODUCERS + CONSUMERS];
+    worker_arg args[PRODUCERS + CONSUMERS];
+    atomic_store(&consumed_total, 0);
+    expected_total = (size_t)producers * PER_PRODUCER;
+    for (int i = 0; i < producers + consumers; i++) {
+        args[i] = (worker_arg){ q, (uint32_t)i, batch, 0, 0, true };
+        pthread_create(&threads[i], NULL, i < producers ? producer : consumer, &args[i]);
+    }
+    for (int i = 0; i < producers + consumers; i++) pthread_join(threads[i], NULL);
+
+    size_t received = 0;
+    uint64_t sum = 0;
+    bool ordered = true;
+    for (int i = producers; i < producers + consumers; i++) {
+        received += args[i].received;
+        sum += args[i].sum;
+        ordered &= args[i].ordered;
+    }
+    uint64_t expect = (uint64_t)producers * PER_PRODUCER * (PER_PRODUCER - 1) / 2;
+    return received == (size_t)producers * PER_PRODUCER && sum == expect && ordered && ringbuf_empty(q);
+}
+
+void test_concurrent() {
+    printf("\n--- Running Test 3: Concurrent producers and consumers ---\n");
+    ag_ringbuf *q = ringbuf_init(64, sizeof(record));
+    TEST_ASSERT(run_threads(q, PRODUCERS, CONSUMERS, false), "T3.1: MPMC single ops deliver every record once");
+    TEST_ASSERT(run_threads(q, PRODUCERS, CONSUMERS, true), "T3.2: MPMC batches deliver every record once");
+    ringbuf_clean(q);
+
+    q = ringbuf_init_spsc(64, sizeof(record));
+    TEST_ASSERT(run_threads(q, 1, 1, false), "T3.3: SPSC single ops deliver every record in order");
+    TEST_ASSERT(run_threads(q, 1, 1, true), "T3.4: SPSC batches deliver every record in order");
+    ringbuf_clean(q);
+}
+
+// =========================================================================
+// MAIN TEST RUNNER
+// =========================================================================
+int main() {
+    test_basic();
+    test_spsc_basic();
+    test_concurrent();
+
+    printf("\n============================================\n");
+    printf("TEST SUITE SUMMARY:\n");
+    printf("Total Tests Run: %d\n", test_count);
+    printf("Tests Passed:    %d\n", test_count - fail_count);
+    printf("Tests Failed:    %d\n", fail_count);
+    printf("============================================\n");
+
+    if (fail_count > 0) {
+        printf("!!! WARNING: %d test(s) failed. Review the FAIL messages above. !!!\n", fail_count);
+        return EXIT_FAILURE;
+    } else {
+        printf("SUCCESS! All tests passed.\n");
+        return EXIT_SUCCESS;
+    }
+}
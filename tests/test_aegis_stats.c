@@ -0,0 +1,173 @@
+#include "aegis_vector.h"
+#include "aegis_string.h"
+#include "aegis_stats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <assert.h>
+
+int test_count = 0;
+int fail_count = 0;
+
+#define TEST_ASSERT(condition, message) \
+    do { \
+        test_count++; \
+        if (!(condition)) { \
+            fail_count++; \
+            fprintf(stderr, "\n[FAIL] %s:%d: %s\n       Condition: %s\n", __FILE__, __LINE__, message, #condition); \
+        } else { \
+            printf("[PASS] %s\n", message); \
+        } \
+    } while (0)
+
+// Dump into a buffer
+static char *dump_to_string(void) {
+    char *buf = NULL;
+    size_t len = 0;
+    FILE *out = open_memstream(&buf, &len);
+    ag_stats_dump(out);
+    fclose(out);
+    return buf;
+}
+
+#ifdef AEGIS_STATS
+
+typedef struct {
+    size_t grows;
+    size_t frees;
+    size_t copied_events;
+} hook_log;
+
+static void count_events(const ag_stats_event *ev, void *ctx) {
+    hook_log *log = (hook_log*)ctx;
+    log->grows += ev->kind == AG_STATS_GROW;
+    log->frees += ev->kind == AG_STATS_FREE;
+    log->copied_events += ev->copied;
+}
+
+// =========================================================================
+// TEST 1: Global and per-site counters
+// =========================================================================
+void test_counters() {
+    printf("\n--- Running Test 1: Global and per-site counters ---\n");
+    ag_stats_reset();
+    ag_stats_counters before = ag_stats_global();
+
+    vector *v = vec_init(0, int, false);
+    const ag_stats_site *site = v->site;
+    TEST_ASSERT(site != NULL && strcmp(site->file, __FILE__) == 0, "T1.1: vec_init records its call site");
+    TEST_ASSERT(site->counters.inits == 1, "T1.2: site counts the creation");
+
+    for (int i = 0; i < 1000; i++) vec_push_back(v, int, i);
+    uint64_t grows = site->counters.grows;
+    TEST_ASSERT(grows > 5 && grows < 20, "T1.3: geometric growth shows as a few grows");
+    TEST_ASSERT(site->counters.peak_capacity >= 1000 * sizeof(int), "T1.4: peak capacity in bytes");
+
+    vec_reserve(v, 5000);
+    TEST_ASSERT(site->counters.grows == grows + 1, "T1.5: reserve is one grow");
+    vec_shrink_to_fit(v);
+    TEST_ASSERT(site->counters.shrinks == 1, "T1.6: shrink_to_fit counts as a shrink");
+
+    vec_push_back(v, int, 1);
+    size_t unused = (v->capacity - v->size) * sizeof(int);
+    vec_clean(v);
+    TEST_ASSERT(site->counters.frees == 1 && site->counters.waste_at_free == unused, "T1.7: unused capacity at clean");
+    TEST_ASSERT(site->counters.live_bytes == 0, "T1.8: live bytes return to zero");
+
+    ag_stats_counters after = ag_stats_global();
+    TEST_ASSERT(after.inits - before.inits == 1 && after.grows - before.grows == site->counters.grows,
+                "T1.9: global counters include the site");
+    TEST_ASSERT(after.bytes_copied >= site->counters.bytes_copied, "T1.10: copy volume is tracked");
+
+    // Untagged strings count globally, ag_stats_tag attributes them
+    ag_string s = ag_stats_tag(new_string(""));
+    for (int i = 0; i < 100; i++) string_append(s, "0123456789");
+    TEST_ASSERT(s->site != NULL && s->site->counters.grows > 0, "T1.11: tagged string growth");
+    vec_clean(s);
+
+    // Re-tagging hands the live bytes over to the new site
+    vector *r = vec_init(16, int, false);
+    const ag_stats_site *first = r->site;
+    r = ag_stats_tag(r);
+    const ag_stats_site *second = r->site;
+    TEST_ASSERT(second != first && first->counters.live_bytes == 0
+                && second->counters.live_bytes == r->capacity * sizeof(int), "T1.12: re-tag moves live bytes");
+    for (int i = 0; i < 100; i++) vec_push_back(r, int, i);
+    vec_clean(r);
+    TEST_ASSERT(first->counters.live_bytes == 0 && second->counters.live_bytes == 0,
+                "T1.13: re-tagged vector frees against its new site");
+}
+
+// =========================================================================
+// TEST 2: Hooks and the report
+// =========================================================================
+void test_hook_and_dump() {
+    printf("\n--- Running Test 2: Hooks and the report ---\n");
+    hook_log log = { 0, 0, 0 };
+    ag_stats_set_hook(count_events, &log);
+
+    vector *v = vec_init(0, double, false);
+    for (int i = 0; i < 100; i++) vec_push_back(v, double, i);
+    size_t grows = v->site->counters.grows;
+    vec_clean(v);
+    ag_stats_set_hook(NULL, NULL);
+    TEST_ASSERT(log.grows == grows && log.frees == 1, "T2.1: hook sees every event");
+
+    vector *w = vec_init(0, double, false);
+    vec_push_back(w, double, 1.0);
+    vec_clean(w);
+    TEST_ASSERT(log.frees == 1, "T2.2: removed hook is not called");
+
+    char *report = dump_to_string();
+    TEST_ASSERT(strstr(report, "reallocations") != NULL, "T2.3: report has the global line");
+    TEST_ASSERT(strstr(report, "test_hook_and_dump") != NULL, "T2.4: report lists call sites");
+    free(report);
+
+    ag_stats_reset();
+    TEST_ASSERT(ag_stats_global().grows == 0, "T2.5: reset zeroes counters");
+}
+
+#else
+
+// =========================================================================
+// TEST 1: Disabled build
+// =========================================================================
+void test_counters() {
+    printf("\n--- Running Test 1: Disabled build ---\n");
+    vector *v = vec_init(0, int, false);
+    TEST_ASSERT(ag_stats_tag(v) == v, "T1.1: ag_stats_tag passes the vector through");
+    vec_clean(v);
+    TEST_ASSERT(ag_stats_global().inits == 0, "T1.2: counters stay zero");
+}
+
+void test_hook_and_dump() {
+    char *report = dump_to_string();
+    TEST_ASSERT(strstr(report, "disabled") != NULL, "T1.3: dump reports stats are off");
+    free(report);
+}
+
+#endif // AEGIS_STATS
+
+// =========================================================================
+// MAIN TEST RUNNER
+// =========================================================================
+int main() {
+    test_counters();
+    test_hook_and_dump();
+
+    printf("\n============================================\n");
+    printf("TEST SUITE SUMMARY:\n");
+    printf("Total Tests Run: %d\n", test_count);
+    printf("Tests Passed:    %d\n", test_count - fail_count);
+    printf("Tests Failed:    %d\n", fail_count);
+    printf("============================================\n");
+
+    if (fail_count > 0) {
+        printf("!!! WARNING: %d test(s) failed. Review the FAIL messages above. !!!\n", fail_count);
+        return EXIT_FAILURE;
+    } else {
+        printf("SUCCESS! All tests passed.\n");
+        return EXIT_SUCCESS;
+    }
+}
@@ -0,0 +1,254 @@
+#include "aegis_strbuilder.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <assert.h>
+
+int test_count = 0;
+int fail_count = 0;
+
+#define TEST_ASSERT(condition, message) \
+    do { \
+        test_count++; \
+        if (!(condition)) { \
+            fail_count++; \
+            fprintf(stderr, "\n[FAIL] %s:%d: %s\n       Condition: %s\n", __FILE__, __LINE__, message, #condition); \
+        } else { \
+            printf("[PASS] %s\n", message); \
+        } \
+    } while (0)
+
+// AVL shape, cached sizes and heights, and leaf bounds
+static bool rope_valid(const ag_rope *r) {
+    if (r == NULL) return true;
+    if (r->left == NULL) return r->height == 0 && r->size > 0 && r->size <= AG_ROPE_LEAF_BYTES;
+    uint32_t hl = r->left->height, hr = r->right->height;
+    return rope_valid(r->left) && rope_valid(r->right)
+        && r->size == r->left->size + r->right->size
+        && r->height == (hl > hr ? hl : hr) + 1
+        && (hl > hr ? hl - hr : hr - hl) <= 1;
+}
+
+static bool rope_equals(const ag_rope *r, const char *expect, size_t len) {
+    if (rope_size(r) != len) return false;
+    ag_string s = rope_to_string(r);
+    bool ok = s->size == len && memcmp(s->data, expect, len) == 0 && sget(s)[len] == '\0';
+    vec_clean(s);
+    return ok;
+}
+
+// =========================================================================
+// TEST 1: Builder appends
+// =========================================================================
+void test_builder() {
+    printf("\n--- Running Test 1: Builder appends ---\n");
+    ag_strbuilder *sb = strbuilder_init();
+    ag_string empty = strbuilder_to_string(sb);
+    TEST_ASSERT(empty->size == 0 && sget(empty)[0] == '\0', "T1.1: empty builder gives an empty string");
+    vec_clean(empty);
+
+    strbuilder_append(sb, "hello");
+    strbuilder_append_char(sb, ',');
+    strbuilder_append_view(sb, sv_from_cstr(" world"));
+    ag_string w = new_string("!!");
+    strbuilder_append_string(sb, w);
+    strbuilder_append_n(sb, "xyz", 1);
+    vec_clean(w);
+
+    ag_string s = strbuilder_to_string(sb);
+    TEST_ASSERT(strcmp(sget(s), "hello, world!!x") == 0, "T1.2: mixed appends in order");
+    TEST_ASSERT(strbuilder_size(sb) == s->size, "T1.3: size matches the built string");
+    TEST_ASSERT(s->capacity == s->size + 1 || s->size < AG_STRING_SSO_CAPACITY, "T1.4: result sized exactly");
+    vec_clean(s);
+
+    // Past several chunks, pieces straddling chunk ends
+    strbuilder_clear(sb);
+    TEST_ASSERT(strbuilder_size(sb) == 0, "T1.5: clear empties the builder");
+    size_t total = 300000;
+    char *expect = malloc(total);
+    size_t len = 0;
+    while (len < total) {
+        size_t piece = (len * 7 + 13) % 97 + 1;
+        if (len + piece > total) piece = total - len;
+        for (size_t i = 0; i < piece; i++) expect[len + i] = (char)('a' + (len + i) % 26);
+        if (piece == 1) strbuilder_append_char(sb, expect[len]);
+        else strbuilder_append_n(sb, expect + len, piece);
+        len += piece;
+    }
+    s = strbuilder_to_string(sb);
+    TEST_ASSERT(s->size == total && memcmp(s->data, expect, total) == 0, "T1.6: 300k bytes of small pieces");
+    TEST_ASSERT(s->capacity == total + 1, "T1.7: large result has no slack");
+    vec_clean(s);
+
+    // A single append larger than any chunk
+    strbuilder_clear(sb);
+    char *big = malloc(3 * AG_STRBUILDER_MAX_CHUNK);
+    memset(big, 'q', 3 * AG_STRBUILDER_MAX_CHUNK);
+    strbuilder_append_char(sb, '<');
+    strbuilder_append_n(sb, big, 3 * AG_STRBUILDER_MAX_CHUNK);
+    strbuilder_append_char(sb, '>');
+    s = strbuilder_to_string(sb);
+    bool ok = s->size == 3 * AG_STRBUILDER_MAX_CHUNK + 2 && sget(s)[0] == '<'
+        && sget(s)[s->size - 1] == '>' && memcmp(sget(s) + 1, big, 3 * AG_STRBUILDER_MAX_CHUNK) == 0;
+    TEST_ASSERT(ok, "T1.8: oversized append lands in one piece");
+    vec_clean(s);
+    free(big);
+    free(expect);
+    strbuilder_clean(sb);
+}
+
+// =========================================================================
+// TEST 2: Reserve and allocators
+// =========================================================================
+void test_reserve() {
+    printf("\n--- Running Test 2: Reserve and allocators ---\n");
+    ag_arena *arena = ag_arena_init(0);
+    ag_strbuilder *sb = strbuilder_init_with_alloc(&arena->allocator);
+    strbuilder_append(sb, "abc");
+    strbuilder_reserve(sb, 5000);
+    ag_sb_chunk *tail = sb->tail;
+    TEST_ASSERT(tail->capacity - tail->size >= 5000, "T2.1: reserve leaves room in the tail");
+    for (int i = 0; i < 5000; i++) strbuilder_append_char(sb, (char)('0' + i % 10));
+    TEST_ASSERT(sb->tail == tail, "T2.2: reserved appends add no chunk");
+
+    ag_string s = strbuilder_to_string(sb);
+    bool ok = s->size == 5003 && memcmp(s->data, "abc0123", 7) == 0 && sget(s)[5002] == '9';
+    TEST_ASSERT(ok && s->allocator == &arena->allocator, "T2.3: string uses the builder's allocator");
+
+    ag_string h = strbuilder_to_string_with_alloc(sb, &ag_default_allocator);
+    TEST_ASSERT(h->allocator == &ag_default_allocator && h->size == s->size, "T2.4: explicit result allocator");
+    vec_clean(h);
+    strbuilder_clean(sb);
+    ag_arena_clean(arena);
+}
+
+// =========================================================================
+// TEST 3: Rope concatenation
+// =========================================================================
+void test_rope_concat() {
+    printf("\n--- Running Test 3: Rope concatenation ---\n");
+    TEST_ASSERT(rope_from_buf("", 0) == NULL && rope_size(NULL) == 0, "T3.1: empty rope is NULL");
+
+    size_t n = 10 * AG_ROPE_LEAF_BYTES + 123;
+    char *text = malloc(2 * n);
+    for (size_t i = 0; i < 2 * n; i++) text[i] = (char)('A' + i % 23);
+    memcpy(text + n, text, n);
+
+    ag_rope *a = rope_from_buf(text, n);
+    TEST_ASSERT(rope_valid(a) && rope_equals(a, text, n), "T3.2: from_buf builds a balanced rope");
+
+    ag_rope *aa = rope_concat(a, a);
+    TEST_ASSERT(rope_valid(aa) && rope_equals(aa, text, 2 * n), "T3.3: concat with itself");
+    TEST_ASSERT(rope_equals(a, text, n), "T3.4: inputs survive concat");
+
+    // Many tiny appends: leaves merge and the tree stays balanced
+    ag_rope *acc = NULL;
+    char *expect = malloc(20000);
+    for (size_t i = 0; i < 20000; i++) {
+        expect[i] = (char)('a' + i % 26);
+        ag_rope *c = rope_from_buf(&expect[i], 1);
+        ag_rope *next = rope_concat(acc, c);
+        rope_release(acc);
+        rope_release(c);
+        acc = next;
+    }
+    TEST_ASSERT(rope_valid(acc) && rope_equals(acc, expect, 20000), "T3.5: 20000 one-byte concats");
+    TEST_ASSERT(acc->height < 40, "T3.6: height stays logarithmic");
+
+    // Long rope onto a short one and the other way round
+    ag_rope *small = rope_from_buf("xy", 2);
+    ag_rope *l = rope_concat(small, aa), *r = rope_concat(aa, small);
+    TEST_ASSERT(rope_valid(l) && rope_valid(r), "T3.7: uneven concats rebalance");
+    TEST_ASSERT(rope_at(l, 0) == 'x' && rope_at(l, 2) == text[0] && rope_at(r, 2 * n + 1) == 'y', "T3.8: rope_at");
+
+    rope_release(l);
+    rope_release(r);
+    rope_release(small);
+    rope_release(acc);
+    rope_release(aa);
+    rope_release(a);
+    free(expect);
+    free(text);
+}
+
+// =========================================================================
+// TEST 4: Rope slicing
+// =========================================================================
+void test_rope_slice() {
+    printf("\n--- Running Test 4: Rope slicing ---\n");
+    size_t n = 50000;
+    char *text = malloc(n);
+    for (size_t i = 0; i < n; i++) text[i] = (char)(' ' + (i * 31) % 90);
+    ag_rope *r = rope_from_buf(text, n);
+
+    bool ok = true;
+    size_t cases[][2] = { { 0, 10 }, { 5, 3000 }, { 1023, 2 }, { 1024, 1024 }, { 777, 40000 }, { 49990, 100 }, { 0, n } };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        size_t pos = cases[i][0], len = cases[i][1];
+        size_t clamped = len > n - pos ? n - pos : len;
+        ag_rope *s = rope_slice(r, pos, len);
+        ok &= rope_valid(s) && rope_equals(s, text + pos, clamped);
+        rope_release(s);
+    }
+    TEST_ASSERT(ok, "T4.1: slices match the text and stay balanced");
+    TEST_ASSERT(rope_slice(r, n, 5) == NULL, "T4.2: slice past the end is empty");
+
+    ag_rope *whole = rope_slice(r, 0, n);
+    TEST_ASSERT(whole == r && r->refs == 2, "T4.3: full slice shares the rope");
+    rope_release(whole);
+
+    // Cut and splice: text[0,1000) + text[30000,n)
+    ag_rope *head = rope_slice(r, 0, 1000), *rest = rope_slice(r, 30000, n);
+    ag_rope *spliced = rope_concat(head, rest);
+    char *expect = malloc(n);
+    memcpy(expect, text, 1000);
+    memcpy(expect + 1000, text + 30000, n - 30000);
+    TEST_ASSERT(rope_valid(spliced) && rope_equals(spliced, expect, 1000 + n - 30000), "T4.4: splice of two slices");
+
+    char buf[64];
+    size_t got = rope_copy(spliced, 990, 20, buf);
+    TEST_ASSERT(got == 20 && memcmp(buf, expect + 990, 20) == 0, "T4.5: rope_copy across the splice");
+    TEST_ASSERT(rope_copy(spliced, rope_size(spliced) - 3, 10, buf) == 3, "T4.6: rope_copy clamps");
+
+    rope_release(head);
+    rope_release(rest);
+    rope_release(spliced);
+
+    // Builder to rope
+    ag_strbuilder *sb = strbuilder_init();
+    for (size_t i = 0; i < n; i += 100) strbuilder_append_n(sb, text + i, 100);
+    ag_rope *br = strbuilder_to_rope(sb);
+    TEST_ASSERT(rope_valid(br) && rope_equals(br, text, n), "T4.7: strbuilder_to_rope");
+    rope_release(br);
+    strbuilder_clean(sb);
+
+    rope_release(r);
+    free(expect);
+    free(text);
+}
+
+// =========================================================================
+// MAIN TEST RUNNER
+// =========================================================================
+int main() {
+    test_builder();
+    test_reserve();
+    test_rope_concat();
+    test_rope_slice();
+
+    printf("\n============================================\n");
+    printf("TEST SUITE SUMMARY:\n");
+    printf("Total Tests Run: %d\n", test_count);
+    printf("Tests Passed:    %d\n", test_count - fail_count);
+    printf("Tests Failed:    %d\n", fail_count);
+    printf("============================================\n");
+
+    if (fail_count > 0) {
+        printf("!!! WARNING: %d test(s) failed. Review the FAIL messages above. !!!\n", fail_count);
+        return EXIT_FAILURE;
+    } else {
+        printf("SUCCESS! All tests passed.\n");
+        return EXIT_SUCCESS;
+    }
+}
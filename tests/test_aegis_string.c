@@ -0,0 +1,499 @@
+#include "aegis_string.h"
+#include "aegis_string_view.h"
+#include "aegis_search.h"
+#include "aegis_numparse.h"
+#include "aegis_numformat.h"
+#include "aegis_split.h"
+#include "aegis_utf8.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <math.h>
+
+int test_count = 0;
+int fail_count = 0;
+
+#define TEST_ASSERT(condition, message) \
+    do { \
+        test_count++; \
+        if (!(condition)) { \
+            fail_count++; \
+            fprintf(stderr, "\n[FAIL] %s:%d: %s\n       Condition: %s\n", __FILE__, __LINE__, message, #condition); \
+        } else { \
+            printf("[PASS] %s\n", message); \
+        } \
+    } while (0)
+
+// Helper to safely clean up a string after use
+void safe_str_clean(ag_string *str_ptr) {
+    if (*str_ptr) {
+        __vec_clean(*str_ptr);
+        *str_ptr = NULL;
+    }
+}
+
+// =========================================================================
+// TEST 1: Construction and small-string storage
+// =========================================================================
+void test_new_string() {
+    printf("\n--- Running Test 1: Construction ---\n");
+    ag_string s = new_string("key");
+    TEST_ASSERT(s->size == 3 && strcmp(sget(s), "key") == 0, "T1.1: new_string short value check");
+    TEST_ASSERT(s->flags & AG_VEC_INLINE, "T1.2: Short string stored inline");
+    TEST_ASSERT((char*)s->data > (char*)s && (char*)s->data < (char*)s + 128, "T1.3: Inline data sits behind the header");
+
+    ag_string e = new_string("");
+    TEST_ASSERT(e->size == 0 && sget(e)[0] == '\0', "T1.4: Empty string check");
+
+    const char *longstr = "this string is definitely longer than the inline buffer";
+    ag_string l = new_string(longstr);
+    TEST_ASSERT(!(l->flags & AG_VEC_INLINE), "T1.5: Long string stored on the heap");
+    TEST_ASSERT(l->size == strlen(longstr) && strcmp(sget(l), longstr) == 0, "T1.6: Long string value check");
+
+    safe_str_clean(&s);
+    safe_str_clean(&e);
+    safe_str_clean(&l);
+}
+
+// =========================================================================
+// TEST 2: Append across the inline / heap boundary
+// =========================================================================
+void test_append() {
+    printf("\n--- Running Test 2: Append ---\n");
+    ag_string s = new_string("abc");
+    string_append(s, "def");
+    TEST_ASSERT(s->size == 6 && strcmp(sget(s), "abcdef") == 0, "T2.1: Append within inline storage");
+    TEST_ASSERT(s->flags & AG_VEC_INLINE, "T2.2: Still inline after short append");
+
+    for (int i = 0; i < 10; i++) {
+        string_append(s, "0123456789");
+    }
+    TEST_ASSERT(s->size == 106, "T2.3: Size after spilling to heap (106)");
+    TEST_ASSERT(!(s->flags & AG_VEC_INLINE), "T2.4: Spilled to heap");
+    TEST_ASSERT(strncmp(sget(s), "abcdef0123", 10) == 0 && sget(s)[106] == '\0', "T2.5: Content and terminator after spill");
+    TEST_ASSERT(s->capacity > s->size, "T2.6: Capacity keeps room for terminator");
+    safe_str_clean(&s);
+
+    // Appending the string's own bytes while it grows
+    s = new_string("0123456789012345678901234567890123456789");
+    string_append_n(s, sget(s), s->size);
+    TEST_ASSERT(s->size == 80 && strncmp(sget(s) + 40, "0123456789", 10) == 0 && sget(s)[80] == '\0',
+                "T2.7: Self-append survives growth");
+    string_append_view(s, sv_slice(sv_from_string(s), 70, 10));
+    TEST_ASSERT(s->size == 90 && strcmp(sget(s) + 80, "0123456789") == 0, "T2.8: Appending a view of itself");
+    safe_str_clean(&s);
+}
+
+// =========================================================================
+// TEST 3: Substring, copy, rep and search
+// =========================================================================
+void test_sub_copy_find() {
+    printf("\n--- Running Test 3: Substring / Copy / Find ---\n");
+    ag_string s = new_string("hello, world");
+
+    ag_string sub = sub_string(s, 7, 100);
+    TEST_ASSERT(sub != NULL && strcmp(sget(sub), "world") == 0, "T3.1: sub_string clamps length");
+    TEST_ASSERT(sub_string(s, 50, 1) == NULL, "T3.2: sub_string out of range returns NULL");
+
+    ag_string rep = string_rep(s);
+    TEST_ASSERT(rep != s && strcmp(sget(rep), "hello, world") == 0, "T3.3: string_rep check");
+
+    ag_string dest = new_string("x");
+    string_copy(dest, s);
+    TEST_ASSERT(dest->size == s->size && strcmp(sget(dest), sget(s)) == 0, "T3.4: string_copy check");
+    string_ncopy(dest, sub, 3);
+    TEST_ASSERT(dest->size == 3 && strcmp(sget(dest), "wor") == 0, "T3.5: string_ncopy check");
+
+    char *found = find_substr(s, sub);
+    TEST_ASSERT(found == sget(s) + 7, "T3.6: find_substr check");
+
+    safe_str_clean(&s);
+    safe_str_clean(&sub);
+    safe_str_clean(&rep);
+    safe_str_clean(&dest);
+}
+
+// =========================================================================
+// TEST 4: Strings backed by an arena
+// =========================================================================
+void test_string_alloc() {
+    printf("\n--- Running Test 4: Strings with Allocators ---\n");
+    ag_arena *arena = ag_arena_init(4096);
+    ag_string s = new_string_with_alloc("arena", &arena->allocator);
+    string_append(s, " backed string that spills out of the inline buffer");
+    TEST_ASSERT(strncmp(sget(s), "arena backed", 12) == 0, "T4.1: Arena string append check");
+    ag_string sub = sub_string(s, 0, 5);
+    TEST_ASSERT(sub->allocator == &arena->allocator, "T4.2: Substring inherits allocator");
+    ag_arena_clean(arena);
+}
+
+// =========================================================================
+// TEST 5: Zero-copy string views
+// =========================================================================
+void test_string_view() {
+    printf("\n--- Running Test 5: String Views ---\n");
+    ag_string s = new_string("GET /index.html HTTP/1.1");
+    ag_string_view sv = sv_from_string(s);
+    TEST_ASSERT(sv.data == sget(s) && sv.size == s->size, "T5.1: View over ag_string shares its bytes");
+
+    ag_string_view method = sv_slice(sv, 0, sv_find_char(sv, ' '));
+    TEST_ASSERT(sv_equal(method, sv_from_cstr("GET")), "T5.2: slice + find_char check");
+    ag_string_view path = sv_slice(sv, 4, 11);
+    TEST_ASSERT(path.data == sget(s) + 4 && sv_equal(path, sv_from_cstr("/index.html")), "T5.3: slice points into source");
+    TEST_ASSERT(sv_slice(sv, 100, 5).size == 0, "T5.4: Out-of-range slice is empty");
+
+    TEST_ASSERT(sv_find(sv, sv_from_cstr("HTTP")) == 16, "T5.5: sv_find check");
+    TEST_ASSERT(sv_find(sv, sv_from_cstr("HTTPS")) == AG_NPOS, "T5.6: sv_find miss check");
+    TEST_ASSERT(sv_starts_with(sv, sv_from_cstr("GET ")) && sv_ends_with(sv, sv_from_cstr("1.1")), "T5.7: starts_with / ends_with");
+    TEST_ASSERT(!sv_starts_with(method, sv_from_cstr("GETX")), "T5.8: starts_with longer prefix");
+
+    TEST_ASSERT(sv_compare(sv_from_cstr("abc"), sv_from_cstr("abd")) < 0, "T5.9: compare less");
+    TEST_ASSERT(sv_compare(sv_from_cstr("abc"), sv_from_cstr("ab")) > 0, "T5.10: compare longer");
+    TEST_ASSERT(sv_compare(sv_from_buf("abcX", 3), sv_from_cstr("abc")) == 0, "T5.11: compare equal buffers");
+
+    TEST_ASSERT(sv_hash(method) == sv_hash(sv_from_cstr("GET")), "T5.12: hash depends only on bytes");
+    TEST_ASSERT(sv_hash(path) != sv_hash(method), "T5.13: hash differs for different bytes");
+
+    ag_string copy = string_from_view(path);
+    TEST_ASSERT(copy->size == 11 && strcmp(sget(copy), "/index.html") == 0, "T5.14: string_from_view materializes");
+    string_append_view(copy, sv_slice(sv, 15, 100));
+    TEST_ASSERT(strcmp(sget(copy), "/index.html HTTP/1.1") == 0, "T5.15: string_append_view check");
+
+    ag_string_view null_sv = sv_from_buf(NULL, 0);
+    TEST_ASSERT(sv_starts_with(null_sv, null_sv) && sv_ends_with(null_sv, null_sv)
+                && sv_starts_with(sv, null_sv) && !sv_ends_with(null_sv, method), "T5.16: empty prefix / suffix on NULL views");
+
+    safe_str_clean(&s);
+    safe_str_clean(&copy);
+}
+
+// =========================================================================
+// TEST 6: Substring search engine
+// =========================================================================
+void test_search() {
+    printf("\n--- Running Test 6: Search ---\n");
+    ag_string log = new_string("");
+    for (int i = 0; i < 200; i++) {
+        string_append(log, "INFO request ok; ");
+    }
+    string_append(log, "ERROR disk full; ");
+    for (int i = 0; i < 200; i++) {
+        string_append(log, "INFO request ok; ");
+    }
+    size_t error_at = 200 * 17;
+
+    TEST_ASSERT(string_find(log, sv_from_cstr("ERROR")) == error_at, "T6.1: Short needle (SIMD filter) find");
+    TEST_ASSERT(string_find(log, sv_from_cstr("ERROR disk full; INFO request ok; INFO")) == error_at, "T6.2: Long needle (Two-Way) find");
+    TEST_ASSERT(string_find(log, sv_from_cstr("WARN")) == AG_NPOS, "T6.3: Missing needle");
+    TEST_ASSERT(string_rfind(log, sv_from_cstr("INFO")) == log->size - 17, "T6.4: rfind check");
+    TEST_ASSERT(string_rfind(log, sv_from_cstr("E")) == error_at, "T6.5: Single byte rfind check");
+    TEST_ASSERT(string_count(log, sv_from_cstr("INFO")) == 400, "T6.6: count check");
+    TEST_ASSERT(sv_count(sv_from_cstr("aaaa"), sv_from_cstr("aa")) == 2, "T6.7: count is non-overlapping");
+
+    vector *hits = vec_init(0, size_t, false);
+    size_t n = string_find_all(log, sv_from_cstr("ok;"), hits);
+    TEST_ASSERT(n == 400 && hits->size == 400, "T6.8: find_all count check");
+    TEST_ASSERT(vec_at(hits, size_t, 0) == 13 && vec_at(hits, size_t, 200) == error_at + 17 + 13, "T6.9: find_all offsets check");
+    __vec_clean(hits);
+
+    // Periodic needle against a periodic haystack
+    ag_string a = new_string("");
+    for (int i = 0; i < 100; i++) string_append(a, "abababababababababababababababababababab");
+    string_append(a, "c");
+    ag_string_view needle = sv_from_cstr("ababababababababababababababababababababc");
+    TEST_ASSERT(string_find(a, needle) == a->size - needle.size, "T6.10: Periodic long needle check");
+
+    // Embedded NUL bytes are searched like any other byte
+    ag_string_view bin = sv_from_buf("ab\0cd\0ef", 8);
+    TEST_ASSERT(sv_find(bin, sv_from_buf("\0ef", 3)) == 5, "T6.11: Search past embedded NUL");
+
+    safe_str_clean(&log);
+    safe_str_clean(&a);
+}
+
+// =========================================================================
+// TEST 7: Numeric parsing
+// =========================================================================
+void test_numeric_parse() {
+    printf("\n--- Running Test 7: Numeric Parsing ---\n");
+    ag_string s = new_string("  -123456789012,rest");
+    TEST_ASSERT(sto_ll(s) == -123456789012LL, "T7.1: sto_ll check");
+
+    long long ll = 0;
+    ag_parse_result r = sv_parse_ll(sv_from_string(s), &ll);
+    TEST_ASSERT(r.status == AG_PARSE_OK && r.consumed == 15, "T7.2: consumed count includes whitespace and sign");
+
+    int i = 0;
+    r = sv_parse_int(sv_from_cstr("99999999999"), &i);
+    TEST_ASSERT(r.status == AG_PARSE_OVERFLOW && i == 2147483647, "T7.3: int overflow is reported and clamped");
+    r = sv_parse_int(sv_from_cstr("abc"), &i);
+    TEST_ASSERT(r.status == AG_PARSE_INVALID && r.consumed == 0, "T7.4: invalid input check");
+
+    uint64_t u = 0;
+    r = sv_parse_u64(sv_from_cstr("18446744073709551615"), &u);
+    TEST_ASSERT(r.status == AG_PARSE_OK && u == UINT64_MAX, "T7.5: u64 max check (SWAR path)");
+    r = sv_parse_u64(sv_from_cstr("18446744073709551616"), &u);
+    TEST_ASSERT(r.status == AG_PARSE_OVERFLOW, "T7.6: u64 overflow check");
+
+    double d = 0;
+    r = sv_parse_d(sv_from_cstr("3.14159265358979323846;"), &d);
+    TEST_ASSERT(r.status == AG_PARSE_OK && r.consumed == 22 && d == 3.14159265358979323846, "T7.7: double with >19 digits");
+    r = sv_parse_d(sv_from_cstr("1e-310"), &d);
+    TEST_ASSERT(d == 1e-310, "T7.8: subnormal double");
+    r = sv_parse_d(sv_from_cstr("-1e400"), &d);
+    TEST_ASSERT(r.status == AG_PARSE_OVERFLOW && isinf(d) && d < 0, "T7.9: double overflow gives -inf");
+    r = sv_parse_d(sv_from_cstr("12e+x"), &d);
+    TEST_ASSERT(r.consumed == 2 && d == 12.0, "T7.10: dangling exponent is not consumed");
+
+    ag_string f = new_string("0.1");
+    TEST_ASSERT(sto_f(f) == 0.1f && sto_d(f) == 0.1 && sto_ld(f) == 0.1L, "T7.11: sto_f / sto_d / sto_ld check");
+    ag_string n = new_string("nope");
+    TEST_ASSERT(sto_int(n) == 0, "T7.12: sto_int returns 0 without a number");
+
+    safe_str_clean(&s);
+    safe_str_clean(&f);
+    safe_str_clean(&n);
+}
+
+// =========================================================================
+// TEST 8: Number formatting
+// =========================================================================
+void test_numeric_format() {
+    printf("\n--- Running Test 8: Number formatting ---\n");
+
+    ag_string s = new_string("");
+    string_append_int(s, -9223372036854775807LL - 1);
+    TEST_ASSERT(strcmp(sget(s), "-9223372036854775808") == 0, "T8.1: append_int handles LLONG_MIN");
+
+    ag_string u = new_string("n=");
+    string_append_u64(u, 0);
+    string_append(u, ",");
+    string_append_u64(u, 18446744073709551615ull);
+    TEST_ASSERT(strcmp(sget(u), "n=0,18446744073709551615") == 0, "T8.2: append_u64 zero and UINT64_MAX");
+
+    const struct { double v; const char *text; } cases[] = {
+        { 0.0, "0.0" }, { -0.0, "-0.0" }, { 1.0, "1.0" }, { 0.1, "0.1" },
+        { -2.5, "-2.5" }, { 1e-4, "0.0001" }, { 1.5e-7, "1.5e-7" },
+        { 1e21, "1e21" }, { 5e-324, "5e-324" },
+        { 1.7976931348623157e308, "1.7976931348623157e308" },
+        { INFINITY, "inf" }, { -INFINITY, "-inf" }, { NAN, "nan" },
+    };
+    bool all_ok = true;
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        ag_string d = new_string("");
+        string_append_double(d, cases[i].v);
+        if (strcmp(sget(d), cases[i].text) != 0) all_ok = false;
+        safe_str_clean(&d);
+    }
+    TEST_ASSERT(all_ok, "T8.3: append_double shortest forms and specials");
+
+    double values[] = { 3.141592653589793, 2.2250738585072014e-308, 123456.789, 9007199254740993.0 };
+    all_ok = true;
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        char buf[AG_FORMAT_DOUBLE_MAX + 1];
+        buf[ag_format_double(buf, values[i])] = '\0';
+        if (strtod(buf, NULL) != values[i]) all_ok = false;
+    }
+    TEST_ASSERT(all_ok, "T8.4: ag_format_double round-trips through strtod");
+
+    ag_string f = new_string("x");
+    string_appendf(f, "%d-%s", 42, "abc");
+    TEST_ASSERT(strcmp(sget(f), "x42-abc") == 0 && f->size == 7, "T8.5: appendf within capacity");
+    string_appendf(f, "%0100d", 7);
+    TEST_ASSERT(f->size == 107 && sget(f)[106] == '7' && sget(f)[107] == '\0', "T8.6: appendf grows once for long output");
+
+    safe_str_clean(&s);
+    safe_str_clean(&u);
+    safe_str_clean(&f);
+}
+
+// =========================================================================
+// TEST 9: Split, lines and join
+// =========================================================================
+static bool tokens_are(ag_string_view src, vector *toks, const char **expect, size_t n) {
+    if (toks->size != n) return false;
+    for (size_t i = 0; i < n; i++)
+        if (!sv_equal(sv_token(src, vec_at(toks, ag_token, i)), sv_from_cstr(expect[i]))) return false;
+    return true;
+}
+
+void test_split() {
+    printf("\n--- Running Test 9: Split, lines and join ---\n");
+    vector *toks = vec_init(0, ag_token, false);
+
+    ag_string csv = new_string("a,bb,,ccc,");
+    const char *e1[] = { "a", "bb", "", "ccc", "" };
+    TEST_ASSERT(string_split(csv, sv_from_cstr(","), 0, toks) == 5, "T9.1: split keeps empty tokens");
+    TEST_ASSERT(tokens_are(sv_from_string(csv), toks, e1, 5), "T9.2: split token contents");
+    toks->size = 0;
+    const char *e2[] = { "a", "bb", "ccc" };
+    string_split(csv, sv_from_cstr(","), AG_SPLIT_SKIP_EMPTY, toks);
+    TEST_ASSERT(tokens_are(sv_from_string(csv), toks, e2, 3), "T9.3: AG_SPLIT_SKIP_EMPTY");
+    TEST_ASSERT(sv_split(sv_from_cstr(""), sv_from_cstr(","), 0, NULL) == 1, "T9.4: empty text is one empty token");
+
+    toks->size = 0;
+    ag_string_view multi = sv_from_cstr("k1::v1::::v3");
+    const char *e3[] = { "k1", "v1", "", "v3" };
+    sv_split(multi, sv_from_cstr("::"), 0, toks);
+    TEST_ASSERT(tokens_are(multi, toks, e3, 4), "T9.5: multi-byte delimiter");
+
+    // Delimiter set across several 64-byte blocks, bytes above 0x7f included
+    ag_string text = new_string("");
+    ag_string expect_join = new_string("");
+    for (int i = 0; i < 300; i++) {
+        char word[16];
+        int len = snprintf(word, sizeof(word), "w%d", i);
+        string_append_n(text, word, (size_t)len);
+        string_append(text, (i % 3 == 0) ? " " : (i % 3 == 1) ? "\t\xff" : ";");
+        if (i > 0) string_append(expect_join, "|");
+        string_append_n(expect_join, word, (size_t)len);
+    }
+    toks->size = 0;
+    size_t n = string_split_any(text, sv_from_buf(" \t;\xff", 4), AG_SPLIT_SKIP_EMPTY, toks);
+    TEST_ASSERT(n == 300, "T9.6: split_any over a byte set");
+    ag_string joined = sv_join_tokens(sv_from_string(text), toks, sv_from_cstr("|"));
+    TEST_ASSERT(strcmp(sget(joined), sget(expect_join)) == 0, "T9.7: join_tokens round trip");
+    TEST_ASSERT(string_split_any(text, sv_from_cstr("#"), 0, NULL) == 1, "T9.8: no delimiter is one token");
+
+    ag_byte_set set;
+    byte_set_init(&set, sv_from_buf("\x00\x7f\x80\xff" "A", 5));
+    bool exact = true;
+    for (int b = 0; b < 256; b++)
+        exact &= byte_set_has(&set, (unsigned char)b) == (b == 0 || b == 0x7f || b == 0x80 || b == 0xff || b == 'A');
+    TEST_ASSERT(exact, "T9.9: byte sets are exact");
+
+    // Lines
+    toks->size = 0;
+    ag_string_view doc = sv_from_cstr("one\r\ntwo\n\nfour\n");
+    const char *e4[] = { "one", "two", "", "four" };
+    TEST_ASSERT(sv_lines(doc, toks) == 4 && tokens_are(doc, toks, e4, 4), "T9.10: lines strip CR and ignore the final LF");
+    TEST_ASSERT(sv_lines(sv_from_cstr("last"), NULL) == 1 && sv_lines(sv_from_cstr(""), NULL) == 0, "T9.11: lines edge cases");
+
+    // Streaming iterator on a long text
+    ag_string big = new_string("");
+    for (int i = 0; i < 1000; i++) string_append(big, (i % 7) ? "a line of text\n" : "\n");
+    ag_split_iter it;
+    ag_string_view line;
+    size_t lines = 0, empty = 0;
+    split_iter_init_lines(&it, sv_from_string(big));
+    while (split_next(&it, &line)) {
+        lines++;
+        empty += line.size == 0;
+    }
+    TEST_ASSERT(lines == 1000 && empty == 143, "T9.12: streaming lines");
+
+    // Join views
+    vector *parts = vec_init(0, ag_string_view, false);
+    vec_push_back(parts, ag_string_view, sv_from_cstr("x"));
+    vec_push_back(parts, ag_string_view, sv_from_cstr(""));
+    vec_push_back(parts, ag_string_view, sv_from_cstr("yz"));
+    ag_string j = string_join(parts, sv_from_cstr(", "));
+    TEST_ASSERT(strcmp(sget(j), "x, , yz") == 0 && j->size == 7, "T9.13: join views");
+    parts->size = 0;
+    ag_string none = string_join(parts, sv_from_cstr(", "));
+    TEST_ASSERT(none->size == 0, "T9.14: join of nothing");
+
+    safe_str_clean(&none);
+    safe_str_clean(&j);
+    safe_str_clean(&big);
+    safe_str_clean(&joined);
+    safe_str_clean(&expect_join);
+    safe_str_clean(&text);
+    safe_str_clean(&csv);
+    __vec_clean(parts);
+    __vec_clean(toks);
+}
+
+// =========================================================================
+// TEST 10: UTF-8 validation, indexing and transcoding
+// =========================================================================
+void test_utf8() {
+    printf("\n--- Running Test 10: UTF-8 validation, indexing and transcoding ---\n");
+    // 1, 2, 3 and 4 byte sequences
+    ag_string s = new_string("a\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80z");
+    TEST_ASSERT(string_validate_utf8(s) && string_utf8_length(s) == 5, "T10.1: valid text and code point count");
+    ag_string_view mid = string_utf8_slice(s, 1, 3);
+    TEST_ASSERT(sv_equal(mid, sv_from_cstr("\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80")), "T10.2: slice by code points");
+    TEST_ASSERT(sv_utf8_offset(sv_from_string(s), 5) == s->size && sv_utf8_offset(sv_from_string(s), 6) == AG_NPOS,
+                "T10.3: offset of the end and past it");
+    size_t pos = 3;
+    TEST_ASSERT(sv_utf8_decode(sv_from_string(s), &pos) == 0x20AC && pos == 6, "T10.4: decode one code point");
+
+    // Ill-formed input
+    const char *bad[] = { "\xc0\xaf", "\xe0\x80\xaf", "\xed\xa0\x80", "\xf4\x90\x80\x80", "\xf5\x80\x80\x80",
+                          "\x80", "\xc3", "\xe2\x82", "\xc3\xa9\xa9", "\xff" };
+    bool rejected = true;
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) rejected &= !sv_utf8_valid(sv_from_cstr(bad[i]));
+    TEST_ASSERT(rejected, "T10.5: overlongs, surrogates, out of range and truncated sequences are rejected");
+
+    // Long text, so the vector kernels see many blocks and the error lands mid-block
+    ag_string text = new_string("");
+    for (int i = 0; i < 200; i++) string_append(text, (i % 5) ? "plain ascii words " : "\xce\xb1\xce\xb2\xe4\xb8\xad\xf0\x9f\x8e\x89 ");
+    ag_string_view tv = sv_from_string(text);
+    TEST_ASSERT(sv_utf8_valid(tv) && sv_utf8_error(tv) == AG_NPOS, "T10.6: long valid text");
+    TEST_ASSERT(sv_utf8_length(tv) == 160 * 18 + 40 * 5, "T10.7: long text length");
+    char saved = sget(text)[1001];
+    sget(text)[1001] = (char)0xe4;
+    TEST_ASSERT(sv_utf8_error(tv) == 1001, "T10.8: offset of the first error");
+    sget(text)[1001] = saved;
+    sget(text)[text->size - 1] = (char)0xf0;
+    TEST_ASSERT(sv_utf8_error(tv) == text->size - 1, "T10.9: sequence cut off by the end");
+    sget(text)[text->size - 1] = ' ';
+
+    // Transcoding round trips
+    vector *w = vec_init(0, uint16_t, false);
+    TEST_ASSERT(string_to_utf16(s, w) == 6 && w->size == 6, "T10.10: astral code point takes a surrogate pair");
+    TEST_ASSERT(vec_at(w, uint16_t, 3) == 0xD83D && vec_at(w, uint16_t, 4) == 0xDE00, "T10.11: surrogate pair values");
+    ag_string back = string_from_utf16((uint16_t*)w->data, w->size);
+    TEST_ASSERT(back != NULL && strcmp(sget(back), sget(s)) == 0, "T10.12: UTF-16 round trip");
+
+    vector *u = vec_init(0, uint32_t, false);
+    string_to_utf32(text, u);
+    ag_string back32 = string_from_utf32((uint32_t*)u->data, u->size);
+    TEST_ASSERT(u->size == sv_utf8_length(tv) && strcmp(sget(back32), sget(text)) == 0, "T10.13: UTF-32 round trip");
+
+    uint16_t lone[] = { 'a', 0xD800, 'b' };
+    uint32_t big[] = { 0x110000 };
+    TEST_ASSERT(string_from_utf16(lone, 3) == NULL && string_from_utf32(big, 1) == NULL, "T10.14: ill-formed UTF-16/32 input");
+    TEST_ASSERT(sv_to_utf16(sv_from_cstr("ab\xc3"), w) == AG_NPOS && w->size == 6, "T10.15: ill-formed UTF-8 leaves the vector unchanged");
+
+    safe_str_clean(&back32);
+    safe_str_clean(&back);
+    safe_str_clean(&text);
+    safe_str_clean(&s);
+    __vec_clean(u);
+    __vec_clean(w);
+}
+
+// =========================================================================
+// MAIN TEST RUNNER
+// =========================================================================
+int main() {
+    test_new_string();
+    test_append();
+    test_sub_copy_find();
+    test_string_alloc();
+    test_string_view();
+    test_search();
+    test_numeric_parse();
+    test_numeric_format();
+    test_split();
+    test_utf8();
+
+    printf("\n============================================\n");
+    printf("TEST SUITE SUMMARY:\n");
+    printf("Total Tests Run: %d\n", test_count);
+    printf("Tests Passed:    %d\n", test_count - fail_count);
+    printf("Tests Failed:    %d\n", fail_count);
+    printf("============================================\n");
+
+    if (fail_count > 0) {
+        printf("!!! WARNING: %d test(s) failed. Review the FAIL messages above. !!!\n", fail_count);
+        return EXIT_FAILURE;
+    } else {
+        printf("SUCCESS! All tests passed.\n");
+        return EXIT_SUCCESS;
+    }
+}
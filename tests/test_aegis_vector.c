@@ -1,9 +1,13 @@
 #include "aegis_vector.h"
+#include "aegis_typed_vector.h"
+#include "aegis_sort.h"
+#include "aegis_threadpool.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
 #include <assert.h>
+#include <unistd.h>
 
 // --- Mock Utilities for independent compilation ---
 // Assuming aegis_utils.h defines these
@@ -283,6 +287,460 @@ void test_edge_cases() {
 }
 
 
+// =========================================================================
+// TEST 7: Type-specialized vectors (AG_VECTOR_DEFINE)
+// =========================================================================
+AG_VECTOR_DEFINE(int)
+AG_VECTOR_DEFINE_NAMED(ag_vec_test, TestData)
+
+void test_typed_vector() {
+    printf("\n--- Running Test 7: Typed Vectors ---\n");
+    ag_vec_int *v = ag_vec_int_init(0, false);
+
+    // 1. Push past the default capacity through the typed fast path
+    for (int i = 0; i < 100; i++) {
+        ag_vec_int_push_back(v, i);
+    }
+    TEST_ASSERT(v->size == 100, "T7.1: Typed push_back size check (100)");
+    TEST_ASSERT(v->capacity >= 100, "T7.2: Typed push_back capacity check (>=100)");
+    TEST_ASSERT(ag_vec_int_at(v, 99) == 99 && v->data[0] == 0, "T7.3: Typed push_back value check");
+
+    // 2. Insert / erase, including insert at size (append)
+    ag_vec_int_insert(v, 0, -1);
+    ag_vec_int_insert(v, v->size, 1000);
+    TEST_ASSERT(v->size == 102, "T7.4: Typed insert size check (102)");
+    TEST_ASSERT(v->data[0] == -1 && v->data[1] == 0 && v->data[101] == 1000, "T7.5: Typed insert value check");
+    ag_vec_int_erase(v, 0);
+    TEST_ASSERT(v->size == 101 && v->data[0] == 0, "T7.6: Typed erase front check");
+
+    // 3. Fill stops at size
+    ag_vec_int_fill(v, 90, 500, 7);
+    TEST_ASSERT(v->data[89] == 89 && v->data[90] == 7 && v->data[100] == 7, "T7.7: Typed fill range check");
+
+    // 4. Interop with the generic API
+    vector *gv = ag_vec_int_as_vector(v);
+    vec_push_back(gv, int, 1234);
+    TEST_ASSERT(ag_vec_int_at(v, 101) == 1234, "T7.8: Generic push_back visible through typed vector");
+    __vec_shrink_to_fit(gv);
+    TEST_ASSERT(v->capacity == v->size, "T7.9: Generic shrink_to_fit on typed vector");
+    ag_vec_int_clean(v);
+
+    // 5. Growth after shrinking an empty vector to zero capacity
+    ag_vec_test *t = ag_vec_test_init(0, false);
+    __vec_shrink_to_fit(ag_vec_test_as_vector(t));
+    TestData d = {7, 7.5f, "Seven"};
+    ag_vec_test_push_back(t, d);
+    TEST_ASSERT(t->size == 1 && t->capacity >= 1, "T7.10: Typed push_back after shrink to zero");
+    TEST_ASSERT(ag_vec_test_at_ptr(t, 0)->id == 7, "T7.11: Typed struct element check");
+    ag_vec_test_clean(t);
+}
+
+// =========================================================================
+// TEST 8: Vectors backed by arena / pool allocators
+// =========================================================================
+void test_allocators() {
+    printf("\n--- Running Test 8: Allocators ---\n");
+
+    // 1. Arena: many vectors, released together by a reset
+    ag_arena *arena = ag_arena_init(1024);
+    vector *a = vec_init_with_alloc(0, int, false, &arena->allocator);
+    vector *b = vec_init_with_alloc(4, int, true, &arena->allocator);
+    TEST_ASSERT(a->allocator == &arena->allocator, "T8.1: vec_init_with_alloc stores the allocator");
+    TEST_ASSERT(vec_at(b, int, 3) == 0, "T8.2: Arena set_zero check");
+    for (int i = 0; i < 1000; i++) {
+        vec_push_back(a, int, i);
+    }
+    TEST_ASSERT(a->size == 1000 && vec_at(a, int, 999) == 999 && vec_at(a, int, 0) == 0, "T8.3: Arena growth keeps data");
+    vec_push_back(b, int, 5);
+    TEST_ASSERT(vec_at(b, int, 4) == 5, "T8.4: Second arena vector intact");
+    ag_arena_reset(arena);
+    vector *c = vec_init_with_alloc(2, long, true, &arena->allocator);
+    TEST_ASSERT(c->size == 2 && vec_at(c, long, 1) == 0, "T8.5: Arena reuse after reset");
+    ag_arena_clean(arena);
+
+    // 2. Pool: headers and small buffers come from fixed-size blocks
+    ag_pool *pool = ag_pool_init(64, 32);
+    vector *p = vec_init_with_alloc(0, int, false, &pool->allocator);
+    for (int i = 0; i < 100; i++) {
+        vec_push_back(p, int, i * 2);
+    }
+    TEST_ASSERT(p->size == 100 && vec_at(p, int, 50) == 100, "T8.6: Pool vector grows past block size");
+    __vec_clean(p);
+    vector *q = vec_init_with_alloc(0, char, false, &pool->allocator);
+    vec_push_back(q, char, 'x');
+    TEST_ASSERT(q->size == 1 && vec_at(q, char, 0) == 'x', "T8.7: Pool block reuse after clean");
+    __vec_clean(q);
+    ag_pool_clean(pool);
+}
+
+// =========================================================================
+// TEST 9: Large-vector (mmap-backed) growth
+// =========================================================================
+void test_large_vector_mode() {
+    printf("\n--- Running Test 9: Large-Vector Mode ---\n");
+    vec_set_mmap_threshold(1 << 20); // 1 MiB, keep the test small
+
+    vector *v = vec_init(0, long, false);
+    for (long i = 0; i < (1 << 18); i++) {
+        vec_push_back(v, long, i);
+    }
+    TEST_ASSERT(v->flags & AG_VEC_MMAPPED, "T9.1: Vector switched to mmap storage past threshold");
+    TEST_ASSERT(v->size == (1 << 18), "T9.2: Size check after mmap growth");
+    TEST_ASSERT(vec_at(v, long, 0) == 0 && vec_at(v, long, (1 << 18) - 1) == (1 << 18) - 1, "T9.3: Data survives the heap to mmap switch");
+    vec_insert(v, 1, long, -1);
+    TEST_ASSERT(vec_at(v, long, 1) == -1 && vec_at(v, long, 2) == 1, "T9.4: Insert on mmap-backed vector");
+    __vec_shrink_to_fit(v);
+    TEST_ASSERT(v->capacity >= v->size && vec_at(v, long, (1 << 18)) == (1 << 18) - 1, "T9.5: Shrink keeps data on mmap-backed vector");
+    safe_vec_clean(&v);
+
+    vector *z = vec_init(1 << 20, int, true);
+    TEST_ASSERT((z->flags & AG_VEC_MMAPPED) && vec_at(z, int, 12345) == 0, "T9.6: Large vec_init starts mmap-backed and zeroed");
+    safe_vec_clean(&z);
+
+    vec_set_mmap_threshold(AG_VEC_MMAP_THRESHOLD);
+}
+
+// =========================================================================
+// TEST 10: Range operations
+// =========================================================================
+static bool is_odd(const void *elem, void *ctx) {
+    (void)ctx;
+    return (*(const int*)elem) % 2 != 0;
+}
+
+void test_range_operations() {
+    printf("\n--- Running Test 10: Range Operations ---\n");
+    int src[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    vector *v = vec_init(0, int, false);
+
+    // 1. push_back_n grows once and copies the whole array
+    vec_push_back_n(v, src, 10);
+    TEST_ASSERT(v->size == 10 && vec_at(v, int, 9) == 9, "T10.1: push_back_n size and value check");
+
+    // 2. insert_range in the middle and at the end
+    int mid[] = {100, 101, 102};
+    vec_insert_range(v, 2, mid, 3);
+    // Expected: [0, 1, 100, 101, 102, 2, ...]
+    TEST_ASSERT(v->size == 13, "T10.2: insert_range size check (13)");
+    TEST_ASSERT(vec_at(v, int, 2) == 100 && vec_at(v, int, 4) == 102 && vec_at(v, int, 5) == 2, "T10.3: insert_range shift check");
+    vec_insert_range(v, v->size, mid, 1);
+    TEST_ASSERT(vec_at(v, int, 13) == 100, "T10.4: insert_range at size appends");
+
+    // 3. erase_range removes [begin, end)
+    vec_erase_range(v, 2, 5);
+    TEST_ASSERT(v->size == 11 && vec_at(v, int, 2) == 2, "T10.5: erase_range check");
+    vec_erase_range(v, 10, 50);
+    TEST_ASSERT(v->size == 10 && vec_at(v, int, 9) == 9, "T10.6: erase_range clamps to size");
+
+    // 4. append, including self-append which grows the source buffer
+    vector *w = vec_init(0, int, false);
+    vec_append(w, v);
+    vec_append(w, w);
+    TEST_ASSERT(w->size == 20 && vec_at(w, int, 19) == 9 && vec_at(w, int, 10) == 0, "T10.7: append / self-append check");
+
+    // 5. insert_range from the vector's own storage
+    vec_insert_range(w, 0, vec_at_ptr(w, int, 18), 2);
+    TEST_ASSERT(w->size == 22 && vec_at(w, int, 0) == 8 && vec_at(w, int, 1) == 9 && vec_at(w, int, 2) == 0, "T10.8: Aliased insert_range check");
+
+    // 6. erase_if keeps order
+    size_t removed = vec_erase_if(v, is_odd, NULL);
+    TEST_ASSERT(removed == 5 && v->size == 5, "T10.9: erase_if removed count check");
+    TEST_ASSERT(vec_at(v, int, 0) == 0 && vec_at(v, int, 2) == 4 && vec_at(v, int, 4) == 8, "T10.10: erase_if order check");
+
+    // 7. Doubling fill over an odd-length range
+    vec_fill(w, 1, 22, int, 7);
+    TEST_ASSERT(vec_at(w, int, 0) == 8 && vec_at(w, int, 1) == 7 && vec_at(w, int, 21) == 7, "T10.11: fill range check");
+
+    safe_vec_clean(&v);
+    safe_vec_clean(&w);
+}
+
+// =========================================================================
+// TEST 11: Sorting and searching
+// =========================================================================
+typedef struct { int score; int id; } ranked;
+#define RANKED_BY_SCORE(a, b) ((a).score > (b).score)
+AG_SORT_DEFINE(by_score, ranked, RANKED_BY_SCORE)
+
+void test_sorting() {
+    printf("\n--- Running Test 11: Sorting and Searching ---\n");
+    vector *v = vec_init(0, int, false);
+    unsigned seed = 12345;
+    for (int i = 0; i < 1000; i++) {
+        seed = seed * 1103515245u + 12345u;
+        vec_push_back(v, int, (int)(seed >> 16) % 100);
+    }
+
+    vec_sort(v, ag_sort_int);
+    bool sorted = true;
+    for (size_t i = 1; i < v->size; i++)
+        if (vec_at(v, int, i - 1) > vec_at(v, int, i)) sorted = false;
+    TEST_ASSERT(sorted, "T11.1: vec_sort orders 1000 ints");
+
+    size_t lb = vec_lower_bound(v, ag_sort_int, 50);
+    size_t ub = vec_upper_bound(v, ag_sort_int, 50);
+    TEST_ASSERT(vec_at(v, int, lb) == 50 && (lb == 0 || vec_at(v, int, lb - 1) < 50), "T11.2: lower_bound check");
+    TEST_ASSERT(ub > lb && (ub == v->size || vec_at(v, int, ub) > 50), "T11.3: upper_bound check");
+    TEST_ASSERT(vec_binary_search(v, ag_sort_int, 0) && !vec_binary_search(v, ag_sort_int, 100), "T11.4: binary_search check");
+
+    size_t n = vec_unique(v, ag_sort_int);
+    TEST_ASSERT(n == 100 && v->size == 100 && vec_at(v, int, 99) == 99, "T11.5: vec_unique keeps one of each value");
+
+    // Descending scores, ties keep insertion order
+    vector *r = vec_init(0, ranked, false);
+    for (int i = 0; i < 40; i++) vec_push_back(r, ranked, ((ranked){ i % 4, i }));
+    vec_stable_sort(r, by_score);
+    TEST_ASSERT(vec_at_ptr(r, ranked, 0)->score == 3 && vec_at_ptr(r, ranked, 0)->id == 3 && vec_at_ptr(r, ranked, 1)->id == 7,
+                "T11.6: stable_sort keeps ties in order");
+    TEST_ASSERT(vec_at_ptr(r, ranked, 39)->score == 0 && vec_at_ptr(r, ranked, 39)->id == 36, "T11.7: stable_sort last element check");
+
+    vector *d = vec_init(0, double, false);
+    for (int i = 0; i < 500; i++) vec_push_back(d, double, (i % 2 ? -1.0 : 1.0) * (i * 0.25));
+    vec_nth_element(d, ag_sort_double, 250);
+    double kth = vec_at(d, double, 250);
+    bool partitioned = true;
+    for (size_t i = 0; i < 250; i++) if (vec_at(d, double, i) > kth) partitioned = false;
+    TEST_ASSERT(kth == 0.0 && partitioned, "T11.8: nth_element places the median");
+
+    vec_radix_sort(d, f64);
+    sorted = true;
+    for (size_t i = 1; i < d->size; i++)
+        if (vec_at(d, double, i - 1) > vec_at(d, double, i)) sorted = false;
+    TEST_ASSERT(sorted && vec_at(d, double, 0) == -124.75, "T11.9: radix sort on doubles");
+
+    vector *u = vec_init(0, int64_t, false);
+    for (int64_t i = 0; i < 1000; i++) vec_push_back(u, int64_t, (i * 7919) % 1000 - 500);
+    vec_radix_sort(u, i64);
+    TEST_ASSERT(vec_at(u, int64_t, 0) == -500 && vec_at(u, int64_t, 999) == 499 && vec_at(u, int64_t, 500) == 0,
+                "T11.10: radix sort on signed 64-bit keys");
+
+    safe_vec_clean(&v);
+    safe_vec_clean(&r);
+    safe_vec_clean(&d);
+    safe_vec_clean(&u);
+}
+
+// =========================================================================
+// TEST 12: Parallel algorithms
+// =========================================================================
+static void scale_int(void *elem, void *ctx) {
+    *(int*)elem *= *(int*)ctx;
+}
+
+static void int_to_double(void *out, const void *in, void *ctx) {
+    (void)ctx;
+    *(double*)out = *(const int*)in * 0.5;
+}
+
+static void sum_int(void *acc, const void *elem, void *ctx) {
+    (void)ctx;
+    *(long long*)acc += *(const int*)elem;
+}
+
+static void sum_partial(void *acc, const void *other, void *ctx) {
+    (void)ctx;
+    *(long long*)acc += *(const long long*)other;
+}
+
+typedef struct { ag_threadpool *pool; long long total; } nested_ctx;
+
+static void nested_body(size_t begin, size_t end, void *ctx) {
+    nested_ctx *c = (nested_ctx*)ctx;
+    for (size_t i = begin; i < end; i++) {
+        vector *inner = vec_init_fill(20000, int, 1);
+        long long part = 0;
+        vec_reduce(inner, &part, sum_int, sum_partial, NULL, c->pool);
+        __atomic_fetch_add(&c->total, part, __ATOMIC_RELAXED);
+        __vec_clean(inner);
+    }
+}
+
+void test_parallel_algorithms() {
+    printf("\n--- Running Test 12: Parallel Algorithms ---\n");
+    ag_threadpool *pool = ag_threadpool_init(4);
+    TEST_ASSERT(ag_threadpool_size(pool) == 4, "T12.1: pool size counts the caller");
+
+    const size_t n = 200000;
+    vector *v = vec_init(n, int, false);
+    for (size_t i = 0; i < n; i++) vec_at(v, int, i) = (int)(i % 1000);
+
+    int factor = 3;
+    vec_for_each(v, scale_int, &factor, pool);
+    TEST_ASSERT(vec_at(v, int, 0) == 0 && vec_at(v, int, 999) == 2997 && vec_at(v, int, n - 1) == 2997,
+                "T12.2: vec_for_each touches every element");
+
+    vector *d = vec_init(0, double, false);
+    vec_transform(d, v, int_to_double, NULL, pool);
+    TEST_ASSERT(d->size == n && vec_at(d, double, 1001) == 1.5, "T12.3: vec_transform resizes and maps");
+
+    long long total = 0;
+    vec_reduce(v, &total, sum_int, sum_partial, NULL, pool);
+    TEST_ASSERT(total == 3LL * 499500 * (long long)(n / 1000), "T12.4: vec_reduce sum check");
+
+    vec_parallel_fill(v, 5, n - 5, int, 7, pool);
+    TEST_ASSERT(vec_at(v, int, 4) == 12 && vec_at(v, int, 5) == 7 && vec_at(v, int, n - 6) == 7
+                && vec_at(v, int, n - 5) == 2985, "T12.5: vec_parallel_fill respects the range");
+
+    unsigned seed = 777;
+    for (size_t i = 0; i < n; i++) {
+        seed = seed * 1103515245u + 12345u;
+        vec_at(v, int, i) = (int)(seed >> 1);
+    }
+    vec_parallel_sort(v, ag_sort_int, pool);
+    bool sorted = true;
+    for (size_t i = 1; i < n; i++)
+        if (vec_at(v, int, i - 1) > vec_at(v, int, i)) sorted = false;
+    TEST_ASSERT(sorted, "T12.6: vec_parallel_sort orders 200000 ints");
+
+    // A NULL pool runs the same operation serially
+    long long serial_total = 0, pool_total = 0;
+    vec_reduce(v, &serial_total, sum_int, sum_partial, NULL, NULL);
+    vec_reduce(v, &pool_total, sum_int, sum_partial, NULL, pool);
+    TEST_ASSERT(serial_total == pool_total, "T12.7: serial and parallel reduce agree");
+
+    nested_ctx nc = { pool, 0 };
+    ag_parallel_for(pool, 16, 1, nested_body, &nc);
+    TEST_ASSERT(nc.total == 16 * 20000, "T12.8: nested parallel calls from pool workers");
+
+    safe_vec_clean(&v);
+    safe_vec_clean(&d);
+    ag_threadpool_clean(pool);
+}
+
+// =========================================================================
+// TEST 13: Persistent vectors
+// =========================================================================
+void test_persistent_vector() {
+    printf("\n--- Running Test 13: Persistent Vectors ---\n");
+    char path[] = "/tmp/aegis_vec_XXXXXX";
+    int fd = mkstemp(path);
+    TEST_ASSERT(fd >= 0, "T13.1: Temporary file created");
+    close(fd);
+
+    vector *v = vec_init(0, double, false);
+    for (int i = 0; i < 5000; i++) vec_push_back(v, double, i * 0.25);
+    TEST_ASSERT(vec_save(v, path), "T13.2: vec_save writes the file");
+
+    vector *m = vec_map_file(path, double, AG_VEC_MAP_READONLY | AG_VEC_MAP_VERIFY);
+    TEST_ASSERT(m != NULL && (m->flags & AG_VEC_FILE_MAPPED), "T13.3: vec_map_file maps the file");
+    TEST_ASSERT(m->size == 5000 && m->capacity == 5000 && m->element_size == sizeof(double), "T13.4: Header fields round trip");
+    TEST_ASSERT(memcmp(m->data, v->data, 5000 * sizeof(double)) == 0, "T13.5: Mapped data matches the saved vector");
+    TEST_ASSERT(((uintptr_t)m->data & 4095) == 0, "T13.6: Data starts on a page boundary");
+    safe_vec_clean(&m);
+
+    TEST_ASSERT(vec_map_file(path, float, AG_VEC_MAP_READONLY) == NULL, "T13.7: Element size mismatch is rejected");
+    m = __vec_map_file(path, 0, AG_VEC_MAP_READONLY);
+    TEST_ASSERT(m != NULL && m->element_size == sizeof(double), "T13.8: element_size 0 accepts any file");
+    safe_vec_clean(&m);
+
+    // Copy-on-write: writes and growth stay private, the file is unchanged
+    m = vec_map_file(path, double, AG_VEC_MAP_COW);
+    vec_at(m, double, 0) = -1.0;
+    vec_push_back(m, double, 42.0);
+    TEST_ASSERT(!(m->flags & AG_VEC_FILE_MAPPED) && m->size == 5001, "T13.9: Growth copies a mapped vector to the heap");
+    TEST_ASSERT(vec_at(m, double, 0) == -1.0 && vec_at(m, double, 4999) == 4999 * 0.25 && vec_at(m, double, 5000) == 42.0, "T13.10: Data survives the copy out of the mapping");
+    safe_vec_clean(&m);
+    m = vec_map_file(path, double, AG_VEC_MAP_VERIFY);
+    TEST_ASSERT(m != NULL && vec_at(m, double, 0) == 0.0, "T13.11: Copy-on-write writes never reach the file");
+    safe_vec_clean(&m);
+
+    // Flip one data byte: the header still parses but VERIFY fails
+    FILE *f = fopen(path, "r+b");
+    fseek(f, AG_VEC_FILE_DATA_OFFSET + 100, SEEK_SET);
+    fputc(0x5a, f);
+    fclose(f);
+    m = vec_map_file(path, double, AG_VEC_MAP_READONLY);
+    TEST_ASSERT(m != NULL, "T13.12: Corrupt data still maps without VERIFY");
+    safe_vec_clean(&m);
+    TEST_ASSERT(vec_map_file(path, double, AG_VEC_MAP_VERIFY) == NULL, "T13.13: VERIFY rejects a checksum mismatch");
+
+    // Empty vectors and non-vector files
+    vector *e = vec_init(0, int, false);
+    TEST_ASSERT(vec_save(e, path), "T13.14: Empty vector saves");
+    m = vec_map_file(path, int, AG_VEC_MAP_VERIFY);
+    TEST_ASSERT(m != NULL && m->size == 0, "T13.15: Empty vector maps back");
+    vec_push_back(m, int, 7);
+    TEST_ASSERT(m->size == 1 && vec_at(m, int, 0) == 7, "T13.16: Mapped empty vector can grow");
+    safe_vec_clean(&m);
+    safe_vec_clean(&e);
+
+    f = fopen(path, "wb");
+    fputs("not a vector", f);
+    fclose(f);
+    TEST_ASSERT(vec_map_file(path, int, AG_VEC_MAP_READONLY) == NULL, "T13.17: Non-vector file is rejected");
+    remove(path);
+    TEST_ASSERT(vec_map_file(path, int, AG_VEC_MAP_READONLY) == NULL, "T13.18: Missing file returns NULL");
+
+    safe_vec_clean(&v);
+}
+
+// =========================================================================
+// TEST 14: Small vectors
+// =========================================================================
+static size_t small_allocs = 0;
+
+static void *small_alloc(void *ctx, size_t size) { (void)ctx; small_allocs++; return malloc(size); }
+static void *small_realloc(void *ctx, void *ptr, size_t old_size, size_t new_size) {
+    (void)ctx; (void)old_size; small_allocs++; return realloc(ptr, new_size);
+}
+static void small_free(void *ctx, void *ptr, size_t size) { (void)ctx; (void)size; free(ptr); }
+
+typedef struct {
+    int key;
+    ag_small_vector(long, 4) values;
+} small_owner;
+
+void test_small_vector() {
+    printf("\n--- Running Test 14: Small Vectors ---\n");
+    ag_allocator counting = { small_alloc, small_realloc, small_free, NULL };
+
+    ag_small_vector(int, 16) ids;
+    vector *v = small_vec_init_with_alloc(&ids, &counting);
+    TEST_ASSERT(v == &ids.vec && v->capacity == 16 && v->element_size == sizeof(int), "T14.1: small_vec_init uses the inline storage");
+
+    for (int i = 0; i < 16; i++) vec_push_back(v, int, i);
+    vec_insert(v, 0, int, -1);
+    TEST_ASSERT(small_allocs == 1, "T14.2: Only the 17th element allocates");
+    vec_erase(v, 0);
+    for (int i = 0; i < 8; i++) vec_pop_back(v);
+    TEST_ASSERT(v->data != ids.storage && !(v->flags & AG_VEC_INLINE), "T14.3: Spilled data lives on the heap");
+    TEST_ASSERT(v->size == 8 && vec_at(v, int, 0) == 0 && vec_at(v, int, 7) == 7, "T14.4: Data survives the spill");
+    vec_clean(v);
+
+    ag_small_vector(int, 8) few;
+    v = small_vec_init_with_alloc(&few, &counting);
+    small_allocs = 0;
+    int src[6] = { 5, 4, 3, 2, 1, 0 };
+    vec_push_back_n(v, src, 6);
+    vec_insert(v, 3, int, 9);
+    vec_erase(v, 0);
+    TEST_ASSERT(small_allocs == 0 && v->data == few.storage, "T14.5: Staying under N never allocates");
+    TEST_ASSERT(v->size == 6 && vec_at(v, int, 2) == 9 && vec_at(v, int, 5) == 0, "T14.6: Range, insert and erase on inline data");
+    vec_clean(v);
+
+    // Embedded in a struct, reused after clean
+    small_owner owner = { 1, { 0 } };
+    vector *vals = small_vec_init(&owner.values);
+    for (long i = 0; i < 100; i++) vec_push_back(vals, long, i * i);
+    TEST_ASSERT(vals->size == 100 && vec_at(vals, long, 99) == 99 * 99, "T14.7: Embedded small vector grows");
+    vec_clean(vals);
+    vals = small_vec_init(&owner.values);
+    vec_push_back(vals, long, 3);
+    TEST_ASSERT(vals->data == owner.values.storage && vec_at(vals, long, 0) == 3, "T14.8: Re-init after clean is inline again");
+    vec_clean(vals);
+
+    // Inserting a vector's own elements copies them through its allocator
+    ag_small_vector(int, 32) self;
+    v = small_vec_init_with_alloc(&self, &counting);
+    vec_push_back_n(v, src, 6);
+    small_allocs = 0;
+    vec_insert_range(v, 1, (int*)v->data + 3, 3);
+    TEST_ASSERT(small_allocs == 1 && v->size == 9, "T14.9: Self-insert scratch comes from the vector's allocator");
+    TEST_ASSERT(vec_at(v, int, 0) == 5 && vec_at(v, int, 1) == 2 && vec_at(v, int, 3) == 0 && vec_at(v, int, 4) == 4,
+                "T14.10: Self-insert copies the original elements");
+    vec_clean(v);
+}
+
 // =========================================================================
 // MAIN TEST RUNNER
 // =========================================================================
@@ -293,6 +751,14 @@ int main() {
     test_insert_and_erase();
     test_complex_types();
     test_edge_cases();
+    test_typed_vector();
+    test_allocators();
+    test_large_vector_mode();
+    test_range_operations();
+    test_sorting();
+    test_parallel_algorithms();
+    test_persistent_vector();
+    test_small_vector();
 
     printf("\n============================================\n");
     printf("TEST SUITE SUMMARY:\n");